@@ -9,6 +9,7 @@ if /i "%1"=="Win32"   set platform=Win32& shift
 if /i "%1"=="x64"     set platform=x64& shift
 if /i "%1"=="Debug"   set config=Debug& shift
 if /i "%1"=="Release" set config=Release& shift
+if /i "%1"=="ReleaseFloat" set config=ReleaseFloat& shift
 
 set OLD_DIR=%CD%
 set DIRS=%*
@@ -11,6 +11,7 @@ if /i "%1"=="Win32"   set platform=Win32& shift
 if /i "%1"=="x64"     set platform=x64& shift
 if /i "%1"=="Debug"   set config=Debug& shift
 if /i "%1"=="Release" set config=Release& shift
+if /i "%1"=="ReleaseFloat" set config=ReleaseFloat& shift
 if not "%1"=="" goto usage
 call "%dir%config.cmd"
 
@@ -93,7 +94,7 @@ echo Usage: %~n0 [compiler] [platform] [configuration]
 echo Where
 echo   compiler: vc6 (Visual Studio 97) or vc9 (VisualStudio 2008)
 echo   paltform: Win32 or x64
-echo   configuration: Debug or Release
+echo   configuration: Debug, Release or ReleaseFloat (single-precision samples)
 goto fail
 
 :fail
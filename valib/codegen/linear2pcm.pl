@@ -7,13 +7,13 @@ my @types    = qw(int16_t  int24_t  int32_t  int16_t  int24_t  int32_t  float
 my @sample_size = (2, 3, 4, 2, 3, 4, 4, 8, 5, 6);
 my @pcm2lin  =
 (
-'dst[$ch] = int2le16(s2i(*src[$ch])); src[$ch]++;',
-'dst[$ch] = int2le24(s2i(*src[$ch])); src[$ch]++;',
-'dst[$ch] = int2le32(s2i(*src[$ch])); src[$ch]++;',
+'dst[$ch] = int2le16(s2i16(*src[$ch])); src[$ch]++;',
+'dst[$ch] = int2le24(s2i24(*src[$ch])); src[$ch]++;',
+'dst[$ch] = int2le32(s2i32(*src[$ch])); src[$ch]++;',
 
-'dst[$ch] = int2be16(s2i(*src[$ch])); src[$ch]++;',
-'dst[$ch] = int2be24(s2i(*src[$ch])); src[$ch]++;',
-'dst[$ch] = int2be32(s2i(*src[$ch])); src[$ch]++;',
+'dst[$ch] = int2be16(s2i16(*src[$ch])); src[$ch]++;',
+'dst[$ch] = int2be24(s2i24(*src[$ch])); src[$ch]++;',
+'dst[$ch] = int2be32(s2i32(*src[$ch])); src[$ch]++;',
 
 'dst[$ch] = float(*src[$ch]); src[$ch]++;',
 'dst[$ch] = double(*src[$ch]); src[$ch]++;',
@@ -256,6 +256,18 @@ SOURCE=..\valib\rng.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\simd.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\simd.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\simd_vec.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\spk.cpp
 # End Source File
 # Begin Source File
@@ -276,6 +288,14 @@ SOURCE=..\valib\syncscan.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\thread_pool.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\thread_pool.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\vargs.cpp
 # End Source File
 # Begin Source File
@@ -344,6 +364,10 @@ SOURCE=..\valib\filters\convert_pcm2linear.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\filters\convert_simd.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\filters\convolver.cpp
 # End Source File
 # Begin Source File
@@ -420,6 +444,14 @@ SOURCE=..\valib\filters\dither.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\filters\dynamics.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\filters\dynamics.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\filters\dvd_graph.cpp
 # End Source File
 # Begin Source File
@@ -476,6 +508,14 @@ SOURCE=..\valib\filters\mixer.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\filters\mixer_simd.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\filters\mixer_simd.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\filters\parser_filter.cpp
 # End Source File
 # Begin Source File
@@ -655,6 +695,14 @@ SOURCE=..\valib\parsers\dts\dts_header.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\parsers\dts\dts_huffman.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\parsers\dts\dts_huffman.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\parsers\dts\dts_parser.cpp
 # End Source File
 # Begin Source File
@@ -663,6 +711,14 @@ SOURCE=..\valib\parsers\dts\dts_parser.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\parsers\dts\dts_synth.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\parsers\dts\dts_synth.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\parsers\dts\dts_tables.h
 # End Source File
 # Begin Source File
@@ -738,6 +794,14 @@ SOURCE=..\valib\parsers\multi_header.cpp
 
 SOURCE=..\valib\parsers\multi_header.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\valib\parsers\parallel_decoder.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\parsers\parallel_decoder.h
+# End Source File
 # End Group
 # Begin Group "sink"
 
@@ -840,6 +904,14 @@ SOURCE=..\valib\source\wav_source.h
 # PROP Default_Filter ""
 # Begin Source File
 
+SOURCE=..\valib\dsp\block_stat.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\dsp\block_stat.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\dsp\dbesi0.c
 # End Source File
 # Begin Source File
@@ -848,14 +920,30 @@ SOURCE=..\valib\dsp\dbesi0.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\dsp\dot.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\dsp\dot.h
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\dsp\fft.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\dsp\fft_ext.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\dsp\fft.h
 # End Source File
 # Begin Source File
 
+SOURCE=..\valib\dsp\fft_simd.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=..\valib\dsp\fftsg.c
 # End Source File
 # Begin Source File
@@ -870,6 +958,22 @@ SOURCE=..\valib\dsp\kaiser.cpp
 
 SOURCE=..\valib\dsp\kaiser.h
 # End Source File
+# Begin Source File
+
+SOURCE=..\valib\dsp\limiter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\dsp\limiter.h
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\dsp\part_conv.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=..\valib\dsp\part_conv.h
+# End Source File
 # End Group
 # Begin Group "fir"
 
@@ -0,0 +1,102 @@
+/*
+  Helpers for convolution tests (Convolver, ConvolverMch)
+
+  RandomFIR - FIR generator of random response of the given length and
+    center.
+  convolve_direct() - reference direct convolution of the input with a
+    response for each channel (or one response for all channels).
+  convolve_filter() - process the input with a filter by chunks and collect
+    the output. Returns the output size (more than size when the filter
+    outputs more than it gets).
+*/
+
+#ifndef CONVOLVE_REF_H
+#define CONVOLVE_REF_H
+
+#include <string.h>
+#include "buffer.h"
+#include "filter.h"
+#include "fir.h"
+#include "rng.h"
+
+class RandomFIR : public FIRGen
+{
+protected:
+  int length;
+  int center;
+  AutoBuf<double> data;
+
+public:
+  RandomFIR(int seed, int length_, int center_): length(length_), center(center_)
+  {
+    RNG rng(seed);
+    data.allocate(length);
+    for (int i = 0; i < length; i++)
+      data[i] = rng.get_sample() / length;
+  }
+
+  virtual int version() const { return 0; }
+  virtual const FIRInstance *make(int sample_rate) const
+  { return new StaticFIRInstance(sample_rate, firt_custom, length, center, data); }
+};
+
+inline void convolve_direct(const SampleBuf &input, size_t size, const FIRInstance *const *firs, SampleBuf &result)
+{
+  result.allocate(input.nch(), size);
+  for (unsigned ch = 0; ch < input.nch(); ch++)
+  {
+    const FIRInstance *fir = firs[ch];
+    for (size_t s = 0; s < size; s++)
+    {
+      // result[s] = sum(input[s + center - i] * fir[i])
+      double sum = 0;
+      for (int i = 0; i < fir->length; i++)
+      {
+        ptrdiff_t t = ptrdiff_t(s) + fir->center - i;
+        if (t >= 0 && t < ptrdiff_t(size))
+          sum += input[ch][t] * fir->data[i];
+      }
+      result[ch][s] = sum;
+    }
+  }
+}
+
+inline void convolve_direct(const SampleBuf &input, size_t size, const FIRInstance *fir, SampleBuf &result)
+{
+  const FIRInstance *firs[NCHANNELS];
+  for (int ch = 0; ch < NCHANNELS; ch++)
+    firs[ch] = fir;
+  convolve_direct(input, size, firs, result);
+}
+
+inline size_t convolve_filter(Speakers spk, const SampleBuf &input, size_t size, Filter *f, SampleBuf &result)
+{
+  const size_t chunk_size = 777;
+  Chunk chunk;
+  size_t in_pos = 0, out_pos = 0;
+
+  f->reset();
+  result.allocate(input.nch(), size);
+  while (!chunk.eos)
+  {
+    if (f->is_empty())
+    {
+      size_t n = MIN(chunk_size, size - in_pos);
+      samples_t in = input.samples();
+      in += in_pos;
+      chunk.set_linear(spk, in, n, false, 0, in_pos + n >= size);
+      in_pos += n;
+      f->process(&chunk);
+    }
+
+    f->get_chunk(&chunk);
+    if (out_pos + chunk.size > size)
+      return out_pos + chunk.size;
+    for (unsigned ch = 0; ch < input.nch(); ch++)
+      memcpy(result[ch] + out_pos, chunk.samples[ch], chunk.size * sizeof(sample_t));
+    out_pos += chunk.size;
+  }
+  return out_pos;
+}
+
+#endif
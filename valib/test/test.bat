@@ -20,7 +20,8 @@ goto end
 echo Run the test suite. Usage:
 echo   test conifg [test] [test]
 echo where
-echo   config - configuration to test: Debug, Release, x64\Debug or x64\Release
+echo   config - configuration to test: Debug, Release, ReleaseFloat, x64\Debug,
+echo            x64\Release or x64\ReleaseFloat
 echo   test   - test to execute; you can specify several tests
 echo.
 echo You must have the samples folder. Directory layout must look like:
@@ -9,18 +9,44 @@ EXTERN_SUITE(suite_test);
 
 EXTERN_SUITE(general);
 EXTERN_TEST(rng);
+EXTERN_TEST(thread_pool);
+EXTERN_TEST(dot_mch);
+EXTERN_TEST(block_stat);
+EXTERN_TEST(limiter);
+EXTERN_TEST(limiter_window);
+EXTERN_TEST(agc_limiter);
+EXTERN_TEST(dynamics);
 EXTERN_SUITE(bitstream);
+EXTERN_SUITE(crc);
+EXTERN_SUITE(syncscan);
+EXTERN_TEST(dts_huffman);
+EXTERN_SUITE(dts_synth);
+EXTERN_TEST(ac3_imdct_a52);
+EXTERN_SUITE(ac3_bitalloc);
+EXTERN_TEST(ac3_enc_mdct);
+EXTERN_TEST(ac3_enc);
+EXTERN_TEST(ac3_enc_threads);
+EXTERN_TEST(parallel_decoder);
+EXTERN_TEST(file_parser_mmap);
+EXTERN_TEST(mpa_synth_exact);
 EXTERN_SUITE(base);
 EXTERN_SUITE(fir);
+EXTERN_SUITE(fft);
 EXTERN_SUITE(linear_filter);
 EXTERN_TEST(cache);
 
 
 EXTERN_TEST(slice);
 EXTERN_TEST(convolver);
+EXTERN_TEST(convolver_part);
 EXTERN_TEST(convolver_mch);
+EXTERN_TEST(convolver_mch_part);
+EXTERN_TEST(convolver_mch_shared);
+EXTERN_SUITE(convert);
+EXTERN_SUITE(mixer);
 EXTERN_SUITE(resample);
 EXTERN_SUITE(proc);
+EXTERN_SUITE(precision);
 EXTERN_TEST(old_style);
 
 // Heavy tests
@@ -29,6 +55,25 @@ EXTERN_TEST(rng_proof);
 
 // Speed tests
 
+EXTERN_TEST(resample_speed);
+EXTERN_TEST(thread_pool_speed);
+EXTERN_TEST(block_stat_speed);
+EXTERN_TEST(limiter_speed);
+EXTERN_TEST(dynamics_speed);
+EXTERN_TEST(fft_speed);
+EXTERN_TEST(convert_speed);
+EXTERN_TEST(syncscan_speed);
+EXTERN_TEST(crc_speed);
+EXTERN_TEST(bitstream_speed);
+EXTERN_TEST(dts_huffman_speed);
+EXTERN_TEST(dts_synth_speed);
+EXTERN_TEST(ac3_imdct_speed);
+EXTERN_TEST(mpa_synth_speed);
+EXTERN_TEST(ac3_bitalloc_speed);
+EXTERN_TEST(ac3_enc_speed);
+EXTERN_TEST(parallel_decoder_speed);
+EXTERN_TEST(file_parser_speed);
+
 ///////////////////////////////////////////////////////////
 // Common tests
 
@@ -36,16 +81,42 @@ FLAT_SUITE(tests, "Common tests")
   SUITE_FACTORY(suite_test),
   SUITE_FACTORY(general),
    TEST_FACTORY(rng),
+   TEST_FACTORY(thread_pool),
   SUITE_FACTORY(bitstream),
+  SUITE_FACTORY(crc),
+  SUITE_FACTORY(syncscan),
+   TEST_FACTORY(dts_huffman),
+  SUITE_FACTORY(dts_synth),
+   TEST_FACTORY(ac3_imdct_a52),
+  SUITE_FACTORY(ac3_bitalloc),
+   TEST_FACTORY(ac3_enc_mdct),
+   TEST_FACTORY(ac3_enc),
+   TEST_FACTORY(ac3_enc_threads),
+  TEST_FACTORY(parallel_decoder),
+  TEST_FACTORY(file_parser_mmap),
+  TEST_FACTORY(mpa_synth_exact),
   SUITE_FACTORY(base),
   SUITE_FACTORY(fir),
+  SUITE_FACTORY(fft),
+  TEST_FACTORY(dot_mch),
+  TEST_FACTORY(block_stat),
+  TEST_FACTORY(limiter),
+  TEST_FACTORY(limiter_window),
   SUITE_FACTORY(linear_filter),
    TEST_FACTORY(cache),
    TEST_FACTORY(slice),
    TEST_FACTORY(convolver),
+   TEST_FACTORY(convolver_part),
    TEST_FACTORY(convolver_mch),
+   TEST_FACTORY(convolver_mch_part),
+   TEST_FACTORY(convolver_mch_shared),
+  SUITE_FACTORY(convert),
+  SUITE_FACTORY(mixer),
   SUITE_FACTORY(resample),
   SUITE_FACTORY(proc),
+  SUITE_FACTORY(precision),
+  TEST_FACTORY(agc_limiter),
+  TEST_FACTORY(dynamics),
 
    TEST_FACTORY(old_style),
 SUITE_END;
@@ -61,6 +132,24 @@ SUITE_END;
 // Speed tests
 
 FLAT_SUITE(speed, "Speed tests")
+  TEST_FACTORY(resample_speed),
+  TEST_FACTORY(thread_pool_speed),
+  TEST_FACTORY(block_stat_speed),
+  TEST_FACTORY(limiter_speed),
+  TEST_FACTORY(dynamics_speed),
+  TEST_FACTORY(fft_speed),
+  TEST_FACTORY(convert_speed),
+  TEST_FACTORY(syncscan_speed),
+  TEST_FACTORY(crc_speed),
+  TEST_FACTORY(bitstream_speed),
+  TEST_FACTORY(dts_huffman_speed),
+  TEST_FACTORY(dts_synth_speed),
+  TEST_FACTORY(ac3_imdct_speed),
+  TEST_FACTORY(mpa_synth_speed),
+  TEST_FACTORY(ac3_bitalloc_speed),
+  TEST_FACTORY(ac3_enc_speed),
+  TEST_FACTORY(parallel_decoder_speed),
+  TEST_FACTORY(file_parser_speed),
 SUITE_END;
 
 FLAT_SUITE(all, "All tests")
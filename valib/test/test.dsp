@@ -95,6 +95,10 @@ SOURCE=.\tests\test_base.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\tests\test_fft.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\tests\test_fir.cpp
 # End Source File
 # Begin Source File
@@ -103,8 +107,20 @@ SOURCE=.\tests\test_general.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\tests\test_precision.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\tests\test_rng.cpp
 # End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_syncscan.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_thread_pool.cpp
+# End Source File
 # End Group
 # Begin Group "filter_tests"
 
@@ -115,6 +131,62 @@ SOURCE=.\tests\test_bitstream.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\tests\test_dot.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_block_stat.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_limiter.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_crc_calc.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_dts_huffman.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_dts_synth.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_ac3_imdct.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_ac3_bitalloc.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_ac3_enc.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_parallel_decoder.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_file_parser.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\test_mpa_synth.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\liba52\imdct.c
+# End Source File
+# Begin Source File
+
+SOURCE=.\tests\filters\test_convert.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\tests\filters\test_convolver.cpp
 # End Source File
 # Begin Source File
@@ -123,10 +195,18 @@ SOURCE=.\tests\filters\test_convolver_mch.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\tests\filters\test_dynamics.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\tests\filters\test_linear_filter.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\tests\filters\test_mixer.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\tests\filters\test_proc.cpp
 # End Source File
 # Begin Source File
@@ -213,6 +293,10 @@ SOURCE=.\suite.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\convolve_ref.h
+# End Source File
+# Begin Source File
+
 SOURCE=.\suite.h
 # End Source File
 # Begin Source File
@@ -442,24 +442,14 @@ public:
     log->msg("IMDCT blocks/s: %i", int(blocks / cpu.get_thread_time()));
   }
 
-  sample_t max_diff(sample_t init, int32_t *x, sample_t *y, int n)
-  {
-    sample_t diff = init;
-    for (int i = 0; i < n; i++)
-      if (fabs(sample_t(x[i]) - y[i] * 32768.0) > diff)
-        diff = fabs(sample_t(x[i]) - y[i] * 32768.0);
-    return diff;
-  }
-
   int test_mdct512()
   {
     int i;
     const int blocks = 10;
     const sample_t *w = ac3_window;
 
-    int16_t  data[512 * blocks];
-    int32_t  output[256];
-    sample_t data_ref[512 * blocks];
+    sample_t data[512 * blocks];
+    sample_t output[256];
     sample_t output_ref[256];
 
     ///////////////////////////////////////////////////////
@@ -470,46 +460,44 @@ public:
     {
       for (i = 0; i < 256; i++)
       {
-        data_ref[512 * block + i] = rng.get_sample() * w[i];
-        data_ref[512 * block + i + 256] = rng.get_sample() * w[255 - i];
-        data[512 * block + i] = int16_t(data_ref[512 * block + i] * 32767);
-        data[512 * block + i + 256] = int16_t(data_ref[512 * block + i + 256] * 32767);
+        data[512 * block + i] = rng.get_sample() * w[i];
+        data[512 * block + i + 256] = rng.get_sample() * w[255 - i];
       }
     }
 
     ///////////////////////////////////////////////////////
-    // Do imdct and compare result
+    // Do mdct and compare result
 
-    MDCT mdct(7);
+    MDCT mdct;
     Ref_MDCT mdct_ref;
     sample_t diff = 0;
 
     for (i = 0; i < blocks; i++)
     {
       mdct.mdct512(output, data + 512 * i);
-      mdct_ref.mdct512(data_ref + 512 * i, output_ref);
+      mdct_ref.mdct512(data + 512 * i, output_ref);
       diff = max_diff(diff, output, output_ref, 256);
-      if (diff > 8) return log->err("MDCT is wrong");
+      if (diff > 1e-4) return log->err("MDCT is wrong");
     }
 
-    log->msg("MDCT 512: max difference = %i", int(diff));
+    log->msg("MDCT 512: max difference = %.0e", diff);
     return 0;
   }
 
   void speed_mdct()
   {
     int s;
-    int16_t mdct_buf[AC3_BLOCK_SAMPLES * 2];
-    int16_t delay[AC3_BLOCK_SAMPLES];
-    int32_t mant[AC3_BLOCK_SAMPLES];
+    sample_t mdct_buf[AC3_BLOCK_SAMPLES * 2];
+    sample_t delay[AC3_BLOCK_SAMPLES];
+    sample_t coef[AC3_BLOCK_SAMPLES];
     SampleBuf input;
-    MDCT mdct(7);
+    MDCT mdct;
     RNG rng;
 
     input.allocate(1, AC3_BLOCK_SAMPLES);
 
     rng.fill_samples(input[0], AC3_BLOCK_SAMPLES);
-    rng.fill_raw(delay, AC3_BLOCK_SAMPLES * 2);
+    rng.fill_samples(delay, AC3_BLOCK_SAMPLES);
 
     CPUMeter cpu;
     cpu.reset();
@@ -524,10 +512,10 @@ public:
       for (s = 0; s < AC3_BLOCK_SAMPLES; s++)
       {
         v = *sptr++;
-        mdct_buf[s + 256] = int32_t(v * ac3_window[AC3_BLOCK_SAMPLES - s - 1]);
-        delay[s] = int32_t(v * ac3_window[s]);
+        mdct_buf[s + 256] = v * ac3_window[AC3_BLOCK_SAMPLES - s - 1];
+        delay[s] = v * ac3_window[s];
       }
-      mdct.mdct512(mant, mdct_buf);
+      mdct.mdct512(coef, mdct_buf);
       blocks++;
     }
     cpu.stop();
@@ -0,0 +1,196 @@
+/*
+  PCM <-> Linear conversion functions test
+  * SIMD conversion kernels must produce bit-identical result with the scalar
+    conversion functions for all formats and channel numbers, including
+    saturation of out-of-range samples, NaN samples and short buffers (tail
+    processing).
+  * Conversion PCM -> Linear -> PCM must be lossless.
+  * Speed test: compare scalar and SIMD conversion.
+*/
+
+#include "buffer.h"
+#include "filters/convert_func.h"
+#include "rng.h"
+#include "simd.h"
+#include "../../suite.h"
+
+static const int seed = 650283;
+static const size_t sizes[] = { 0, 1, 2, 3, 5, 7, 255, 257, 4099 };
+static const size_t max_size = 4099;
+
+static const int formats[] =
+{
+  FORMAT_PCM16, FORMAT_PCM24, FORMAT_PCM32,
+  FORMAT_PCM16_BE, FORMAT_PCM24_BE, FORMAT_PCM32_BE,
+  FORMAT_PCMFLOAT, FORMAT_PCMDOUBLE
+};
+
+static const int modes[NCHANNELS] =
+{ MODE_1_0, MODE_2_0, MODE_3_0, MODE_2_2, MODE_3_2, MODE_5_1 };
+
+static bool equal_bits(const SampleBuf &buf1, const SampleBuf &buf2, int nch, size_t size)
+{
+  for (int ch = 0; ch < nch; ch++)
+    if (memcmp(buf1[ch], buf2[ch], size * sizeof(sample_t)))
+      return false;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(convert_simd, "PCM <-> Linear SIMD kernels")
+  RNG rng(seed);
+  SampleBuf input, ref, test;
+  AutoBuf<uint8_t> ref_raw, test_raw;
+
+  int old_mask = simd_get_mask();
+  for (int f = 0; f < array_size(formats); f++)
+    for (int m = 0; m < NCHANNELS; m++)
+    {
+      Speakers spk(formats[f], modes[m], 48000);
+      int nch = spk.nch();
+      size_t raw_size = max_size * nch * sample_size(spk.format);
+
+      // 25% of samples are out of range to check saturation, some samples
+      // are NaN
+      sample_t zero = 0;
+      input.allocate(nch, max_size);
+      for (int ch = 0; ch < nch; ch++)
+      {
+        rng.fill_samples(input[ch], max_size);
+        for (size_t s = 0; s < max_size; s++)
+          input[ch][s] *= spk.level * 4 / 3;
+        for (size_t s = ch; s < max_size; s += 13)
+          input[ch][s] = zero / zero;
+      }
+
+      ref.allocate(nch, max_size);
+      test.allocate(nch, max_size);
+      ref_raw.allocate(raw_size);
+      test_raw.allocate(raw_size);
+
+      for (int i = 0; i < array_size(sizes); i++)
+      {
+        size_t size = sizes[i];
+
+        // Linear -> PCM
+
+        simd_set_mask(SIMD_NONE);
+        convert_t scalar = find_linear2pcm(spk.format, nch);
+        simd_set_mask(old_mask);
+        convert_t simd = find_linear2pcm(spk.format, nch);
+        CHECK(scalar != 0 && simd != 0);
+
+        // Guard bytes at the end must stay untouched
+        memset(ref_raw, 0x5a, raw_size);
+        memset(test_raw, 0x5a, raw_size);
+        (*scalar)(ref_raw, input, size);
+        (*simd)(test_raw, input, size);
+        CHECKT(memcmp(ref_raw, test_raw, raw_size) == 0,
+          ("Linear -> %s %s, size = %i: SIMD result differs", spk.format_text(), spk.mode_text(), (int)size));
+
+        // PCM -> Linear
+
+        simd_set_mask(SIMD_NONE);
+        scalar = find_pcm2linear(spk.format, nch);
+        simd_set_mask(old_mask);
+        simd = find_pcm2linear(spk.format, nch);
+        CHECK(scalar != 0 && simd != 0);
+
+        ref.zero();
+        test.zero();
+        (*scalar)(ref_raw, ref, size);
+        (*simd)(ref_raw, test, size);
+        CHECKT(equal_bits(ref, test, nch, max_size),
+          ("%s %s -> Linear, size = %i: SIMD result differs", spk.format_text(), spk.mode_text(), (int)size));
+      }
+    }
+  simd_set_mask(old_mask);
+TEST_END(convert_simd);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(convert_roundtrip, "PCM -> Linear -> PCM conversion")
+  RNG rng(seed);
+  SampleBuf samples;
+  AutoBuf<uint8_t> raw, result;
+
+  for (int f = 0; f < array_size(formats); f++)
+  {
+    Speakers spk(formats[f], MODE_5_1, 48000);
+    int nch = spk.nch();
+    size_t raw_size = max_size * nch * sample_size(spk.format);
+
+    // Single-precision sample cannot hold 32-bit integer
+    if (sizeof(sample_t) == sizeof(float) &&
+        (spk.format == FORMAT_PCM32 || spk.format == FORMAT_PCM32_BE))
+      continue;
+
+    raw.allocate(raw_size);
+    result.allocate(raw_size);
+    samples.allocate(nch, max_size);
+
+    if (spk.format == FORMAT_PCMFLOAT || spk.format == FORMAT_PCMDOUBLE)
+    {
+      // Random data may contain NaNs, so make floating-point PCM
+      // from valid samples
+      for (int ch = 0; ch < nch; ch++)
+        rng.fill_samples(samples[ch], max_size);
+      (*find_linear2pcm(spk.format, nch))(raw, samples, max_size);
+    }
+    else
+      rng.fill_raw(raw, raw_size);
+
+    (*find_pcm2linear(spk.format, nch))(raw, samples, max_size);
+    (*find_linear2pcm(spk.format, nch))(result, samples, max_size);
+    CHECKT(memcmp(raw, result, raw_size) == 0, ("%s: conversion is not lossless", spk.format_text()));
+  }
+TEST_END(convert_roundtrip);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(convert_speed, "PCM <-> Linear conversion speed test")
+  const size_t size = 4096;
+  const int runs = 20000;
+
+  RNG rng(seed);
+  SampleBuf samples;
+  AutoBuf<uint8_t> raw;
+
+  int old_mask = simd_get_mask();
+  for (int f = 0; f < array_size(formats); f++)
+  {
+    Speakers spk(formats[f], MODE_STEREO, 48000);
+    int nch = spk.nch();
+
+    samples.allocate(nch, size);
+    raw.allocate(size * nch * sample_size(spk.format));
+    for (int ch = 0; ch < nch; ch++)
+      rng.fill_samples(samples[ch], size);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      convert_t l2p = find_linear2pcm(spk.format, nch);
+      convert_t p2l = find_pcm2linear(spk.format, nch);
+
+      vtime_t time = local_time();
+      for (int i = 0; i < runs; i++)
+      {
+        (*l2p)(raw, samples, size);
+        (*p2l)(raw, samples, size);
+      }
+      time = local_time() - time;
+      log->msg("%-10s %s %.3fs", spk.format_text(), pass? "SIMD:  ": "Scalar:", time);
+    }
+  }
+  simd_set_mask(old_mask);
+TEST_END(convert_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(convert, "PCM <-> Linear conversion test")
+  TEST_FACTORY(convert_simd),
+  TEST_FACTORY(convert_roundtrip),
+SUITE_END;
@@ -4,6 +4,8 @@
 #include "filters/gain.h"
 #include "filters/slice.h"
 #include "fir/param_fir.h"
+#include "rng.h"
+#include "../../convolve_ref.h"
 #include "../../suite.h"
 
 static const Speakers spk = Speakers(FORMAT_LINEAR, MODE_STEREO, 48000);
@@ -140,3 +142,50 @@ TEST(convolver, "Convolver test")
   // TODO
 
 TEST_END(convolver);
+
+///////////////////////////////////////////////////////////////////////////////
+// Partitioned convolution test
+// Long response is split into several partitions and the delay is longer
+// than the processing buffer. Compare with the direct convolution.
+
+TEST(convolver_part, "Convolver partitioned convolution")
+  // (length, center, input size)
+  static const int tests[][3] =
+  {
+    { 5000,  2500, 20000 }, // delay > buffer size
+    { 5000,     0, 20000 }, // no delay
+    { 5000,  4999, 20000 }, // maximum delay
+    { 3000,  2500,  1000 }, // input is shorter than the delay
+    {  100,    50,  9999 }, // single partition
+  };
+
+  RNG rng(seed);
+  SampleBuf input, ref, test;
+  Convolver conv;
+  conv.set_input(spk);
+
+  for (int i = 0; i < array_size(tests); i++)
+  {
+    RandomFIR gen(seed + i, tests[i][0], tests[i][1]);
+    const FIRInstance *fir = gen.make(spk.sample_rate);
+    size_t size = tests[i][2];
+
+    input.allocate(spk.nch(), size);
+    for (int ch = 0; ch < spk.nch(); ch++)
+      rng.fill_samples(input[ch], size);
+
+    convolve_direct(input, size, fir, ref);
+    conv.set_fir(&gen);
+    size_t out_size = convolve_filter(spk, input, size, &conv, test);
+    CHECKT(out_size == size, ("length=%i center=%i: output size %i != input size %i", fir->length, fir->center, out_size, size));
+
+    sample_t diff = 0;
+    for (int ch = 0; ch < spk.nch(); ch++)
+      for (size_t s = 0; s < size; s++)
+        diff = MAX(diff, fabs(ref[ch][s] - test[ch][s]));
+    CHECKT(diff < db2value(-100), ("length=%i center=%i: difference %gdB", fir->length, fir->center, value2db(diff)));
+
+    conv.set_fir(0);
+    delete fir;
+  }
+TEST_END(convolver_part);
@@ -4,6 +4,8 @@
 #include "filters/gain.h"
 #include "filters/slice.h"
 #include "fir/param_fir.h"
+#include "rng.h"
+#include "../../convolve_ref.h"
 #include "../../suite.h"
 
 static const Speakers spk = Speakers(FORMAT_LINEAR, MODE_QUADRO, 48000);
@@ -19,7 +21,7 @@ TEST(convolver_mch, "ConvolverMch test")
   const int freq = 1000;
   const int df = 100;
   const double att = 100;
-  const int *order = spk.order();
+  const short *order = spk.order();
 
   FIRZero zero_fir;
   FIRIdentity identity_fir;
@@ -216,3 +218,99 @@ TEST(convolver_mch, "ConvolverMch test")
   // TODO
 
 TEST_END(convolver_mch);
+
+///////////////////////////////////////////////////////////////////////////////
+// Partitioned convolution test
+// Responses of different length and center, mixed with trivial responses,
+// that must be delayed to stay aligned. Compare with the direct convolution.
+
+TEST(convolver_mch_part, "ConvolverMch partitioned convolution")
+  const size_t size = 20000;
+  int ch;
+
+  RandomFIR long_fir(seed, 5000, 2500);
+  RandomFIR short_fir(seed + 1, 300, 10);
+  FIRIdentity identity_fir;
+  FIRGain gain_fir(0.5);
+
+  const FIRGen *gens[NCHANNELS] = { 0, 0, 0, 0, 0, 0 };
+  gens[CH_L] = &long_fir;
+  gens[CH_R] = &short_fir;
+  gens[CH_SL] = &identity_fir;
+  gens[CH_SR] = &gain_fir;
+
+  const short *order = spk.order();
+  const FIRInstance *firs[NCHANNELS];
+  for (ch = 0; ch < spk.nch(); ch++)
+    firs[ch] = gens[order[ch]]->make(spk.sample_rate);
+
+  RNG rng(seed);
+  SampleBuf input, ref, test;
+  input.allocate(spk.nch(), size);
+  for (ch = 0; ch < spk.nch(); ch++)
+    rng.fill_samples(input[ch], size);
+
+  ConvolverMch conv;
+  conv.set_input(spk);
+  conv.set_all_firs(gens);
+
+  convolve_direct(input, size, firs, ref);
+  size_t out_size = convolve_filter(spk, input, size, &conv, test);
+  CHECKT(out_size == size, ("Output size %i != input size %i", out_size, size));
+
+  for (ch = 0; ch < spk.nch(); ch++)
+  {
+    sample_t diff = 0;
+    for (size_t s = 0; s < size; s++)
+      diff = MAX(diff, fabs(ref[ch][s] - test[ch][s]));
+    CHECKT(diff < db2value(-100), ("Channel %i: difference %gdB", ch, value2db(diff)));
+    delete firs[ch];
+  }
+TEST_END(convolver_mch_part);
+
+TEST(convolver_mch_shared, "ConvolverMch shared responses")
+  // Channels with identical responses (different generators with equal
+  // data) are convolved together and must give the same result as
+  // separate convolution.
+  const size_t size = 20000;
+  int ch;
+
+  RandomFIR fir1(seed, 3000, 1500);
+  RandomFIR fir2(seed, 3000, 1500);
+  RandomFIR fir3(seed, 3000, 1500);
+  RandomFIR other_fir(seed + 1, 3000, 1500);
+
+  const FIRGen *gens[NCHANNELS] = { 0, 0, 0, 0, 0, 0 };
+  gens[CH_L] = &fir1;
+  gens[CH_R] = &fir2;
+  gens[CH_SL] = &other_fir;
+  gens[CH_SR] = &fir3;
+
+  const short *order = spk.order();
+  const FIRInstance *firs[NCHANNELS];
+  for (ch = 0; ch < spk.nch(); ch++)
+    firs[ch] = gens[order[ch]]->make(spk.sample_rate);
+
+  RNG rng(seed);
+  SampleBuf input, ref, test;
+  input.allocate(spk.nch(), size);
+  for (ch = 0; ch < spk.nch(); ch++)
+    rng.fill_samples(input[ch], size);
+
+  ConvolverMch conv;
+  conv.set_input(spk);
+  conv.set_all_firs(gens);
+
+  convolve_direct(input, size, firs, ref);
+  size_t out_size = convolve_filter(spk, input, size, &conv, test);
+  CHECKT(out_size == size, ("Output size %i != input size %i", out_size, size));
+
+  for (ch = 0; ch < spk.nch(); ch++)
+  {
+    sample_t diff = 0;
+    for (size_t s = 0; s < size; s++)
+      diff = MAX(diff, fabs(ref[ch][s] - test[ch][s]));
+    CHECKT(diff < db2value(-100), ("Channel %i: difference %gdB", ch, value2db(diff)));
+    delete firs[ch];
+  }
+TEST_END(convolver_mch_shared);
@@ -0,0 +1,260 @@
+/*
+  Dynamics filter test
+
+  * Disabled filter passes the stream unchanged.
+  * Bands with no compression sum to an allpass (flat response).
+  * Static compression curve: a tone 20dB over the threshold is compressed
+    by the ratio.
+  * Channels are compressed independently: a quiet channel is not changed
+    when a loud one is compressed.
+  * Output does not depend on the chunk size and on SIMD.
+  * AudioProcessor places the filter before or after the mixer.
+  * Speed test: wideband and 3-band compression of 5.1.
+*/
+
+#include <math.h>
+#include <string.h>
+#include "filters/dynamics.h"
+#include "filters/proc.h"
+#include "rng.h"
+#include "simd.h"
+#include "vtime.h"
+#include "../../suite.h"
+
+static const int seed = 230917;
+static const size_t noise_size = 65536;
+static const Speakers spk(FORMAT_LINEAR, MODE_5_1, 48000);
+
+#ifdef FLOAT_SAMPLE
+static const double eps = 1e-5;
+#else
+static const double eps = 1e-9;
+#endif
+
+// Process the buffer in-place by chunks of random size (whole buffer when
+// rng is zero)
+static void run_filter(Filter *filter, SampleBuf &buf, size_t size, RNG *rng)
+{
+  Chunk chunk;
+  size_t pos = 0;
+  while (pos < size)
+  {
+    size_t n = size - pos;
+    if (rng)
+    {
+      size_t r = rng->next() % 1000;
+      n = MIN(n, r);
+    }
+
+    samples_t s = buf.samples();
+    s += pos;
+    chunk.set_linear(spk, s, n);
+    filter->process(&chunk);
+    while (!filter->is_empty())
+      filter->get_chunk(&chunk);
+    pos += n;
+  }
+}
+
+static void tone(SampleBuf &buf, int nch, size_t size, double freq, double amp)
+{
+  buf.allocate(nch, size);
+  for (int ch = 0; ch < nch; ch++)
+    for (size_t s = 0; s < size; s++)
+      buf[ch][s] = amp * sin(2 * M_PI * freq * s / spk.sample_rate);
+}
+
+static double peak(const sample_t *x, size_t start, size_t end)
+{
+  double p = 0;
+  for (size_t s = start; s < end; s++)
+    p = MAX(p, fabs(x[s]));
+  return p;
+}
+
+// RMS level of a tone over the whole number of periods
+// (sampled peak depends on the phase of the tone)
+static double rms(const sample_t *x, size_t start, size_t end, double freq)
+{
+  size_t period = size_t(spk.sample_rate / freq + 0.5);
+  end = start + (end - start) / period * period;
+
+  double sum = 0;
+  for (size_t s = start; s < end; s++)
+    sum += x[s] * x[s];
+  return sqrt(sum / (end - start));
+}
+
+TEST(dynamics, "Dynamics filter")
+  const int nch = spk.nch();
+  SampleBuf buf, ref;
+  RNG rng(seed);
+  Dynamics dyn;
+  DynamicsBand band;
+  int ch;
+
+  CHECK(dyn.set_input(spk));
+
+  /////////////////////////////////////////////////////////
+  // Disabled filter
+
+  buf.allocate(nch, noise_size);
+  ref.allocate(nch, noise_size);
+  rng.fill_samples(buf[0], nch * noise_size);
+  memcpy(ref[0], buf[0], nch * noise_size * sizeof(sample_t));
+
+  run_filter(&dyn, buf, noise_size, &rng);
+  CHECK(memcmp(buf[0], ref[0], nch * noise_size * sizeof(sample_t)) == 0);
+
+  /////////////////////////////////////////////////////////
+  // Flat response of bands
+
+  static const double freqs[] = { 50, 250, 1000, 4000, 12000 };
+  dyn.set_enabled(true);
+  dyn.set_multiband(true);
+  band.threshold = 100;
+  band.ratio = 4;
+  band.gain = 0;
+  for (int b = 0; b < Dynamics::nbands; b++)
+    dyn.set_band(b, band);
+
+  for (int i = 0; i < array_size(freqs); i++)
+  {
+    tone(buf, nch, noise_size, freqs[i], 0.5);
+    dyn.reset();
+    run_filter(&dyn, buf, noise_size, &rng);
+
+    double err = value2db(rms(buf[0], noise_size / 2, noise_size, freqs[i]) * sqrt(2.0) / 0.5);
+    CHECKT(fabs(err) < 0.01, ("%.0fHz: %.3fdB", freqs[i], err));
+  }
+
+  /////////////////////////////////////////////////////////
+  // Static curve (3kHz tone has 16 samples period, so the RMS level of
+  // each sub-block is equal to the RMS level of the tone)
+
+  const double thr = -30;
+  const double ratio = 4;
+  const double loud = db2value(-10);  // 20dB over the threshold
+  const double quiet = db2value(-40); // 10dB under the threshold
+  dyn.set_multiband(false);
+  dyn.set_rms(true);
+  band.threshold = thr;
+  band.ratio = ratio;
+  band.gain = 0;
+  dyn.set_band(0, band);
+
+  tone(buf, nch, noise_size, 3000, loud * sqrt(2.0));
+  dyn.reset();
+  run_filter(&dyn, buf, noise_size, &rng);
+
+  double out_db = value2db(rms(buf[0], noise_size / 2, noise_size, 3000));
+  double ref_db = thr + 20 / ratio;
+  log->msg("Static curve: %.2fdB (%.2fdB expected)", out_db, ref_db);
+  CHECK(fabs(out_db - ref_db) < 0.05);
+  CHECK(fabs(value2db(dyn.get_gain(0, 0)) - (ref_db - thr - 20)) < 0.05);
+
+  /////////////////////////////////////////////////////////
+  // Independent channels: loud tone at channel 0 only
+
+  for (int multiband = 0; multiband <= 1; multiband++)
+  {
+    dyn.set_multiband(multiband != 0);
+    for (int b = 0; b < Dynamics::nbands; b++)
+      dyn.set_band(b, band);
+
+    tone(buf, nch, noise_size, 1000, quiet);
+    for (size_t s = 0; s < noise_size; s++)
+      buf[0][s] *= 100;
+    tone(ref, nch, noise_size, 1000, quiet);
+
+    dyn.reset();
+    run_filter(&dyn, buf, noise_size, &rng);
+    // channel 0 is 27dB over the threshold and must be compressed by ~20dB
+    CHECK(peak(buf[0], noise_size / 2, noise_size) < 0.2);
+
+    // multiband output is delayed by the allpass, so the level is compared
+    for (ch = 1; ch < nch; ch++)
+    {
+      double err = value2db(rms(buf[ch], noise_size / 2, noise_size, 1000) * sqrt(2.0) / quiet);
+      CHECKT(fabs(err) < 0.01, ("Multiband %i: channel %i is changed by %.3fdB", multiband, ch, err));
+      if (!multiband)
+        CHECK(memcmp(buf[ch], ref[ch], noise_size * sizeof(sample_t)) == 0);
+    }
+  }
+
+  /////////////////////////////////////////////////////////
+  // Chunk size and SIMD
+
+  int old_mask = simd_get_mask();
+  for (int multiband = 0; multiband <= 1; multiband++)
+    for (int rms = 0; rms <= 1; rms++)
+    {
+      dyn.set_multiband(multiband != 0);
+      dyn.set_rms(rms != 0);
+
+      RNG noise(seed);
+      buf.allocate(nch, noise_size);
+      ref.allocate(nch, noise_size);
+      noise.fill_samples(buf[0], nch * noise_size);
+      for (size_t s = 0; s < nch * noise_size; s++)
+        buf[0][s] *= (s / 4096) & 1? 1.0: 0.01;
+      memcpy(ref[0], buf[0], nch * noise_size * sizeof(sample_t));
+
+      simd_set_mask(SIMD_NONE);
+      dyn.reset();
+      run_filter(&dyn, ref, noise_size, 0);
+      simd_set_mask(old_mask);
+      dyn.reset();
+      run_filter(&dyn, buf, noise_size, &rng);
+
+      double diff = 0;
+      for (size_t s = 0; s < nch * noise_size; s++)
+        diff = MAX(diff, fabs(buf[0][s] - ref[0][s]));
+      CHECKT(diff < eps, ("Multiband %i, rms %i: difference %g", multiband, rms, diff));
+    }
+
+  /////////////////////////////////////////////////////////
+  // AudioProcessor chain
+
+  char info[1024];
+  AudioProcessor proc(2048);
+  Speakers stereo(FORMAT_LINEAR, MODE_STEREO, 48000);
+  CHECK(proc.set_input(spk));
+  CHECK(proc.set_user(stereo));
+
+  proc.get_info(info, sizeof(info));
+  CHECK(strstr(info, "Mixer") && strstr(info, "Dynamics") &&
+        strstr(info, "Mixer") < strstr(info, "Dynamics"));
+
+  CHECK(proc.set_dynamics_pre_mixer(true));
+  proc.get_info(info, sizeof(info));
+  CHECK(strstr(info, "Dynamics") < strstr(info, "Mixer"));
+TEST_END(dynamics);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(dynamics_speed, "Dynamics filter speed test")
+  const int runs = 20;
+  const int nch = spk.nch();
+  SampleBuf buf(nch, noise_size);
+  RNG rng(seed);
+  Dynamics dyn;
+
+  CHECK(dyn.set_input(spk));
+  dyn.set_enabled(true);
+
+  for (int multiband = 0; multiband <= 1; multiband++)
+  {
+    dyn.set_multiband(multiband != 0);
+    rng.fill_samples(buf[0], nch * noise_size);
+
+    vtime_t time = local_time();
+    for (int run = 0; run < runs; run++)
+      run_filter(&dyn, buf, noise_size, 0);
+    time = local_time() - time;
+
+    log->msg("%s: %.1f Msamples/s", multiband? "3-band": "Wideband",
+      runs * noise_size * nch / time * 1e-6);
+  }
+TEST_END(dynamics_speed);
@@ -0,0 +1,263 @@
+/*
+  Mixer filter test
+  * SIMD mixing kernels must produce bit-identical result with the scalar
+    mixing functions for all input/output channel combinations, for both
+    in-place and buffered mixing.
+  * Mixing plan (sparse matrix processing) must produce the same result as
+    the full matrix multiplication.
+  * Upmix in the buffer negotiated by the filter chain must produce the same
+    result as buffered upmix.
+*/
+
+#include "filter_graph.h"
+#include "filters/convert.h"
+#include "filters/levels.h"
+#include "filters/mixer.h"
+#include "source/generator.h"
+#include "rng.h"
+#include "simd.h"
+#include "../../suite.h"
+
+static const int seed = 204872;
+static const size_t noise_size = 16 * 1024 + 3;
+static const size_t chunk_size = 4095; // not aligned to the vector size
+
+static const int modes[NCHANNELS] =
+{ MODE_1_0, MODE_2_0, MODE_3_0, MODE_2_2, MODE_3_2, MODE_5_1 };
+
+// Run the input through the mixer and store the result.
+// Input is copied for each chunk because the mixer may work in-place.
+
+static void mix(const SampleBuf &input, Speakers in_spk, Speakers out_spk, const matrix_t *matrix, SampleBuf &result)
+{
+  Mixer mixer(1024);
+  SampleBuf work(in_spk.nch(), chunk_size);
+  Chunk chunk;
+  int ch;
+
+  mixer.set_input(in_spk);
+  mixer.set_output(out_spk);
+  if (matrix)
+  {
+    mixer.set_auto_matrix(false);
+    mixer.set_matrix(*matrix);
+  }
+
+  result.allocate(out_spk.nch(), noise_size);
+  size_t in_pos = 0, out_pos = 0;
+
+  while (in_pos < noise_size)
+  {
+    size_t n = MIN(chunk_size, noise_size - in_pos);
+    for (ch = 0; ch < in_spk.nch(); ch++)
+      memcpy(work[ch], input[ch] + in_pos, n * sizeof(sample_t));
+    in_pos += n;
+
+    chunk.set_linear(in_spk, work, n);
+    mixer.process(&chunk);
+    while (!mixer.is_empty())
+    {
+      mixer.get_chunk(&chunk);
+      for (ch = 0; ch < out_spk.nch(); ch++)
+        memcpy(result[ch] + out_pos, chunk.samples[ch], chunk.size * sizeof(sample_t));
+      out_pos += chunk.size;
+    }
+  }
+}
+
+// Reference full matrix multiplication (unit levels and gains)
+
+static void mix_ref(const SampleBuf &input, Speakers in_spk, Speakers out_spk, const matrix_t &matrix, SampleBuf &result)
+{
+  const short int *in_order = in_spk.order();
+  const short int *out_order = out_spk.order();
+
+  result.allocate(out_spk.nch(), noise_size);
+  for (int o = 0; o < out_spk.nch(); o++)
+    for (size_t s = 0; s < noise_size; s++)
+    {
+      sample_t sum = input[0][s] * matrix[in_order[0]][out_order[o]];
+      for (int i = 1; i < in_spk.nch(); i++)
+        sum += input[i][s] * matrix[in_order[i]][out_order[o]];
+      result[o][s] = sum;
+    }
+}
+
+static void noise(RNG &rng, int nch, SampleBuf &buf)
+{
+  buf.allocate(nch, noise_size);
+  for (int ch = 0; ch < nch; ch++)
+    rng.fill_samples(buf[ch], noise_size);
+}
+
+static bool equal_bits(const SampleBuf &buf1, const SampleBuf &buf2)
+{
+  for (unsigned ch = 0; ch < buf1.nch(); ch++)
+    if (memcmp(buf1[ch], buf2[ch], buf1.nsamples() * sizeof(sample_t)))
+      return false;
+  return true;
+}
+
+static bool equal_values(const SampleBuf &buf1, const SampleBuf &buf2)
+{
+  // +0 and -0 are equal values but have different bits
+  for (unsigned ch = 0; ch < buf1.nch(); ch++)
+    for (size_t s = 0; s < buf1.nsamples(); s++)
+      if (buf1[ch][s] != buf2[ch][s])
+        return false;
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(mixer_simd, "Mixer SIMD kernels")
+  int i, j, in_ch, out_ch;
+  SampleBuf input, ref, test;
+  RNG rng(seed);
+
+  // Random dense matrix
+  matrix_t matrix;
+  for (i = 0; i < NCHANNELS; i++)
+    for (j = 0; j < NCHANNELS; j++)
+      matrix[i][j] = rng.get_sample();
+
+  int old_mask = simd_get_mask();
+  for (in_ch = 0; in_ch < NCHANNELS; in_ch++)
+    for (out_ch = 0; out_ch < NCHANNELS; out_ch++)
+    {
+      Speakers in_spk(FORMAT_LINEAR, modes[in_ch], 48000);
+      Speakers out_spk(FORMAT_LINEAR, modes[out_ch], 48000);
+      noise(rng, in_spk.nch(), input);
+
+      simd_set_mask(SIMD_NONE);
+      mix(input, in_spk, out_spk, 0, ref);
+      simd_set_mask(old_mask);
+      mix(input, in_spk, out_spk, 0, test);
+      CHECKT(equal_bits(ref, test), ("Auto matrix %s -> %s: SIMD result differs", in_spk.mode_text(), out_spk.mode_text()));
+
+      simd_set_mask(SIMD_NONE);
+      mix(input, in_spk, out_spk, &matrix, ref);
+      simd_set_mask(old_mask);
+      mix(input, in_spk, out_spk, &matrix, test);
+      CHECKT(equal_bits(ref, test), ("Dense matrix %s -> %s: SIMD result differs", in_spk.mode_text(), out_spk.mode_text()));
+    }
+
+TEST_END(mixer_simd);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(mixer_plan, "Mixer sparse matrix processing")
+  int i, j, in_ch, out_ch, iter;
+  SampleBuf input, ref, test;
+  RNG rng(seed);
+  matrix_t matrix;
+
+  for (in_ch = 0; in_ch < NCHANNELS; in_ch++)
+    for (out_ch = 0; out_ch < NCHANNELS; out_ch++)
+    {
+      Speakers in_spk(FORMAT_LINEAR, modes[in_ch], 48000);
+      Speakers out_spk(FORMAT_LINEAR, modes[out_ch], 48000);
+      noise(rng, in_spk.nch(), input);
+
+      // Identity: pass-through, copy and zero channels
+      matrix.identity();
+      mix_ref(input, in_spk, out_spk, matrix, ref);
+      mix(input, in_spk, out_spk, &matrix, test);
+      CHECKT(equal_values(ref, test), ("Identity matrix %s -> %s: result differs", in_spk.mode_text(), out_spk.mode_text()));
+
+      // Swap channels: cyclic dependency at in-place mixing
+      matrix.zero();
+      for (i = 0; i < NCHANNELS; i++)
+        matrix[i][NCHANNELS - i - 1] = 1.0;
+      mix_ref(input, in_spk, out_spk, matrix, ref);
+      mix(input, in_spk, out_spk, &matrix, test);
+      CHECKT(equal_values(ref, test), ("Swap matrix %s -> %s: result differs", in_spk.mode_text(), out_spk.mode_text()));
+
+      // Random sparse matrices with unit and zero elements
+      for (iter = 0; iter < 16; iter++)
+      {
+        for (i = 0; i < NCHANNELS; i++)
+          for (j = 0; j < NCHANNELS; j++)
+          {
+            uint32_t r = rng.next() % 10;
+            if (r < 5)
+              matrix[i][j] = 0;
+            else if (r < 7)
+              matrix[i][j] = 1.0;
+            else
+              matrix[i][j] = rng.get_sample();
+          }
+
+        mix_ref(input, in_spk, out_spk, matrix, ref);
+        mix(input, in_spk, out_spk, &matrix, test);
+        CHECKT(equal_values(ref, test), ("Sparse matrix %s -> %s: result differs", in_spk.mode_text(), out_spk.mode_text()));
+      }
+    }
+
+TEST_END(mixer_plan);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(mixer_negotiate, "Mixer in-place upmix with buffer negotiation")
+  // Converter -> Levels -> Mixer: converter reserves channels for the mixer.
+  // Converter -> NullFilter -> Mixer: NullFilter works in-place but does not
+  // report it, so the mixer must use its own buffer (reference).
+  static const int in_modes[] = { MODE_1_0, MODE_STEREO, MODE_2_2, MODE_3_2 };
+  const size_t stream_len = 64 * 1024 + 7;
+
+  RNG rng(seed);
+  matrix_t matrix;
+
+  for (int i = 0; i < array_size(in_modes); i++)
+    for (int r = 0; r < 2; r++)
+    {
+      Speakers in_spk(FORMAT_PCM16, in_modes[i], 48000);
+      Speakers out_spk(FORMAT_LINEAR, MODE_5_1, 48000);
+
+      Converter conv(2048), ref_conv(2048);
+      Levels levels;
+      NullFilter barrier(FORMAT_MASK_LINEAR);
+      Mixer mixer(1024), ref_mixer(1024);
+
+      conv.set_format(FORMAT_LINEAR);
+      ref_conv.set_format(FORMAT_LINEAR);
+      mixer.set_output(out_spk);
+      ref_mixer.set_output(out_spk);
+
+      // Auto matrix and random dense matrix
+      if (r)
+      {
+        for (int j = 0; j < NCHANNELS; j++)
+          for (int k = 0; k < NCHANNELS; k++)
+            matrix[j][k] = rng.get_sample();
+        mixer.set_auto_matrix(false);
+        mixer.set_matrix(matrix);
+        ref_mixer.set_auto_matrix(false);
+        ref_mixer.set_matrix(matrix);
+      }
+
+      FilterChain chain, ref_chain;
+      chain.add_back(&conv, "Converter");
+      chain.add_back(&levels, "Levels");
+      chain.add_back(&mixer, "Mixer");
+      ref_chain.add_back(&ref_conv, "Converter");
+      ref_chain.add_back(&barrier, "NullFilter");
+      ref_chain.add_back(&ref_mixer, "Mixer");
+
+      size_t data_size = stream_len * in_spk.nch() * in_spk.sample_size();
+      NoiseGen src(in_spk, seed, data_size, 5000);
+      NoiseGen ref(in_spk, seed, data_size, 5000);
+      CHECK(compare(log, &src, &chain, &ref, &ref_chain) == 0);
+
+      CHECKT(!mixer.is_buffered() && ref_mixer.is_buffered(),
+        ("%s -> %s: buffer was not negotiated", in_spk.mode_text(), out_spk.mode_text()));
+    }
+TEST_END(mixer_negotiate);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(mixer, "Mixer test")
+  TEST_FACTORY(mixer_simd),
+  TEST_FACTORY(mixer_plan),
+  TEST_FACTORY(mixer_negotiate),
+SUITE_END;
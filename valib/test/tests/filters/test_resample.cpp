@@ -1,6 +1,8 @@
 /*
   Resample filter test
   * Test that backward transform is equal to the bandlimited original signal
+  * Test that SIMD convolution stage gives the same result as the scalar one
+  * Speed test: SIMD vs scalar convolution stage for common rates
 */
 
 #include "source/generator.h"
@@ -9,6 +11,7 @@
 #include "filters/slice.h"
 #include "filter_graph.h"
 #include "fir/param_fir.h"
+#include "simd.h"
 #include "../../suite.h"
 
 
@@ -143,6 +146,93 @@ TestResult up_down(Log *log, int rate1, int rate2, double a, double q)
   return test_passed;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// SIMD vs scalar convolution stage
+// SIMD kernels sum in a different order, so results are not bit-exact.
+
+static const int simd_rates[][2] =
+{
+  { 44100, 48000 },
+  { 48000, 44100 },
+  { 44100, 96000 },
+};
+
+static void resample_noise(int rate1, int rate2, int mask, size_t len, SampleBuf &result)
+{
+  Speakers spk(FORMAT_LINEAR, MODE_5_1, rate1);
+  NoiseGen noise(spk, seed, len);
+  Resample res(rate2);
+  Chunk chunk;
+  size_t pos = 0;
+
+  int old_mask = simd_get_mask();
+  simd_set_mask(mask);
+
+  res.set_input(spk);
+  result.allocate(spk.nch(), len * rate2 / rate1 + 1);
+  while (!noise.is_empty())
+  {
+    noise.get_chunk(&chunk);
+    res.process(&chunk);
+    while (!res.is_empty())
+    {
+      res.get_chunk(&chunk);
+      size_t n = MIN(chunk.size, result.nsamples() - pos);
+      for (int ch = 0; ch < spk.nch(); ch++)
+        memcpy(result[ch] + pos, chunk.samples[ch], n * sizeof(sample_t));
+      pos += n;
+    }
+  }
+
+  simd_set_mask(old_mask);
+}
+
+TEST(resample_simd, "Resample SIMD convolution stage")
+  const sample_t max_diff = sizeof(sample_t) == sizeof(float)? 1e-5: 1e-12;
+  SampleBuf ref, test;
+
+  for (int i = 0; i < array_size(simd_rates); i++)
+  {
+    resample_noise(simd_rates[i][0], simd_rates[i][1], SIMD_NONE, block_size, ref);
+    resample_noise(simd_rates[i][0], simd_rates[i][1], SIMD_ALL, block_size, test);
+
+    sample_t diff = 0;
+    for (unsigned ch = 0; ch < ref.nch(); ch++)
+      for (size_t s = 0; s < ref.nsamples(); s++)
+        diff = MAX(diff, fabs(ref[ch][s] - test[ch][s]));
+
+    CHECKT(diff < max_diff, ("%iHz -> %iHz: SIMD result differs by %g", simd_rates[i][0], simd_rates[i][1], diff));
+  }
+TEST_END(resample_simd);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(resample_speed, "Resample speed test (5.1, 10 sec)")
+  SampleBuf buf;
+
+  for (int i = 0; i < array_size(simd_rates); i++)
+  {
+    int rate1 = simd_rates[i][0];
+    int rate2 = simd_rates[i][1];
+    size_t len = rate1 * 10;
+
+    vtime_t time = local_time();
+    resample_noise(rate1, rate2, SIMD_NONE, len, buf);
+    vtime_t scalar_time = local_time() - time;
+
+    time = local_time();
+    resample_noise(rate1, rate2, SIMD_ALL, len, buf);
+    vtime_t simd_time = local_time() - time;
+
+    log->msg("%5iHz -> %5iHz: scalar %.3fs (x%.0f realtime), SIMD %.3fs (x%.0f realtime)",
+      rate1, rate2, scalar_time, 10 / scalar_time, simd_time, 10 / simd_time);
+  }
+TEST_END(resample_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
 SUITE(resample, "Resample filter test")
   TEST_FACTORY(resample_reverse),
+  TEST_FACTORY(resample_simd),
 SUITE_END;
@@ -0,0 +1,266 @@
+/*
+  AC3 bit allocation test
+  (defined at parsers/ac3/ac3_bitalloc.h)
+
+  * BitAlloc must give the same bap as the reference bit_alloc() for a
+    sequence of blocks where some of the inputs change and some do not.
+    It must report (return true) every change of bap. Checked for both
+    SIMD and scalar code.
+  * BitAlloc::compute_bap() must match bit_alloc() for any SNR offset.
+  * Speed test: reference vs BitAlloc for a 5.1 stream with reused
+    exponents and for the stream with new exponents at each block.
+*/
+
+#include <string.h>
+#include "spk.h"
+#include "parsers/ac3/ac3_defs.h"
+#include "parsers/ac3/ac3_bitalloc.h"
+#include "parsers/ac3/ac3_tables.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+#define DELTA_BIT_NONE 2
+
+static const int seed = 914627;
+static const int blocks = 20000;
+
+// Bit allocation parameters of a channel
+struct BAParams
+{
+  int8_t exp[256];
+  int    deltbae;
+  int8_t deltba[50];
+  int    start, end;
+  int    fscod, halfratecod;
+  int    sdecay, fdecay, sgain, fgain, dbknee, floor;
+  int    fastleak, slowleak;
+  int    snroffset;
+
+  void random_exp(RNG &rng)
+  {
+    // Exponents are coded as differences -2..2
+    int e = rng.next() % 25;
+    for (int i = 0; i < 256; i++)
+    {
+      e += rng.next() % 5 - 2;
+      e = MAX(0, MIN(24, e));
+      exp[i] = e;
+    }
+  }
+
+  void random_range(RNG &rng)
+  {
+    switch (rng.next() % 3)
+    {
+      case 0: // fbw channel
+        start = 0;
+        end = (rng.next() % 61) * 3 + 73;
+        fastleak = slowleak = 0;
+        break;
+
+      case 1: // coupling channel
+        start = (rng.next() % 16) * 12 + 37;
+        end = start + (rng.next() % ((253 - start) / 12) + 1) * 12;
+        fastleak = (int(rng.next() % 8) << 8) + 768;
+        slowleak = (int(rng.next() % 8) << 8) + 768;
+        break;
+
+      default: // lfe channel
+        start = 0;
+        end = 7;
+        fastleak = slowleak = 0;
+        break;
+    }
+  }
+
+  void random_params(RNG &rng)
+  {
+    fscod  = rng.next() % 3;
+    halfratecod = 0;
+    sdecay = sdecay_tbl[rng.next() % 4];
+    fdecay = fdecay_tbl[rng.next() % 4];
+    sgain  = sgain_tbl[rng.next() % 4];
+    dbknee = dbknee_tbl[rng.next() % 4];
+    floor  = floor_tbl[rng.next() % 8];
+    fgain  = fgain_tbl[rng.next() % 8];
+  }
+
+  void random_snroffset(RNG &rng)
+  {
+    int csnroffst = rng.next() % 64;
+    int fsnroffst = rng.next() % 16;
+    snroffset = (((csnroffst - 15) << 4) + fsnroffst) << 2;
+  }
+
+  void random_deltba(RNG &rng)
+  {
+    deltbae = rng.next() % 4;
+    memset(deltba, 0, sizeof(deltba));
+    for (int i = rng.next() % 50; i < 50; i += rng.next() % 8 + 1)
+      deltba[i] = int8_t((int(rng.next() % 8) - 4) << 4);
+  }
+
+  void init(RNG &rng)
+  {
+    random_exp(rng);
+    random_range(rng);
+    random_params(rng);
+    random_snroffset(rng);
+    random_deltba(rng);
+  }
+
+  // Change some of the parameters
+  void change(RNG &rng)
+  {
+    switch (rng.next() % 8)
+    {
+      case 0: random_exp(rng); break;
+      case 1: random_range(rng); break;
+      case 2: random_params(rng); break;
+      case 3: random_snroffset(rng); break;
+      case 4: random_deltba(rng); break;
+      case 5: exp[rng.next() % 256] ^= 1; break;
+      default: break; // nothing changed
+    }
+  }
+
+  void ref(int8_t *bap)
+  {
+    bit_alloc(bap, exp, deltbae, deltba, start, end, fscod, halfratecod,
+      sdecay, fdecay, sgain, fgain, dbknee, floor, fastleak, slowleak, snroffset);
+  }
+
+  bool test(BitAlloc &ba, int8_t *bap)
+  {
+    return ba.compute(bap, exp, deltbae, deltba, start, end, fscod, halfratecod,
+      sdecay, fdecay, sgain, fgain, dbknee, floor, fastleak, slowleak, snroffset);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(ac3_bitalloc_incremental, "BitAlloc vs reference bit allocation")
+  int8_t ref[256], old_ref[256];
+  int8_t bap[2][256];
+  BitAlloc ba[2];
+  BAParams p;
+  RNG rng(seed);
+
+  int old_mask = simd_get_mask();
+  memset(ref, 0, sizeof(ref));
+  p.init(rng);
+
+  for (int block = 0; block < blocks; block++)
+  {
+    if (block)
+      p.change(rng);
+
+    memcpy(old_ref, ref, sizeof(ref));
+    p.ref(ref);
+    bool changed = memcmp(ref + p.start, old_ref + p.start, p.end - p.start) != 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      bool recomputed = p.test(ba[pass], bap[pass]);
+      CHECKT(memcmp(ref + p.start, bap[pass] + p.start, p.end - p.start) == 0,
+        ("Block %i (%s): bap differs", block, pass? "SIMD": "scalar"));
+      CHECKT(recomputed || !changed || block == 0,
+        ("Block %i (%s): bap change was not reported", block, pass? "SIMD": "scalar"));
+    }
+  }
+  simd_set_mask(old_mask);
+TEST_END(ac3_bitalloc_incremental);
+
+TEST(ac3_bitalloc_snr, "BitAlloc::compute_bap() for all SNR offsets")
+  int8_t ref[256];
+  int8_t bap[2][256];
+  BitAlloc ba;
+  BAParams p;
+  RNG rng(seed);
+
+  int old_mask = simd_get_mask();
+  for (int i = 0; i < 100; i++)
+  {
+    p.init(rng);
+    p.test(ba, bap[0]);
+
+    for (int csnroffst = 0; csnroffst < 64; csnroffst++)
+    {
+      p.snroffset = (((csnroffst - 15) << 4) + int(rng.next() % 16)) << 2;
+      p.ref(ref);
+      for (int pass = 0; pass < 2; pass++)
+      {
+        simd_set_mask(pass? old_mask: SIMD_NONE);
+        ba.compute_bap(bap[pass], p.floor, p.snroffset);
+        CHECKT(memcmp(ref + p.start, bap[pass] + p.start, p.end - p.start) == 0,
+          ("Set %i, snroffset = %i (%s): bap differs", i, p.snroffset, pass? "SIMD": "scalar"));
+      }
+    }
+  }
+  simd_set_mask(old_mask);
+TEST_END(ac3_bitalloc_snr);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+// 5 fbw channels and lfe, 6 blocks per frame. Bit allocation info and SNR
+// offsets are sent at each block (worst case for the decoder). Exponents
+// are new at block 0 only (reuse) or at each block (new).
+
+TEST(ac3_bitalloc_speed, "AC3 bit allocation speed test")
+  const int frames = 2000;
+  const int nch = 6;
+  BAParams p[nch][2];
+  int8_t bap[nch][256];
+  BitAlloc ba[nch];
+  int frame, b, ch;
+
+  RNG rng(seed);
+  for (ch = 0; ch < nch; ch++)
+    for (int i = 0; i < 2; i++)
+    {
+      p[ch][i].init(rng);
+      p[ch][i].deltbae = DELTA_BIT_NONE;
+      p[ch][i].start = 0;
+      p[ch][i].end = ch < nch - 1? 253: 7;
+      p[ch][i].fastleak = p[ch][i].slowleak = 0;
+    }
+
+  for (int reuse = 1; reuse >= 0; reuse--)
+  {
+    const char *name = reuse? "reuse": "new";
+
+    vtime_t time = local_time();
+    for (frame = 0; frame < frames; frame++)
+      for (b = 0; b < AC3_NBLOCKS; b++)
+        for (ch = 0; ch < nch; ch++)
+          p[ch][reuse? 0: b & 1].ref(bap[ch]);
+    time = local_time() - time;
+    log->msg("Reference: %-5s %.0f frames/s", name, frames / time);
+
+    int old_mask = simd_get_mask();
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      for (ch = 0; ch < nch; ch++)
+        ba[ch].reset();
+
+      time = local_time();
+      for (frame = 0; frame < frames; frame++)
+        for (b = 0; b < AC3_NBLOCKS; b++)
+          for (ch = 0; ch < nch; ch++)
+            p[ch][reuse? 0: b & 1].test(ba[ch], bap[ch]);
+      time = local_time() - time;
+      log->msg("%-10s %-5s %.0f frames/s", pass? "SIMD:": "Scalar:", name, frames / time);
+    }
+    simd_set_mask(old_mask);
+  }
+TEST_END(ac3_bitalloc_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(ac3_bitalloc, "AC3 bit allocation test")
+  TEST_FACTORY(ac3_bitalloc_incremental),
+  TEST_FACTORY(ac3_bitalloc_snr),
+SUITE_END;
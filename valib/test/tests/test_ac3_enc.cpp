@@ -0,0 +1,314 @@
+/*
+  AC3 encoder test
+  (classes defined at parsers/ac3/ac3_mdct.h and parsers/ac3/ac3_enc.h)
+
+  * MDCT must match the direct formula. SIMD and scalar kernels must give
+    identical results.
+  * Encode-decode: encoded stream is decoded with AC3Parser and compared with
+    the source (encoder delay is 256 samples, LFE is not compared). SIMD and
+    scalar encoders must produce identical streams.
+  * Threads: streams encoded with several threads and with batch encoding
+    (mixed with the filter interface) must be identical to the stream
+    encoded with one thread.
+  * Speed test: encoded frames/s for 5.1 640kbps, scalar and SIMD, and
+    batch encoding with all processors. Real-time rate for 48kHz is
+    31.25 frames/s.
+*/
+
+#include <math.h>
+#include "parsers/ac3/ac3_enc.h"
+#include "parsers/ac3/ac3_header.h"
+#include "parsers/ac3/ac3_mdct.h"
+#include "parsers/ac3/ac3_parser.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+#ifdef FLOAT_SAMPLE
+static const double max_err = 1e-4;
+#else
+static const double max_err = 1e-10;
+#endif
+
+static const int seed = 583201;
+static const int blocks = 1000;
+
+///////////////////////////////////////////////////////////////////////////////
+
+static void ref_mdct512(const sample_t *data, double *coef)
+{
+  const int N = 512;
+  for (int k = 0; k < N/2; k++)
+  {
+    double sum = 0;
+    for (int n = 0; n < N; n++)
+      sum += data[n] * cos((2*M_PI) / (4*N) * (2*n+1) * (2*k+1) + M_PI/4 * (2*k+1));
+    coef[k] = sum * -2.0 / N;
+  }
+}
+
+TEST(ac3_enc_mdct, "MDCT vs direct formula")
+  sample_t data[512];
+  sample_t test[2][256];
+  double ref[256];
+  MDCT mdct;
+  RNG rng(seed);
+
+  int old_mask = simd_get_mask();
+  for (int block = 0; block < blocks; block++)
+  {
+    rng.fill_samples(data, 512);
+    ref_mdct512(data, ref);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      mdct.mdct512(test[pass], data);
+    }
+    simd_set_mask(old_mask);
+
+    double diff = 0;
+    for (int i = 0; i < 256; i++)
+      diff = MAX(diff, fabs(ref[i] - test[0][i]));
+
+    CHECKT(diff < max_err, ("Block %i: diff = %g", block, diff));
+    CHECKT(memcmp(test[0], test[1], sizeof(test[0])) == 0,
+      ("Block %i: SIMD and scalar results differ", block));
+  }
+TEST_END(ac3_enc_mdct);
+
+///////////////////////////////////////////////////////////////////////////////
+// Encode-decode test
+
+static void make_source(SampleBuf &src, Speakers spk, int frames)
+{
+  RNG rng(seed);
+  src.allocate(spk.nch(), AC3_FRAME_SAMPLES * frames);
+  for (int ch = 0; ch < spk.nch(); ch++)
+    for (int i = 0; i < AC3_FRAME_SAMPLES * frames; i++)
+      src[ch][i] = (rng.get_sample() * 0.05 + 0.4 * sin(i * 0.013 * (ch + 1)) + 0.2 * sin(i * 0.31 * (ch + 1))) * spk.level;
+}
+
+// Encodes source into the stream. Returns number of frames encoded.
+static int encode(Rawdata &stream, size_t &size, const SampleBuf &src, Speakers spk, int bitrate, int frames, int threads = 1)
+{
+  AC3Enc enc;
+  if (!enc.set_threads(threads) || !enc.set_bitrate(bitrate) || !enc.set_input(spk))
+    return 0;
+
+  int nframes = 0;
+  size = 0;
+  stream.allocate(frames * AC3_MAX_FRAME_SIZE);
+
+  Chunk chunk;
+  samples_t in;
+  for (int frame = 0; frame < frames; frame++)
+  {
+    for (int ch = 0; ch < spk.nch(); ch++)
+      in[ch] = src[ch] + frame * AC3_FRAME_SAMPLES;
+
+    Chunk c(spk, in, AC3_FRAME_SAMPLES);
+    if (!enc.process(&c))
+      return 0;
+
+    while (!enc.is_empty())
+    {
+      if (!enc.get_chunk(&chunk))
+        return 0;
+      if (chunk.size)
+      {
+        memcpy(stream.data() + size, chunk.rawdata, chunk.size);
+        size += chunk.size;
+        nframes++;
+      }
+    }
+  }
+  return nframes;
+}
+
+static int ac3_encdec(Log *log, Speakers spk, int bitrate, double min_snr)
+{
+  const int frames = 200;
+  const int delay = 256;
+
+  SampleBuf src;
+  make_source(src, spk, frames);
+
+  int old_mask = simd_get_mask();
+  Rawdata stream[2];
+  size_t size[2];
+  int nframes[2];
+  for (int pass = 0; pass < 2; pass++)
+  {
+    simd_set_mask(pass? old_mask: SIMD_NONE);
+    nframes[pass] = encode(stream[pass], size[pass], src, spk, bitrate, frames);
+  }
+  simd_set_mask(old_mask);
+
+  if (nframes[0] != frames)
+    return log->err("%s %ikbps: %i frames encoded of %i", spk.mode_text(), bitrate / 1000, nframes[0], frames);
+  if (size[0] != size[1] || memcmp(stream[0], stream[1], size[0]))
+    return log->err("%s %ikbps: SIMD and scalar streams differ", spk.mode_text(), bitrate / 1000);
+
+  // Decode and compare (first frames are skipped)
+
+  AC3Parser dec;
+  dec.do_dither = false;
+
+  int nch = spk.lfe()? spk.nch() - 1: spk.nch();
+  double signal = 0, noise = 0;
+  uint8_t *frame = stream[0];
+  for (int i = 0; i < frames; i++)
+  {
+    HeaderInfo hinfo;
+    if (!ac3_header.parse_header(frame, &hinfo) || !dec.parse_frame(frame, hinfo.frame_size))
+      return log->err("%s %ikbps: cannot decode frame %i", spk.mode_text(), bitrate / 1000, i);
+    frame += hinfo.frame_size;
+
+    if (i < 2)
+      continue;
+
+    samples_t out = dec.get_samples();
+    for (int ch = 0; ch < nch; ch++)
+      for (int s = 0; s < AC3_FRAME_SAMPLES; s++)
+      {
+        double x = src[ch][i * AC3_FRAME_SAMPLES + s - delay] / spk.level;
+        double d = out[ch][s] / spk.level - x;
+        signal += x * x;
+        noise += d * d;
+      }
+  }
+
+  double snr = 10 * log10(signal / noise);
+  log->msg("%s %ikbps: SNR = %.1fdB", spk.mode_text(), bitrate / 1000, snr);
+  if (snr < min_snr)
+    return log->err("%s %ikbps: SNR is too low", spk.mode_text(), bitrate / 1000);
+  return 0;
+}
+
+TEST(ac3_enc, "AC3 encode-decode")
+  ac3_encdec(log, Speakers(FORMAT_LINEAR, MODE_5_1, 48000), 640000, 20);
+  ac3_encdec(log, Speakers(FORMAT_LINEAR, MODE_STEREO, 48000), 192000, 18);
+TEST_END(ac3_enc);
+
+///////////////////////////////////////////////////////////////////////////////
+// Threads and batch encoding
+
+TEST(ac3_enc_threads, "AC3 encoder threads and batch encoding")
+  const int frames = 50;
+  const int bitrate = 448000;
+  Speakers spk(FORMAT_LINEAR, MODE_5_1, 48000);
+  int i;
+
+  SampleBuf src;
+  make_source(src, spk, frames);
+
+  Rawdata ref;
+  size_t ref_size;
+  CHECK(encode(ref, ref_size, src, spk, bitrate, frames) == frames);
+
+  // Channels encoded by several threads
+  static const int threads[] = { 2, 3, 4 };
+  for (i = 0; i < array_size(threads); i++)
+  {
+    Rawdata stream;
+    size_t size;
+    int nframes = encode(stream, size, src, spk, bitrate, frames, threads[i]);
+    CHECKT(nframes == frames && size == ref_size && memcmp(stream, ref, size) == 0,
+      ("%i threads: streams differ", threads[i]));
+  }
+
+  // Batches of different size, the rest of frames with the filter interface
+  static const int batch_threads[] = { 1, 2, 3, 5 };
+  static const size_t batch[] = { 1, 7, 2, 16 };
+  for (i = 0; i < array_size(batch_threads); i++)
+  {
+    AC3Enc enc;
+    CHECK(enc.set_threads(batch_threads[i]) && enc.set_bitrate(bitrate) && enc.set_input(spk));
+
+    size_t frame_size = enc.get_frame_size();
+    Rawdata stream(frames * frame_size);
+    samples_t in = src;
+    size_t nframes = 0;
+    for (int j = 0; j < array_size(batch); j++)
+    {
+      CHECKT(enc.encode_frames(in, batch[j], stream + nframes * frame_size) == batch[j],
+        ("%i threads: cannot encode a batch of %i frames", batch_threads[i], int(batch[j])));
+      in += batch[j] * AC3_FRAME_SAMPLES;
+      nframes += batch[j];
+    }
+
+    Chunk chunk;
+    Chunk c(spk, in, (frames - nframes) * AC3_FRAME_SAMPLES);
+    CHECK(enc.process(&c));
+    while (!enc.is_empty())
+    {
+      CHECK(enc.get_chunk(&chunk));
+      if (chunk.size && nframes < frames)
+        memcpy(stream + frame_size * nframes++, chunk.rawdata, chunk.size);
+    }
+
+    CHECKT(nframes == frames && frames * frame_size == ref_size && memcmp(stream, ref, ref_size) == 0,
+      ("%i threads: batch encoding differs", batch_threads[i]));
+  }
+TEST_END(ac3_enc_threads);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(ac3_enc_speed, "AC3 encoder speed test")
+  const int frames = 64;
+  const int runs = 30;
+  Speakers spk(FORMAT_LINEAR, MODE_5_1, 48000);
+
+  SampleBuf src;
+  make_source(src, spk, frames);
+
+  int old_mask = simd_get_mask();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    simd_set_mask(pass? old_mask: SIMD_NONE);
+
+    AC3Enc enc;
+    enc.set_bitrate(640000);
+    enc.set_input(spk);
+
+    Chunk chunk;
+    samples_t in;
+    int nframes = 0;
+    vtime_t time = local_time();
+    for (int run = 0; run < runs; run++)
+      for (int frame = 0; frame < frames; frame++)
+      {
+        for (int ch = 0; ch < spk.nch(); ch++)
+          in[ch] = src[ch] + frame * AC3_FRAME_SAMPLES;
+
+        Chunk c(spk, in, AC3_FRAME_SAMPLES);
+        enc.process(&c);
+        while (!enc.is_empty())
+          if (enc.get_chunk(&chunk) && chunk.size)
+            nframes++;
+      }
+    time = local_time() - time;
+
+    log->msg("%-6s 5.1 640kbps: %.0f frames/s (%.0fx real-time)", pass? "SIMD": "Scalar",
+      nframes / time, nframes / time / (48000.0 / AC3_FRAME_SAMPLES));
+  }
+  simd_set_mask(old_mask);
+
+  // Batch encoding
+  AC3Enc enc;
+  enc.set_threads(0);
+  enc.set_bitrate(640000);
+  enc.set_input(spk);
+
+  Rawdata out(frames * enc.get_frame_size());
+  int nframes = 0;
+  vtime_t time = local_time();
+  for (int run = 0; run < runs; run++)
+    nframes += (int)enc.encode_frames(src, frames, out);
+  time = local_time() - time;
+
+  log->msg("Batch  5.1 640kbps, %i threads: %.0f frames/s (%.0fx real-time)", enc.get_threads(),
+    nframes / time, nframes / time / (48000.0 / AC3_FRAME_SAMPLES));
+TEST_END(ac3_enc_speed);
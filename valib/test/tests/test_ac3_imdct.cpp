@@ -0,0 +1,152 @@
+/*
+  AC3 IMDCT test
+  (class defined at parsers/ac3/ac3_imdct.h)
+
+  * Long and short block transforms must match liba52 (test/liba52/imdct.c)
+    for a sequence of blocks (overlap-add state is compared as well).
+    Output of IMDCT is scaled by 2 compared to liba52.
+  * SIMD and scalar kernels must give identical results.
+  * Speed test: liba52 vs IMDCT (blocks/ms).
+*/
+
+#include <math.h>
+#include "parsers/ac3/ac3_imdct.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+#ifdef LIBA52_DOUBLE
+typedef double a52_sample_t;
+#else
+typedef float a52_sample_t;
+#endif
+
+#if defined(LIBA52_DOUBLE) && !defined(FLOAT_SAMPLE)
+static const double max_err = 1e-10;
+#else
+static const double max_err = 1e-4;
+#endif
+
+extern "C" void a52_imdct_init(uint32_t mm_accel);
+extern "C" void a52_imdct_512(a52_sample_t *data, a52_sample_t *delay, a52_sample_t bias);
+extern "C" void a52_imdct_256(a52_sample_t *data, a52_sample_t *delay, a52_sample_t bias);
+
+static const int seed = 274593;
+static const int blocks = 1000;
+
+class A52IMDCT
+{
+public:
+  a52_sample_t data[256];
+  a52_sample_t delay[256];
+
+  A52IMDCT()
+  {
+    a52_imdct_init(0);
+    memset(delay, 0, sizeof(delay));
+  }
+
+  void imdct(const sample_t *coef, bool short_block, sample_t *result)
+  {
+    int i;
+    for (i = 0; i < 256; i++)
+      data[i] = a52_sample_t(coef[i]);
+
+    if (short_block)
+      a52_imdct_256(data, delay, 0);
+    else
+      a52_imdct_512(data, delay, 0);
+
+    for (i = 0; i < 256; i++)
+      result[i] = sample_t(data[i] * 2);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(ac3_imdct_a52, "IMDCT vs liba52")
+  sample_t coef[256];
+  sample_t ref[256];
+  sample_t test[2][256];
+  sample_t delay[2][256];
+  IMDCT imdct;
+  A52IMDCT a52;
+  RNG rng(seed);
+
+  int old_mask = simd_get_mask();
+  memset(delay, 0, sizeof(delay));
+
+  for (int block = 0; block < blocks; block++)
+  {
+    // Long and short blocks in random order. Short blocks are
+    // transients: bursts of them.
+    bool short_block = (block / 4) % 3 == 1 && (rng.next() & 1);
+    rng.fill_samples(coef, 256);
+    a52.imdct(coef, short_block, ref);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      memcpy(test[pass], coef, sizeof(coef));
+      if (short_block)
+        imdct.imdct_256(test[pass], delay[pass]);
+      else
+        imdct.imdct_512(test[pass], delay[pass]);
+    }
+    simd_set_mask(old_mask);
+
+    double diff = 0;
+    for (int i = 0; i < 256; i++)
+      diff = MAX(diff, fabs(ref[i] - test[0][i]));
+
+    CHECKT(diff < max_err, ("Block %i (%s): diff = %g", block, short_block? "short": "long", diff));
+    CHECKT(memcmp(test[0], test[1], sizeof(test[0])) == 0 && memcmp(delay[0], delay[1], sizeof(delay[0])) == 0,
+      ("Block %i (%s): SIMD and scalar results differ", block, short_block? "short": "long"));
+  }
+TEST_END(ac3_imdct_a52);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(ac3_imdct_speed, "AC3 IMDCT speed test")
+  const int runs = 200000;
+  sample_t coef[256];
+  sample_t data[256];
+  sample_t delay[256];
+  int i;
+
+  RNG rng(seed);
+  rng.fill_samples(coef, 256);
+  memset(delay, 0, sizeof(delay));
+
+  for (int short_block = 0; short_block < 2; short_block++)
+  {
+    const char *name = short_block? "short": "long";
+
+    A52IMDCT a52;
+    vtime_t time = local_time();
+    for (i = 0; i < runs; i++)
+      a52.imdct(coef, short_block != 0, data);
+    time = local_time() - time;
+    log->msg("liba52 %-6s %.0f blocks/ms", name, runs / time * 1e-3);
+
+    IMDCT imdct;
+    int old_mask = simd_get_mask();
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      time = local_time();
+      for (i = 0; i < runs; i++)
+      {
+        memcpy(data, coef, sizeof(coef));
+        if (short_block)
+          imdct.imdct_256(data, delay);
+        else
+          imdct.imdct_512(data, delay);
+      }
+      time = local_time() - time;
+      log->msg("%-6s %-6s %.0f blocks/ms", pass? "SIMD": "Scalar", name, runs / time * 1e-3);
+    }
+    simd_set_mask(old_mask);
+  }
+TEST_END(ac3_imdct_speed);
@@ -3,7 +3,9 @@
   (classes defined at bitstream.h)
 
   * ReadBS
+  * ReadBS: peek(), skip(), get_n() and the end of the stream
   * WriteBS
+  * Speed test: 64 bit cached ReadBS vs 32 bit word reader (bits/ns)
 
 */
 
@@ -180,6 +182,111 @@ TEST(bitstream_read, "ReadBS")
 
 TEST_END(bitstream_read);
 
+///////////////////////////////////////////////////////////////////////////////
+// ReadBS extensions test
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(bitstream_read_ext, "ReadBS peek/skip/get_n")
+  ReadBS bs;
+  uint32_t result, test;
+
+  const size_t buf_size = 256;
+  AutoBuf<uint8_t> buf(buf_size + 4);
+
+  RNG rng(seed);
+  rng.fill_raw(buf, buf.size());
+
+  /////////////////////////////////////////////////////////
+  // ReadBS::peek()
+  // Must not move the position
+
+  {
+    for (unsigned i = 0; i <= 32; i++)
+      for (unsigned j = 0; j <= 32; j++)
+      {
+        bs.set(buf, 0, 64);
+        bs.get(i);
+        result = bs.peek(j);
+        test = j? get_uint32(buf, i) >> (32 - j): 0;
+        CHECKT(result == test, ("bs.get(%i); bs.peek(%i); sequence fails", i, j));
+        CHECKT(bs.get_pos_bits() == i, ("bs.peek(%i) changes the position", j));
+      }
+  }
+
+  /////////////////////////////////////////////////////////
+  // ReadBS::skip()
+  // Short and long skips
+
+  {
+    for (size_t i = 0; i <= 32; i++)
+      for (size_t j = 0; j <= 1024; j += (j < 64? 1: 61))
+      {
+        bs.set(buf, i, 32 + 1024 + 32);
+        bs.skip(j);
+        result = bs.get(32);
+        test = get_uint32(buf, i + j);
+        CHECKT(result == test, ("bs.set(start_bit=%i); bs.skip(%i); sequence fails", i, j));
+      }
+  }
+
+  /////////////////////////////////////////////////////////
+  // ReadBS::get_n(), ReadBS::get_signed_n()
+  // Compare with get() and get_signed()
+
+  {
+    ReadBS ref;
+    uint32_t values[64];
+    int32_t  values_signed[64];
+
+    for (unsigned num_bits = 0; num_bits <= 32; num_bits++)
+      for (unsigned offset = 0; offset < 8; offset++)
+      {
+        size_t count = MIN(size_t(64), (buf_size * 8 - offset) / MAX(num_bits, 1u));
+
+        bs.set(buf, offset, buf_size * 8 - offset);
+        ref.set(buf, offset, buf_size * 8 - offset);
+        bs.get_n(num_bits, values, count);
+        for (size_t k = 0; k < count; k++)
+          CHECKT(values[k] == ref.get(num_bits), ("bs.get_n(%i) fails at offset %i", num_bits, offset));
+        CHECKT(bs.get_pos_bits() == ref.get_pos_bits(), ("bs.get_n(%i) wrong position", num_bits));
+
+        bs.set(buf, offset, buf_size * 8 - offset);
+        ref.set(buf, offset, buf_size * 8 - offset);
+        bs.get_signed_n(num_bits, values_signed, count);
+        for (size_t k = 0; k < count; k++)
+          CHECKT(values_signed[k] == ref.get_signed(num_bits), ("bs.get_signed_n(%i) fails at offset %i", num_bits, offset));
+      }
+  }
+
+  /////////////////////////////////////////////////////////
+  // End of the stream
+  // Read up to the last bit of streams of all sizes. The
+  // reader must not touch memory beyond the stream.
+
+  {
+    for (size_t size = 1; size <= 32; size++)
+    {
+      AutoBuf<uint8_t> stream(size);
+      memcpy(stream, buf, size);
+
+      for (unsigned num_bits = 1; num_bits <= 32 && num_bits <= size * 8; num_bits++)
+      {
+        bs.set(stream, 0, size * 8);
+        size_t pos_bits = 0;
+        while (pos_bits + num_bits <= size * 8)
+        {
+          result = bs.get(num_bits);
+          test = get_uint32(buf, pos_bits) >> (32 - num_bits);
+          CHECKT(result == test, ("size = %i: bs.get(%i) fails at the end of the stream", size, num_bits));
+          pos_bits += num_bits;
+        }
+        CHECK(bs.get_pos_bits() == pos_bits);
+      }
+    }
+  }
+
+TEST_END(bitstream_read_ext);
+
 ///////////////////////////////////////////////////////////////////////////////
 // WriteBS test
 ///////////////////////////////////////////////////////////////////////////////
@@ -363,11 +470,128 @@ TEST(bitstream_write, "WriteBS")
 TEST_END(bitstream_write);
 
 
+///////////////////////////////////////////////////////////////////////////////
+// ReadBS speed test
+// Compare with the 32 bit word reader (previous ReadBS implementation)
+///////////////////////////////////////////////////////////////////////////////
+
+class ReadBS32
+{
+protected:
+  const uint32_t *pos;
+  uint32_t current_word;
+  unsigned bits_left;
+
+  uint32_t get_next(unsigned num_bits)
+  {
+    uint32_t result = (current_word << (32 - bits_left)) >> (32 - bits_left);
+    num_bits -= bits_left;
+    current_word = be2uint32(*pos++);
+    bits_left = 32;
+    if (num_bits != 0)
+      result = (result << num_bits) | (current_word >> (32 - num_bits));
+    bits_left -= num_bits;
+    return result;
+  }
+
+public:
+  void set(const uint8_t *buf)
+  {
+    assert(align32(buf) == 0);
+    pos = (const uint32_t *)buf;
+    current_word = be2uint32(*pos++);
+    bits_left = 32;
+  }
+
+  inline uint32_t get(unsigned num_bits)
+  {
+    if (num_bits == 0)
+      return 0;
+    if (num_bits < bits_left)
+    {
+      uint32_t result = (current_word << (32 - bits_left)) >> (32 - num_bits);
+      bits_left -= num_bits;
+      return result;
+    }
+    return get_next(num_bits);
+  }
+};
+
+TEST(bitstream_speed, "ReadBS speed test")
+  const size_t size = 1024 * 1024;
+  const size_t nwidths = 4096;
+  const int runs = 20;
+
+  AutoBuf<uint8_t> buf(size + 8);
+  AutoBuf<uint8_t> widths(nwidths);
+  RNG rng(seed);
+  rng.fill_raw(buf, buf.size());
+
+  // Field widths typical for audio frames: 1..16 bits
+  size_t bits_per_pass = 0;
+  for (size_t i = 0; i < nwidths; i++)
+  {
+    widths[i] = uint8_t(rng.next() % 16 + 1);
+    bits_per_pass += widths[i];
+  }
+  const size_t passes = (size * 8 - 32) / bits_per_pass;
+  const double total_bits = double(bits_per_pass) * passes * runs;
+
+  uint32_t sum_old = 0, sum_new = 0, sum_n = 0;
+  size_t i, j;
+  int run;
+
+  vtime_t time_old = local_time();
+  for (run = 0; run < runs; run++)
+  {
+    ReadBS32 bs;
+    bs.set(buf);
+    for (i = 0; i < passes; i++)
+      for (j = 0; j < nwidths; j++)
+        sum_old += bs.get(widths[j]);
+  }
+  time_old = local_time() - time_old;
+
+  vtime_t time_new = local_time();
+  for (run = 0; run < runs; run++)
+  {
+    ReadBS bs;
+    bs.set(buf, 0, size * 8);
+    for (i = 0; i < passes; i++)
+      for (j = 0; j < nwidths; j++)
+        sum_new += bs.get(widths[j]);
+  }
+  time_new = local_time() - time_new;
+
+  // Fixed-width groups (7 bit, like AC3 exponents)
+  const size_t ngroups = size * 8 / 7 / 64;
+  vtime_t time_n = local_time();
+  for (run = 0; run < runs; run++)
+  {
+    uint32_t values[64];
+    ReadBS bs;
+    bs.set(buf, 0, size * 8);
+    for (i = 0; i < ngroups; i++)
+    {
+      bs.get_n(7, values, 64);
+      for (j = 0; j < 64; j++)
+        sum_n += values[j];
+    }
+  }
+  time_n = local_time() - time_n;
+
+  CHECKT(sum_old == sum_new, ("Readers give different results"));
+  log->msg("32 bit reader: %.2f bits/ns", total_bits / time_old * 1e-9);
+  log->msg("64 bit reader: %.2f bits/ns", total_bits / time_new * 1e-9);
+  log->msg("get_n(7):      %.2f bits/ns", double(ngroups) * 64 * 7 * runs / time_n * 1e-9);
+TEST_END(bitstream_speed);
+
 ///////////////////////////////////////////////////////////////////////////////
 // Test suite
 ///////////////////////////////////////////////////////////////////////////////
 
 SUITE(bitstream, "Bitstream")
   TEST_FACTORY(bitstream_read),
+  TEST_FACTORY(bitstream_read_ext),
   TEST_FACTORY(bitstream_write),
 SUITE_END;
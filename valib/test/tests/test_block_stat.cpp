@@ -0,0 +1,167 @@
+/*
+  Block statistics test
+  (functions defined at dsp/block_stat.h)
+
+  * Peak levels of all kernels must be equal to the reference for any
+    number of channels and block size (including the tail), NaN samples
+    must be skipped. Sum of squares must match the reference.
+  * Speed test: the old unrolled peak search vs kernels (Msamples/s).
+*/
+
+#include <math.h>
+#include "buffer.h"
+#include "dsp/block_stat.h"
+#include "rng.h"
+#include "simd.h"
+#include "vtime.h"
+#include "../suite.h"
+
+#ifdef FLOAT_SAMPLE
+static const double max_err = 1e-5;
+#else
+static const double max_err = 1e-12;
+#endif
+
+static const int seed = 347291;
+static const size_t max_size = 1031;
+
+static void ref_block_stat(const sample_t *x, size_t n, double &peak, double &sum2)
+{
+  peak = 0;
+  sum2 = 0;
+  for (size_t i = 0; i < n; i++)
+    if (x[i] == x[i]) // not NaN
+    {
+      if (fabs(x[i]) > peak)
+        peak = fabs(x[i]);
+      sum2 += double(x[i]) * double(x[i]);
+    }
+}
+
+TEST(block_stat, "Multichannel peak level and power")
+  static const int simd_masks[] = { SIMD_NONE, SIMD_SSE2, SIMD_SSE2 | SIMD_AVX };
+  static const size_t sizes[] = { 0, 1, 3, 7, 8, 15, 16, 17, 33, 256, max_size };
+
+  SampleBuf buf(NCHANNELS, max_size);
+  sample_t peak[NCHANNELS];
+  sample_t sum2[NCHANNELS];
+  sample_t peak2[NCHANNELS];
+  RNG rng(seed);
+
+  int old_mask = simd_get_mask();
+  for (int i = 0; i < array_size(sizes); i++)
+    for (int nch = 1; nch <= NCHANNELS; nch++)
+    {
+      size_t n = sizes[i];
+      rng.fill_samples(buf[0], NCHANNELS * max_size);
+
+      // Peak is placed at random position (tail too), channel 1 has no
+      // signal and channel 2 has NaN samples.
+      for (int ch = 0; ch < nch; ch++)
+        if (n)
+          buf[ch][rng.next() % n] = (rng.next() & 1)? 1.5: -1.5;
+      if (nch > 1)
+        memset(buf[1], 0, n * sizeof(sample_t));
+      if (nch > 2 && n)
+      {
+        sample_t zero = 0;
+        buf[2][0] = zero / zero;
+        buf[2][n - 1] = zero / zero;
+      }
+
+      samples_t s = buf.samples();
+      const sample_t *const *x = s.samples;
+      for (int m = 0; m < array_size(simd_masks); m++)
+      {
+        simd_set_mask(simd_masks[m] & old_mask);
+        block_stat_mch_t block_stat = find_block_stat_mch();
+        block_stat(x, nch, n, peak, sum2);
+        block_stat(x, nch, n, peak2, 0);
+
+        for (int ch = 0; ch < nch; ch++)
+        {
+          double ref_peak, ref_sum2;
+          ref_block_stat(buf[ch], n, ref_peak, ref_sum2);
+          CHECKT(peak[ch] == sample_t(ref_peak) && peak2[ch] == sample_t(ref_peak),
+            ("Mask %x, %i samples, channel %i of %i: peak = %g, reference = %g", simd_masks[m], int(n), ch, nch, peak[ch], ref_peak));
+          if (ch != 2)
+            CHECKT(fabs(sum2[ch] - ref_sum2) <= max_err * (ref_sum2 + 1),
+              ("Mask %x, %i samples, channel %i of %i: sum2 = %g, reference = %g", simd_masks[m], int(n), ch, nch, sum2[ch], ref_sum2));
+        }
+      }
+      simd_set_mask(old_mask);
+    }
+TEST_END(block_stat);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+static void old_peak(const sample_t *const *x, int nch, size_t n, sample_t *peak)
+{
+  // The loop used by AGC and Levels before
+  for (int ch = 0; ch < nch; ch++)
+  {
+    sample_t max = 0;
+    const sample_t *sptr = x[ch];
+    const sample_t *send = sptr + n - 7;
+    while (sptr < send)
+    {
+      if (fabs(sptr[0]) > max) max = fabs(sptr[0]);
+      if (fabs(sptr[1]) > max) max = fabs(sptr[1]);
+      if (fabs(sptr[2]) > max) max = fabs(sptr[2]);
+      if (fabs(sptr[3]) > max) max = fabs(sptr[3]);
+      if (fabs(sptr[4]) > max) max = fabs(sptr[4]);
+      if (fabs(sptr[5]) > max) max = fabs(sptr[5]);
+      if (fabs(sptr[6]) > max) max = fabs(sptr[6]);
+      if (fabs(sptr[7]) > max) max = fabs(sptr[7]);
+      sptr += 8;
+    }
+    send += 7;
+    while (sptr < send)
+    {
+      if (fabs(sptr[0]) > max) max = fabs(sptr[0]);
+      sptr++;
+    }
+    peak[ch] = max;
+  }
+}
+
+TEST(block_stat_speed, "Block statistics speed test")
+  const size_t n = 1024;
+  const int runs = 20000;
+  SampleBuf buf(NCHANNELS, n);
+  sample_t peak[NCHANNELS];
+  sample_t sum2[NCHANNELS];
+  int i;
+
+  RNG rng(seed);
+  rng.fill_samples(buf[0], NCHANNELS * n);
+  samples_t s = buf.samples();
+  const sample_t *const *x = s.samples;
+
+  vtime_t time = local_time();
+  for (i = 0; i < runs; i++)
+    old_peak(x, NCHANNELS, n, peak);
+  time = local_time() - time;
+  log->msg("Old peak loop:  %.0f Msamples/s", runs * n * NCHANNELS / time * 1e-6);
+
+  int old_mask = simd_get_mask();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    simd_set_mask(pass? old_mask: SIMD_NONE);
+    block_stat_mch_t block_stat = find_block_stat_mch();
+
+    time = local_time();
+    for (i = 0; i < runs; i++)
+      block_stat(x, NCHANNELS, n, peak, 0);
+    time = local_time() - time;
+    log->msg("%-6s peak:      %.0f Msamples/s", pass? "SIMD": "Scalar", runs * n * NCHANNELS / time * 1e-6);
+
+    time = local_time();
+    for (i = 0; i < runs; i++)
+      block_stat(x, NCHANNELS, n, peak, sum2);
+    time = local_time() - time;
+    log->msg("%-6s peak+sum2: %.0f Msamples/s", pass? "SIMD": "Scalar", runs * n * NCHANNELS / time * 1e-6);
+  }
+  simd_set_mask(old_mask);
+TEST_END(block_stat_speed);
@@ -0,0 +1,132 @@
+/*
+  CRC engine test
+  (class defined at crc.h)
+
+  * Slicing-by-8 and PCLMUL paths must give the same CRC as the bitwise
+    reference for different polinomials, initial values, message lengths
+    and alignments.
+  * Bitstream interface (calc_bits) over the fast paths.
+  * Speed test: table and PCLMUL paths (MB/s).
+*/
+
+#include "crc.h"
+#include "auto_buf.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+static const int seed = 658473;
+
+static const struct { uint32_t poly; unsigned power; } polys[] =
+{
+  { POLY_CRC16, 16 },
+  { POLY_CRC32, 32 },
+  { 0x07, 8 },          // CRC-8
+  { 0x864cfb, 24 },     // CRC-24 (OpenPGP)
+  { 0x4599, 15 },       // CRC-15 (CAN)
+};
+
+// Bitwise reference
+static uint32_t crc_ref(const CRC &crc, uint32_t value, const uint8_t *data, size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+    value = crc.add_bits(value, data[i], 8);
+  return value;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(crc_calc, "Table and PCLMUL CRC vs bitwise reference")
+  const size_t max_size = 1100;
+  const size_t max_shift = 16;
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> buf(max_size + max_shift);
+  rng.fill_raw(buf, buf.size());
+
+  int old_mask = simd_get_mask();
+  for (int i = 0; i < array_size(polys); i++)
+  {
+    CRC crc(polys[i].poly, polys[i].power);
+    for (size_t size = 0; size < max_size; size += (size < 300? 1: 37))
+      for (size_t shift = 0; shift < max_shift; shift++)
+      {
+        uint32_t init = crc.crc_init(rng.next() & ((1 << (polys[i].power - 1)) - 1));
+        uint32_t ref = crc_ref(crc, init, buf + shift, size);
+        for (int pass = 0; pass < 2; pass++)
+        {
+          simd_set_mask(pass? old_mask: SIMD_NONE);
+          uint32_t test = crc.calc(init, buf + shift, size);
+          if (test != ref)
+          {
+            simd_set_mask(old_mask);
+            CHECKT(false, ("%s CRC%i: size = %i, shift = %i, crc = 0x%x (must be 0x%x)",
+              pass? "SIMD": "Table", polys[i].power, size, shift, test, ref));
+          }
+        }
+      }
+  }
+  simd_set_mask(old_mask);
+TEST_END(crc_calc);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(crc_calc_bits, "Bitstream CRC over large blocks")
+  const size_t size = 4096;
+  const int iterations = 200;
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> buf(size);
+  rng.fill_raw(buf, buf.size());
+
+  int old_mask = simd_get_mask();
+  for (int i = 0; i < iterations; i++)
+  {
+    const CRC &crc = (i & 1)? crc32: crc16;
+    size_t start_bit = rng.next() % 64;
+    size_t bits = rng.next() % (size * 8 - 64);
+
+    simd_set_mask(SIMD_NONE);
+    uint32_t ref = crc.calc_bits(0, buf, start_bit, bits);
+    simd_set_mask(old_mask);
+    uint32_t test = crc.calc_bits(0, buf, start_bit, bits);
+
+    CHECKT(test == ref, ("start_bit = %i, bits = %i, crc = 0x%x (must be 0x%x)",
+      start_bit, bits, test, ref));
+  }
+TEST_END(crc_calc_bits);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(crc_speed, "CRC speed test")
+  const size_t size = 4096;   // typical frame size
+  const int runs = 50000;
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> buf(size);
+  rng.fill_raw(buf, buf.size());
+
+  int old_mask = simd_get_mask();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    simd_set_mask(pass? old_mask: SIMD_NONE);
+    uint32_t result = 0;
+
+    vtime_t time = local_time();
+    for (int i = 0; i < runs; i++)
+      result = crc16.calc(result, buf, size);
+    time = local_time() - time;
+
+    log->msg("%-7s %.0fMB/s (0x%04x)", pass? "SIMD:": "Table:",
+      double(size) * runs / 1024 / 1024 / time, crc16.crc_get(result));
+  }
+  simd_set_mask(old_mask);
+TEST_END(crc_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(crc, "CRC test")
+  TEST_FACTORY(crc_calc),
+  TEST_FACTORY(crc_calc_bits),
+SUITE_END;
@@ -0,0 +1,53 @@
+/*
+  Multichannel dot product test
+  (functions defined at dsp/dot.h)
+
+  * All kernels must match the double precision reference for a long filter
+    (with the tail), within rounding of the products. In the single
+    precision build it checks that kernels do not accumulate in float.
+*/
+
+#include <math.h>
+#include "buffer.h"
+#include "dsp/dot.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+static const int seed = 581207;
+static const int filter_len = 4099;
+
+TEST(dot_mch, "Multichannel dot product")
+  static const int simd_masks[] = { SIMD_NONE, SIMD_SSE2, SIMD_SSE2 | SIMD_AVX };
+
+  SampleBuf buf(NCHANNELS, filter_len);
+  SampleBuf filter(1, filter_len);
+  sample_t result[NCHANNELS];
+  RNG rng(seed);
+
+  rng.fill_samples(buf[0], NCHANNELS * filter_len);
+  rng.fill_samples(filter[0], filter_len);
+  samples_t s = buf.samples();
+
+  int old_mask = simd_get_mask();
+  for (int m = 0; m < array_size(simd_masks); m++)
+  {
+    simd_set_mask(simd_masks[m] & old_mask);
+    dot_mch_t dot = find_dot_mch();
+    dot(s.samples, NCHANNELS, filter[0], filter_len, result);
+
+    for (int ch = 0; ch < NCHANNELS; ch++)
+    {
+      // Products are rounded to sample_t; summation error must be much
+      // less than the precision of sample_t.
+      double ref = 0;
+      for (int j = 0; j < filter_len; j++)
+        ref += sample_t(buf[ch][j] * filter[0][j]);
+
+      double err = fabs(result[ch] - ref) / fabs(ref);
+      CHECKT(err < (sizeof(sample_t) == sizeof(float)? 2e-7: 1e-14),
+        ("mask %x, channel %i: relative error %g", simd_masks[m], ch, err));
+    }
+  }
+  simd_set_mask(old_mask);
+TEST_END(dot_mch);
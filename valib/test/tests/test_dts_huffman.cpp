@@ -0,0 +1,157 @@
+/*
+  DTS Huffman decoder test
+  (class defined at parsers/dts/dts_huffman.h)
+
+  * Lookup-table decoder must decode exactly the same symbols and consume
+    exactly the same number of bits as the bit-by-bit table walk for all
+    DTS Huffman tables.
+  * Speed test: table walk vs lookup-table decoder (symbols/us).
+*/
+
+#include "parsers/dts/dts_defs.h"
+#include "parsers/dts/dts_huffman.h"
+#include "parsers/dts/dts_tables_huffman.h"
+#include "auto_buf.h"
+#include "rng.h"
+#include "../suite.h"
+
+static const int seed = 83264;
+static const size_t stream_size = 4096;
+
+// Reference: walk the table bit by bit (previous DTSParser::InverseQ)
+static int huff_walk(ReadBS &bs, const huff_entry_t *huff)
+{
+  int value = 0;
+  int length = 0, j;
+
+  while (1)
+  {
+    length++;
+    value <<= 1;
+    value |= bs.get(1);
+
+    for (j = 0; huff[j].length != 0 && huff[j].length < length; j++);
+
+    if (huff[j].length == 0)
+      break;
+
+    for (; huff[j].length == length; j++)
+      if (huff[j].code == value)
+        return huff[j].value;
+  }
+
+  return 0;
+}
+
+static int all_tables(const huff_entry_t **tables, int max_tables)
+{
+  int n = 0;
+  int i, j;
+  for (i = 0; i < array_size(bitalloc_12) && n < max_tables; i++)
+    tables[n++] = bitalloc_12[i];
+  for (i = 0; i < array_size(scales_129) && n < max_tables; i++)
+    tables[n++] = scales_129[i];
+  for (i = 0; i < array_size(tmode) && n < max_tables; i++)
+    tables[n++] = tmode[i];
+  for (i = 0; i < array_size(bitalloc_select); i++)
+    for (j = 0; j < 7 && bitalloc_select[i][j] && n < max_tables; j++)
+      tables[n++] = bitalloc_select[i][j];
+  return n;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(dts_huffman, "DTS Huffman lookup-table decoder")
+  const huff_entry_t *tables[128];
+  int ntables = all_tables(tables, array_size(tables));
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> buf(stream_size);
+  const size_t size_bits = stream_size * 8;
+
+  for (int t = 0; t < ntables; t++)
+  {
+    DTSHuffman lut(tables[t]);
+    rng.fill_raw(buf, buf.size());
+
+    ReadBS ref, bs;
+    ref.set(buf, 0, size_bits);
+    bs.set(buf, 0, size_bits);
+
+    // Single symbols and groups of random size.
+    // The longest code is 16 bits.
+    int values[8];
+    while (ref.get_pos_bits() + 8 * 16 <= size_bits)
+    {
+      int n = rng.next() % 9;
+      if (n)
+        lut.get_n(bs, values, n);
+      else
+        values[n++] = lut.get(bs);
+
+      for (int i = 0; i < n; i++)
+      {
+        int value = huff_walk(ref, tables[t]);
+        CHECKT(values[i] == value && bs.get_pos_bits() >= ref.get_pos_bits(),
+          ("Table %i: symbol %i at bit %i, must be %i", t, values[i], ref.get_pos_bits(), value));
+      }
+      CHECKT(bs.get_pos_bits() == ref.get_pos_bits(),
+        ("Table %i: position %i, must be %i", t, bs.get_pos_bits(), ref.get_pos_bits()));
+    }
+  }
+TEST_END(dts_huffman);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+// Decode subband samples in groups of 8 with the largest tables
+
+TEST(dts_huffman_speed, "DTS Huffman speed test")
+  const int runs = 50;
+  const huff_entry_t *tables[] = { bitalloc_a_129, bitalloc_e_65, bitalloc_d_33, scales_b_129 };
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> buf(stream_size);
+  rng.fill_raw(buf, buf.size());
+  const size_t size_bits = stream_size * 8;
+
+  for (int t = 0; t < array_size(tables); t++)
+  {
+    DTSHuffman lut(tables[t]);
+    size_t nsymbols = 0;
+    int sum_walk = 0, sum_lut = 0;
+    int values[8];
+    int run, i;
+
+    vtime_t time_walk = local_time();
+    for (run = 0; run < runs; run++)
+    {
+      ReadBS bs;
+      bs.set(buf, 0, size_bits);
+      while (bs.get_pos_bits() + 8 * 16 <= size_bits)
+      {
+        for (i = 0; i < 8; i++)
+          sum_walk += huff_walk(bs, tables[t]);
+        nsymbols += 8;
+      }
+    }
+    time_walk = local_time() - time_walk;
+
+    vtime_t time_lut = local_time();
+    for (run = 0; run < runs; run++)
+    {
+      ReadBS bs;
+      bs.set(buf, 0, size_bits);
+      while (bs.get_pos_bits() + 8 * 16 <= size_bits)
+      {
+        lut.get_n(bs, values, 8);
+        for (i = 0; i < 8; i++)
+          sum_lut += values[i];
+      }
+    }
+    time_lut = local_time() - time_lut;
+
+    CHECK(sum_walk == sum_lut);
+    log->msg("Table %i: walk %.1f, lookup %.1f symbols/us", t,
+      nsymbols / time_walk * 1e-6, nsymbols / time_lut * 1e-6);
+  }
+TEST_END(dts_huffman_speed);
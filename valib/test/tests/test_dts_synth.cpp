@@ -0,0 +1,265 @@
+/*
+  DTS synthesis filterbank test
+  (class defined at parsers/dts/dts_synth.h)
+
+  * QMF synthesis and LFE interpolation must match the direct implementation
+    (cosine modulation matrix and history shift of the previous DTSParser)
+    for all channel counts, active subbands and both prototype filters.
+  * SIMD and scalar kernels must give identical results.
+  * Speed test: direct vs fast filterbank for 5 channels (Msamples/s).
+*/
+
+#include <math.h>
+#include "parsers/dts/dts_synth.h"
+#include "parsers/dts/dts_tables_fir.h"
+#include "auto_buf.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+static const int seed = 730291;
+static const int frames = 50;
+
+#ifdef FLOAT_SAMPLE
+static const double max_err = 1e-5;
+#else
+static const double max_err = 1e-11;
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference: direct filterbank (previous DTSParser implementation)
+
+class QMFRef
+{
+public:
+  double cos_mod[544];
+  double fir_hist[DTS_PRIM_CHANNELS_MAX][512];
+  double fir_out[DTS_PRIM_CHANNELS_MAX][64];
+
+  QMFRef()
+  {
+    int i, j, k;
+    for (j = 0, k = 0; k < 16; k++)
+      for (i = 0; i < 16; i++)
+        cos_mod[j++] = cos((2*i+1)*(2*k+1)*M_PI/64);
+    for (k = 0; k < 16; k++)
+      for (i = 0; i < 16; i++)
+        cos_mod[j++] = cos((i)*(2*k+1)*M_PI/32);
+    for (k = 0; k < 16; k++)
+      cos_mod[j++] = 0.25/(2*cos((2*k+1)*M_PI/128));
+    for (k = 0; k < 16; k++)
+      cos_mod[j++] = -0.25/(2.0*sin((2*k+1)*M_PI/128));
+
+    memset(fir_hist, 0, sizeof(fir_hist));
+    memset(fir_out, 0, sizeof(fir_out));
+  }
+
+  void qmf(int ch, double samples_in[32][8], int activity, bool perfect, sample_t *samples_out, double scale)
+  {
+    const double *coef = perfect? fir_32bands_perfect: fir_32bands_nonperfect;
+    double *f = fir_hist[ch];
+    double *out = fir_out[ch];
+    double x[32];
+    int i, j, k, s;
+
+    for (s = 0; s < 8; s++)
+    {
+      for (i = 0; i < 32; i++)
+        x[i] = i < activity? samples_in[i][s]: 0.0;
+
+      for (k = 0; k < 16; k++)
+      {
+        double a = 0, b = x[0] * cos_mod[256 + 16*k];
+        for (i = 0; i < 16; i++)
+          a += (x[2*i] + x[2*i+1]) * cos_mod[16*k + i];
+        for (i = 1; i < 16; i++)
+          b += (x[2*i] + x[2*i-1]) * cos_mod[256 + 16*k + i];
+        f[k]      = cos_mod[k + 512] * (a+b);
+        f[32-k-1] = cos_mod[k + 528] * (a-b);
+      }
+
+      for (k = 31, i = 0; i < 32; i++, k--)
+      {
+        double a = out[i];
+        double b = out[32+i];
+        for (j = 0; j < 512; j += 64)
+        {
+          a += coef[i+j] * (f[i+j] - f[k+j]);
+          b += coef[32+i+j] * (-f[i+j] - f[k+j]);
+        }
+        out[i] = a;
+        out[32+i] = b;
+      }
+
+      for (i = 0; i < 32; i++)
+        *samples_out++ = sample_t(out[i] / scale);
+
+      memmove(f + 32, f, 480 * sizeof(double));
+      for (i = 0; i < 32; i++)
+      {
+        out[i] = out[i+32];
+        out[i+32] = 0.0;
+      }
+    }
+  }
+
+  static void lfe(int decimation, int nsamples, const double *samples_in, sample_t *samples_out, double scale)
+  {
+    int deci = decimation == 1? 128: 64;
+    const double *coef = decimation == 1? lfe_fir_128: lfe_fir_64;
+    for (int n = 0; n < nsamples; n++)
+      for (int k = 0; k < deci; k++)
+      {
+        double sum = 0.0;
+        for (int j = 0; j < 512 / deci; j++)
+          sum += samples_in[n-j] * coef[k+j*deci];
+        *samples_out++ = sample_t(sum / scale);
+      }
+  }
+};
+
+static double max_diff(const sample_t *a, const sample_t *b, size_t size)
+{
+  double diff = 0;
+  for (size_t i = 0; i < size; i++)
+    diff = MAX(diff, fabs(a[i] - b[i]));
+  return diff;
+}
+
+static void random_subbands(RNG &rng, double samples_in[][32][8], int nch)
+{
+  for (int ch = 0; ch < nch; ch++)
+    for (int i = 0; i < 32; i++)
+      for (int s = 0; s < 8; s++)
+        samples_in[ch][i][s] = rng.get_sample() * 32768.0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(dts_synth_qmf, "DTS QMF synthesis")
+  double samples_in[DTS_PRIM_CHANNELS_MAX][32][8];
+  sample_t ref[DTS_PRIM_CHANNELS_MAX][256];
+  sample_t test[2][DTS_PRIM_CHANNELS_MAX][256];
+  sample_t *out[2][DTS_PRIM_CHANNELS_MAX];
+  int activity[DTS_PRIM_CHANNELS_MAX];
+  int ch, pass;
+
+  RNG rng(seed);
+  int old_mask = simd_get_mask();
+
+  for (int nch = 1; nch <= DTS_PRIM_CHANNELS_MAX; nch++)
+    for (int perfect = 0; perfect < 2; perfect++)
+    {
+      QMFRef qmf_ref;
+      DTSSynth synth[2];
+      for (pass = 0; pass < 2; pass++)
+        for (ch = 0; ch < nch; ch++)
+          out[pass][ch] = test[pass][ch];
+
+      for (int frame = 0; frame < frames; frame++)
+      {
+        random_subbands(rng, samples_in, nch);
+        for (ch = 0; ch < nch; ch++)
+        {
+          activity[ch] = rng.next() % 33;
+          qmf_ref.qmf(ch, samples_in[ch], activity[ch], perfect != 0, ref[ch], 32768.0);
+        }
+
+        for (pass = 0; pass < 2; pass++)
+        {
+          simd_set_mask(pass? old_mask: SIMD_NONE);
+          synth[pass].qmf(nch, samples_in, activity, perfect != 0, out[pass], 32768.0);
+        }
+        simd_set_mask(old_mask);
+
+        for (ch = 0; ch < nch; ch++)
+        {
+          double diff = max_diff(ref[ch], test[0][ch], 256);
+          CHECKT(diff < max_err, ("nch = %i, perfect = %i, frame %i, ch %i: diff = %g", nch, perfect, frame, ch, diff));
+          CHECKT(memcmp(test[0][ch], test[1][ch], sizeof(test[0][ch])) == 0,
+            ("nch = %i, perfect = %i, frame %i, ch %i: SIMD and scalar results differ", nch, perfect, frame, ch));
+        }
+      }
+    }
+TEST_END(dts_synth_qmf);
+
+TEST(dts_synth_lfe, "DTS LFE interpolation")
+  const int nsamples = 2 * 2 * DTS_LFE_MAX;
+  const int history = 8;
+  double samples_in[history + nsamples];
+  sample_t ref[nsamples * 128];
+  sample_t test[2][nsamples * 128];
+
+  RNG rng(seed);
+  int old_mask = simd_get_mask();
+  for (int decimation = 1; decimation <= 2; decimation++)
+  {
+    int n = decimation * 2 * 2;
+    int size = n * (decimation == 1? 128: 64);
+    for (int i = 0; i < history + n; i++)
+      samples_in[i] = rng.get_sample() * 8388608.0;
+
+    QMFRef::lfe(decimation, n, samples_in + history, ref, 8388608.0);
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      DTSSynth::lfe(decimation, n, samples_in + history, test[pass], 8388608.0);
+    }
+    simd_set_mask(old_mask);
+
+    double diff = max_diff(ref, test[0], size);
+    CHECKT(diff < max_err, ("decimation = %i: diff = %g", decimation, diff));
+    CHECKT(memcmp(test[0], test[1], size * sizeof(sample_t)) == 0,
+      ("decimation = %i: SIMD and scalar results differ", decimation));
+  }
+TEST_END(dts_synth_lfe);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(dts_synth_speed, "DTS QMF synthesis speed test")
+  const int nch = DTS_PRIM_CHANNELS_MAX;
+  const int runs = 2000;
+
+  double samples_in[DTS_PRIM_CHANNELS_MAX][32][8];
+  sample_t buf[DTS_PRIM_CHANNELS_MAX][256];
+  sample_t *out[DTS_PRIM_CHANNELS_MAX];
+  int activity[DTS_PRIM_CHANNELS_MAX];
+  int ch, i;
+
+  RNG rng(seed);
+  random_subbands(rng, samples_in, nch);
+  for (ch = 0; ch < nch; ch++)
+  {
+    activity[ch] = 32;
+    out[ch] = buf[ch];
+  }
+
+  QMFRef qmf_ref;
+  vtime_t time = local_time();
+  for (i = 0; i < runs; i++)
+    for (ch = 0; ch < nch; ch++)
+      qmf_ref.qmf(ch, samples_in[ch], activity[ch], false, buf[ch], 32768.0);
+  time = local_time() - time;
+  log->msg("Direct:  %.1f Msamples/s", double(runs) * nch * 256 / time * 1e-6);
+
+  int old_mask = simd_get_mask();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    simd_set_mask(pass? old_mask: SIMD_NONE);
+    DTSSynth synth;
+    time = local_time();
+    for (i = 0; i < runs; i++)
+      synth.qmf(nch, samples_in, activity, false, out, 32768.0);
+    time = local_time() - time;
+    log->msg("%-8s %.1f Msamples/s", pass? "SIMD:": "Scalar:", double(runs) * nch * 256 / time * 1e-6);
+  }
+  simd_set_mask(old_mask);
+TEST_END(dts_synth_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(dts_synth, "DTS synthesis filterbank test")
+  TEST_FACTORY(dts_synth_qmf),
+  TEST_FACTORY(dts_synth_lfe),
+SUITE_END;
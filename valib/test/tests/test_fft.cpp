@@ -0,0 +1,167 @@
+/*
+  FFT backends test
+  * All backends must produce the same result as Ooura's FFT (reference)
+    for forward and inverse transforms
+  * Speed test: compare backends for some common lengths
+*/
+
+#include <math.h>
+#include "buffer.h"
+#include "dsp/fft.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+static const int seed = 493875;
+static const sample_t max_err = sizeof(sample_t) == sizeof(float)? 1e-5: 1e-13;
+
+typedef FFTBackend *(*create_fft_t)();
+static const create_fft_t backends[] = { create_simd_fft, create_external_fft };
+
+// Maximum difference relative to the maximum value of the reference
+static sample_t rel_diff(const sample_t *test, const sample_t *ref, unsigned n)
+{
+  sample_t diff = 0, max = 0;
+  for (unsigned i = 0; i < n; i++)
+  {
+    diff = MAX(diff, fabs(test[i] - ref[i]));
+    max = MAX(max, fabs(ref[i]));
+  }
+  return max > 0? diff / max: diff;
+}
+
+TEST(fft_backends, "Compare FFT backends with Ooura's FFT")
+  RNG rng(seed);
+  FFTBackend *ref_fft = create_ooura_fft();
+  Samples input, ref, test;
+
+  for (int b = 0; b < array_size(backends); b++)
+  {
+    FFTBackend *fft = backends[b]();
+    if (!fft)
+      continue;
+
+    for (unsigned n = 2; n <= 65536; n *= 2)
+    {
+      if (!fft->init(n))
+        continue;
+
+      CHECK(ref_fft->init(n));
+      input.allocate(n);
+      ref.allocate(n);
+      test.allocate(n);
+      rng.fill_samples(input, n);
+
+      // Forward transform
+
+      memcpy(ref, input, n * sizeof(sample_t));
+      memcpy(test, input, n * sizeof(sample_t));
+      ref_fft->rdft(ref);
+      fft->rdft(test);
+
+      sample_t err = rel_diff(test, ref, n);
+      CHECKT(err < max_err, ("%s rdft(), n = %i: error = %g", fft->name(), n, err));
+
+      // Inverse transform
+
+      memcpy(ref, input, n * sizeof(sample_t));
+      memcpy(test, input, n * sizeof(sample_t));
+      ref_fft->inv_rdft(ref);
+      fft->inv_rdft(test);
+
+      err = rel_diff(test, ref, n);
+      CHECKT(err < max_err, ("%s inv_rdft(), n = %i: error = %g", fft->name(), n, err));
+
+      // Round trip
+
+      memcpy(test, input, n * sizeof(sample_t));
+      fft->rdft(test);
+      fft->inv_rdft(test);
+      for (unsigned i = 0; i < n; i++)
+        test[i] *= 2.0 / n;
+
+      err = rel_diff(test, input, n);
+      CHECKT(err < max_err, ("%s round trip, n = %i: error = %g", fft->name(), n, err));
+    }
+
+    delete fft;
+  }
+
+  delete ref_fft;
+TEST_END(fft_backends);
+
+TEST(fft_select, "MM_FFT backend selection")
+  int old_mask = simd_get_mask();
+  MM_FFT fft;
+
+  // Ooura's FFT is always available
+  simd_set_mask(SIMD_NONE);
+  CHECK(fft.set_length(1024));
+  CHECK(fft.is_ok() && fft.get_length() == 1024);
+  if (!create_external_fft())
+    CHECK(!strcmp(fft.backend_name(), "Ooura"));
+
+  // SIMD backend must be used when available
+  simd_set_mask(old_mask);
+  FFTBackend *simd_fft = create_simd_fft();
+  CHECK(fft.set_length(2048));
+  if (simd_fft && simd_fft->init(2048) && !create_external_fft())
+    CHECK(!strcmp(fft.backend_name(), simd_fft->name()));
+  delete simd_fft;
+
+  // Short transforms are supported by Ooura's FFT
+  CHECK(fft.set_length(4));
+  CHECK(fft.is_ok());
+
+  // Only power of 2 is supported
+  CHECK(!fft.set_length(1000));
+  CHECK(!fft.is_ok());
+TEST_END(fft_select);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(fft_speed, "FFT speed test")
+  static const unsigned lengths[] = { 256, 2048, 16384, 131072 };
+  const int total = 1 << 24; // samples to transform for each length
+  create_fft_t create[] = { create_ooura_fft, create_simd_fft, create_external_fft };
+
+  RNG rng(seed);
+  Samples data, buf;
+
+  for (int i = 0; i < array_size(lengths); i++)
+  {
+    unsigned n = lengths[i];
+    data.allocate(n);
+    buf.allocate(n);
+    rng.fill_samples(data, n);
+
+    for (int b = 0; b < array_size(create); b++)
+    {
+      FFTBackend *fft = create[b]();
+      if (!fft)
+        continue;
+
+      if (fft->init(n))
+      {
+        vtime_t time = local_time();
+        for (int j = 0; j < total / (int)n; j++)
+        {
+          memcpy(buf, data, n * sizeof(sample_t));
+          fft->rdft(buf);
+          fft->inv_rdft(buf);
+        }
+        time = local_time() - time;
+        log->msg("n = %6i %-12s %.3fs", n, fft->name(), time);
+      }
+      delete fft;
+    }
+  }
+TEST_END(fft_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(fft, "FFT test")
+  TEST_FACTORY(fft_backends),
+  TEST_FACTORY(fft_select),
+SUITE_END;
@@ -0,0 +1,192 @@
+/*
+  FileParser test
+  (class defined at parsers/file_parser.h)
+
+  * Memory-mapped mode must load the same frames as buffered mode. Two
+    parsers walk the file in lockstep, frames and positions are compared.
+    The test file consists of several AC3 streams with noise in between,
+    and small map window is used, so frames straddle the window boundary.
+    Frames are zapped after the comparison to simulate in-place processing.
+  * The same after random seeks, and stats() must give the same result.
+  * Speed test: file walk with buffered and memory-mapped modes (MB/s).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+#include "parsers/file_parser.h"
+#include "parsers/ac3/ac3_enc.h"
+#include "parsers/ac3/ac3_header.h"
+#include "rng.h"
+#include "../suite.h"
+
+static const int seed = 418263;
+static const char *filename = "test_file_parser.ac3";
+
+///////////////////////////////////////////////////////////////////////////////
+// Test file: AC3 streams of noise and tones with noise in between
+
+static bool encode_stream(FILE *f, Speakers spk, int bitrate, int frames, RNG &rng)
+{
+  SampleBuf buf(spk.nch(), AC3_FRAME_SAMPLES);
+  AC3Enc enc;
+  if (!enc.set_bitrate(bitrate) || !enc.set_input(spk))
+    return false;
+
+  Chunk chunk;
+  for (int frame = 0; frame < frames; frame++)
+  {
+    for (int ch = 0; ch < spk.nch(); ch++)
+      for (int i = 0; i < AC3_FRAME_SAMPLES; i++)
+      {
+        double t = double(frame * AC3_FRAME_SAMPLES + i);
+        buf[ch][i] = (rng.get_sample() * 0.3 + 0.5 * sin(t * 0.01 * (ch + 1))) * spk.level;
+      }
+
+    Chunk in(spk, buf, AC3_FRAME_SAMPLES);
+    if (!enc.process(&in))
+      return false;
+
+    while (!enc.is_empty())
+    {
+      if (!enc.get_chunk(&chunk))
+        return false;
+      if (chunk.size)
+        fwrite(chunk.rawdata, 1, chunk.size, f);
+    }
+  }
+  return true;
+}
+
+static void write_noise(FILE *f, size_t size, RNG &rng)
+{
+  Rawdata noise(size);
+  rng.fill_raw(noise, size);
+  fwrite(noise, 1, size, f);
+}
+
+static bool make_file(int frames)
+{
+  RNG rng(seed);
+  FILE *f = fopen(filename, "wb");
+  if (!f)
+    return false;
+
+  write_noise(f, 1000, rng);
+  bool result = encode_stream(f, Speakers(FORMAT_LINEAR, MODE_5_1, 48000), 448000, frames, rng);
+  write_noise(f, 5000, rng);
+  result = result && encode_stream(f, Speakers(FORMAT_LINEAR, MODE_STEREO, 48000), 192000, frames / 2, rng);
+  result = result && encode_stream(f, Speakers(FORMAT_LINEAR, MODE_5_1, 48000), 640000, frames / 2, rng);
+  write_noise(f, 100, rng);
+
+  fclose(f);
+  return result;
+}
+
+static bool open_file(FileParser &file, bool mapped)
+{
+  file.use_mmap = mapped;
+  file.map_window = 0; // minimal window
+  return file.open(filename, &ac3_header) && file.is_mapped() == mapped;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Walk both files in lockstep and compare frames loaded
+
+static bool compare_frames(Log *log, FileParser &ref, FileParser &test, int max_frames)
+{
+  for (int frame = 0; frame < max_frames; frame++)
+  {
+    bool ref_loaded = ref.load_frame();
+    bool test_loaded = test.load_frame();
+    if (ref_loaded != test_loaded)
+    {
+      log->err("Frame %i: frame was loaded only in %s mode", frame, ref_loaded? "buffered": "mapped");
+      return false;
+    }
+
+    if (!ref_loaded)
+      return ref.eof() == test.eof();
+
+    if (ref.get_pos() != test.get_pos() ||
+        ref.is_new_stream() != test.is_new_stream() ||
+        ref.get_frame_size() != test.get_frame_size() ||
+        memcmp(ref.get_frame(), test.get_frame(), ref.get_frame_size()))
+    {
+      log->err("Frame %i at %.0f: frames differ", frame, double(ref.get_pos()));
+      return false;
+    }
+
+    // In-place processing
+    memset(ref.get_frame(), 0, ref.get_frame_size());
+    memset(test.get_frame(), 0, test.get_frame_size());
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(file_parser_mmap, "FileParser memory-mapped mode")
+  FileParser ref, test;
+  int i;
+
+  CHECKT(make_file(200), ("Cannot create the test file"));
+  CHECKT(open_file(ref, false) && open_file(test, true), ("Cannot open the test file"));
+
+  // Walk the whole file
+  CHECK(compare_frames(log, ref, test, INT_MAX));
+  CHECK(ref.eof() && test.eof());
+  CHECK(ref.get_frames() == test.get_frames());
+  CHECK(ref.get_frames() == 400);
+
+  // Random seeks
+  RNG rng(seed);
+  for (i = 0; i < 100; i++)
+  {
+    FileParser::fsize_t pos = rng.next() % ref.get_size();
+    CHECK(ref.seek(pos) == 0 && test.seek(pos) == 0);
+    CHECK(ref.get_pos() == pos && test.get_pos() == pos);
+    CHECKT(compare_frames(log, ref, test, 10), ("Seek to %.0f: frames differ", double(pos)));
+  }
+
+  // Stats
+  srand(seed);
+  bool ref_stats = ref.stats();
+  srand(seed);
+  bool test_stats = test.stats();
+  CHECK(ref_stats && test_stats);
+  CHECK(ref.get_size(FileParser::frames) == test.get_size(FileParser::frames));
+
+  ref.close();
+  test.close();
+  remove(filename);
+TEST_END(file_parser_mmap);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(file_parser_speed, "FileParser speed test")
+  const int runs = 20;
+
+  CHECKT(make_file(500), ("Cannot create the test file"));
+
+  for (int mapped = 0; mapped < 2; mapped++)
+  {
+    FileParser file;
+    file.use_mmap = mapped != 0;
+    CHECKT(file.open(filename, &ac3_header), ("Cannot open the test file"));
+
+    vtime_t time = local_time();
+    for (int i = 0; i < runs; i++)
+    {
+      file.seek(0);
+      while (file.load_frame())
+        ;
+    }
+    time = local_time() - time;
+    log->msg("%-8s %.0f MB/s", mapped? "Mapped:": "Buffered:", double(file.get_size()) * runs / time / 1e6);
+  }
+
+  remove(filename);
+TEST_END(file_parser_speed);
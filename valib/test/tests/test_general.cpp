@@ -200,24 +200,29 @@ SUITE_END;
     float f;
     struct 
     {
-      unsigned mantissa:23;
-      unsigned exponent:8;
-      unsigned sign:1;
+      unsigned mant : 23;
+      unsigned exp  : 8;
+      unsigned sign : 1;
     };
-  };
 
+    float_t(float _f) { f = _f;   }
+    operator float &() { return f; }
+  };
 
-  inline int32_t sample_mant(sample_t s);
+  inline int32_t sample_mant(sample_t s)
   {
-    int32_t i32;
-    i32 = float_t(s).mant_high;
-    (uint32_t)i32 |= float_t(s).sign << 31;
-    return i32;
+    uint32_t mant;
+    float_t f = s;
+
+    mant = 0x40000000 | (f.mant << 7);
+    mant = (mant ^ (unsigned)(-(int)f.sign)) + f.sign;
+    return (int32_t)mant;
   }
 
-  inline int sample_exp(sample_t s)
+  inline int16_t sample_exp(sample_t s)
   {
-    return float_t(s).exp;
+    float_t f = s;
+    return int16_t(f.exp) - 127 + 1;
   }
 
 #endif // #ifndef FLOAT_SAMPLE ... #else ... 
@@ -0,0 +1,337 @@
+/*
+  Look-ahead limiter test
+  (class defined at dsp/limiter.h, limiter mode of AGC at filters/agc.h)
+
+  * Signal below the level passes unchanged with the limiter delay.
+  * Output peak level is not greater than the limiter level, and the gain
+    is not changed faster than the look-ahead allows.
+  * True-peak mode limits the peaks between samples (measured with 16x
+    oversampling).
+  * Output does not depend on the chunk size.
+  * Sliding minimum equals the brute-force minimum over the window for a
+    falling peak envelope (the deque is full) with power-of-2 windows.
+  * AGC in limiter mode keeps the stream length and position (the delay is
+    dropped), including streams shorter than the delay.
+  * Speed test: short and long look-ahead, sample and true-peak mode.
+*/
+
+#include <math.h>
+#include "buffer.h"
+#include "dsp/limiter.h"
+#include "filters/agc.h"
+#include "rng.h"
+#include "vtime.h"
+#include "../suite.h"
+
+static const int seed = 582031;
+static const size_t noise_size = 65536;
+static const int lookahead = 256;
+static const double eps = 1e-6;
+
+// Noise with loud bursts
+static void bursts(RNG &rng, int nch, size_t size, SampleBuf &buf)
+{
+  buf.allocate(nch, size);
+  rng.fill_samples(buf[0], nch * size);
+  for (int ch = 0; ch < nch; ch++)
+    for (size_t s = 0; s < size; s++)
+      if ((s / 1000) % 5 == 2)
+        buf[ch][s] *= 4.0;
+      else
+        buf[ch][s] *= 0.5;
+}
+
+// Peak level with 16x oversampling (windowed sinc of 64 taps)
+static double measure_true_peak(const sample_t *x, size_t size)
+{
+  const int half = 32;
+  double peak = 0;
+  for (size_t s = half; s + half < size; s++)
+    for (int p = 0; p < 16; p++)
+    {
+      double y = 0;
+      for (int k = -half + 1; k <= half; k++)
+      {
+        double t = (k - p / 16.0) * M_PI;
+        double w = 0.5 + 0.5 * cos(t / half);
+        y += x[s + k] * (t == 0? 1: sin(t) / t) * w;
+      }
+      peak = MAX(peak, fabs(y));
+    }
+  return peak;
+}
+
+static void process_chunks(Limiter &lim, RNG &rng, SampleBuf &buf, size_t size)
+{
+  size_t pos = 0;
+  while (pos < size)
+  {
+    size_t n = rng.next() % 1000;
+    n = MIN(n, size - pos);
+    samples_t s = buf.samples();
+    s += pos;
+    lim.process(s.samples, n);
+    pos += n;
+  }
+}
+
+TEST(limiter, "Look-ahead limiter")
+  const int nch = 2;
+  const sample_t level = 0.9;
+  Limiter lim;
+  SampleBuf input, output;
+  RNG rng(seed);
+  size_t s;
+  int ch;
+
+  CHECK(!lim.init(0, lookahead, false));
+  CHECK(!lim.init(nch, 0, false));
+
+  for (int true_peak = 0; true_peak <= 1; true_peak++)
+  {
+    CHECK(lim.init(nch, lookahead, true_peak != 0));
+    lim.set_level(level);
+    lim.set_release(pow(10.0, 50.0 / 48000 / 20));
+    int latency = lim.get_latency();
+    CHECK(latency >= lookahead - 1);
+
+    /////////////////////////////////////////////////////////
+    // Quiet signal is delayed only
+
+    bursts(rng, nch, noise_size, input);
+    for (ch = 0; ch < nch; ch++)
+      for (s = 0; s < noise_size; s++)
+        input[ch][s] *= 0.1;
+
+    output.allocate(nch, noise_size);
+    for (ch = 0; ch < nch; ch++)
+      memcpy(output[ch], input[ch], noise_size * sizeof(sample_t));
+
+    lim.reset();
+    process_chunks(lim, rng, output, noise_size);
+    for (ch = 0; ch < nch; ch++)
+    {
+      for (s = 0; s < size_t(latency); s++)
+        CHECK(output[ch][s] == 0);
+      for (s = latency; s < noise_size; s++)
+        CHECKT(output[ch][s] == input[ch][s - latency],
+          ("True peak %i: sample %i of channel %i is changed", true_peak, int(s), ch));
+    }
+    CHECK(lim.get_gain() == 1.0);
+
+    /////////////////////////////////////////////////////////
+    // Loud signal: output level, smooth gain, chunk size
+
+    bursts(rng, nch, noise_size, input);
+    output.allocate(nch, noise_size);
+    SampleBuf whole(nch, noise_size);
+    for (ch = 0; ch < nch; ch++)
+    {
+      memcpy(output[ch], input[ch], noise_size * sizeof(sample_t));
+      memcpy(whole[ch], input[ch], noise_size * sizeof(sample_t));
+    }
+
+    lim.reset();
+    process_chunks(lim, rng, output, noise_size);
+    lim.reset();
+    lim.process(whole.samples().samples, noise_size);
+
+    double max_step = 0, prev_gain = 1.0;
+    size_t prev_s = latency;
+    for (s = latency; s < noise_size; s++)
+      for (ch = 0; ch < nch; ch++)
+      {
+        CHECKT(fabs(output[ch][s]) <= level * (1 + eps),
+          ("True peak %i: sample %i of channel %i = %g is over the level", true_peak, int(s), ch, output[ch][s]));
+        CHECK(output[ch][s] == whole[ch][s]);
+
+        // gain step per sample (gain is measured at loud enough samples)
+        if (fabs(input[ch][s - latency]) > 0.1)
+        {
+          double gain = output[ch][s] / input[ch][s - latency];
+          if (s > prev_s)
+            max_step = MAX(max_step, fabs(gain - prev_gain) / (s - prev_s));
+          prev_gain = gain;
+          prev_s = s;
+        }
+      }
+    // gain falls by 1/lookahead of its range at most
+    CHECKT(max_step < 1.0 / lookahead + eps, ("True peak %i: gain step %g", true_peak, max_step));
+  }
+
+  /////////////////////////////////////////////////////////
+  // Inter-sample peaks: sine at fs/4 with samples at 45 degrees
+
+  SampleBuf sine(1, noise_size);
+  double sample_peak[2], tp[2];
+  for (int true_peak = 0; true_peak <= 1; true_peak++)
+  {
+    for (s = 0; s < noise_size; s++)
+      sine[0][s] = 2.0 * sin(M_PI / 2 * s + M_PI / 4);
+
+    CHECK(lim.init(1, lookahead, true_peak != 0));
+    lim.set_level(level);
+    lim.process(sine.samples().samples, noise_size);
+
+    sample_peak[true_peak] = 0;
+    for (s = lim.get_latency(); s < noise_size; s++)
+      sample_peak[true_peak] = MAX(sample_peak[true_peak], fabs(sine[0][s]));
+    tp[true_peak] = measure_true_peak(sine[0] + lim.get_latency(), 4096);
+    log->msg("True peak %i: sample peak %.2fdB, true peak %.2fdB",
+      true_peak, value2db(sample_peak[true_peak] / level), value2db(tp[true_peak] / level));
+  }
+  CHECK(sample_peak[0] <= level * (1 + eps) && tp[0] > level * 1.3);
+  CHECK(tp[1] < level * 1.01);
+TEST_END(limiter);
+
+///////////////////////////////////////////////////////////////////////////////
+// Sliding minimum
+
+// Exposes the deque: required gain of the last sample and the minimum
+class LimiterProbe : public Limiter
+{
+public:
+  int get_window() const    { return window; }
+  sample_t last_gain() const { return dq_gain[(dq_front + dq_size - 1) & (dq_ring - 1)]; }
+  sample_t min_gain() const  { return dq_gain[dq_front]; }
+};
+
+TEST(limiter_window, "Limiter sliding minimum")
+  // Power-of-2 windows: lookahead in sample-peak mode, lookahead + 1 in
+  // true-peak mode
+  static const struct { int lookahead; bool true_peak; } tests[] =
+  {
+    { 4, false }, { 16, false }, { 256, false }, { 15, true }, { 255, true }
+  };
+  const size_t size = 4096;
+  const sample_t level = 0.5;
+  LimiterProbe lim;
+  SampleBuf buf(1, size), req(1, size);
+
+  // Falling peak envelope: required gain grows, so nothing is dropped from
+  // the back of the deque and it holds the whole window
+  for (size_t s = 0; s < size; s++)
+    buf[0][s] = sample_t((s & 1? -1: 1) * (2.0 - double(s) / size));
+
+  for (int i = 0; i < array_size(tests); i++)
+  {
+    CHECK(lim.init(1, tests[i].lookahead, tests[i].true_peak));
+    lim.set_level(level);
+    int window = lim.get_window();
+    int latency = lim.get_latency();
+
+    SampleBuf out(1, size);
+    memcpy(out[0], buf[0], size * sizeof(sample_t));
+    sample_t peak = 0;
+    for (size_t s = 0; s < size; s++)
+    {
+      sample_t *ptr = out[0] + s;
+      lim.process(&ptr, 1);
+
+      req[0][s] = lim.last_gain();
+      sample_t min = req[0][s];
+      for (size_t j = s + 1 > size_t(window)? s + 1 - window: 0; j < s; j++)
+        if (req[0][j] < min) min = req[0][j];
+
+      CHECKT(lim.min_gain() == min,
+        ("Look-ahead %i, true peak %i: sample %i: minimum %g, must be %g",
+        tests[i].lookahead, tests[i].true_peak, int(s), lim.min_gain(), min));
+      if (s >= size_t(latency))
+        peak = MAX(peak, fabs(out[0][s]));
+    }
+    CHECKT(peak <= level * (1 + eps),
+      ("Look-ahead %i, true peak %i: output peak %g is over the level",
+      tests[i].lookahead, tests[i].true_peak, peak));
+  }
+TEST_END(limiter_window);
+
+///////////////////////////////////////////////////////////////////////////////
+// AGC in limiter mode
+
+static size_t run_filter(Filter *filter, Speakers spk, RNG &rng, const SampleBuf &input, size_t size, SampleBuf &output, bool &eos)
+{
+  SampleBuf work(spk.nch(), 1000);
+  Chunk chunk;
+  size_t in_pos = 0, out_pos = 0;
+  eos = false;
+
+  do {
+    size_t n = rng.next() % 1000;
+    n = MIN(n, size - in_pos);
+    for (int ch = 0; ch < spk.nch(); ch++)
+      memcpy(work[ch], input[ch] + in_pos, n * sizeof(sample_t));
+    in_pos += n;
+
+    chunk.set_linear(spk, work, n, false, 0, in_pos >= size);
+    filter->process(&chunk);
+    while (!filter->is_empty())
+    {
+      filter->get_chunk(&chunk);
+      for (int ch = 0; ch < spk.nch(); ch++)
+        memcpy(output[ch] + out_pos, chunk.samples[ch], MIN(chunk.size, output.nsamples() - out_pos) * sizeof(sample_t));
+      out_pos += chunk.size;
+      eos = eos || chunk.eos;
+    }
+  } while (in_pos < size);
+  return out_pos;
+}
+
+TEST(agc_limiter, "AGC limiter mode")
+  static const size_t sizes[] = { 0, 1, 100, noise_size };
+  Speakers spk(FORMAT_LINEAR, MODE_STEREO, 48000);
+  SampleBuf input, output;
+  RNG rng(seed);
+  bool eos;
+
+  AGC agc(1024);
+  agc.limiter = true;
+  agc.master = 0.5;
+  agc.limiter_level = 0.9;
+  agc.set_input(spk);
+
+  bursts(rng, spk.nch(), noise_size, input);
+  output.allocate(spk.nch(), noise_size);
+
+  for (int i = 0; i < array_size(sizes); i++)
+  {
+    size_t n = run_filter(&agc, spk, rng, input, sizes[i], output, eos);
+    CHECKT(n == sizes[i] && eos, ("%i samples in, %i samples out", int(sizes[i]), int(n)));
+
+    // Quiet samples are scaled only and stay in place
+    for (int ch = 0; ch < spk.nch(); ch++)
+      for (size_t s = 0; s < n; s++)
+      {
+        CHECK(fabs(output[ch][s]) <= 0.9 * (1 + eps));
+        if (s < 1000)
+          CHECK(output[ch][s] == input[ch][s] * 0.5);
+      }
+  }
+TEST_END(agc_limiter);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(limiter_speed, "Look-ahead limiter speed test")
+  static const int lookaheads[] = { 48, 4800 };
+  const int runs = 20;
+  const int nch = 6;
+  SampleBuf buf;
+  RNG rng(seed);
+  Limiter lim;
+
+  for (int true_peak = 0; true_peak <= 1; true_peak++)
+    for (int i = 0; i < array_size(lookaheads); i++)
+    {
+      CHECK(lim.init(nch, lookaheads[i], true_peak != 0));
+      lim.set_level(0.9);
+      bursts(rng, nch, noise_size, buf);
+
+      vtime_t time = local_time();
+      for (int run = 0; run < runs; run++)
+        lim.process(buf.samples().samples, noise_size);
+      time = local_time() - time;
+
+      log->msg("True peak %i, look-ahead %4i: %.1f Msamples/s",
+        true_peak, lookaheads[i], runs * noise_size * nch / time * 1e-6);
+    }
+TEST_END(limiter_speed);
@@ -0,0 +1,123 @@
+/*
+  MPA synthesis filter test
+  (classes defined at parsers/mpa/mpa_synth.h)
+
+  * SIMD synthesis filters must give bit-exact results with SynthBufferFPU
+    for a long sequence of blocks and after reset().
+  * Speed test: frames/s for a stereo Layer II stream (36 blocks of 32
+    samples per channel) for each implementation.
+*/
+
+#include <string.h>
+#include "parsers/mpa/mpa_synth.h"
+#include "rng.h"
+#include "../suite.h"
+
+static const int seed = 581737;
+static const int blocks = 10000;
+
+static void random_block(RNG &rng, sample_t samples[32])
+{
+  // Subband samples are fractions scaled with scalefactors
+  sample_t scale = sample_t(1.0 / (1 << (rng.next() % 16)));
+  for (int i = 0; i < 32; i++)
+    samples[i] = rng.get_sample() * scale;
+}
+
+static bool compare(SynthBuffer *ref, SynthBuffer *test, RNG &rng)
+{
+  sample_t in[32], ref_out[32], test_out[32];
+  for (int block = 0; block < blocks; block++)
+  {
+    random_block(rng, in);
+    memcpy(ref_out, in, sizeof(in));
+    memcpy(test_out, in, sizeof(in));
+    ref->synth(ref_out);
+    test->synth(test_out);
+    if (memcmp(ref_out, test_out, sizeof(ref_out)))
+      return false;
+  }
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(mpa_synth_exact, "MPA synthesis filters vs FPU")
+#ifdef VALIB_SIMD_X86
+  RNG rng(seed);
+  SynthBufferFPU fpu;
+#ifdef VALIB_SIMD_AVX
+  SynthBuffer *simd[2] = { new SynthBufferSSE2(), new SynthBufferAVX() };
+#else
+  SynthBuffer *simd[2] = { new SynthBufferSSE2(), 0 };
+#endif
+  const char *name[2] = { "SSE2", "AVX" };
+  const int caps[2] = { SIMD_SSE2, SIMD_AVX };
+
+  for (int i = 0; i < 2; i++)
+  {
+    if (!simd[i] || !simd_has(caps[i]))
+    {
+      log->msg("%s is not supported, skipping", name[i]);
+      continue;
+    }
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      fpu.reset();
+      simd[i]->reset();
+      CHECKT(compare(&fpu, simd[i], rng), ("%s (pass %i): result differs", name[i], pass));
+
+      // Make states different, next pass checks reset()
+      sample_t garbage[32];
+      random_block(rng, garbage);
+      simd[i]->synth(garbage);
+    }
+  }
+
+  delete simd[0];
+  delete simd[1];
+#endif
+TEST_END(mpa_synth_exact);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(mpa_synth_speed, "MPA synthesis filter speed test")
+  const int frames = 10000;
+  const int nch = 2;
+  sample_t in[36][32];
+  sample_t buf[32];
+  int frame, ch, i;
+
+  RNG rng(seed);
+  for (i = 0; i < 36; i++)
+    random_block(rng, in[i]);
+
+  SynthBuffer *synth[3] = { new SynthBufferFPU(), 0, 0 };
+  const char *name[3] = { "FPU", "SSE2", "AVX" };
+#ifdef VALIB_SIMD_X86
+  if (simd_has(SIMD_SSE2)) synth[1] = new SynthBufferSSE2();
+#endif
+#ifdef VALIB_SIMD_AVX
+  if (simd_has(SIMD_AVX))  synth[2] = new SynthBufferAVX();
+#endif
+
+  for (int s = 0; s < 3; s++)
+  {
+    if (!synth[s])
+      continue;
+
+    vtime_t time = local_time();
+    for (frame = 0; frame < frames; frame++)
+      for (ch = 0; ch < nch; ch++)
+        for (i = 0; i < 36; i++)
+        {
+          memcpy(buf, in[i], sizeof(buf));
+          synth[s]->synth(buf);
+        }
+    time = local_time() - time;
+    log->msg("%-5s %.0f frames/s", name[s], frames / time);
+    delete synth[s];
+  }
+TEST_END(mpa_synth_speed);
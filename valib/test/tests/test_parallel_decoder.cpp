@@ -0,0 +1,208 @@
+/*
+  Parallel decoder test
+  (class defined at parsers/parallel_decoder.h)
+
+  * Output of ParallelDecoder must be identical to sequential decoding with
+    FileParser and AC3Parser for any number of threads and job size. The
+    test file consists of 2 AC3 streams of different formats, so new stream
+    handling is checked too. Dithering is off.
+  * Speed test: sequential vs parallel decoding (frames/s).
+*/
+
+#include <stdio.h>
+#include <math.h>
+#include "parsers/parallel_decoder.h"
+#include "parsers/ac3/ac3_enc.h"
+#include "parsers/ac3/ac3_header.h"
+#include "parsers/ac3/ac3_parser.h"
+#include "rng.h"
+#include "../suite.h"
+
+static const int seed = 639281;
+static const char *filename = "test_parallel_decoder.ac3";
+
+///////////////////////////////////////////////////////////////////////////////
+// Sink that stores decoded samples and counts frames and streams
+
+class StoreSink : public NullSink
+{
+public:
+  bool    store;
+  Samples data;
+  size_t  size;
+  int     nframes;
+  int     nstreams;
+
+  StoreSink(bool _store = true): store(_store), size(0), nframes(0), nstreams(0)
+  {}
+
+  void add(Speakers _spk, samples_t samples, size_t nsamples)
+  {
+    if (!store)
+      return;
+
+    size_t add_size = _spk.nch() * nsamples;
+    if (data.size() < size + add_size)
+      data.reallocate((size + add_size) * 2);
+
+    for (int ch = 0; ch < _spk.nch(); ch++)
+      memcpy(data.data() + size + ch * nsamples, samples[ch], nsamples * sizeof(sample_t));
+    size += add_size;
+  }
+
+  virtual bool process(const Chunk *chunk)
+  {
+    if (chunk->eos)
+      nstreams++;
+    if (chunk->size)
+    {
+      add(chunk->spk, chunk->samples, chunk->size);
+      nframes++;
+    }
+    return NullSink::process(chunk);
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Encode test file: 2 streams of noise and tones
+
+static bool encode_stream(FILE *f, Speakers spk, int bitrate, int frames, RNG &rng)
+{
+  SampleBuf buf(spk.nch(), AC3_FRAME_SAMPLES);
+  AC3Enc enc;
+  if (!enc.set_bitrate(bitrate) || !enc.set_input(spk))
+    return false;
+
+  Chunk chunk;
+  for (int frame = 0; frame < frames; frame++)
+  {
+    for (int ch = 0; ch < spk.nch(); ch++)
+      for (int i = 0; i < AC3_FRAME_SAMPLES; i++)
+      {
+        double t = double(frame * AC3_FRAME_SAMPLES + i);
+        buf[ch][i] = (rng.get_sample() * 0.3 + 0.5 * sin(t * 0.01 * (ch + 1))) * spk.level;
+      }
+
+    Chunk in(spk, buf, AC3_FRAME_SAMPLES);
+    if (!enc.process(&in))
+      return false;
+
+    while (!enc.is_empty())
+    {
+      if (!enc.get_chunk(&chunk))
+        return false;
+      if (chunk.size)
+        fwrite(chunk.rawdata, 1, chunk.size, f);
+    }
+  }
+  return true;
+}
+
+static bool make_file(int frames)
+{
+  RNG rng(seed);
+  FILE *f = fopen(filename, "wb");
+  if (!f)
+    return false;
+
+  bool result =
+    encode_stream(f, Speakers(FORMAT_LINEAR, MODE_5_1, 48000), 448000, frames, rng) &&
+    encode_stream(f, Speakers(FORMAT_LINEAR, MODE_STEREO, 48000), 192000, frames / 2, rng);
+
+  fclose(f);
+  return result;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference sequential decoding
+
+static bool decode_seq(StoreSink *sink)
+{
+  FileParser file;
+  AC3Parser parser;
+  parser.do_dither = false;
+
+  if (!file.open(filename, &ac3_header))
+    return false;
+
+  while (file.load_frame())
+  {
+    if (file.is_new_stream())
+    {
+      parser.reset();
+      sink->nstreams++;
+    }
+
+    if (parser.parse_frame(file.get_frame(), file.get_frame_size()))
+    {
+      sink->add(parser.get_spk(), parser.get_samples(), parser.get_nsamples());
+      sink->nframes++;
+    }
+  }
+  return true;
+}
+
+static bool decode_par(ParallelDecoder *dec, StoreSink *sink)
+{
+  FileParser file;
+  if (!file.open(filename, &ac3_header))
+    return false;
+  return dec->decode(&file, sink);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(parallel_decoder, "ParallelDecoder vs sequential decoding")
+  const int threads[] = { 1, 2, 3, 8 };
+  const int job_frames[] = { 1, 5, 16 };
+
+  CHECKT(make_file(100), ("Cannot create the test file"));
+
+  StoreSink ref;
+  CHECKT(decode_seq(&ref), ("Cannot open the test file"));
+
+  for (int i = 0; i < array_size(threads); i++)
+    for (int j = 0; j < array_size(job_frames); j++)
+    {
+      StoreSink test;
+      ParallelDecoder dec(threads[i]);
+      dec.job_frames = job_frames[j];
+      dec.dither = false;
+
+      CHECKT(decode_par(&dec, &test), ("threads = %i, job = %i: decode() failed", threads[i], job_frames[j]));
+      CHECKT(dec.get_errors() == 0, ("threads = %i, job = %i: %i errors", threads[i], job_frames[j], dec.get_errors()));
+      CHECKT(test.nframes == ref.nframes && test.nstreams == ref.nstreams,
+        ("threads = %i, job = %i: %i frames, %i streams (must be %i, %i)",
+        threads[i], job_frames[j], test.nframes, test.nstreams, ref.nframes, ref.nstreams));
+      CHECKT(test.size == ref.size && memcmp(test.data, ref.data, ref.size * sizeof(sample_t)) == 0,
+        ("threads = %i, job = %i: output differs", threads[i], job_frames[j]));
+    }
+
+  remove(filename);
+TEST_END(parallel_decoder);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(parallel_decoder_speed, "ParallelDecoder speed test")
+  CHECKT(make_file(500), ("Cannot create the test file"));
+
+  StoreSink seq(false);
+  vtime_t time = local_time();
+  decode_seq(&seq);
+  time = local_time() - time;
+  log->msg("Sequential: %.0f frames/s", seq.nframes / time);
+
+  int cpus = ParallelDecoder::get_cpus();
+  for (int threads = 1; threads <= cpus; threads *= 2)
+  {
+    StoreSink par(false);
+    ParallelDecoder dec(threads);
+    time = local_time();
+    decode_par(&dec, &par);
+    time = local_time() - time;
+    log->msg("%i threads: %.0f frames/s", threads, par.nframes / time);
+  }
+
+  remove(filename);
+TEST_END(parallel_decoder_speed);
@@ -0,0 +1,335 @@
+/*
+  Sample precision test
+  Processing with sample_t must not lose more than max_err_db of quality
+  compared to the double-precision reference computed here. The test is
+  useful for the single-precision build (FLOAT_SAMPLE defined), but must
+  pass for both builds.
+
+  * Mixer: random 5.1 -> stereo matrix (matrix multiplication as reference)
+  * Convolver: long low-pass filter (direct convolution as reference)
+  * Resample: tone 48kHz -> 44.1kHz (ideal tone as reference)
+  * AGC and Levels: constant gain (scaled input and its peak as reference)
+  * Converter: PCM16/24/32 -> Linear (integer values as reference)
+
+  The error is the maximum difference relative to the peak level of the
+  reference.
+*/
+
+#include <math.h>
+#include "filters/agc.h"
+#include "filters/convert.h"
+#include "filters/convolver.h"
+#include "filters/levels.h"
+#include "filters/mixer.h"
+#include "filters/resample.h"
+#include "fir/param_fir.h"
+#include "rng.h"
+#include "../suite.h"
+
+static const int seed = 735012;
+static const size_t noise_size = 64 * 1024;
+static const size_t chunk_size = 4096;
+
+// Single-precision sample has 24-bit mantissa (-144dB). Long filters and
+// resampling accumulate the rounding error, so we allow 24dB for it.
+static const double max_err_db = -120;
+
+typedef AutoBuf<double> RefBuf;
+
+// Run the input through the filter and collect up to output.nsamples()
+// samples. Input is copied for each chunk because the filter may work
+// in-place. Returns the number of output samples.
+
+static size_t run_filter(Filter *filter, Speakers spk, const SampleBuf &input, size_t size, SampleBuf &output)
+{
+  Speakers out_spk = filter->get_output();
+  SampleBuf work(spk.nch(), chunk_size);
+  Chunk chunk;
+  int ch;
+
+  size_t in_pos = 0, out_pos = 0;
+  while (in_pos < size)
+  {
+    size_t n = MIN(chunk_size, size - in_pos);
+    for (ch = 0; ch < spk.nch(); ch++)
+      memcpy(work[ch], input[ch] + in_pos, n * sizeof(sample_t));
+    in_pos += n;
+
+    chunk.set_linear(spk, work, n, false, 0, in_pos >= size);
+    filter->process(&chunk);
+    while (!filter->is_empty())
+    {
+      filter->get_chunk(&chunk);
+      n = MIN(chunk.size, output.nsamples() - out_pos);
+      for (ch = 0; ch < out_spk.nch(); ch++)
+        memcpy(output[ch] + out_pos, chunk.samples[ch], n * sizeof(sample_t));
+      out_pos += n;
+    }
+  }
+  return out_pos;
+}
+
+// Maximum error in dB relative to the reference peak level at [start, end)
+
+static double calc_err_db(const SampleBuf &test, const RefBuf *ref, int nch, size_t start, size_t end)
+{
+  double diff = 0, level = 0;
+  for (int ch = 0; ch < nch; ch++)
+    for (size_t s = start; s < end; s++)
+    {
+      diff = MAX(diff, fabs(test[ch][s] - ref[ch][s]));
+      level = MAX(level, fabs(ref[ch][s]));
+    }
+  return log10(diff / level) * 20;
+}
+
+static void noise(RNG &rng, int nch, size_t size, SampleBuf &buf)
+{
+  buf.allocate(nch, size);
+  for (int ch = 0; ch < nch; ch++)
+    rng.fill_samples(buf[ch], size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(precision_mixer, "Mixer precision")
+  Speakers in_spk(FORMAT_LINEAR, MODE_5_1, 48000);
+  Speakers out_spk(FORMAT_LINEAR, MODE_STEREO, 48000);
+  const short int *in_order = in_spk.order();
+  const short int *out_order = out_spk.order();
+
+  RNG rng(seed);
+  matrix_t matrix;
+  for (int i = 0; i < NCHANNELS; i++)
+    for (int j = 0; j < NCHANNELS; j++)
+      matrix[i][j] = rng.get_sample();
+
+  SampleBuf input, output(out_spk.nch(), noise_size);
+  RefBuf ref[NCHANNELS];
+  noise(rng, in_spk.nch(), noise_size, input);
+
+  for (int o = 0; o < out_spk.nch(); o++)
+  {
+    ref[o].allocate(noise_size);
+    for (size_t s = 0; s < noise_size; s++)
+    {
+      double sum = 0;
+      for (int i = 0; i < in_spk.nch(); i++)
+        sum += double(input[i][s]) * double(matrix[in_order[i]][out_order[o]]);
+      ref[o][s] = sum;
+    }
+  }
+
+  Mixer mixer(1024);
+  mixer.set_input(in_spk);
+  mixer.set_output(out_spk);
+  mixer.set_auto_matrix(false);
+  mixer.set_matrix(matrix);
+
+  size_t n = run_filter(&mixer, in_spk, input, noise_size, output);
+  CHECK(n == noise_size);
+
+  double err = calc_err_db(output, ref, out_spk.nch(), 0, n);
+  log->msg("Mixer error: %.0fdB", err);
+  CHECK(err < max_err_db);
+TEST_END(precision_mixer);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(precision_convolver, "Convolver precision")
+  Speakers spk(FORMAT_LINEAR, MODE_STEREO, 48000);
+  ParamFIR low_pass(FIR_LOW_PASS, 1000, 0, 100, 100);
+
+  const FIRInstance *fir = low_pass.make(spk.sample_rate);
+  CHECK(fir != 0);
+
+  RNG rng(seed);
+  SampleBuf input, output(spk.nch(), noise_size);
+  RefBuf ref[NCHANNELS];
+  noise(rng, spk.nch(), noise_size, input);
+
+  for (int ch = 0; ch < spk.nch(); ch++)
+  {
+    ref[ch].allocate(noise_size);
+    for (int s = 0; s < (int)noise_size; s++)
+    {
+      double sum = 0;
+      for (int i = 0; i < fir->length; i++)
+      {
+        int pos = s + fir->center - i;
+        if (pos >= 0 && pos < (int)noise_size)
+          sum += fir->data[i] * double(input[ch][pos]);
+      }
+      ref[ch][s] = sum;
+    }
+  }
+  safe_delete(fir);
+
+  Convolver conv(&low_pass);
+  conv.set_input(spk);
+
+  size_t n = run_filter(&conv, spk, input, noise_size, output);
+  CHECK(n == noise_size);
+
+  double err = calc_err_db(output, ref, spk.nch(), 0, n);
+  log->msg("Convolver error: %.0fdB", err);
+  CHECK(err < max_err_db);
+TEST_END(precision_convolver);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(precision_resample, "Resample precision")
+  // Resampler noise must be much lower than the threshold,
+  // so we use higher attenuation than the default.
+  const int freq = 1000;
+  const int rate1 = 48000;
+  const int rate2 = 44100;
+  const size_t out_size = size_t(noise_size) * rate2 / rate1;
+  const size_t trans = 4096; // transient process at stream ends
+
+  Speakers spk(FORMAT_LINEAR, MODE_STEREO, rate1);
+  SampleBuf input(spk.nch(), noise_size), output(spk.nch(), out_size);
+  RefBuf ref[NCHANNELS];
+
+  for (int ch = 0; ch < spk.nch(); ch++)
+  {
+    for (size_t s = 0; s < noise_size; s++)
+      input[ch][s] = sin(2 * M_PI * freq * s / rate1 + ch);
+
+    ref[ch].allocate(out_size);
+    for (size_t s = 0; s < out_size; s++)
+      ref[ch][s] = sin(2 * M_PI * freq * s / rate2 + ch);
+  }
+
+  Resample res(rate2, 140, 0.99);
+  res.set_input(spk);
+
+  size_t n = run_filter(&res, spk, input, noise_size, output);
+  CHECK(n == out_size);
+
+  double err = calc_err_db(output, ref, spk.nch(), trans, n - trans);
+  log->msg("Resample error: %.0fdB", err);
+  CHECK(err < max_err_db);
+TEST_END(precision_resample);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(precision_agc, "AGC and Levels precision")
+  const double gain = 0.3;
+  Speakers spk(FORMAT_LINEAR, MODE_5_1, 48000);
+
+  RNG rng(seed);
+  SampleBuf input, output(spk.nch(), noise_size);
+  RefBuf ref[NCHANNELS];
+  noise(rng, spk.nch(), noise_size, input);
+
+  double peak[NCHANNELS];
+  for (int ch = 0; ch < spk.nch(); ch++)
+  {
+    peak[ch] = 0;
+    ref[ch].allocate(noise_size);
+    for (size_t s = 0; s < noise_size; s++)
+    {
+      ref[ch][s] = double(input[ch][s]) * gain;
+      peak[ch] = MAX(peak[ch], fabs(ref[ch][s]));
+    }
+  }
+
+  AGC agc(1024);
+  agc.auto_gain = false;
+  agc.master = gain;
+  agc.set_input(spk);
+
+  size_t n = run_filter(&agc, spk, input, noise_size, output);
+  CHECK(n == noise_size);
+
+  double err = calc_err_db(output, ref, spk.nch(), 0, n);
+  log->msg("AGC error: %.0fdB", err);
+  CHECK(err < max_err_db);
+
+  // Measure the levels of the AGC output
+
+  Levels levels(1024);
+  levels.set_input(spk);
+  run_filter(&levels, spk, output, n, output);
+
+  const short int *order = spk.order();
+  for (int ch = 0; ch < spk.nch(); ch++)
+  {
+    err = log10(fabs(levels.get_max_level(order[ch]) - peak[ch]) / peak[ch]) * 20;
+    CHECKT(err < max_err_db, ("Levels error: %.0fdB (ch %i)", err, ch));
+  }
+TEST_END(precision_agc);
+
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(precision_convert, "PCM -> Linear conversion precision")
+  static const int formats[] = { FORMAT_PCM16, FORMAT_PCM24, FORMAT_PCM32 };
+  const size_t nsamples = noise_size / 4;
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> raw;
+  SampleBuf output;
+  RefBuf ref[NCHANNELS];
+  Chunk chunk;
+
+  for (int f = 0; f < array_size(formats); f++)
+  {
+    Speakers spk(formats[f], MODE_STEREO, 48000);
+    int nch = spk.nch();
+    int size = sample_size(spk.format);
+
+    raw.allocate(nsamples * nch * size);
+    rng.fill_raw(raw, raw.size());
+
+    // Reference: integer values shifted by 0.5 (see convert_func.cpp)
+    for (int ch = 0; ch < nch; ch++)
+    {
+      ref[ch].allocate(nsamples);
+      for (size_t s = 0; s < nsamples; s++)
+      {
+        uint8_t *p = raw + (s * nch + ch) * size;
+        int32_t i;
+        switch (spk.format)
+        {
+          case FORMAT_PCM16: i = le2int16(*(int16_t *)p); break;
+          case FORMAT_PCM24: i = le2int24(*(int24_t *)p); break;
+          default:           i = le2int32(*(int32_t *)p); break;
+        }
+        ref[ch][s] = double(i) + 0.5;
+      }
+    }
+
+    Converter conv(2048);
+    conv.set_format(FORMAT_LINEAR);
+    conv.set_input(spk);
+    output.allocate(nch, nsamples);
+
+    size_t out_pos = 0;
+    chunk.set_rawdata(spk, raw, raw.size(), false, 0, true);
+    conv.process(&chunk);
+    while (!conv.is_empty())
+    {
+      conv.get_chunk(&chunk);
+      size_t n = MIN(chunk.size, nsamples - out_pos);
+      for (int ch = 0; ch < nch; ch++)
+        memcpy(output[ch] + out_pos, chunk.samples[ch], n * sizeof(sample_t));
+      out_pos += n;
+    }
+    CHECK(out_pos == nsamples);
+
+    double err = calc_err_db(output, ref, nch, 0, out_pos);
+    log->msg("%s error: %.0fdB", spk.format_text(), err);
+    CHECK(err < max_err_db);
+  }
+TEST_END(precision_convert);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(precision, "Sample precision test")
+  TEST_FACTORY(precision_mixer),
+  TEST_FACTORY(precision_convolver),
+  TEST_FACTORY(precision_resample),
+  TEST_FACTORY(precision_agc),
+  TEST_FACTORY(precision_convert),
+SUITE_END;
@@ -0,0 +1,193 @@
+/*
+  SyncScan test
+  * Scanner must find all syncpoints (compared with get_sync() at each
+    position) in both internal and external buffer modes, for scalar and
+    SIMD code and any block size.
+  * Speed test: scan noise and zeros for standard syncpoints (MB/s).
+*/
+
+#include "buffer.h"
+#include "syncscan.h"
+#include "rng.h"
+#include "simd.h"
+#include "../suite.h"
+
+static const int seed = 927341;
+static const size_t data_size = 256 * 1024;
+
+// Syncwords of standard syncpoints inserted into the noise
+static const uint32_t syncwords[] =
+{
+  0x0b770000, 0x770b0000,             // AC3
+  0xff1f00e8, 0x1fffe800,             // DTS16
+  0xfe7f0180, 0x7ffe8001,             // DTS14
+  0x72f81f4e,                         // SPDIF
+  0xfffc0000                          // MPA
+};
+
+static void make_data(RNG &rng, uint8_t *data, size_t size)
+{
+  rng.fill_raw(data, size);
+  for (int i = 0; i < 1000; i++)
+  {
+    size_t pos = rng.next() % (size - 4);
+    uint32_t sync = syncwords[rng.next() % array_size(syncwords)];
+    data[pos + 0] = uint8_t(sync >> 24);
+    data[pos + 1] = uint8_t(sync >> 16);
+    if (sync & 0xffff)
+    {
+      data[pos + 2] = uint8_t(sync >> 8);
+      data[pos + 3] = uint8_t(sync);
+    }
+  }
+}
+
+// Reference: check each position
+static size_t find_all(const SyncScan &scan, uint8_t *data, size_t size, size_t *result)
+{
+  size_t n = 0;
+  for (size_t pos = 0; pos + 4 <= size; pos++)
+    if (scan.get_sync(data + pos))
+      result[n++] = pos;
+  return n;
+}
+
+static size_t scan_internal(RNG &rng, SyncScan &scan, uint8_t *data, size_t size, size_t *result)
+{
+  size_t n = 0;
+  uint8_t *pos = data;
+  uint8_t *end = data + size;
+
+  scan.reset();
+  while (pos < end)
+  {
+    size_t block = rng.next() % 1000 + 1;
+    block = MIN(block, size_t(end - pos));
+    size_t gone = scan.scan(pos, block);
+    pos += gone;
+    if (scan.get_sync())
+      result[n++] = pos - data - 4;
+  }
+  return n;
+}
+
+static size_t scan_external(RNG &rng, SyncScan &scan, uint8_t *data, size_t size, size_t *result)
+{
+  size_t n = 0;
+  uint8_t syncbuf[4];
+  uint8_t *pos = data + 4;
+  uint8_t *end = data + size;
+
+  memcpy(syncbuf, data, 4);
+  if (scan.get_sync(syncbuf))
+    result[n++] = 0;
+
+  while (pos < end)
+  {
+    size_t block = rng.next() % 1000 + 1;
+    block = MIN(block, size_t(end - pos));
+    size_t gone = scan.scan(syncbuf, pos, block);
+    pos += gone;
+    if (scan.get_sync(syncbuf))
+      result[n++] = pos - data - 4;
+  }
+  return n;
+}
+
+static bool equal_pos(const size_t *pos1, size_t n1, const size_t *pos2, size_t n2)
+{
+  return n1 == n2 && memcmp(pos1, pos2, n1 * sizeof(size_t)) == 0;
+}
+
+TEST(syncscan_simd, "Scalar and SIMD scan")
+  static const uint32_t syncmasks[] =
+  {
+    SYNCMASK_MAD,
+    SYNCMASK_AC3 | SYNCMASK_DTS,
+    SYNCMASK_MPA_LE,
+    SYNCMASK_SPDIF,
+    SYNCMASK_MAD | SYNCMASK_SPDIF | SYNCMASK_PS
+  };
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> data(data_size);
+  AutoBuf<size_t> ref(data_size), test(data_size);
+  make_data(rng, data, data_size);
+
+  int old_mask = simd_get_mask();
+  for (int i = 0; i < array_size(syncmasks); i++)
+  {
+    SyncScan scan;
+    scan.set_standard(syncmasks[i]);
+
+    size_t nref = find_all(scan, data, data_size, ref);
+    CHECK(nref > 0);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      const char *code = pass? "SIMD": "Scalar";
+      size_t n;
+
+      n = scan_internal(rng, scan, data, data_size, test);
+      CHECKT(equal_pos(ref, nref, test, n), ("%s internal buffer scan, syncmask = %x: %i syncpoints found, %i expected", code, syncmasks[i], n, nref));
+
+      n = scan_external(rng, scan, data, data_size, test);
+      CHECKT(equal_pos(ref, nref, test, n), ("%s external buffer scan, syncmask = %x: %i syncpoints found, %i expected", code, syncmasks[i], n, nref));
+    }
+  }
+  simd_set_mask(old_mask);
+TEST_END(syncscan_simd);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(syncscan_speed, "SyncScan speed test")
+  const size_t size = 1024 * 1024;
+  const int runs = 500;
+
+  RNG rng(seed);
+  AutoBuf<uint8_t> data(size);
+  SyncScan scan;
+  scan.set_standard(SYNCMASK_MAD | SYNCMASK_SPDIF);
+
+  int old_mask = simd_get_mask();
+  for (int zeros = 0; zeros < 2; zeros++)
+  {
+    // Noise is a worst case: it has many false syncpoints
+    if (zeros)
+      memset(data, 0, size);
+    else
+      rng.fill_raw(data, size);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+      simd_set_mask(pass? old_mask: SIMD_NONE);
+      int syncpoints = 0;
+
+      vtime_t time = local_time();
+      for (int i = 0; i < runs; i++)
+      {
+        uint8_t *pos = data;
+        uint8_t *end = data + size;
+        scan.reset();
+        while (pos < end)
+        {
+          pos += scan.scan(pos, end - pos);
+          if (scan.get_sync())
+            syncpoints++;
+        }
+      }
+      time = local_time() - time;
+      log->msg("%-6s %-7s %.0fMB/s (%i syncpoints)", zeros? "Zeros:": "Noise:",
+        pass? "SIMD:": "Scalar:", double(size) * runs / 1024 / 1024 / time, syncpoints / runs);
+    }
+  }
+  simd_set_mask(old_mask);
+TEST_END(syncscan_speed);
+
+///////////////////////////////////////////////////////////////////////////////
+
+SUITE(syncscan, "SyncScan test")
+  TEST_FACTORY(syncscan_simd),
+SUITE_END;
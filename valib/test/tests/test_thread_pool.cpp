@@ -0,0 +1,77 @@
+/*
+  Thread pool test
+  (class defined at thread_pool.h)
+
+  * Each job of a run must be done exactly once, for any number of threads
+    and jobs, including runs after the number of threads was changed.
+  * The same for asynchronous runs, mixed with synchronous ones.
+  * Speed test: time of an empty run (cost of waking threads up).
+*/
+
+#include <string.h>
+#include "thread_pool.h"
+#include "vtime.h"
+#include "../suite.h"
+
+static const int max_jobs = 64;
+
+struct Counter
+{
+  int count[max_jobs];
+};
+
+static void count_proc(void *param, int job)
+{
+  ((Counter *)param)->count[job]++;
+}
+
+static void empty_proc(void *, int)
+{}
+
+TEST(thread_pool, "Thread pool")
+  static const int threads[] = { 1, 2, 3, 8, 1, 4 };
+  static const int jobs[] = { 0, 1, 2, 3, 7, 8, 64 };
+  const int runs = 100;
+
+  ThreadPool pool;
+  CHECK(pool.get_threads() == 1);
+  CHECK(!pool.set_threads(-1));
+  CHECK(pool.set_threads(0) && pool.get_threads() == ThreadPool::get_cpus());
+
+  for (int i = 0; i < array_size(threads); i++)
+  {
+    CHECK(pool.set_threads(threads[i]));
+    CHECK(pool.get_threads() == threads[i]);
+
+    for (int j = 0; j < array_size(jobs); j++)
+    {
+      Counter counter;
+      memset(&counter, 0, sizeof(counter));
+      for (int run = 0; run < runs; run++)
+        if (run & 1)
+          pool.run(count_proc, &counter, jobs[j]);
+        else
+          pool.run_async(count_proc, &counter, jobs[j]);
+      pool.wait();
+
+      for (int job = 0; job < jobs[j]; job++)
+        CHECKT(counter.count[job] == runs,
+          ("%i threads, %i jobs: job %i is done %i times of %i", threads[i], jobs[j], job, counter.count[job], runs));
+    }
+  }
+TEST_END(thread_pool);
+
+///////////////////////////////////////////////////////////////////////////////
+// Speed test
+
+TEST(thread_pool_speed, "Thread pool speed test")
+  const int runs = 10000;
+  ThreadPool pool(MAX(ThreadPool::get_cpus(), 2));
+
+  vtime_t time = local_time();
+  for (int run = 0; run < runs; run++)
+    pool.run(empty_proc, 0, pool.get_threads());
+  time = local_time() - time;
+
+  log->msg("%i threads: %.1fus per run", pool.get_threads(), time / runs * 1e6);
+TEST_END(thread_pool_speed);
@@ -1,6 +1,16 @@
 #include <limits.h>
 #include "auto_file.h"
 
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
 #if defined(_MSC_VER) && (_MSC_VER >= 1400)
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -114,3 +124,160 @@ MemFile::~MemFile()
 {
   safe_delete(data);
 }
+
+///////////////////////////////////////////////////////////////////////////////
+// MapFile
+
+MapFile::MapFile(): filesize(-1), view(0), view_size(0)
+{
+#ifdef _WIN32
+  file = INVALID_HANDLE_VALUE;
+  mapping = 0;
+#else
+  fd = -1;
+#endif
+}
+
+MapFile::~MapFile()
+{
+  close();
+}
+
+#ifdef _WIN32
+
+size_t
+MapFile::granularity()
+{
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  return sysinfo.dwAllocationGranularity;
+}
+
+bool
+MapFile::open(const char *filename)
+{
+  close();
+
+  file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+
+  DWORD size_hi = 0;
+  DWORD size_lo = GetFileSize(file, &size_hi);
+  if (size_lo == INVALID_FILE_SIZE && GetLastError() != NO_ERROR)
+  {
+    close();
+    return false;
+  }
+
+  // Empty file cannot be mapped
+  mapping = CreateFileMapping(file, 0, PAGE_WRITECOPY, 0, 0, 0);
+  if (!mapping)
+  {
+    close();
+    return false;
+  }
+
+  filesize = ((fsize_t)size_hi << 32) | size_lo;
+  return true;
+}
+
+void
+MapFile::close()
+{
+  unmap();
+  if (mapping)
+    CloseHandle(mapping);
+  if (file != INVALID_HANDLE_VALUE)
+    CloseHandle(file);
+  file = INVALID_HANDLE_VALUE;
+  mapping = 0;
+  filesize = -1;
+}
+
+uint8_t *
+MapFile::map(fsize_t pos, size_t size)
+{
+  unmap();
+  if (!is_open() || pos < 0 || size == 0 || pos + (fsize_t)size > filesize)
+    return 0;
+
+  view = (uint8_t *)MapViewOfFile(mapping, FILE_MAP_COPY, DWORD(pos >> 32), DWORD(pos), size);
+  view_size = view? size: 0;
+  return view;
+}
+
+void
+MapFile::unmap()
+{
+  if (view)
+    UnmapViewOfFile(view);
+  view = 0;
+  view_size = 0;
+}
+
+#else
+
+size_t
+MapFile::granularity()
+{
+  long page_size = sysconf(_SC_PAGESIZE);
+  return page_size > 0? (size_t)page_size: 4096;
+}
+
+bool
+MapFile::open(const char *filename)
+{
+  close();
+
+  fd = ::open(filename, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    close();
+    return false;
+  }
+
+  filesize = (fsize_t)st.st_size;
+  return true;
+}
+
+void
+MapFile::close()
+{
+  unmap();
+  if (fd >= 0)
+    ::close(fd);
+  fd = -1;
+  filesize = -1;
+}
+
+uint8_t *
+MapFile::map(fsize_t pos, size_t size)
+{
+  unmap();
+  if (!is_open() || pos < 0 || size == 0 || pos + (fsize_t)size > filesize)
+    return 0;
+
+  void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)pos);
+  if (p == MAP_FAILED)
+    return 0;
+
+  view = (uint8_t *)p;
+  view_size = size;
+  return view;
+}
+
+void
+MapFile::unmap()
+{
+  if (view)
+    munmap(view, view_size);
+  view = 0;
+  view_size = 0;
+}
+
+#endif
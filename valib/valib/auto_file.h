@@ -1,6 +1,7 @@
 /*
   AutoFile - Simple file helper class. Supports large files >2G.
   MemFile - Load the whole file into memory.
+  MapFile - Memory-mapped file, read-only, maps a view of the file at a time.
 
   AutoFile may support large files >2G (currently only in Visual C++). If you
   open a large file without large file support, file size is set to
@@ -18,6 +19,12 @@
 
   is_large() helps to detect a large value that cannot be cast to size_t.
   size_cast() casts the value to size_t. Returns -1 when the value is too large.
+
+  MapFile maps a part of the file (view) into memory. Only one view exists at
+  a time, so a large file may be walked with a window smaller than the address
+  space. The view is copy-on-write: it may be modified (in-place processing),
+  but changes never go to the file. View position must be a multiple of
+  granularity().
 */
 
 #ifndef VALIB_AUTO_FILE_H
@@ -86,4 +93,43 @@ public:
   inline operator uint8_t *() const { return (uint8_t *)data; }
 };
 
+
+class MapFile
+{
+public:
+  typedef AutoFile::fsize_t fsize_t;
+
+protected:
+#ifdef _WIN32
+  void *file;
+  void *mapping;
+#else
+  int fd;
+#endif
+  fsize_t filesize;
+
+  uint8_t *view;
+  size_t   view_size;
+
+  MapFile(const MapFile &);
+  MapFile &operator =(const MapFile &);
+
+public:
+  MapFile();
+  ~MapFile();
+
+  static size_t granularity();
+
+  bool open(const char *filename);
+  void close();
+
+  uint8_t *map(fsize_t pos, size_t size);
+  void unmap();
+
+  inline bool     is_open()   const { return filesize >= 0; }
+  inline fsize_t  size()      const { return filesize;      }
+  inline uint8_t *data()      const { return view;          }
+  inline size_t   data_size() const { return view_size;     }
+};
+
 #endif
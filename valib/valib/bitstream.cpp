@@ -5,16 +5,16 @@
 
 ReadBS::ReadBS(): 
   start(0), start_bit(0), size_bits(0),
-  pos(0), current_word(0), bits_left(0)
+  pos(0), end(0), cache(0), bits_left(0)
 {}
 
 void 
 ReadBS::set(const uint8_t *buf_, size_t start_bit_, size_t size_bits_)
 {
-  size_t align = align32(buf_);
-  start = (const uint32_t *)(buf_ - align);
-  start_bit = start_bit_ + align * 8;
+  start = buf_;
+  start_bit = start_bit_;
   size_bits = size_bits_;
+  end = buf_ + (start_bit + size_bits + 7) / 8;
 
   set_pos_bits(0);
 }
@@ -24,49 +24,105 @@ ReadBS::set_pos_bits(size_t pos_bits)
 {
   assert(pos_bits <= size_bits);
 
-  pos = start + (start_bit + pos_bits) / 32;
-  bits_left = 32 - ((start_bit + pos_bits) & 0x1f);
-  current_word = be2uint32(*pos);
-  pos++;
+  pos = start + (start_bit + pos_bits) / 8;
+  cache = 0;
+  bits_left = 0;
+  refill();
+
+  unsigned shift = (start_bit + pos_bits) & 7;
+  cache <<= shift;
+  bits_left -= shift;
 }
 
-uint32_t
-ReadBS::get_next(unsigned num_bits)
+void
+ReadBS::refill_tail()
 {
-  uint32_t result;
-  result = (current_word << (32 - bits_left)) >> (32 - bits_left);
-  num_bits -= bits_left;
+  // Load the end of the stream byte by byte. Bits beyond
+  // the end of the stream are zeros.
+  while (bits_left <= 56)
+  {
+    if (pos < end)
+      cache |= (uint64_t)*pos << (56 - bits_left);
+    pos++;
+    bits_left += 8;
+  }
+}
 
-  current_word = be2uint32(*pos);
-  bits_left = 32;
-  pos++;
+void
+ReadBS::get_n(unsigned num_bits, uint32_t *values, size_t count)
+{
+  assert(num_bits <= 32);
+  assert(get_pos_bits() + num_bits * count <= size_bits);
 
-  if (num_bits != 0)
-    result = (result << num_bits) | (current_word >> (32 - num_bits));
+  if (num_bits == 0)
+  {
+    memset(values, 0, count * sizeof(uint32_t));
+    return;
+  }
 
-  bits_left -= num_bits;
+  // Refill once per group of values that fit into the cache
+  const size_t group = 56 / num_bits;
+  while (count >= group)
+  {
+    refill();
+    for (size_t i = 0; i < group; i++)
+    {
+      values[i] = (uint32_t)(cache >> (64 - num_bits));
+      cache <<= num_bits;
+    }
+    bits_left -= unsigned(group * num_bits);
+    values += group;
+    count -= group;
+  }
 
-  return result;
+  if (count)
+  {
+    refill();
+    while (count--)
+    {
+      *values++ = (uint32_t)(cache >> (64 - num_bits));
+      cache <<= num_bits;
+      bits_left -= num_bits;
+    }
+  }
 }
 
-int32_t
-ReadBS::get_next_signed(unsigned num_bits)
+void
+ReadBS::get_signed_n(unsigned num_bits, int32_t *values, size_t count)
 {
-  int32_t result;
-
-  result = int32_t(current_word << (32 - bits_left)) >> (32 - bits_left);
-  num_bits -= bits_left;
+  assert(num_bits <= 32);
+  assert(get_pos_bits() + num_bits * count <= size_bits);
 
-  current_word = be2uint32(*pos);
-  bits_left = 32;
-  pos++;
+  if (num_bits == 0)
+  {
+    memset(values, 0, count * sizeof(int32_t));
+    return;
+  }
 
-  if (num_bits != 0)
-    result = (result << num_bits) | (current_word >> (32 - num_bits));
-        
-  bits_left -= num_bits;
+  const size_t group = 56 / num_bits;
+  while (count >= group)
+  {
+    refill();
+    for (size_t i = 0; i < group; i++)
+    {
+      values[i] = (int32_t)((int64_t)cache >> (64 - num_bits));
+      cache <<= num_bits;
+    }
+    bits_left -= unsigned(group * num_bits);
+    values += group;
+    count -= group;
+  }
 
-  return result;
+  if (count)
+  {
+    refill();
+    while (count--)
+    {
+      *values++ = (int32_t)((int64_t)cache >> (64 - num_bits));
+      cache <<= num_bits;
+      bits_left -= num_bits;
+    }
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
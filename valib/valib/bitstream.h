@@ -6,6 +6,20 @@
   -----------------
   Low endian streams MUST be aligned to stream word boundary
   (16 bit for 14 and 16 bit stream and 32 bit for 32 bit stream)
+
+  ReadBS cache
+  ------------
+  ReadBS keeps up to 64 bits of the stream left-aligned in a 64 bit cache.
+  Refill is branchless: it loads 8 bytes (unaligned, big endian) at the
+  current byte position and ORs them below the valid bits. After the
+  refill the cache holds at least 56 bits, so any 32 bit read needs at most
+  one refill. The refill never reads beyond the last byte of the stream:
+  the last 8 bytes are loaded byte by byte, and reading past the end of the
+  stream gives zeros.
+
+  peek(n)     - return next n bits without moving the position
+  skip(n)     - skip n bits (any number)
+  get_n(n, values, count) - read a group of fixed-width values
 */
 
 #ifndef VALIB_BITSTREAM_H              
@@ -22,29 +36,31 @@ class ReadBS
 private:
   /////////////////////////////////////////////////////////
   // start
-  //   Aligned pointer to the start of the stream. May
-  //   point before the actual start of the stream.
+  //   Pointer to the first byte of the stream.
   // start_bit
   //   start + start_bit points to the actual starting bit
   //   of the stream
-  // stream_size_bits
+  // size_bits
   //   Stream size in bits;
   // pos
-  //   Pointer to the next word.
-  // current_word, bits_left
-  //   Current word of the stream and amount of the bits
-  //   left unread.
-
-  const uint32_t *start;
+  //   Pointer to the next byte to load into the cache.
+  // end
+  //   End of the stream (we never read beyond it).
+  // cache, bits_left
+  //   Left-aligned cache and amount of the bits left
+  //   unread in the cache.
+
+  const uint8_t *start;
   size_t start_bit;
   size_t size_bits;
 
-  const uint32_t *pos;
-  uint32_t current_word;
+  const uint8_t *pos;
+  const uint8_t *end;
+  uint64_t cache;
   unsigned bits_left;
 
-  uint32_t get_next(unsigned num_bits);
-  int32_t  get_next_signed(unsigned num_bits);
+  inline void refill();
+  void refill_tail();
 
 public:
   ReadBS();
@@ -52,11 +68,17 @@ public:
   void set(const uint8_t *buf, size_t start_bit, size_t size_bits);
 
   void   set_pos_bits(size_t pos_bits);
-  size_t get_pos_bits() const { return (pos - start) * 32 - bits_left - start_bit; }
+  size_t get_pos_bits() const { return (pos - start) * 8 - bits_left - start_bit; }
 
   inline uint32_t get(unsigned num_bits);
   inline int32_t  get_signed(unsigned num_bits);
   inline bool     get_bool();
+
+  inline uint32_t peek(unsigned num_bits);
+  inline void     skip(size_t num_bits);
+
+  void get_n(unsigned num_bits, uint32_t *values, size_t count);
+  void get_signed_n(unsigned num_bits, int32_t *values, size_t count);
 };
 
 class WriteBS
@@ -103,25 +125,36 @@ public:
 
 ///////////////////////////////////////////////////////////////////////////////
 
+inline void
+ReadBS::refill()
+{
+  if (end - pos >= 8)
+  {
+    const uint32_t *p = (const uint32_t *)pos;
+    uint64_t next = ((uint64_t)be2uint32(p[0]) << 32) | be2uint32(p[1]);
+    cache |= next >> bits_left;
+    pos += (63 - bits_left) >> 3;
+    bits_left |= 56;
+  }
+  else
+    refill_tail();
+}
+
 inline uint32_t
 ReadBS::get(unsigned num_bits)
 {
   uint32_t result;
   assert(num_bits <= 32);
   assert(get_pos_bits() + num_bits <= size_bits);
-  assert(bits_left > 0);
 
-  if (num_bits == 0)
-    return 0;
+  if (bits_left < num_bits)
+    refill();
 
-  if (num_bits < bits_left) 
-  {
-    result = (current_word << (32 - bits_left)) >> (32 - num_bits);
-    bits_left -= num_bits;
-    return result;
-  }
-  else
-    return get_next(num_bits);
+  // Double shift allows num_bits == 0
+  result = (uint32_t)((cache >> 1) >> (63 - num_bits));
+  cache <<= num_bits;
+  bits_left -= num_bits;
+  return result;
 }
 
 inline int32_t
@@ -130,19 +163,44 @@ ReadBS::get_signed(unsigned num_bits)
   int32_t result;
   assert(num_bits <= 32);
   assert(get_pos_bits() + num_bits <= size_bits);
-  assert(bits_left > 0);
 
   if (num_bits == 0)
     return 0;
-        
-  if (num_bits < bits_left) 
+
+  if (bits_left < num_bits)
+    refill();
+
+  result = (int32_t)((int64_t)cache >> (64 - num_bits));
+  cache <<= num_bits;
+  bits_left -= num_bits;
+  return result;
+}
+
+inline uint32_t
+ReadBS::peek(unsigned num_bits)
+{
+  assert(num_bits <= 32);
+
+  if (bits_left < num_bits)
+    refill();
+
+  return (uint32_t)((cache >> 1) >> (63 - num_bits));
+}
+
+inline void
+ReadBS::skip(size_t num_bits)
+{
+  assert(get_pos_bits() + num_bits <= size_bits);
+
+  if (num_bits <= 32)
   {
-    result = int32_t(current_word << (32 - bits_left)) >> (32 - num_bits);
-    bits_left -= num_bits;
-    return result;
+    if (bits_left < num_bits)
+      refill();
+    cache <<= num_bits;
+    bits_left -= (unsigned)num_bits;
   }
   else
-    return get_next_signed(num_bits);
+    set_pos_bits(get_pos_bits() + num_bits);
 }
 
 inline bool
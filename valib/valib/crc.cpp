@@ -3,6 +3,24 @@
   If we increase table size (and decrease table accesses) it increases cache
   misses so 8bit table may be considered as optimal choise.
 
+  But the classic algorithm is limited by the dependency chain: each byte
+  step needs the result of the previous one. Slicing-by-8 uses 8 tables of
+  8bit (8KB, still fits L1 cache) to process 8 bytes with independent
+  lookups, so the CPU can execute them in parallel.
+
+  Carry-less multiply folding
+  ===========================
+  Internally CRC is a 32bit left-aligned value, i.e. we always work with
+  the polinomial G = x^32 + poly of degree 32. 128-bit block X followed by
+  128 bits of data B may be replaced by a congruent 128-bit value:
+
+  X*x^128 + B = Xh*x^192 + Xl*x^128 + B = Xh*K1 + Xl*K2 + B (mod G)
+
+  where Xh, Xl are 64-bit halves of X and K1 = x^192 mod G, K2 = x^128 mod G
+  are 32-bit constants. Each product is a 96-bit PCLMULQDQ result. We fold 4
+  blocks in parallel (constants x^576, x^512), then fold them into one and
+  finish with the table: CRC of 16 bytes of the remainder is X*x^32 mod G.
+
   Some words about 32bit access
   =============================
   This module uses 32bit access everywhere. Why?
@@ -19,6 +37,19 @@
 
 
 #include "crc.h"
+#include "simd.h"
+
+#ifdef VALIB_SIMD_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+#endif
+
+// Minimal block size to use PCLMUL folding. calc_pclmul() needs at least
+// 64 bytes to load its 4 folding registers; shorter blocks are faster with
+// the table anyway.
+static const size_t pclmul_min_size = 128;
 
 const CRC crc16(POLY_CRC16, 16);
 const CRC crc32(POLY_CRC32, 32);
@@ -44,20 +75,31 @@ CRC::add_bits(uint32_t crc, uint32_t data, size_t bits) const
 uint32_t
 CRC::add_8(uint32_t crc, uint32_t data) const
 {
-  return (crc << 8) ^ tbl[(crc >> 24) ^ (data & 0xff)];
+  return (crc << 8) ^ tbl[0][(crc >> 24) ^ (data & 0xff)];
 }
 
 uint32_t
 CRC::add_32(uint32_t crc, uint32_t data) const
 {
   crc ^= data;
-  crc = (crc << 8) ^ tbl[crc >> 24];
-  crc = (crc << 8) ^ tbl[crc >> 24];
-  crc = (crc << 8) ^ tbl[crc >> 24];
-  crc = (crc << 8) ^ tbl[crc >> 24];
+  crc = (crc << 8) ^ tbl[0][crc >> 24];
+  crc = (crc << 8) ^ tbl[0][crc >> 24];
+  crc = (crc << 8) ^ tbl[0][crc >> 24];
+  crc = (crc << 8) ^ tbl[0][crc >> 24];
   return crc;
 }
 
+uint32_t
+CRC::add_64(uint32_t crc, uint32_t hi, uint32_t lo) const
+{
+  crc ^= hi;
+  return
+    tbl[7][crc >> 24] ^ tbl[6][(crc >> 16) & 0xff] ^
+    tbl[5][(crc >> 8) & 0xff] ^ tbl[4][crc & 0xff] ^
+    tbl[3][lo >> 24] ^ tbl[2][(lo >> 16) & 0xff] ^
+    tbl[1][(lo >> 8) & 0xff] ^ tbl[0][lo & 0xff];
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Init CRC table
 
@@ -71,7 +113,21 @@ CRC::init(uint32_t _poly, unsigned _power)
   power = _power;
 
   for (byte = 0; byte < 256; byte++)
-    tbl[byte] = add_bits(0, byte, 8);
+    tbl[0][byte] = add_bits(0, byte, 8);
+
+  for (int k = 1; k < 8; k++)
+    for (byte = 0; byte < 256; byte++)
+      tbl[k][byte] = (tbl[k-1][byte] << 8) ^ tbl[0][tbl[k-1][byte] >> 24];
+
+  // x^n mod G: x^32 mod G = poly, multiply by x (n - 32) times
+  static const int fold_pow[4] = { 192, 128, 576, 512 };
+  for (int i = 0; i < 4; i++)
+  {
+    uint32_t k = poly;
+    for (int n = 32; n < fold_pow[i]; n++)
+      k = (k & 0x80000000)? (k << 1) ^ poly: k << 1;
+    fold_k[i] = k;
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -79,6 +135,16 @@ CRC::init(uint32_t _poly, unsigned _power)
 
 uint32_t 
 CRC::calc(uint32_t crc, const uint8_t *data, size_t size) const
+{
+#ifdef VALIB_SIMD_X86
+  if (size >= pclmul_min_size && simd_has(SIMD_PCLMUL | SIMD_SSE41))
+    return calc_pclmul(crc, data, size);
+#endif
+  return calc_table(crc, data, size);
+}
+
+uint32_t 
+CRC::calc_table(uint32_t crc, const uint8_t *data, size_t size) const
 {
   const uint8_t *end = data + size;
 
@@ -91,10 +157,19 @@ CRC::calc(uint32_t crc, const uint8_t *data, size_t size) const
     crc = add_8(crc, *data++);
 
   /////////////////////////////////////////////////////
-  // Process main block (32bit)
+  // Process main block (2x32bit, slicing-by-8)
 
   uint32_t *data32 = (uint32_t *)data;
   uint32_t *end32  = (uint32_t *)(end - align32(end));
+  while (data32 + 2 <= end32)
+  {
+    crc = add_64(crc, be2uint32(data32[0]), be2uint32(data32[1]));
+    data32 += 2;
+  }
+
+  /////////////////////////////////////////////////////
+  // Process the last 32bit word
+
   while (data32 < end32)
   {
     crc = add_32(crc, be2uint32(*data32));
@@ -113,6 +188,79 @@ CRC::calc(uint32_t crc, const uint8_t *data, size_t size) const
   return crc;
 }
 
+#ifdef VALIB_SIMD_X86
+
+SIMD_TARGET_PCLMUL static inline __m128i
+fold(__m128i x, __m128i k, __m128i data)
+{
+  __m128i hi = _mm_clmulepi64_si128(x, k, 0x11);
+  __m128i lo = _mm_clmulepi64_si128(x, k, 0x00);
+  return _mm_xor_si128(_mm_xor_si128(hi, lo), data);
+}
+
+SIMD_TARGET_PCLMUL uint32_t
+CRC::calc_pclmul(uint32_t crc, const uint8_t *data, size_t size) const
+{
+  assert(size >= pclmul_min_size);
+
+  // Byte-reversed load: the first bit of the stream becomes the highest
+  // bit of the register (x^127).
+  const __m128i bswap = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  #define LOAD(p) _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(p)), bswap)
+
+  const __m128i k128 = _mm_set_epi32(0, fold_k[0], 0, fold_k[1]);
+  const __m128i k512 = _mm_set_epi32(0, fold_k[2], 0, fold_k[3]);
+
+  // Initial CRC is added to the first 32 bits of the stream
+  __m128i x0 = _mm_xor_si128(LOAD(data), _mm_set_epi32(crc, 0, 0, 0));
+  __m128i x1 = LOAD(data + 16);
+  __m128i x2 = LOAD(data + 32);
+  __m128i x3 = LOAD(data + 48);
+  data += 64;
+  size -= 64;
+
+  while (size >= 64)
+  {
+    x0 = fold(x0, k512, LOAD(data));
+    x1 = fold(x1, k512, LOAD(data + 16));
+    x2 = fold(x2, k512, LOAD(data + 32));
+    x3 = fold(x3, k512, LOAD(data + 48));
+    data += 64;
+    size -= 64;
+  }
+
+  x0 = fold(x0, k128, x1);
+  x0 = fold(x0, k128, x2);
+  x0 = fold(x0, k128, x3);
+
+  while (size >= 16)
+  {
+    x0 = fold(x0, k128, LOAD(data));
+    data += 16;
+    size -= 16;
+  }
+  #undef LOAD
+
+  // CRC of the 128-bit remainder
+  crc = 0;
+  crc = add_32(crc, (uint32_t)_mm_extract_epi32(x0, 3));
+  crc = add_32(crc, (uint32_t)_mm_extract_epi32(x0, 2));
+  crc = add_32(crc, (uint32_t)_mm_extract_epi32(x0, 1));
+  crc = add_32(crc, (uint32_t)_mm_extract_epi32(x0, 0));
+
+  return calc_table(crc, data, size);
+}
+
+#else
+
+uint32_t
+CRC::calc_pclmul(uint32_t crc, const uint8_t *data, size_t size) const
+{
+  return calc_table(crc, data, size);
+}
+
+#endif
+
 uint32_t 
 CRC::calc_bits(uint32_t crc, const uint8_t *data, size_t start_bit, size_t bits) const
 {
@@ -8,6 +8,18 @@
 
   This module provides 2 predefined constant classes for standard
   CRC16 and CRC32 polinomials
+
+  Bytestream CRC engine
+  =====================
+
+  calc() uses slicing-by-8 tables: 8 bytes are processed with 8 independent
+  table lookups instead of 8 dependent byte steps. When the CPU supports
+  carry-less multiplication (SIMD_PCLMUL) large blocks are folded 64 bytes
+  at a time with PCLMULQDQ and only the final 128-bit remainder is reduced
+  with tables.
+
+  All paths give the same result for any polinomial. Use simd_set_mask() to
+  force the table code.
 */
 
 #ifndef VALIB_CRC_H
@@ -29,7 +41,8 @@ class CRC
 protected:
   uint32_t poly;
   unsigned power;
-  uint32_t tbl[256];
+  uint32_t tbl[8][256];   // tbl[k][b] = CRC of byte b followed by k zero bytes
+  uint32_t fold_k[4];     // x^192, x^128, x^576, x^512 mod poly (PCLMUL folding)
 
   /////////////////////////////////////////////////////////////////////////////
   // CRC primitives
@@ -38,6 +51,10 @@ protected:
 
   __forceinline uint32_t add_8    (uint32_t crc, uint32_t data) const;
   __forceinline uint32_t add_32   (uint32_t crc, uint32_t data) const;
+  __forceinline uint32_t add_64   (uint32_t crc, uint32_t hi, uint32_t lo) const;
+
+  uint32_t calc_table (uint32_t crc, const uint8_t *data, size_t size) const;
+  uint32_t calc_pclmul(uint32_t crc, const uint8_t *data, size_t size) const;
 
 public:
   CRC() {};
@@ -145,7 +145,9 @@ struct int24_t // int24_t is a low-endian structure
 // sample_t - audio sample type
 //   All internal audio processing is done with this type. There're 2 sample
 //   types supported now: float and double. To use single-precision float type
-//   define FLOAT_SAMPLE global symbol.
+//   define FLOAT_SAMPLE global symbol (ReleaseFloat configuration).
+//   Precision test (test_precision.cpp) states the quality loss allowed for
+//   the single-precision build.
 //
 //   SAMPLE_THRESHOLD - minimum difference between samples
 //   EQUAL_SAMPLES    - macro to compare two samples
@@ -157,10 +159,12 @@ struct int24_t // int24_t is a low-endian structure
 #ifndef FLOAT_SAMPLE
 
   typedef double   sample_t;
+# define SAMPLE_THRESHOLD (1e-10)
 
 #else
 
   typedef float    sample_t;
+# define SAMPLE_THRESHOLD (1e-6)
 
 # if _MSC_VER >= 1200
     // most of tables use double-precision constants
@@ -172,7 +176,6 @@ struct int24_t // int24_t is a low-endian structure
 
 #endif
 
-#define SAMPLE_THRESHOLD (1e-10)
 #define EQUAL_SAMPLES(s1, s2) (fabs((s1) - (s2)) < SAMPLE_THRESHOLD)
 
 typedef double vtime_t;
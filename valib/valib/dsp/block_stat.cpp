@@ -0,0 +1,75 @@
+#include "block_stat.h"
+#include "../simd_vec.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernels
+// Two accumulators of each kind per channel; the tail is done in scalar.
+// Scalar kernel is built from the same code with vec_scalar.
+
+#define DEFINE_BLOCK_STAT_KERNEL(name, V, target)                             \
+static target                                                                 \
+void name(const sample_t *const *x, int nch, size_t n, sample_t *peak, sample_t *sum2) \
+{                                                                             \
+  for (int ch = 0; ch < nch; ch++)                                            \
+  {                                                                           \
+    const sample_t *xch = x[ch];                                              \
+    V::vec a, b;                                                              \
+    V::vec m0 = V::zero(), m1 = V::zero();                                    \
+    V::vec s0 = V::zero(), s1 = V::zero();                                    \
+    size_t j = 0;                                                             \
+                                                                              \
+    if (sum2)                                                                 \
+      for (; j + 2 * V::width <= n; j += 2 * V::width)                        \
+      {                                                                       \
+        a = V::load(xch + j);                                                 \
+        b = V::load(xch + j + V::width);                                      \
+        m0 = V::max(V::abs(a), m0);                                           \
+        m1 = V::max(V::abs(b), m1);                                           \
+        s0 = V::add(s0, V::mul(a, a));                                        \
+        s1 = V::add(s1, V::mul(b, b));                                        \
+      }                                                                       \
+    else                                                                      \
+      for (; j + 2 * V::width <= n; j += 2 * V::width)                        \
+      {                                                                       \
+        m0 = V::max(V::abs(V::load(xch + j)), m0);                            \
+        m1 = V::max(V::abs(V::load(xch + j + V::width)), m1);                 \
+      }                                                                       \
+                                                                              \
+    sample_t m = V::hmax(V::max(m0, m1));                                     \
+    sample_t s = V::hsum(V::add(s0, s1));                                     \
+    for (; j < n; j++)                                                        \
+    {                                                                         \
+      m = vec_scalar::max(vec_scalar::abs(xch[j]), m);                        \
+      s += xch[j] * xch[j];                                                   \
+    }                                                                         \
+                                                                              \
+    peak[ch] = m;                                                             \
+    if (sum2)                                                                 \
+      sum2[ch] = s;                                                           \
+  }                                                                           \
+}
+
+DEFINE_BLOCK_STAT_KERNEL(block_stat_mch_scalar, vec_scalar, )
+
+#ifdef VALIB_SIMD_X86
+DEFINE_BLOCK_STAT_KERNEL(block_stat_mch_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_BLOCK_STAT_KERNEL(block_stat_mch_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+block_stat_mch_t find_block_stat_mch()
+{
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return block_stat_mch_avx;
+#endif
+  if (caps & SIMD_SSE2)
+    return block_stat_mch_sse2;
+#endif
+  return block_stat_mch_scalar;
+}
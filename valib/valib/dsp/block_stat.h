@@ -0,0 +1,32 @@
+#ifndef VALIB_BLOCK_STAT_H
+#define VALIB_BLOCK_STAT_H
+
+#include "../defs.h"
+
+/******************************************************************************
+
+Multichannel block statistics (peak level and power)
+
+* block_stat_mch_t(x, nch, n, peak, sum2)
+  x - input pointers for each channel [nch]
+  nch - number of channels (up to NCHANNELS)
+  n - number of samples
+  peak - peak level for each channel [nch]: max(|x[ch][j]|), j = 0..n-1
+  sum2 - sum of squares for each channel [nch]: sum(x[ch][j]^2), j = 0..n-1
+    (RMS level is sqrt(sum2 / n)). May be zero when only peak levels are
+    needed.
+
+  All statistics are found with one pass over the data. NaN samples are
+  skipped by the peak search. Peak is exact, sum of squares of SIMD kernels
+  may differ from the scalar kernel in rounding (different order of sums).
+
+* find_block_stat_mch()
+  Returns the best kernel allowed by simd_caps(). Never returns zero: when
+  SIMD is not available, scalar kernel is returned.
+
+******************************************************************************/
+
+typedef void (*block_stat_mch_t)(const sample_t *const *x, int nch, size_t n, sample_t *peak, sample_t *sum2);
+block_stat_mch_t find_block_stat_mch();
+
+#endif
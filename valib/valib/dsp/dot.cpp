@@ -0,0 +1,140 @@
+#include "dot.h"
+#include "../simd_vec.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Scalar kernel
+
+static void dot_mch_scalar(const sample_t *const *x, int nch, const sample_t *f, int n, sample_t *result)
+{
+  for (int ch = 0; ch < nch; ch++)
+  {
+    const sample_t *xch = x[ch];
+    double sum = 0;
+    for (int j = 0; j < n; j++)
+      sum += xch[j] * f[j];
+    result[ch] = (sample_t)sum;
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SIMD kernels
+// One accumulator vector per channel; the tail is added in scalar.
+
+#ifdef VALIB_SIMD_X86
+
+#ifndef FLOAT_SAMPLE
+
+#define DEFINE_DOT_KERNEL(name, V, target)                                    \
+static target                                                                 \
+void name(const sample_t *const *x, int nch, const sample_t *f, int n, sample_t *result) \
+{                                                                             \
+  int ch, j;                                                                  \
+  V::vec acc[NCHANNELS];                                                      \
+  for (ch = 0; ch < nch; ch++)                                                \
+    acc[ch] = V::zero();                                                      \
+                                                                              \
+  for (j = 0; j + V::width <= n; j += V::width)                               \
+  {                                                                           \
+    V::vec fv = V::load(f + j);                                               \
+    for (ch = 0; ch < nch; ch++)                                              \
+      acc[ch] = V::add(acc[ch], V::mul(V::load(x[ch] + j), fv));              \
+  }                                                                           \
+                                                                              \
+  for (ch = 0; ch < nch; ch++)                                                \
+  {                                                                           \
+    sample_t sum = V::hsum(acc[ch]);                                          \
+    for (int k = j; k < n; k++)                                               \
+      sum += x[ch][k] * f[k];                                                 \
+    result[ch] = sum;                                                         \
+  }                                                                           \
+}
+
+DEFINE_DOT_KERNEL(dot_mch_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_DOT_KERNEL(dot_mch_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+
+#else
+
+// Single precision build: products are rounded to float (as in the scalar
+// kernel), but summed in double, so long filters do not lose precision.
+
+static void dot_mch_sse2(const sample_t *const *x, int nch, const sample_t *f, int n, sample_t *result)
+{
+  int ch, j;
+  __m128d acc_lo[NCHANNELS], acc_hi[NCHANNELS];
+  for (ch = 0; ch < nch; ch++)
+    acc_lo[ch] = acc_hi[ch] = _mm_setzero_pd();
+
+  for (j = 0; j + 4 <= n; j += 4)
+  {
+    __m128 fv = _mm_loadu_ps(f + j);
+    for (ch = 0; ch < nch; ch++)
+    {
+      __m128 p = _mm_mul_ps(_mm_loadu_ps(x[ch] + j), fv);
+      acc_lo[ch] = _mm_add_pd(acc_lo[ch], _mm_cvtps_pd(p));
+      acc_hi[ch] = _mm_add_pd(acc_hi[ch], _mm_cvtps_pd(_mm_movehl_ps(p, p)));
+    }
+  }
+
+  for (ch = 0; ch < nch; ch++)
+  {
+    __m128d s = _mm_add_pd(acc_lo[ch], acc_hi[ch]);
+    double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    for (int k = j; k < n; k++)
+      sum += x[ch][k] * f[k];
+    result[ch] = (sample_t)sum;
+  }
+}
+
+#ifdef VALIB_SIMD_AVX
+static SIMD_TARGET_AVX
+void dot_mch_avx(const sample_t *const *x, int nch, const sample_t *f, int n, sample_t *result)
+{
+  int ch, j;
+  __m256d acc_lo[NCHANNELS], acc_hi[NCHANNELS];
+  for (ch = 0; ch < nch; ch++)
+    acc_lo[ch] = acc_hi[ch] = _mm256_setzero_pd();
+
+  for (j = 0; j + 8 <= n; j += 8)
+  {
+    __m256 fv = _mm256_loadu_ps(f + j);
+    for (ch = 0; ch < nch; ch++)
+    {
+      __m256 p = _mm256_mul_ps(_mm256_loadu_ps(x[ch] + j), fv);
+      acc_lo[ch] = _mm256_add_pd(acc_lo[ch], _mm256_cvtps_pd(_mm256_castps256_ps128(p)));
+      acc_hi[ch] = _mm256_add_pd(acc_hi[ch], _mm256_cvtps_pd(_mm256_extractf128_ps(p, 1)));
+    }
+  }
+
+  for (ch = 0; ch < nch; ch++)
+  {
+    __m256d s4 = _mm256_add_pd(acc_lo[ch], acc_hi[ch]);
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(s4), _mm256_extractf128_pd(s4, 1));
+    double sum = _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    for (int k = j; k < n; k++)
+      sum += x[ch][k] * f[k];
+    result[ch] = (sample_t)sum;
+  }
+}
+#endif
+
+#endif // FLOAT_SAMPLE
+
+#endif // VALIB_SIMD_X86
+
+///////////////////////////////////////////////////////////////////////////////
+
+dot_mch_t find_dot_mch()
+{
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return dot_mch_avx;
+#endif
+  if (caps & SIMD_SSE2)
+    return dot_mch_sse2;
+#endif
+  return dot_mch_scalar;
+}
@@ -0,0 +1,33 @@
+#ifndef VALIB_DOT_H
+#define VALIB_DOT_H
+
+#include "../defs.h"
+
+/******************************************************************************
+
+Multichannel dot product (FIR convolution step)
+
+* dot_mch_t(x, nch, f, n, result)
+  x - input pointers for each channel [nch]
+  nch - number of channels (up to NCHANNELS)
+  f - filter [n]
+  n - filter length
+  result - result for each channel [nch]
+  Computes result[ch] = sum(x[ch][j] * f[j]), j = 0..n-1
+
+  The filter is loaded once for all channels, so a filter bank that is
+  walked by all channels stays in the cache (and in registers).
+
+* find_dot_mch()
+  Returns the best kernel allowed by simd_caps(). Never returns zero: when
+  SIMD is not available, scalar kernel is returned. Scalar kernel sums
+  in double precision from left to right. SIMD kernels sum in double
+  precision too (in the single precision build products are converted to
+  double before summation), but in a different order.
+
+******************************************************************************/
+
+typedef void (*dot_mch_t)(const sample_t *const *x, int nch, const sample_t *f, int n, sample_t *result);
+dot_mch_t find_dot_mch();
+
+#endif
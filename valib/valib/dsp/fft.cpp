@@ -2,38 +2,83 @@
 #include "fft.h"
 #include "fftsg.h"
 
-MM_FFT::MM_FFT()
+///////////////////////////////////////////////////////////////////////////////
+// Ooura's FFT backend
+
+class OouraFFT : public FFTBackend
+{
+protected:
+  AutoBuf<int> fft_ip;
+  AutoBuf<sample_t> fft_w;
+  int len;
+
+public:
+  OouraFFT(): len(0) {}
+
+  virtual const char *name() const { return "Ooura"; }
+
+  virtual bool init(unsigned length)
+  {
+    if (length < 2 || (length & (length - 1)))
+      return false;
+
+    len = length;
+    fft_ip.allocate((int)(2 + sqrt(double(length * 2))));
+    fft_w.allocate(length/2+1);
+
+    if (!fft_ip.is_allocated() || !fft_w.is_allocated())
+      return false;
+
+    fft_ip[0] = 0;
+    return true;
+  }
+
+  virtual void rdft(sample_t *samples)
+  { ::rdft(len, 1, samples, fft_ip, fft_w); }
+
+  virtual void inv_rdft(sample_t *samples)
+  { ::rdft(len, -1, samples, fft_ip, fft_w); }
+};
+
+FFTBackend *create_ooura_fft()
+{
+  return new OouraFFT();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// MM_FFT
+
+MM_FFT::MM_FFT(): backend(0), len(0)
 {}
 
-MM_FFT::MM_FFT(unsigned length)
+MM_FFT::MM_FFT(unsigned length): backend(0), len(0)
 {
   set_length(length);
 }
 
+MM_FFT::~MM_FFT()
+{
+  safe_delete(backend);
+}
+
 bool
 MM_FFT::set_length(unsigned length)
 {
   if (len == length && is_ok())
     return true;
 
-  len = length;
-  fft_ip.allocate((int)(2 + sqrt(double(length * 2))));
-  fft_w.allocate(length/2+1);
-
-  if (fft_ip.is_allocated())
-    fft_ip[0] = 0;
-
-  return is_ok();
-}
+  FFTBackend *(*create[])() =
+  { create_external_fft, create_simd_fft, create_ooura_fft };
 
-void
-MM_FFT::rdft(sample_t *samples)
-{
-  ::rdft(len, 1, samples, fft_ip, fft_w);
-}
+  safe_delete(backend);
+  len = length;
 
-void
-MM_FFT::inv_rdft(sample_t *samples)
-{
-  ::rdft(len, -1, samples, fft_ip, fft_w);
+  for (size_t i = 0; i < array_size(create); i++)
+  {
+    backend = create[i]();
+    if (backend && backend->init(length))
+      return true;
+    safe_delete(backend);
+  }
+  return false;
 }
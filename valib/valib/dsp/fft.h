@@ -1,5 +1,35 @@
 /*
-  Simple wrapper class for Ooura FFT
+  Real FFT with pluggable backends
+
+  MM_FFT
+    Real FFT of power-of-2 length in the format of Ooura's rdft():
+      rdft(a):     a[2k] = R[k], a[2k+1] = I[k] (0 < k < n/2),
+                   a[0] = R[0], a[1] = R[n/2]
+      inv_rdft(a): inverse transform scaled by n/2
+    See fftsg.c for the exact definition.
+
+    The transform is done by the best backend available for the length,
+    chosen at set_length():
+    * External library (only when compiled with VALIB_FFTW)
+    * SIMD radix-4/radix-2 FFT (when allowed by simd_caps())
+    * Ooura's FFT (always available)
+
+  FFTBackend
+    Backend interface. init() returns false when the backend cannot be used
+    for the length given. All backends must produce the same format.
+
+  create_ooura_fft(), create_simd_fft(), create_external_fft()
+    Create the backend of the given type. Return zero when the backend is
+    not available (compiled out or not supported by CPU).
+
+  SplitFFT
+    Forward complex FFT of power-of-2 length (4 or more), in-place, with
+    real and imaginary parts in separate arrays:
+      X[k] = sum(x[j] * exp(-2*pi*i*j*k/n))
+    Input must be in bit-reversed order (see rev()), so the caller can
+    reorder the data at its own pre-processing pass. Output is in natural
+    order. Inverse transform is the forward one with re and im swapped.
+    Uses the stages of the SIMD backend when allowed by simd_caps().
 */
 
 #ifndef FFT_H
@@ -8,23 +38,67 @@
 #include "../defs.h"
 #include "../auto_buf.h"
 
+class FFTBackend
+{
+public:
+  virtual ~FFTBackend() {}
+
+  virtual const char *name() const = 0;
+  virtual bool init(unsigned length) = 0;
+
+  virtual void rdft(sample_t *samples) = 0;
+  virtual void inv_rdft(sample_t *samples) = 0;
+};
+
+FFTBackend *create_ooura_fft();
+FFTBackend *create_simd_fft();
+FFTBackend *create_external_fft();
+
 class MM_FFT
 {
 protected:
-  AutoBuf<int> fft_ip;
-  AutoBuf<sample_t> fft_w;
+  FFTBackend *backend;
   unsigned len;
 
+private:
+  MM_FFT(const MM_FFT &);
+  MM_FFT &operator =(const MM_FFT &);
+
 public:
   MM_FFT();
   MM_FFT(unsigned length);
+  ~MM_FFT();
 
   bool set_length(unsigned length);
   unsigned get_length() const { return len; }
-  bool is_ok() const { return fft_ip.is_allocated() && fft_w.is_allocated(); }
+  bool is_ok() const { return backend != 0; }
+  const char *backend_name() const { return backend? backend->name(): 0; }
+
+  void rdft(sample_t *samples)     { backend->rdft(samples);     }
+  void inv_rdft(sample_t *samples) { backend->inv_rdft(samples); }
+};
+
+class SplitFFT
+{
+protected:
+  unsigned m;
+  AutoBuf<unsigned> rev_tbl;  // bit reversal table [m]
+  AutoBuf<sample_t> wr;       // stage twiddles: w[h + j] = exp(-i*pi*j/h) [m]
+  AutoBuf<sample_t> wi;
+
+private:
+  SplitFFT(const SplitFFT &);
+  SplitFFT &operator =(const SplitFFT &);
+
+public:
+  SplitFFT(): m(0) {}
+  SplitFFT(unsigned length): m(0) { set_length(length); }
+
+  bool set_length(unsigned length);
+  unsigned get_length() const { return m; }
+  const unsigned *rev() const { return rev_tbl; }
 
-  void rdft(sample_t *samples);
-  void inv_rdft(sample_t *samples);
+  void fft(sample_t *re, sample_t *im) const;
 };
 
 #endif
@@ -0,0 +1,119 @@
+/*
+  External FFT library backend
+
+  Define VALIB_FFTW to use FFTW3 (libfftw3 or libfftw3f when FLOAT_SAMPLE is
+  defined). Otherwise the backend is not available and create_external_fft()
+  returns zero.
+
+  Note that FFTW planner is not thread-safe, so MM_FFT::set_length() must not
+  be called from different threads at once.
+*/
+
+#include <string.h>
+#include "fft.h"
+
+#ifdef VALIB_FFTW
+
+#include <fftw3.h>
+
+#ifdef FLOAT_SAMPLE
+#  define FFTW(name) fftwf_##name
+#else
+#  define FFTW(name) fftw_##name
+#endif
+
+class FFTW_FFT : public FFTBackend
+{
+protected:
+  unsigned n;
+  sample_t *buf;
+  FFTW(complex) *spectrum;
+  FFTW(plan) forward;
+  FFTW(plan) inverse;
+
+  void uninit()
+  {
+    if (forward) FFTW(destroy_plan)(forward);
+    if (inverse) FFTW(destroy_plan)(inverse);
+    if (buf) FFTW(free)(buf);
+    if (spectrum) FFTW(free)(spectrum);
+    n = 0; buf = 0; spectrum = 0; forward = 0; inverse = 0;
+  }
+
+public:
+  FFTW_FFT(): n(0), buf(0), spectrum(0), forward(0), inverse(0) {}
+  ~FFTW_FFT() { uninit(); }
+
+  virtual const char *name() const { return "FFTW"; }
+
+  virtual bool init(unsigned length)
+  {
+    uninit();
+    if (length < 2 || (length & (length - 1)))
+      return false;
+
+    n = length;
+    buf = (sample_t *)FFTW(malloc)(sizeof(sample_t) * n);
+    spectrum = (FFTW(complex) *)FFTW(malloc)(sizeof(FFTW(complex)) * (n/2+1));
+    if (!buf || !spectrum)
+    {
+      uninit();
+      return false;
+    }
+
+    forward = FFTW(plan_dft_r2c_1d)(n, buf, spectrum, FFTW_ESTIMATE);
+    inverse = FFTW(plan_dft_c2r_1d)(n, spectrum, buf, FFTW_ESTIMATE);
+    if (!forward || !inverse)
+    {
+      uninit();
+      return false;
+    }
+    return true;
+  }
+
+  virtual void rdft(sample_t *a)
+  {
+    // Ooura's format stores negated imaginary parts
+    memcpy(buf, a, n * sizeof(sample_t));
+    FFTW(execute)(forward);
+
+    a[0] = spectrum[0][0];
+    a[1] = spectrum[n/2][0];
+    for (unsigned k = 1; k < n/2; k++)
+    {
+      a[2*k]   = spectrum[k][0];
+      a[2*k+1] = -spectrum[k][1];
+    }
+  }
+
+  virtual void inv_rdft(sample_t *a)
+  {
+    // FFTW inverse is scaled by n, Ooura's is scaled by n/2
+    spectrum[0][0] = a[0] * 0.5f;
+    spectrum[0][1] = 0;
+    spectrum[n/2][0] = a[1] * 0.5f;
+    spectrum[n/2][1] = 0;
+    for (unsigned k = 1; k < n/2; k++)
+    {
+      spectrum[k][0] = a[2*k] * 0.5f;
+      spectrum[k][1] = -a[2*k+1] * 0.5f;
+    }
+
+    FFTW(execute)(inverse);
+    memcpy(a, buf, n * sizeof(sample_t));
+  }
+};
+
+FFTBackend *create_external_fft()
+{
+  return new FFTW_FFT();
+}
+
+#else
+
+FFTBackend *create_external_fft()
+{
+  return 0;
+}
+
+#endif
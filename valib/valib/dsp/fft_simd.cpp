@@ -0,0 +1,531 @@
+/*
+  SIMD FFT backend
+
+  Real FFT of length n is done with the complex FFT of length m = n/2:
+  z[j] = x[2j] + i*x[2j+1]. Complex FFT works with separate arrays of real
+  and imaginary parts, so butterflies of a stage are processed by whole
+  vectors. Input is reordered (bit reversal) when it is split into real and
+  imaginary arrays, and the first two stages (trivial twiddles) are done at
+  the same pass. The rest of stages are done with SIMD radix-4 butterflies
+  (two radix-2 stages per pass) and one radix-2 stage when required.
+  Finally the spectrum of the real signal is built from the complex one and
+  stored in Ooura's format.
+
+  Inverse transform reverses these steps. Inverse complex FFT is done with
+  the forward one with real and imaginary arrays swapped.
+
+  The complex FFT stages are also used by SplitFFT. It has scalar versions
+  of the stages, built from the same code, for use without SIMD.
+*/
+
+#include <math.h>
+#include "fft.h"
+#include "../simd_vec.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Radix-2 stage: butterflies of size 2h with twiddles w[h..2h)
+// Radix-4 stage: two radix-2 stages (h and 2h) in one pass
+// Require h >= V::width.
+
+#define DEFINE_FFT_STAGE(name2, name4, V, target)                             \
+static target void name2(sample_t *re, sample_t *im, const sample_t *wr, const sample_t *wi, unsigned m, unsigned h) \
+{                                                                             \
+  for (unsigned k = 0; k < m; k += 2 * h)                                     \
+  {                                                                           \
+    sample_t *r0 = re + k, *r1 = r0 + h;                                      \
+    sample_t *i0 = im + k, *i1 = i0 + h;                                      \
+    for (unsigned j = 0; j < h; j += V::width)                                \
+    {                                                                         \
+      V::vec cr = V::load(wr + h + j);                                        \
+      V::vec ci = V::load(wi + h + j);                                        \
+      V::vec xr = V::load(r1 + j);                                            \
+      V::vec xi = V::load(i1 + j);                                            \
+      V::vec tr = V::sub(V::mul(xr, cr), V::mul(xi, ci));                     \
+      V::vec ti = V::add(V::mul(xr, ci), V::mul(xi, cr));                     \
+      V::vec ur = V::load(r0 + j);                                            \
+      V::vec ui = V::load(i0 + j);                                            \
+      V::store(r0 + j, V::add(ur, tr));                                       \
+      V::store(i0 + j, V::add(ui, ti));                                       \
+      V::store(r1 + j, V::sub(ur, tr));                                       \
+      V::store(i1 + j, V::sub(ui, ti));                                       \
+    }                                                                         \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+static target void name4(sample_t *re, sample_t *im, const sample_t *wr, const sample_t *wi, unsigned m, unsigned h) \
+{                                                                             \
+  for (unsigned k = 0; k < m; k += 4 * h)                                     \
+  {                                                                           \
+    sample_t *r0 = re + k, *r1 = r0 + h, *r2 = r1 + h, *r3 = r2 + h;          \
+    sample_t *i0 = im + k, *i1 = i0 + h, *i2 = i1 + h, *i3 = i2 + h;          \
+    for (unsigned j = 0; j < h; j += V::width)                                \
+    {                                                                         \
+      /* stage h: (x0, x1) and (x2, x3) with w1 = w[h + j] */                 \
+      V::vec cr = V::load(wr + h + j);                                        \
+      V::vec ci = V::load(wi + h + j);                                        \
+      V::vec xr = V::load(r1 + j);                                            \
+      V::vec xi = V::load(i1 + j);                                            \
+      V::vec tr = V::sub(V::mul(xr, cr), V::mul(xi, ci));                     \
+      V::vec ti = V::add(V::mul(xr, ci), V::mul(xi, cr));                     \
+      V::vec ur = V::load(r0 + j);                                            \
+      V::vec ui = V::load(i0 + j);                                            \
+      V::vec a0r = V::add(ur, tr), a0i = V::add(ui, ti);                      \
+      V::vec a1r = V::sub(ur, tr), a1i = V::sub(ui, ti);                      \
+                                                                              \
+      xr = V::load(r3 + j);                                                   \
+      xi = V::load(i3 + j);                                                   \
+      tr = V::sub(V::mul(xr, cr), V::mul(xi, ci));                            \
+      ti = V::add(V::mul(xr, ci), V::mul(xi, cr));                            \
+      ur = V::load(r2 + j);                                                   \
+      ui = V::load(i2 + j);                                                   \
+      V::vec a2r = V::add(ur, tr), a2i = V::add(ui, ti);                      \
+      V::vec a3r = V::sub(ur, tr), a3i = V::sub(ui, ti);                      \
+                                                                              \
+      /* stage 2h: (a0, a2) with w2 = w[2h + j], (a1, a3) with -i*w2 */       \
+      cr = V::load(wr + 2 * h + j);                                           \
+      ci = V::load(wi + 2 * h + j);                                           \
+      tr = V::sub(V::mul(a2r, cr), V::mul(a2i, ci));                          \
+      ti = V::add(V::mul(a2r, ci), V::mul(a2i, cr));                          \
+      V::store(r0 + j, V::add(a0r, tr));                                      \
+      V::store(i0 + j, V::add(a0i, ti));                                      \
+      V::store(r2 + j, V::sub(a0r, tr));                                      \
+      V::store(i2 + j, V::sub(a0i, ti));                                      \
+                                                                              \
+      /* -i*(a + ib) = b - ia */                                              \
+      tr = V::add(V::mul(a3r, ci), V::mul(a3i, cr));                          \
+      ti = V::sub(V::mul(a3i, ci), V::mul(a3r, cr));                          \
+      V::store(r1 + j, V::add(a1r, tr));                                      \
+      V::store(i1 + j, V::add(a1i, ti));                                      \
+      V::store(r3 + j, V::sub(a1r, tr));                                      \
+      V::store(i3 + j, V::sub(a1i, ti));                                      \
+    }                                                                         \
+  }                                                                           \
+}
+
+typedef void (*fft_stage_t)(sample_t *re, sample_t *im, const sample_t *wr, const sample_t *wi, unsigned m, unsigned h);
+
+DEFINE_FFT_STAGE(fft_stage2_scalar, fft_stage4_scalar, vec_scalar, )
+
+#ifdef VALIB_SIMD_X86
+
+DEFINE_FFT_STAGE(fft_stage2_sse2, fft_stage4_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_FFT_STAGE(fft_stage2_avx,  fft_stage4_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Real spectrum <-> complex spectrum conversion (see SimdFFT::rdft() and
+// SimdFFT::inv_rdft() for formulas). Bins k and m-k are processed together,
+// so bins m-k are loaded and stored in reverse order. Return the first bin
+// that was not processed.
+//
+// fft_post: complex spectrum (re, im) -> real spectrum a
+// fft_pre:  real spectrum a -> complex spectrum (in-place, swapped re/im)
+// fft_out:  (re, im) -> a interleaved (swapped re/im)
+
+#define DEFINE_FFT_POST(post, pre, out, V, target)                            \
+static target unsigned post(sample_t *a, const sample_t *re, const sample_t *im, const sample_t *pc, const sample_t *ps, unsigned m) \
+{                                                                             \
+  const V::vec half = V::set1(0.5);                                           \
+  unsigned k;                                                                 \
+  for (k = 1; k + V::width - 1 <= m/2; k += V::width)                         \
+  {                                                                           \
+    unsigned j = m - k - V::width + 1;                                        \
+    V::vec rk = V::load(re + k), ik = V::load(im + k);                        \
+    V::vec rj = V::reverse(V::load(re + j));                                  \
+    V::vec ij = V::reverse(V::load(im + j));                                  \
+    V::vec c = V::load(pc + k), s = V::load(ps + k);                          \
+                                                                              \
+    V::vec er = V::mul(V::add(rk, rj), half);                                 \
+    V::vec ei = V::mul(V::sub(ik, ij), half);                                 \
+    V::vec or_ = V::mul(V::add(ik, ij), half);                                \
+    V::vec oi = V::mul(V::sub(rj, rk), half);                                 \
+    V::vec tr = V::add(V::mul(c, or_), V::mul(s, oi));                        \
+    V::vec ti = V::sub(V::mul(c, oi), V::mul(s, or_));                        \
+                                                                              \
+    V::store2(a + 2 * k, V::add(er, tr), V::sub(V::sub(V::zero(), ei), ti));  \
+    V::store2(a + 2 * j, V::reverse(V::sub(er, tr)), V::reverse(V::sub(ei, ti))); \
+  }                                                                           \
+  return k;                                                                   \
+}                                                                             \
+                                                                              \
+static target unsigned pre(sample_t *a, const sample_t *pc, const sample_t *ps, unsigned m) \
+{                                                                             \
+  const V::vec half = V::set1(0.5);                                           \
+  unsigned k;                                                                 \
+  for (k = 1; k + V::width - 1 <= m/2; k += V::width)                         \
+  {                                                                           \
+    unsigned j = m - k - V::width + 1;                                        \
+    V::vec xr, xi, yr, yi;                                                    \
+    V::load2(a + 2 * k, xr, xi);                                              \
+    V::load2(a + 2 * j, yr, yi);                                              \
+    xi = V::sub(V::zero(), xi);                                               \
+    yr = V::reverse(yr);                                                      \
+    yi = V::reverse(yi);                                                      \
+    V::vec c = V::load(pc + k), s = V::load(ps + k);                          \
+                                                                              \
+    V::vec er = V::mul(V::add(xr, yr), half);                                 \
+    V::vec ei = V::mul(V::add(xi, yi), half);                                 \
+    V::vec dr = V::mul(V::sub(xr, yr), half);                                 \
+    V::vec di = V::mul(V::sub(xi, yi), half);                                 \
+    V::vec or_ = V::sub(V::mul(dr, c), V::mul(di, s));                        \
+    V::vec oi = V::add(V::mul(dr, s), V::mul(di, c));                         \
+                                                                              \
+    V::store2(a + 2 * k, V::add(ei, or_), V::sub(er, oi));                    \
+    V::store2(a + 2 * j, V::reverse(V::sub(or_, ei)), V::reverse(V::add(er, oi))); \
+  }                                                                           \
+  return k;                                                                   \
+}                                                                             \
+                                                                              \
+static target void out(sample_t *a, const sample_t *re, const sample_t *im, unsigned m) \
+{                                                                             \
+  for (unsigned k = 0; k < m; k += V::width)                                  \
+    V::store2(a + 2 * k, V::load(im + k), V::load(re + k));                   \
+}
+
+DEFINE_FFT_POST(fft_post_sse2, fft_pre_sse2, fft_out_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_FFT_POST(fft_post_avx,  fft_pre_avx,  fft_out_avx,  vec_avx,  SIMD_TARGET_AVX)
+#else
+// AVX kernels are not built: avx_width is always 0, so these are never called
+#define fft_stage2_avx fft_stage2_sse2
+#define fft_stage4_avx fft_stage4_sse2
+#define fft_post_avx   fft_post_sse2
+#define fft_pre_avx    fft_pre_sse2
+#define fft_out_avx    fft_out_sse2
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+class SimdFFT : public FFTBackend
+{
+protected:
+  unsigned n;           // real transform length
+  unsigned m;           // complex transform length (n/2)
+  unsigned avx_width;   // minimum stage size for AVX stage (0 if AVX is not available)
+
+  AutoBuf<unsigned> rev; // bit reversal table [m]
+  AutoBuf<sample_t> wr;  // stage twiddles: w[h + j] = exp(-i*pi*j/h) [m]
+  AutoBuf<sample_t> wi;
+  AutoBuf<sample_t> pc;  // post-processing twiddles: exp(-2*i*pi*k/n) [m/2+1]
+  AutoBuf<sample_t> ps;
+  AutoBuf<sample_t> re;  // work buffers [m]
+  AutoBuf<sample_t> im;
+
+  void load(const sample_t *a);
+  void stages();
+
+public:
+  SimdFFT(): n(0), m(0), avx_width(0) {}
+
+  virtual const char *name() const { return avx_width? "SIMD (AVX)": "SIMD (SSE2)"; }
+  virtual bool init(unsigned length);
+
+  virtual void rdft(sample_t *samples);
+  virtual void inv_rdft(sample_t *samples);
+};
+
+bool
+SimdFFT::init(unsigned length)
+{
+  unsigned i, h, bits;
+  const double pi = 3.14159265358979323846;
+
+  // Short transforms are not worth it
+  if (length < 16 || (length & (length - 1)))
+    return false;
+
+  n = length;
+  m = length / 2;
+#ifdef VALIB_SIMD_AVX
+  avx_width = (simd_caps() & SIMD_AVX)? vec_avx::width: 0;
+#else
+  avx_width = 0;
+#endif
+
+  rev.allocate(m);
+  wr.allocate(m);
+  wi.allocate(m);
+  pc.allocate(m/2+1);
+  ps.allocate(m/2+1);
+  re.allocate(m);
+  im.allocate(m);
+
+  if (!rev.is_allocated() || !wr.is_allocated() || !wi.is_allocated() ||
+      !pc.is_allocated() || !ps.is_allocated() ||
+      !re.is_allocated() || !im.is_allocated())
+    return false;
+
+  for (bits = 0; (1u << bits) < m; bits++)
+    ;
+
+  for (i = 0; i < m; i++)
+  {
+    unsigned r = 0;
+    for (unsigned b = 0; b < bits; b++)
+      if (i & (1 << b))
+        r |= 1 << (bits - b - 1);
+    rev[i] = r;
+  }
+
+  wr[0] = 1; wi[0] = 0;
+  for (h = 1; h < m; h *= 2)
+    for (i = 0; i < h; i++)
+    {
+      wr[h + i] = (sample_t)cos(pi * i / h);
+      wi[h + i] = (sample_t)-sin(pi * i / h);
+    }
+
+  for (i = 0; i <= m/2; i++)
+  {
+    pc[i] = (sample_t)cos(2 * pi * i / n);
+    ps[i] = (sample_t)sin(2 * pi * i / n);
+  }
+
+  return true;
+}
+
+void
+SimdFFT::load(const sample_t *a)
+{
+  // Load interleaved complex data in bit-reversed order and do the first
+  // two stages: radix-4 butterflies with twiddles 1 and -i
+  for (unsigned k = 0; k < m; k += 4)
+  {
+    const sample_t *z0 = a + 2 * rev[k];
+    const sample_t *z1 = a + 2 * rev[k+1];
+    const sample_t *z2 = a + 2 * rev[k+2];
+    const sample_t *z3 = a + 2 * rev[k+3];
+
+    sample_t a0r = z0[0] + z1[0], a0i = z0[1] + z1[1];
+    sample_t a1r = z0[0] - z1[0], a1i = z0[1] - z1[1];
+    sample_t a2r = z2[0] + z3[0], a2i = z2[1] + z3[1];
+    sample_t a3r = z2[0] - z3[0], a3i = z2[1] - z3[1];
+
+    sample_t *r = re + k, *i = im + k;
+    r[0] = a0r + a2r; i[0] = a0i + a2i;
+    r[2] = a0r - a2r; i[2] = a0i - a2i;
+    r[1] = a1r + a3i; i[1] = a1i - a3r;
+    r[3] = a1r - a3i; i[3] = a1i + a3r;
+  }
+}
+
+void
+SimdFFT::stages()
+{
+  unsigned h = 4;
+  while (h < m)
+  {
+    bool avx = avx_width && h >= avx_width;
+    if (h * 4 <= m)
+    {
+      if (avx) fft_stage4_avx(re, im, wr, wi, m, h);
+      else     fft_stage4_sse2(re, im, wr, wi, m, h);
+      h *= 4;
+    }
+    else
+    {
+      if (avx) fft_stage2_avx(re, im, wr, wi, m, h);
+      else     fft_stage2_sse2(re, im, wr, wi, m, h);
+      h *= 2;
+    }
+  }
+}
+
+void
+SimdFFT::rdft(sample_t *a)
+{
+  unsigned k;
+
+  load(a);
+  stages();
+
+  // X[k] = E[k] + W^k * O[k], X[m-k] = conj(E[k] - W^k * O[k])
+  // E[k] = (Z[k] + conj(Z[m-k])) / 2, O[k] = (Z[k] - conj(Z[m-k])) / 2i
+
+  a[0] = re[0] + im[0];
+  a[1] = re[0] - im[0];
+
+  k = (avx_width && m >= 2 * avx_width)?
+    fft_post_avx(a, re, im, pc, ps, m):
+    fft_post_sse2(a, re, im, pc, ps, m);
+
+  for (; k <= m/2; k++)
+  {
+    sample_t er = (re[k] + re[m-k]) * 0.5f;
+    sample_t ei = (im[k] - im[m-k]) * 0.5f;
+    sample_t or_ = (im[k] + im[m-k]) * 0.5f;
+    sample_t oi = (re[m-k] - re[k]) * 0.5f;
+
+    sample_t tr = pc[k] * or_ + ps[k] * oi;
+    sample_t ti = pc[k] * oi - ps[k] * or_;
+
+    // Ooura's format stores negated imaginary parts
+    a[2*k]       = er + tr;
+    a[2*k+1]     = -(ei + ti);
+    a[2*(m-k)]   = er - tr;
+    a[2*(m-k)+1] = ei - ti;
+  }
+}
+
+void
+SimdFFT::inv_rdft(sample_t *a)
+{
+  unsigned k;
+  sample_t zr, zi;
+
+  // Z[k] = E[k] + i * O[k]
+  // E[k] = (X[k] + conj(X[m-k])) / 2, O[k] = (X[k] - conj(X[m-k])) * W^-k / 2
+  //
+  // Inverse complex transform is the forward transform with swapped real
+  // and imaginary parts, so Z is stored swapped (in-place).
+
+  zr = (a[0] + a[1]) * 0.5f;
+  zi = (a[0] - a[1]) * 0.5f;
+  a[0] = zi;
+  a[1] = zr;
+
+  k = (avx_width && m >= 2 * avx_width)?
+    fft_pre_avx(a, pc, ps, m):
+    fft_pre_sse2(a, pc, ps, m);
+
+  for (; k <= m/2; k++)
+  {
+    sample_t xr = a[2*k], xi = -a[2*k+1];
+    sample_t yr = a[2*(m-k)], yi = a[2*(m-k)+1];
+
+    sample_t er = (xr + yr) * 0.5f;
+    sample_t ei = (xi + yi) * 0.5f;
+    sample_t dr = (xr - yr) * 0.5f;
+    sample_t di = (xi - yi) * 0.5f;
+
+    sample_t or_ = dr * pc[k] - di * ps[k];
+    sample_t oi = dr * ps[k] + di * pc[k];
+
+    a[2*k]       = ei + or_;
+    a[2*k+1]     = er - oi;
+    a[2*(m-k)]   = or_ - ei;
+    a[2*(m-k)+1] = er + oi;
+  }
+
+  load(a);
+  stages();
+
+  if (avx_width && m >= avx_width)
+    fft_out_avx(a, re, im, m);
+  else
+    fft_out_sse2(a, re, im, m);
+}
+
+FFTBackend *create_simd_fft()
+{
+  if (simd_caps() & SIMD_SSE2)
+    return new SimdFFT();
+  return 0;
+}
+
+#else
+
+FFTBackend *create_simd_fft()
+{
+  return 0;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// SplitFFT
+
+bool
+SplitFFT::set_length(unsigned length)
+{
+  unsigned i, h, bits;
+  const double pi = 3.14159265358979323846;
+
+  m = 0;
+  if (length < 4 || (length & (length - 1)))
+    return false;
+
+  rev_tbl.allocate(length);
+  wr.allocate(length);
+  wi.allocate(length);
+  if (!rev_tbl.is_allocated() || !wr.is_allocated() || !wi.is_allocated())
+    return false;
+
+  for (bits = 0; (1u << bits) < length; bits++)
+    ;
+
+  for (i = 0; i < length; i++)
+  {
+    unsigned r = 0;
+    for (unsigned b = 0; b < bits; b++)
+      if (i & (1 << b))
+        r |= 1 << (bits - b - 1);
+    rev_tbl[i] = r;
+  }
+
+  wr[0] = 1; wi[0] = 0;
+  for (h = 1; h < length; h *= 2)
+    for (i = 0; i < h; i++)
+    {
+      wr[h + i] = (sample_t)cos(pi * i / h);
+      wi[h + i] = (sample_t)-sin(pi * i / h);
+    }
+
+  m = length;
+  return true;
+}
+
+void
+SplitFFT::fft(sample_t *re, sample_t *im) const
+{
+  unsigned k, h;
+
+  // First two stages: radix-4 butterflies with twiddles 1 and -i
+  for (k = 0; k < m; k += 4)
+  {
+    sample_t *r = re + k, *i = im + k;
+    sample_t a0r = r[0] + r[1], a0i = i[0] + i[1];
+    sample_t a1r = r[0] - r[1], a1i = i[0] - i[1];
+    sample_t a2r = r[2] + r[3], a2i = i[2] + i[3];
+    sample_t a3r = r[2] - r[3], a3i = i[2] - i[3];
+
+    r[0] = a0r + a2r; i[0] = a0i + a2i;
+    r[2] = a0r - a2r; i[2] = a0i - a2i;
+    r[1] = a1r + a3i; i[1] = a1i - a3r;
+    r[3] = a1r - a3i; i[3] = a1i + a3r;
+  }
+
+  int caps = simd_caps();
+  for (h = 4; h < m; )
+  {
+    fft_stage_t stage2 = fft_stage2_scalar;
+    fft_stage_t stage4 = fft_stage4_scalar;
+#ifdef VALIB_SIMD_X86
+#ifdef VALIB_SIMD_AVX
+    if ((caps & SIMD_AVX) && h >= vec_avx::width)
+    {
+      stage2 = fft_stage2_avx;
+      stage4 = fft_stage4_avx;
+    }
+    else
+#endif
+    if (caps & SIMD_SSE2)
+    {
+      stage2 = fft_stage2_sse2;
+      stage4 = fft_stage4_sse2;
+    }
+#endif
+
+    if (h * 4 <= m)
+    {
+      stage4(re, im, wr, wi, m, h);
+      h *= 4;
+    }
+    else
+    {
+      stage2(re, im, wr, wi, m, h);
+      h *= 2;
+    }
+  }
+}
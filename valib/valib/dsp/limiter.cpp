@@ -0,0 +1,231 @@
+#include <math.h>
+#include <string.h>
+#include "limiter.h"
+#include "dot.h"
+#include "kaiser.h"
+
+// True-peak interpolator: half-length and stopband attenuation (dB)
+static const int interp_half = 8;
+static const double interp_att = 60;
+
+inline double sinc(double x) { return x == 0 ? 1 : sin(x)/x; }
+
+Limiter::Limiter():
+  nch(0), lookahead(0), window(0), taps(0), latency(0), ring(0),
+  level(1.0), release(1.0), pos(0),
+  dq_ring(0), dq_front(0), dq_size(0), time(0),
+  box_pos(0), box_sum(0), gain(1.0), out_gain(1.0)
+{}
+
+bool
+Limiter::init(int nch_, int lookahead_, bool true_peak)
+{
+  uninit();
+  if (nch_ <= 0 || nch_ > NCHANNELS || lookahead_ <= 0)
+    return false;
+
+  int taps_ = true_peak? 2 * interp_half: 0;
+  int latency_ = lookahead_ - 1 + taps_ / 2;
+
+  // Delay line holds the output sample and the interpolator window
+  int ring_ = 1;
+  while (ring_ < latency_ + taps_ + 1)
+    ring_ *= 2;
+
+  // Inter-sample peak between samples j and j+1 is limited by the gain of
+  // both samples, so the minimum is taken over one more sample.
+  int window_ = true_peak? lookahead_ + 1: lookahead_;
+  int dq_ring_ = 1;
+  while (dq_ring_ < window_)
+    dq_ring_ *= 2;
+
+  buf.allocate(nch_, ring_ + taps_);
+  dq_gain.allocate(dq_ring_);
+  dq_time.allocate(dq_ring_);
+  box.allocate(lookahead_);
+  if (taps_)
+    phases.allocate(3, taps_);
+
+  if (!buf.is_allocated() ||
+      !dq_gain.is_allocated() ||
+      !dq_time.is_allocated() ||
+      !box.is_allocated() ||
+      (taps_ && !phases.is_allocated()))
+    return false;
+
+  // Phase p interpolates at j + (p+1)/4 from samples j-half+1..j+half
+  if (taps_)
+  {
+    double alpha = kaiser_alpha(interp_att);
+    for (int p = 0; p < 3; p++)
+      for (int k = 0; k < taps_; k++)
+      {
+        double t = interp_half - 1 - k + (p + 1) * 0.25;
+        phases[p][k] = (sample_t)(sinc(t * M_PI) * kaiser_window(t, taps_ + 1, alpha));
+      }
+  }
+
+  nch = nch_;
+  lookahead = lookahead_;
+  window = window_;
+  taps = taps_;
+  latency = latency_;
+  ring = ring_;
+  dq_ring = dq_ring_;
+
+  reset();
+  return true;
+}
+
+void
+Limiter::uninit()
+{
+  nch = 0;
+  lookahead = 0;
+  window = 0;
+  taps = 0;
+  latency = 0;
+  ring = 0;
+  dq_ring = 0;
+}
+
+void
+Limiter::set_level(sample_t level_)
+{
+  level = level_ > 0? level_: 0;
+}
+
+void
+Limiter::set_release(sample_t release_)
+{
+  release = release_ > 1.0? release_: 1.0;
+}
+
+void
+Limiter::reset()
+{
+  gain = 1.0;
+  out_gain = 1.0;
+  if (!is_ok())
+    return;
+
+  buf.zero();
+  pos = 0;
+
+  dq_front = 0;
+  dq_size = 0;
+  time = 0;
+
+  for (int i = 0; i < lookahead; i++)
+    box[i] = 1.0;
+  box_pos = 0;
+  box_sum = lookahead;
+}
+
+void
+Limiter::process(sample_t *const *samples, size_t n)
+{
+  if (!is_ok())
+    return;
+
+  int ch, p;
+  const int mask = ring - 1;
+  const int dq_mask = dq_ring - 1;
+  const int half = taps / 2;
+  const double inv_lookahead = 1.0 / lookahead;
+  dot_mch_t dot = find_dot_mch();
+
+  const sample_t *win[NCHANNELS];
+  sample_t interp[NCHANNELS];
+
+  for (size_t i = 0; i < n; i++)
+  {
+    /////////////////////////////////////////////////////
+    // Peak level
+
+    sample_t peak = 0;
+    for (ch = 0; ch < nch; ch++)
+    {
+      sample_t x = samples[ch][i];
+      buf[ch][pos] = x;
+      if (pos < taps)
+        buf[ch][pos + ring] = x;
+      if (!taps && fabs(x) > peak)
+        peak = fabs(x);
+    }
+
+    if (taps)
+    {
+      // Samples j-half+1..j+half, j = time - half
+      int start = pos - taps + 1;
+      if (start < 0)
+        start += ring;
+      for (ch = 0; ch < nch; ch++)
+      {
+        win[ch] = buf[ch] + start;
+        if (fabs(win[ch][half - 1]) > peak) peak = fabs(win[ch][half - 1]);
+        if (fabs(win[ch][half]) > peak) peak = fabs(win[ch][half]);
+      }
+
+      for (p = 0; p < 3; p++)
+      {
+        dot(win, nch, phases[p], taps, interp);
+        for (ch = 0; ch < nch; ch++)
+          if (fabs(interp[ch]) > peak)
+            peak = fabs(interp[ch]);
+      }
+    }
+
+    /////////////////////////////////////////////////////
+    // Sliding minimum of the required gain
+
+    sample_t r = peak > level? level / peak: 1.0;
+
+    // Drop the expired front before the push, so the deque never holds
+    // more than window values
+    if (dq_size && time - dq_time[dq_front] >= size_t(window))
+    {
+      dq_front = (dq_front + 1) & dq_mask;
+      dq_size--;
+    }
+
+    int back = (dq_front + dq_size) & dq_mask;
+    while (dq_size && dq_gain[(back - 1) & dq_mask] >= r)
+    {
+      back = (back - 1) & dq_mask;
+      dq_size--;
+    }
+    dq_gain[back] = r;
+    dq_time[back] = time;
+    dq_size++;
+
+    /////////////////////////////////////////////////////
+    // Release and smoothing
+
+    sample_t g = gain * release;
+    if (g > dq_gain[dq_front]) g = dq_gain[dq_front];
+    gain = g;
+
+    box_sum += g - box[box_pos];
+    box[box_pos] = g;
+    if (++box_pos >= lookahead)
+    {
+      // Drop the rounding error of the running sum
+      box_pos = 0;
+      box_sum = 0;
+      for (int j = 0; j < lookahead; j++)
+        box_sum += box[j];
+    }
+    out_gain = sample_t(box_sum * inv_lookahead);
+
+    /////////////////////////////////////////////////////
+    // Output
+
+    int out_pos = (pos - latency) & mask;
+    for (ch = 0; ch < nch; ch++)
+      samples[ch][i] = buf[ch][out_pos] * out_gain;
+
+    pos = (pos + 1) & mask;
+    time++;
+  }
+}
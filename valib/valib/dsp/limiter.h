@@ -0,0 +1,113 @@
+#ifndef VALIB_LIMITER_H
+#define VALIB_LIMITER_H
+
+#include "../auto_buf.h"
+#include "../buffer.h"
+
+/******************************************************************************
+
+Look-ahead peak limiter
+
+All channels share one gain, computed per sample in 4 steps:
+
+1) Peak level of the sample over all channels. In true-peak mode the signal
+   is also interpolated at 3 points between each pair of samples (4x
+   oversampling, polyphase windowed-sinc filter), so peaks between samples
+   are found. The interpolator delays the detection by half of its length.
+2) Required gain (level / peak when peak > level) is passed through the
+   sliding minimum over the look-ahead window (monotonic deque).
+3) Gain is released to 1.0 no faster than release factor per sample.
+4) Moving average over the look-ahead window makes the gain curve smooth.
+   Each gain value averaged is not greater than the gain required for the
+   output sample, so the average is not greater too: the gain starts to
+   fall look-ahead samples before the peak and reaches the required value
+   exactly at the peak.
+
+Each step costs O(1) per sample (amortized for the deque), independent of
+the look-ahead length. Still, a long look-ahead is slower: the delay line
+grows and does not fit into the cache.
+
+* init(nch, lookahead, true_peak)
+  nch - number of channels
+  lookahead - look-ahead in samples (>= 1), length of the gain attack
+  true_peak - detect inter-sample peaks
+  Allocates buffers and resets the limiter. Returns false on allocation
+  error or wrong parameters.
+
+* set_level(level)
+  Maximum output level. Peaks above are reduced.
+
+* set_release(release)
+  Maximum gain increase per sample (factor >= 1.0).
+
+* get_latency()
+  Output is delayed by this number of samples (lookahead - 1 plus the
+  delay of the true-peak interpolator).
+
+* get_gain()
+  Gain applied to the last output sample.
+
+* reset()
+  Clear the delay line and set gain to 1.0.
+
+* process(samples, n)
+  samples - pointers to channel buffers [nch][n] (in-place)
+  n - number of samples
+  Limit the next n samples. Output is delayed by get_latency() samples,
+  the delay line is filled with zeros after reset().
+
+******************************************************************************/
+
+class Limiter
+{
+protected:
+  int nch;
+  int lookahead;
+  int window;        // sliding minimum window
+  int taps;          // taps of each interpolator phase (0: sample peak)
+  int latency;
+  int ring;          // delay line size, power of 2
+
+  sample_t level;
+  sample_t release;
+
+  SampleBuf buf;     // [nch][ring + taps] delay line, first taps samples
+                     // are mirrored after the end for the interpolator
+  SampleBuf phases;  // [3][taps] interpolator phases
+  int pos;
+
+  AutoBuf<sample_t> dq_gain;   // [dq_ring] sliding minimum deque
+  AutoBuf<size_t>   dq_time;
+  int dq_ring;       // deque ring size, power of 2 (>= window)
+  int dq_front;
+  int dq_size;
+  size_t time;
+
+  AutoBuf<sample_t> box;       // [lookahead] gains to average
+  int    box_pos;
+  double box_sum;
+  sample_t gain;     // released gain
+  sample_t out_gain; // averaged gain
+
+public:
+  Limiter();
+
+  bool init(int nch, int lookahead, bool true_peak);
+  void uninit();
+  bool is_ok() const { return lookahead > 0; }
+
+  void set_level(sample_t level);
+  void set_release(sample_t release);
+  sample_t get_level() const   { return level;    }
+  sample_t get_release() const { return release;  }
+
+  int get_lookahead() const    { return lookahead; }
+  bool get_true_peak() const   { return taps > 0; }
+  int get_latency() const      { return latency;  }
+  sample_t get_gain() const    { return out_gain; }
+
+  void reset();
+  void process(sample_t *const *samples, size_t n);
+};
+
+#endif
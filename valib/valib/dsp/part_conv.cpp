@@ -0,0 +1,163 @@
+#include <string.h>
+#include "part_conv.h"
+
+PartConv::PartConv():
+  nfilters(0), nch(0), block_size(0), nparts(0)
+{
+  for (int ch = 0; ch < NCHANNELS; ch++)
+    fdl_pos[ch] = 0;
+}
+
+bool
+PartConv::init(int nfilters_, int nch_, int block_size_, int length)
+{
+  uninit();
+  if (nfilters_ <= 0 || nch_ <= 0 || nch_ > NCHANNELS || block_size_ <= 0 || length <= 0)
+    return false;
+
+  int n = (length + block_size_ - 1) / block_size_;
+  int spectrum_size = n * 2 * block_size_;
+
+  fft.set_length(block_size_ * 2);
+  filter.allocate(nfilters_, spectrum_size);
+  fdl.allocate(nch_, spectrum_size);
+  overlap.allocate(nch_, block_size_);
+  fft_buf.allocate(nch_, block_size_ * 2);
+
+  if (!fft.is_ok() ||
+      !filter.is_allocated() ||
+      !fdl.is_allocated() ||
+      !overlap.is_allocated() ||
+      !fft_buf.is_allocated())
+    return false;
+
+  nfilters = nfilters_;
+  nch = nch_;
+  block_size = block_size_;
+  nparts = n;
+
+  filter.zero();
+  reset();
+  return true;
+}
+
+void
+PartConv::uninit()
+{
+  nfilters = 0;
+  nch = 0;
+  block_size = 0;
+  nparts = 0;
+}
+
+void
+PartConv::set_filter(int f, const double *data, int length, int delay)
+{
+  assert(f >= 0 && f < nfilters);
+  assert(delay >= 0 && delay + length <= nparts * block_size);
+
+  int i, p;
+  const int fft_size = block_size * 2;
+  sample_t *part = filter[f];
+
+  // Impulse response is scaled to compensate the inverse transform gain
+  memset(part, 0, nparts * fft_size * sizeof(sample_t));
+  for (i = 0; i < length; i++)
+  {
+    int t = delay + i;
+    part[(t / block_size) * fft_size + t % block_size] = data[i] / block_size;
+  }
+
+  for (p = 0; p < nparts; p++)
+    fft.rdft(part + p * fft_size);
+}
+
+void
+PartConv::reset()
+{
+  if (!is_ok())
+    return;
+
+  fdl.zero();
+  overlap.zero();
+  for (int ch = 0; ch < NCHANNELS; ch++)
+    fdl_pos[ch] = 0;
+}
+
+void
+PartConv::process(int f, int ch, sample_t *samples)
+{
+  process(f, &ch, 1, &samples);
+}
+
+void
+PartConv::process(int f, const int *chs, int n, sample_t *const *samples)
+{
+  assert(f >= 0 && f < nfilters);
+  assert(n > 0 && n <= nch);
+
+  int i, k, p;
+  const int fft_size = block_size * 2;
+  int pos[NCHANNELS];
+
+  // Put spectra of new blocks into the FDL
+
+  for (k = 0; k < n; k++)
+  {
+    int ch = chs[k];
+    assert(ch >= 0 && ch < nch);
+
+    pos[k] = fdl_pos[ch];
+    sample_t *x = fdl[ch] + pos[k] * fft_size;
+    memcpy(x, samples[k], block_size * sizeof(sample_t));
+    memset(x + block_size, 0, block_size * sizeof(sample_t));
+    fft.rdft(x);
+
+    memset(fft_buf[k], 0, fft_size * sizeof(sample_t));
+  }
+
+  // Accumulate products of partitions and delayed input spectra.
+  // Partition p is multiplied by the input block delayed by p blocks.
+  // Partition is applied to all channels of the group while it is
+  // in the cache.
+
+  for (p = 0; p < nparts; p++)
+  {
+    const sample_t *h = filter[f] + p * fft_size;
+    for (k = 0; k < n; k++)
+    {
+      sample_t *y = fft_buf[k];
+      const sample_t *x = fdl[chs[k]] + pos[k] * fft_size;
+
+      y[0] += h[0] * x[0];
+      y[1] += h[1] * x[1];
+      for (i = 1; i < block_size; i++)
+      {
+        y[i*2  ] += h[i*2  ] * x[i*2] - h[i*2+1] * x[i*2+1];
+        y[i*2+1] += h[i*2+1] * x[i*2] + h[i*2  ] * x[i*2+1];
+      }
+
+      if (--pos[k] < 0)
+        pos[k] = nparts - 1;
+    }
+  }
+
+  // Overlap-add
+
+  for (k = 0; k < n; k++)
+  {
+    int ch = chs[k];
+    sample_t *y = fft_buf[k];
+    sample_t *delay_ch = overlap[ch];
+
+    fft.inv_rdft(y);
+
+    for (i = 0; i < block_size; i++)
+      samples[k][i] = y[i] + delay_ch[i];
+
+    memcpy(delay_ch, y + block_size, block_size * sizeof(sample_t));
+
+    if (++fdl_pos[ch] >= nparts)
+      fdl_pos[ch] = 0;
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef VALIB_PART_CONV_H
+#define VALIB_PART_CONV_H
+
+#include "../buffer.h"
+#include "fft.h"
+
+/******************************************************************************
+
+Uniformly partitioned FFT convolution
+
+The impulse response is split into partitions of the block size. Each
+partition is transformed separately, and spectra of the last input blocks are
+kept at the frequency-delay line (FDL). Output spectrum for the current block
+is the sum of products of each partition and the corresponding input spectrum
+from the FDL, so only one forward and one inverse FFT of 2*block_size is
+required per block regardless of the filter length. Latency and per-block
+work depend only on the block size.
+
+Several channels may share the same filter (FDL and overlap are per-channel).
+Channels that share the filter may be processed together: each partition of
+the filter spectrum is loaded once for all channels of the group, so the
+filter is read from memory once per block instead of once per channel.
+
+* init(nfilters, nch, block_size, length)
+  nfilters - number of filters
+  nch - number of channels
+  block_size - block (partition) size, power of 2
+  length - maximum length of the impulse response (including delay)
+  Allocates buffers. All filters are zero after init. Returns false on
+  allocation error.
+
+* set_filter(f, data, length, delay)
+  f - filter index
+  data - impulse response [length]
+  length - length of the impulse response
+  delay - position of the impulse response (delay + length must not exceed
+    the length given at init())
+
+* reset()
+  Clear FDL and overlap buffers of all channels.
+
+* process(f, ch, samples)
+  f - filter index
+  ch - channel index
+  samples - block of block_size samples (in-place)
+  Convolve next block of the channel with the filter.
+
+* process(f, chs, n, samples)
+  f - filter index
+  chs - channel indices [n]
+  n - number of channels
+  samples - blocks of block_size samples for each channel [n] (in-place)
+  Convolve next blocks of several channels with the same filter.
+
+******************************************************************************/
+
+class PartConv
+{
+protected:
+  int nfilters;
+  int nch;
+  int block_size;
+  int nparts;
+  int fdl_pos[NCHANNELS];
+
+  MM_FFT    fft;
+  SampleBuf filter;  // [nfilters][nparts * 2 * block_size]
+  SampleBuf fdl;     // [nch][nparts * 2 * block_size]
+  SampleBuf overlap; // [nch][block_size]
+  SampleBuf fft_buf; // [nch][2 * block_size]
+
+public:
+  PartConv();
+
+  bool init(int nfilters, int nch, int block_size, int length);
+  void uninit();
+  bool is_ok() const { return nparts > 0; }
+
+  int get_block_size() const { return block_size; }
+  int get_nparts() const { return nparts; }
+
+  void set_filter(int f, const double *data, int length, int delay);
+  void reset();
+  void process(int f, int ch, sample_t *samples);
+  void process(int f, const int *chs, int n, sample_t *const *samples);
+};
+
+#endif
@@ -464,6 +464,28 @@ public:
 //   query_input()
 //   get_output()
 //   is_empty()
+//
+//
+// Buffer negotiation [working thread]
+//   FilterGraph uses these functions when it builds the chain to let a filter
+//   work in the buffer of the upstream filter instead of its own buffer.
+//   Default implementation does no negotiation.
+//
+// is_inplace()
+//   Filter sends the data in the same buffer it receives (pass-through for
+//   the negotiation).
+//
+// get_inplace_nch()
+//   Number of channels the filter needs in the input buffer to work in-place.
+//   Zero means that the filter does not need more channels than it receives.
+//   Called after set_input().
+//
+// reserve_nch()
+//   Called for the filter that owns the buffer. Returns true if output buffer
+//   has at least nch channels. Must not drop the filter's state.
+//
+// set_inplace_nch()
+//   Tells the filter how many channels the input buffer has (0 if not known).
         
 class Filter: public Sink, public Source
 {
@@ -482,6 +504,11 @@ public:
   virtual bool is_empty() const = 0;
   virtual bool get_chunk(Chunk *chunk) = 0;
 
+  virtual bool is_inplace() const        { return false; }
+  virtual int  get_inplace_nch() const   { return 0;     }
+  virtual bool reserve_nch(int nch)      { return false; }
+  virtual void set_inplace_nch(int nch)  {}
+
   inline bool process_to(const Chunk *_chunk, Sink *_sink)
   {
     Chunk chunk;
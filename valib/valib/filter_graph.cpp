@@ -210,6 +210,8 @@ FilterGraph::add_node(int node, Speakers spk)
   prev[node_end] = next_node;
   node_state[next_node] = ns_ok;
 
+  negotiate_buffers(next_node);
+
   // update ofdd status
   // aggregate is data-dependent if chain has
   // at least one ofdd filter
@@ -225,6 +227,42 @@ FilterGraph::add_node(int node, Speakers spk)
   return true;
 }
 
+/////////////////////////////////////////////////////////
+// Negotiate buffers for a new node
+//
+// void negotiate_buffers(int node)
+// node - node just added to the chain
+//
+// If the node's filter needs more channels in its input
+// buffer to work in-place (upmix), ask the filter that
+// owns the buffer to reserve them. In-place filters
+// between them send the data in the same buffer, so we
+// skip them. Filter at the start node is external and
+// cannot reserve anything.
+//
+// Filter buffers persist between chunks, so reserved
+// channels are never released.
+
+void
+FilterGraph::negotiate_buffers(int node)
+{
+  int nch = filter[node]->get_inplace_nch();
+  if (nch == 0)
+  {
+    filter[node]->set_inplace_nch(0);
+    return;
+  }
+
+  int owner = prev[node];
+  while (owner != node_start && filter[owner]->is_inplace())
+    owner = prev[owner];
+
+  if (owner != node_start && filter[owner]->reserve_nch(nch))
+    filter[node]->set_inplace_nch(nch);
+  else
+    filter[node]->set_inplace_nch(0);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Chain data flow
 ///////////////////////////////////////////////////////////////////////////////
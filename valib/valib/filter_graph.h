@@ -111,6 +111,7 @@ private:
 
   bool build_chain(int node);
   bool add_node(int node, Speakers spk);
+  void negotiate_buffers(int node);
 
   /////////////////////////////////////////////////////////
   // Chain data flow
@@ -1,6 +1,7 @@
 #include <math.h>
 #include <string.h>
 #include "agc.h"
+#include "../dsp/block_stat.h"
     
 #define LEVEL_MINUS_50DB 0.0031622776601683793319988935444327
 #define LEVEL_MINUS_100DB 0.00001
@@ -38,6 +39,15 @@ AGC::AGC(size_t _nsamples)
   drc_power = 0;     // dB; this value has meaning of loudness raise at -50dB level
   drc_level = 1.0;   // factor
 
+  // Limiter
+  limiter   = false;
+  true_peak = true;
+  lookahead = 0.005; // sec
+  limiter_level = 1.0; // factor
+  lim_mode  = false;
+  pre_samples = 0;
+  post_samples = 0;
+
   // rebuild window
   set_buffer(_nsamples);
 }
@@ -122,7 +132,6 @@ AGC::process()
 
   sample_t max;
   sample_t *sptr;
-  sample_t *send;
 
   sample_t levels_loc[NCHANNELS];
   memset(levels_loc, 0, sizeof(levels_loc));
@@ -130,32 +139,12 @@ AGC::process()
   ///////////////////////////////////////
   // Channel levels
 
-  for (ch = 0; ch < nch; ch++)
-  {
-    max = 0;
-    sptr = buf[block][ch];
-    send = sptr + nsamples - 7;
-    while (sptr < send)
-    {
-      if (fabs(sptr[0]) > max) max = fabs(sptr[0]);
-      if (fabs(sptr[1]) > max) max = fabs(sptr[1]);
-      if (fabs(sptr[2]) > max) max = fabs(sptr[2]);
-      if (fabs(sptr[3]) > max) max = fabs(sptr[3]);
-      if (fabs(sptr[4]) > max) max = fabs(sptr[4]);
-      if (fabs(sptr[5]) > max) max = fabs(sptr[5]);
-      if (fabs(sptr[6]) > max) max = fabs(sptr[6]);
-      if (fabs(sptr[7]) > max) max = fabs(sptr[7]);
-      sptr += 8;
-    }
-    send += 7;
-    while (sptr < send)
-    {
-      if (fabs(sptr[0]) > max) max = fabs(sptr[0]);
-      sptr++;
-    }
+  samples_t block_samples = buf[block];
+  block_stat_mch_t block_stat = find_block_stat_mch();
+  block_stat(block_samples.samples, nch, nsamples, levels_loc, 0);
 
-    levels_loc[ch] = max / spk_level;
-  }
+  for (ch = 0; ch < nch; ch++)
+    levels_loc[ch] /= spk_level;
 
   ///////////////////////////////////////
   // Gain, Limiter, DRC
@@ -312,11 +301,18 @@ AGC::reset()
 
   level  = 1.0;
   factor = 1.0;
+
+  // limiter is initialized with the first chunk
+  lim_mode = limiter;
+  lim.uninit();
 }
 
 bool 
 AGC::get_chunk(Chunk *_chunk)
 {
+  if (lim_mode)
+    return limiter_chunk(_chunk);
+
   while (fill_buffer())
   {
     process();
@@ -345,3 +341,91 @@ AGC::get_chunk(Chunk *_chunk)
   _chunk->set_dummy();
   return true;
 }
+
+///////////////////////////////////////////////////////////
+// Limiter mode
+
+bool
+AGC::init_limiter()
+{
+  int nch = spk.nch();
+  int n = int(lookahead * spk.sample_rate + 0.5);
+  if (n < 1) n = 1;
+
+  if (!lim.init(nch, n, true_peak))
+    return false;
+
+  tail.allocate(nch, lim.get_latency() + 1);
+  if (!tail.is_allocated())
+    return false;
+
+  pre_samples = lim.get_latency();
+  post_samples = lim.get_latency();
+  return true;
+}
+
+bool
+AGC::limiter_chunk(Chunk *_chunk)
+{
+  if (!size && !flushing)
+  {
+    _chunk->set_dummy();
+    return true;
+  }
+
+  if (!lim.is_ok() && !init_limiter())
+    return false;
+
+  int ch;
+  int nch = spk.nch();
+  lim.set_level(limiter_level * spk.level);
+  lim.set_release(pow(10.0, release / spk.sample_rate / 20));
+
+  if (size)
+  {
+    // master gain and limiter (in-place)
+    if (!EQUAL_SAMPLES(master, 1.0))
+      for (ch = 0; ch < nch; ch++)
+        for (size_t s = 0; s < size; s++)
+          samples[ch][s] *= master;
+
+    lim.process(samples.samples, size);
+    gain = master * lim.get_gain();
+    drc_level = 1.0;
+
+    // output is delayed by the limiter latency
+    size_t drop = MIN(size, pre_samples);
+    samples_t out = samples;
+    out += drop;
+    pre_samples -= drop;
+
+    _chunk->set_linear
+    (
+      spk, out, size - drop,
+      sync, time + vtime_t(int(drop) - lim.get_latency()) / spk.sample_rate,
+      flushing && post_samples == 0
+    );
+
+    drop_samples(size);
+    sync = false;
+    flushing = flushing && post_samples;
+    return true;
+  }
+
+  // flushing: send the tail (a part of it may be in the pre-delay when the
+  // stream is shorter than the latency) and start a new stream
+
+  tail.zero();
+  lim.process(tail.samples().samples, post_samples);
+
+  size_t drop = MIN(post_samples, pre_samples);
+  samples_t out = tail;
+  out += drop;
+  _chunk->set_linear(spk, out, post_samples - drop, false, 0, true);
+
+  flushing = false;
+  lim.reset();
+  pre_samples = lim.get_latency();
+  post_samples = lim.get_latency();
+  return true;
+}
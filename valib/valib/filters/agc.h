@@ -7,7 +7,7 @@
   Output formats: Linear
   Buffer: +
   Inline: -
-  Delay: nsamples
+  Delay: nsamples (limiter latency in limiter mode)
   Timing: unchanged
   Paramters:
     buffer       // processing buffer length in samples [offline]
@@ -19,6 +19,18 @@
     drc          // DRC enabled [online]
     drc_power    // DRC power (dB) [online]
     drc_level    // current DRC gain level (read-only) [read-only]
+    limiter      // look-ahead limiter mode [offline]
+    true_peak    // limit inter-sample peaks [offline]
+    lookahead    // limiter look-ahead (sec) [offline]
+    limiter_level // limiter level [online]
+
+  Limiter mode
+  ============
+  Block buffer is not used in this mode. Master gain is applied, and peaks
+  above the limiter level are reduced by the look-ahead limiter (see
+  dsp/limiter.h) with the gain released at the release speed. Delay is the
+  look-ahead instead of the buffer length. Auto gain, normalize and DRC are
+  not used. Offline parameters take effect after reset().
 */
 
 #ifndef VALIB_AGC_H
@@ -26,6 +38,7 @@
 
 #include "../buffer.h"
 #include "../filter.h"
+#include "../dsp/limiter.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 // AGC class
@@ -47,11 +60,21 @@ protected:
   sample_t  factor;               // previous block factor
   sample_t  level;                // previous block level (not scaled)
 
+  // limiter mode
+  Limiter   lim;
+  bool      lim_mode;             // limiter mode is active
+  size_t    pre_samples;          // limiter delay to drop at the stream start
+  size_t    post_samples;         // limiter tail to send at the stream end
+  SampleBuf tail;
+
   inline size_t next_block();
 
   bool fill_buffer();
   void process();
 
+  bool init_limiter();
+  bool limiter_chunk(Chunk *out);
+
 public:
   // Options
   bool auto_gain;                 // [rw] automatic gain control
@@ -69,6 +92,12 @@ public:
   sample_t drc_power;             // [rw] DRC power (dB)
   sample_t drc_level;             // [r]  current DRC gain level (read-only)
 
+  // Limiter
+  bool     limiter;               // [rw] look-ahead limiter mode
+  bool     true_peak;             // [rw] limit inter-sample peaks
+  vtime_t  lookahead;             // [rw] limiter look-ahead (sec)
+  sample_t limiter_level;         // [rw] limiter level
+
   AGC(size_t nsamples);
 
   /////////////////////////////////////////////////////////
@@ -83,6 +112,9 @@ public:
 
   virtual void reset();
   virtual bool get_chunk(Chunk *out);
+
+  // buffers always have NCHANNELS channels
+  virtual bool reserve_nch(int nch) { return nch <= NCHANNELS; }
 };
 
 
@@ -106,6 +106,10 @@ public:
   inline double get_freq() const;
   inline void   set_freq(double _freq);
 
+  /////////////////////////////////////////////////////////
+  // Filter interface
+
+  virtual bool is_inplace() const { return true; }
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -41,6 +41,8 @@ public:
   // You can specify CH_NONE to get sum of all channels
   // Returns actual number of samples copied
   size_t get_samples(int ch_name, vtime_t time, sample_t *buf, size_t size);
+
+  virtual bool is_inplace() const { return true; }
 };
 
 #endif
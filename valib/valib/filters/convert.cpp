@@ -13,6 +13,7 @@ Converter::Converter(size_t _nsamples)
   format = FORMAT_UNKNOWN;
   memcpy(order, std_order, sizeof(order));
   nsamples = _nsamples;
+  reserved_nch = 0;
   out_size = 0;
   part_size = 0;
 }
@@ -83,18 +84,34 @@ Converter::initialize()
   /////////////////////////////////////////////////////////
   // allocate buffer
 
-  if (!buf.allocate(spk.nch() * nsamples * sample_size(format)))
+  if (!alloc_buffer())
   {
     convert = 0;
     spk = spk_unknown;
     return false;
   }
 
+  return true;
+}
+
+bool
+Converter::alloc_buffer()
+{
+  // Linear buffer may have more channels than we need when
+  // downstream filter reserved them (see reserve_nch())
+
+  int nch = spk.nch();
+  if (format == FORMAT_LINEAR && reserved_nch > nch)
+    nch = reserved_nch;
+
+  if (!buf.allocate(nch * nsamples * sample_size(format)))
+    return false;
+
   if (format == FORMAT_LINEAR)
   {
     // set channel pointers
     out_samples[0] = (sample_t *)buf.data();
-    for (int ch = 1; ch < spk.nch(); ch++)
+    for (int ch = 1; ch < nch; ch++)
       out_samples[ch] = out_samples[ch-1] + nsamples;
     out_rawdata = 0;
   }
@@ -279,6 +296,38 @@ Converter::set_input(Speakers _spk)
   return initialize();
 }
 
+bool
+Converter::is_inplace() const
+{
+  return spk.format == format;
+}
+
+bool
+Converter::reserve_nch(int nch)
+{
+  // Only PCM -> Linear conversion owns the linear buffer
+  if (format != FORMAT_LINEAR || spk.format == FORMAT_LINEAR || convert == 0)
+    return false;
+
+  if (nch > NCHANNELS)
+    return false;
+
+  if (nch <= reserved_nch || nch <= spk.nch())
+    return true;
+
+  // Converted data is sent immediately, so the buffer holds
+  // nothing between calls and we may reallocate it without
+  // the reset.
+  reserved_nch = nch;
+  if (!alloc_buffer())
+  {
+    convert = 0;
+    spk = spk_unknown;
+    return false;
+  }
+  return true;
+}
+
 Speakers 
 Converter::get_output() const
 {
@@ -38,6 +38,7 @@ protected:
   // converted samples buffer
   Rawdata   buf;           // buffer for converted data
   size_t    nsamples;      // buffer size in samples
+  int       reserved_nch;  // linear buffer channels reserved by downstream filter
 
   // output data pointers
   uint8_t  *out_rawdata;   // buffer pointer for pcm data
@@ -50,6 +51,7 @@ protected:
 
   convert_t find_conversion(int _format, Speakers _spk) const;
   bool initialize();       // initialize convertor
+  bool alloc_buffer();     // allocate buffer and set output pointers
   void convert_pcm2linear();
   void convert_linear2pcm();
   bool is_lpcm(int format) { return format == FORMAT_LPCM20 || format == FORMAT_LPCM24; }
@@ -81,6 +83,9 @@ public:
 
   virtual Speakers get_output() const;
   virtual bool get_chunk(Chunk *out);
+
+  virtual bool is_inplace() const;
+  virtual bool reserve_nch(int nch);
 };
 
 #endif
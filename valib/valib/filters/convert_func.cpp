@@ -47,85 +47,73 @@
 
   Default real to integer conversion is truncation. We cannot accept this
   because it will produce high quantization noise. Thus we have to specify
-  the rounding directly. Direct call to floor() function is slow, but the only
-  compatible solution. Also it is used in debug builds as reference. For
-  release builds paltform-specific methods may be used. Following functions are
-  wrappers for paltform-specific code:
-
-  set_rounding() - set the correct rounding mode if needed
-  release_rounding() - restore an old rounding mode if needed
-  s2i() - sample to integer conversion
+  the rounding directly. Direct call to floor() function is slow. Instead we
+  use SSE2 conversion with the default rounding mode (round to nearest) that
+  does not require to touch FPU control word:
+
+  floor(s) = round(s - 0.5)
+
+  The only difference is at exact integers of s that may be rounded either
+  way (at the half of the quantization step). Integer values stored as
+  i + 0.5 are always restored exactly.
+
   i2s() - integer to sample conversion
+  s2i16(), s2i24(), s2i32() - sample to integer conversion with saturation
+    to the range of the PCM format. NaN is converted to zero.
 
-  Note, that conversion DOES NOT do scaling. The correct level and no overflow
-  guarantee is the task for the caller.
-*/
+  Note, that conversion DOES NOT do scaling. The correct level is the task
+  for the caller. Saturation just prevents wrapping around on overflow.
 
+  SIMD conversion
+  ===============
 
+  SIMD kernels (convert_simd.h) are used for PCM16/24/32 (both byte orders),
+  PCM Float and PCM Double formats when allowed by simd_caps(). They do the
+  same operations as scalar functions, so the result is bit-exact.
+*/
 
 #include <math.h>
 #include "convert_func.h"
+#include "../simd.h"
 #include <emmintrin.h>
 
-#if defined(_DEBUG) || !defined(_M_IX86)
-
-/*static inline int set_rounding() { return 0; }
-static inline void restore_rounding(int) {}*/
+// Saturation limits after the shift by 0.5. Float cannot represent 2^31-1,
+// so we use the largest float below 2^31 for PCM32.
+#define S2I_MIN16 (-32768.0)
+#define S2I_MAX16 (+32767.0)
+#define S2I_MIN24 (-8388608.0)
+#define S2I_MAX24 (+8388607.0)
+#define S2I_MIN32 (-2147483648.0)
+#ifdef FLOAT_SAMPLE
+#define S2I_MAX32 (+2147483520.0)
+#else
+#define S2I_MAX32 (+2147483647.0)
+#endif
 
 #define i2s(i) (sample_t(i)+0.5)
-#define s2i(s) /*int32_t(floor(s))/*/int32_t(_mm_cvtsd_si32(_mm_load_sd(&s)))/**/
 
-#elif defined(_M_IX86)
-
-/*static inline int set_rounding()
+static inline int32_t s2i(sample_t s, sample_t min, sample_t max)
 {
-  // Set x87 FPU rounding mode.
-  // Returns unchanged FPU control word to restore later.
-
-  const uint16_t rc_mask    = 0x0c00;
-  const uint16_t rc_nearest = 0x0000;
-  const uint16_t rc_down    = 0x0400;
-  const uint16_t rc_up      = 0x0800;
-  const uint16_t rc_trunc   = 0x0c00;
-
-  uint16_t x87_ctrl;
-  __asm fnstcw [x87_ctrl];
-
-  uint16_t new_ctrl = x87_ctrl & ~rc_mask | rc_down;
-  __asm fldcw [new_ctrl];
-
-  return x87_ctrl;
-}
-
-static inline void restore_rounding(int r)
-{
-  // Restore an old x87 FPU control word
-
-  uint16_t x87_ctrl = r;
-  __asm fldcw [x87_ctrl];
-}*/
-
-/*static inline sample_t i2s(int32_t i)
-{
-  return sample_t(i) + 0.5;
+  if (s != s) return 0; // NaN
+  s -= 0.5;
+  if (s < min) s = min;
+  if (s > max) s = max;
+#ifdef FLOAT_SAMPLE
+  return _mm_cvtss_si32(_mm_set_ss(s));
+#else
+  return _mm_cvtsd_si32(_mm_set_sd(s));
+#endif
 }
 
-static inline int32_t s2i(sample_t s)
-{
-  int32_t i;
-  __asm fld [s]
-  __asm fistp [i]
-  return i;
-}/*/
-#define i2s(i) (sample_t(i)+0.5)
-#define s2i(s) int32_t(_mm_cvtsd_si32(_mm_load_sd(&s)))/**/
-
-#endif
+#define s2i16(s) s2i(s, S2I_MIN16, S2I_MAX16)
+#define s2i24(s) s2i(s, S2I_MIN24, S2I_MAX24)
+#define s2i32(s) s2i(s, S2I_MIN32, S2I_MAX32)
 
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "convert_pcm2linear.h"
 #include "convert_linear2pcm.h"
+#include "convert_simd.h"
 
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -154,7 +142,11 @@ convert_t find_pcm2linear(int pcm_format, int nch)
   if (nch < 1 || nch > NCHANNELS)
     return 0;
 
-  for (int i = 0; i < array_size(pcm2linear_formats); i++)
+  convert_t simd = find_pcm2linear_simd(pcm_format, nch);
+  if (simd)
+    return simd;
+
+  for (size_t i = 0; i < array_size(pcm2linear_formats); i++)
     if (pcm_format == pcm2linear_formats[i])
       return pcm2linear_tbl[nch-1][i];
 
@@ -166,7 +158,11 @@ convert_t find_linear2pcm(int pcm_format, int nch)
   if (nch < 1 || nch > NCHANNELS)
     return 0;
 
-  for (int i = 0; i < array_size(linear2pcm_formats); i++)
+  convert_t simd = find_linear2pcm_simd(pcm_format, nch);
+  if (simd)
+    return simd;
+
+  for (size_t i = 0; i < array_size(linear2pcm_formats); i++)
     if (pcm_format == linear2pcm_formats[i])
       return linear2pcm_tbl[nch-1][i];
 
@@ -0,0 +1,423 @@
+/* included from convert_func.cpp */
+
+/*
+  SIMD PCM <-> Linear conversion
+
+  Conversion is done by blocks of frames through a small buffer:
+  * PCM -> Linear: convert interleaved PCM values into interleaved samples,
+    4 values per step, then deinterleave the buffer into channels.
+  * Linear -> PCM: interleave channels into the buffer, then convert 4 values
+    per step.
+  Mono is converted without the intermediate buffer.
+
+  Each format is described by a codec:
+    size    - PCM value size in bytes
+    read    - number of values covered by the vector load (24-bit codec loads
+              16 bytes for 4 values, so it needs 6 values in the buffer)
+    decode(rawdata, samples) - convert 4 PCM values to samples
+    encode(rawdata, samples) - convert 4 samples to PCM values
+    decode1(), encode1()     - scalar conversion of one value for the tail
+
+  Codecs do the same operations as i2s()/s2iXX() in the same precision, so
+  SIMD kernels are bit-exact to the scalar functions (NaN is converted to
+  zero by both). PCM24 and big-endian
+  PCM32 use byte shuffles, so they require SSSE3.
+*/
+
+#ifdef VALIB_SIMD_X86
+
+#include <tmmintrin.h>
+#include "../simd_vec.h"
+
+static const int convert_block = 256; // frames per buffer
+
+///////////////////////////////////////////////////////////////////////////////
+// 4 integers <-> 4 samples
+
+#ifndef FLOAT_SAMPLE
+
+static inline void i2s_vec(sample_t *s, __m128i i)
+{
+  const __m128d half = _mm_set1_pd(0.5);
+  _mm_storeu_pd(s,     _mm_add_pd(_mm_cvtepi32_pd(i), half));
+  _mm_storeu_pd(s + 2, _mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(i, 8)), half));
+}
+
+static inline __m128i s2i_vec(const sample_t *s, sample_t min, sample_t max)
+{
+  const __m128d half = _mm_set1_pd(0.5);
+  const __m128d vmin = _mm_set1_pd(min);
+  const __m128d vmax = _mm_set1_pd(max);
+  __m128d lo = _mm_sub_pd(_mm_loadu_pd(s), half);
+  __m128d hi = _mm_sub_pd(_mm_loadu_pd(s + 2), half);
+  // clamp, then zero NaN lanes (max() turns NaN into min)
+  lo = _mm_and_pd(_mm_min_pd(_mm_max_pd(lo, vmin), vmax), _mm_cmpord_pd(lo, lo));
+  hi = _mm_and_pd(_mm_min_pd(_mm_max_pd(hi, vmin), vmax), _mm_cmpord_pd(hi, hi));
+  return _mm_unpacklo_epi64(_mm_cvtpd_epi32(lo), _mm_cvtpd_epi32(hi));
+}
+
+#else
+
+static inline void i2s_vec(sample_t *s, __m128i i)
+{
+  _mm_storeu_ps(s, _mm_add_ps(_mm_cvtepi32_ps(i), _mm_set1_ps(0.5f)));
+}
+
+static inline __m128i s2i_vec(const sample_t *s, sample_t min, sample_t max)
+{
+  __m128 x = _mm_sub_ps(_mm_loadu_ps(s), _mm_set1_ps(0.5f));
+  // clamp, then zero NaN lanes (max() turns NaN into min)
+  x = _mm_and_ps(_mm_min_ps(_mm_max_ps(x, _mm_set1_ps(min)), _mm_set1_ps(max)), _mm_cmpord_ps(x, x));
+  return _mm_cvtps_epi32(x);
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Integer codecs
+// load() and store() convert between PCM values and 4 int32 values.
+
+#define INT_CODEC(target, min, max)                                           \
+  static inline target void decode(const uint8_t *p, sample_t *s)             \
+  { i2s_vec(s, load(p)); }                                                    \
+  static inline target void encode(uint8_t *p, const sample_t *s)             \
+  { store(p, s2i_vec(s, min, max)); }
+
+static inline __m128i swab16_vec(__m128i x)
+{ return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8)); }
+
+struct pcm16_codec
+{
+  enum { size = 2, read = 4 };
+
+  static inline __m128i load(const uint8_t *p)
+  {
+    __m128i x = _mm_loadl_epi64((const __m128i *)p);
+    return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+  }
+  static inline void store(uint8_t *p, __m128i x)
+  { _mm_storel_epi64((__m128i *)p, _mm_packs_epi32(x, x)); }
+
+  static inline sample_t decode1(const uint8_t *p)  { return i2s(le2int16(*(int16_t *)p)); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(int16_t *)p = int2le16(s2i16(s)); }
+  INT_CODEC(, S2I_MIN16, S2I_MAX16)
+};
+
+struct pcm16_be_codec
+{
+  enum { size = 2, read = 4 };
+
+  static inline __m128i load(const uint8_t *p)
+  {
+    __m128i x = swab16_vec(_mm_loadl_epi64((const __m128i *)p));
+    return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+  }
+  static inline void store(uint8_t *p, __m128i x)
+  { _mm_storel_epi64((__m128i *)p, swab16_vec(_mm_packs_epi32(x, x))); }
+
+  static inline sample_t decode1(const uint8_t *p)  { return i2s(be2int16(*(int16_t *)p)); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(int16_t *)p = int2be16(s2i16(s)); }
+  INT_CODEC(, S2I_MIN16, S2I_MAX16)
+};
+
+struct pcm32_codec
+{
+  enum { size = 4, read = 4 };
+
+  static inline __m128i load(const uint8_t *p)    { return _mm_loadu_si128((const __m128i *)p); }
+  static inline void store(uint8_t *p, __m128i x) { _mm_storeu_si128((__m128i *)p, x); }
+
+  static inline sample_t decode1(const uint8_t *p)  { return i2s(le2int32(*(int32_t *)p)); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(int32_t *)p = int2le32(s2i32(s)); }
+  INT_CODEC(, S2I_MIN32, S2I_MAX32)
+};
+
+// Byte shuffles (SSSE3)
+// 24-bit values are placed into the high bytes of int32 and shifted back
+// arithmetically to extend the sign.
+
+struct pcm24_codec
+{
+  enum { size = 3, read = 6 };
+
+  static inline SIMD_TARGET_SSSE3 __m128i load(const uint8_t *p)
+  {
+    const __m128i shuf = _mm_setr_epi8(-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    return _mm_srai_epi32(_mm_shuffle_epi8(x, shuf), 8);
+  }
+  static inline SIMD_TARGET_SSSE3 void store(uint8_t *p, __m128i x)
+  {
+    const __m128i shuf = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    x = _mm_shuffle_epi8(x, shuf);
+    _mm_storel_epi64((__m128i *)p, x);
+    *(int32_t *)(p + 8) = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+  }
+
+  static inline sample_t decode1(const uint8_t *p)  { return i2s(le2int24(*(int24_t *)p)); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(int24_t *)p = int2le24(s2i24(s)); }
+  INT_CODEC(SIMD_TARGET_SSSE3, S2I_MIN24, S2I_MAX24)
+};
+
+struct pcm24_be_codec
+{
+  enum { size = 3, read = 6 };
+
+  static inline SIMD_TARGET_SSSE3 __m128i load(const uint8_t *p)
+  {
+    const __m128i shuf = _mm_setr_epi8(-1, 2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9);
+    __m128i x = _mm_loadu_si128((const __m128i *)p);
+    return _mm_srai_epi32(_mm_shuffle_epi8(x, shuf), 8);
+  }
+  static inline SIMD_TARGET_SSSE3 void store(uint8_t *p, __m128i x)
+  {
+    const __m128i shuf = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    x = _mm_shuffle_epi8(x, shuf);
+    _mm_storel_epi64((__m128i *)p, x);
+    *(int32_t *)(p + 8) = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+  }
+
+  static inline sample_t decode1(const uint8_t *p)  { return i2s(be2int24(*(int24_t *)p)); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(int24_t *)p = int2be24(s2i24(s)); }
+  INT_CODEC(SIMD_TARGET_SSSE3, S2I_MIN24, S2I_MAX24)
+};
+
+struct pcm32_be_codec
+{
+  enum { size = 4, read = 4 };
+
+  static inline SIMD_TARGET_SSSE3 __m128i swab(__m128i x)
+  {
+    const __m128i shuf = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    return _mm_shuffle_epi8(x, shuf);
+  }
+  static inline SIMD_TARGET_SSSE3 __m128i load(const uint8_t *p)
+  { return swab(_mm_loadu_si128((const __m128i *)p)); }
+  static inline SIMD_TARGET_SSSE3 void store(uint8_t *p, __m128i x)
+  { _mm_storeu_si128((__m128i *)p, swab(x)); }
+
+  static inline sample_t decode1(const uint8_t *p)  { return i2s(be2int32(*(int32_t *)p)); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(int32_t *)p = int2be32(s2i32(s)); }
+  INT_CODEC(SIMD_TARGET_SSSE3, S2I_MIN32, S2I_MAX32)
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Floating-point codecs
+
+struct pcmfloat_codec
+{
+  enum { size = 4, read = 4 };
+
+  static inline sample_t decode1(const uint8_t *p)  { return sample_t(*(float *)p); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(float *)p = float(s); }
+
+#ifndef FLOAT_SAMPLE
+  static inline void decode(const uint8_t *p, sample_t *s)
+  {
+    __m128 x = _mm_loadu_ps((const float *)p);
+    _mm_storeu_pd(s,     _mm_cvtps_pd(x));
+    _mm_storeu_pd(s + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+  }
+  static inline void encode(uint8_t *p, const sample_t *s)
+  {
+    __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(s));
+    __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(s + 2));
+    _mm_storeu_ps((float *)p, _mm_movelh_ps(lo, hi));
+  }
+#else
+  static inline void decode(const uint8_t *p, sample_t *s)
+  { _mm_storeu_ps(s, _mm_loadu_ps((const float *)p)); }
+  static inline void encode(uint8_t *p, const sample_t *s)
+  { _mm_storeu_ps((float *)p, _mm_loadu_ps(s)); }
+#endif
+};
+
+struct pcmdouble_codec
+{
+  enum { size = 8, read = 4 };
+
+  static inline sample_t decode1(const uint8_t *p)  { return sample_t(*(double *)p); }
+  static inline void encode1(uint8_t *p, sample_t s) { *(double *)p = double(s); }
+
+#ifndef FLOAT_SAMPLE
+  static inline void decode(const uint8_t *p, sample_t *s)
+  {
+    _mm_storeu_pd(s,     _mm_loadu_pd((const double *)p));
+    _mm_storeu_pd(s + 2, _mm_loadu_pd((const double *)p + 2));
+  }
+  static inline void encode(uint8_t *p, const sample_t *s)
+  {
+    _mm_storeu_pd((double *)p,     _mm_loadu_pd(s));
+    _mm_storeu_pd((double *)p + 2, _mm_loadu_pd(s + 2));
+  }
+#else
+  static inline void decode(const uint8_t *p, sample_t *s)
+  {
+    __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd((const double *)p));
+    __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd((const double *)p + 2));
+    _mm_storeu_ps(s, _mm_movelh_ps(lo, hi));
+  }
+  static inline void encode(uint8_t *p, const sample_t *s)
+  {
+    __m128 x = _mm_loadu_ps(s);
+    _mm_storeu_pd((double *)p,     _mm_cvtps_pd(x));
+    _mm_storeu_pd((double *)p + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+  }
+#endif
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Interleave/deinterleave the buffer
+
+template <int nch>
+static inline void deinterleave(const sample_t *buf, samples_t samples, size_t n)
+{
+  for (size_t s = 0; s < n; s++, buf += nch)
+    for (int ch = 0; ch < nch; ch++)
+      samples[ch][s] = buf[ch];
+}
+
+template <int nch>
+static inline void interleave(samples_t samples, sample_t *buf, size_t n)
+{
+  for (size_t s = 0; s < n; s++, buf += nch)
+    for (int ch = 0; ch < nch; ch++)
+      buf[ch] = samples[ch][s];
+}
+
+template <>
+inline void deinterleave<2>(const sample_t *buf, samples_t samples, size_t n)
+{
+  typedef vec_sse2 V;
+  size_t s = 0;
+  for (; s + V::width <= n; s += V::width)
+  {
+    V::vec l, r;
+    V::load2(buf + 2 * s, l, r);
+    V::store(samples[0] + s, l);
+    V::store(samples[1] + s, r);
+  }
+  for (; s < n; s++)
+  {
+    samples[0][s] = buf[2 * s];
+    samples[1][s] = buf[2 * s + 1];
+  }
+}
+
+template <>
+inline void interleave<2>(samples_t samples, sample_t *buf, size_t n)
+{
+  typedef vec_sse2 V;
+  size_t s = 0;
+  for (; s + V::width <= n; s += V::width)
+    V::store2(buf + 2 * s, V::load(samples[0] + s), V::load(samples[1] + s));
+  for (; s < n; s++)
+  {
+    buf[2 * s]     = samples[0][s];
+    buf[2 * s + 1] = samples[1][s];
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Conversion kernels
+//
+// Defined with a macro because GCC requires the target attribute on each
+// function that inlines SSSE3 intrinsics.
+
+#define DEFINE_CONVERT_KERNELS(suffix, target)                                \
+template <class C, int nch> static target                                     \
+void pcm2linear_##suffix(uint8_t *rawdata, samples_t samples, size_t size)    \
+{                                                                             \
+  sample_t buf[convert_block * nch];                                          \
+  while (size)                                                                \
+  {                                                                           \
+    size_t n = MIN(size, (size_t)convert_block);                              \
+    size_t total = n * nch;                                                   \
+    sample_t *dst = nch == 1? samples[0]: buf;                                \
+                                                                              \
+    size_t i = 0;                                                             \
+    for (; i + C::read <= total; i += 4)                                      \
+      C::decode(rawdata + i * C::size, dst + i);                              \
+    for (; i < total; i++)                                                    \
+      dst[i] = C::decode1(rawdata + i * C::size);                             \
+                                                                              \
+    if (nch > 1)                                                              \
+      deinterleave<nch>(buf, samples, n);                                     \
+                                                                              \
+    rawdata += total * C::size;                                               \
+    samples += n;                                                             \
+    size -= n;                                                                \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+template <class C, int nch> static target                                     \
+void linear2pcm_##suffix(uint8_t *rawdata, samples_t samples, size_t size)    \
+{                                                                             \
+  sample_t buf[convert_block * nch];                                          \
+  while (size)                                                                \
+  {                                                                           \
+    size_t n = MIN(size, (size_t)convert_block);                              \
+    size_t total = n * nch;                                                   \
+    const sample_t *src = nch == 1? samples[0]: buf;                          \
+                                                                              \
+    if (nch > 1)                                                              \
+      interleave<nch>(samples, buf, n);                                       \
+                                                                              \
+    size_t i = 0;                                                             \
+    for (; i + 4 <= total; i += 4)                                            \
+      C::encode(rawdata + i * C::size, src + i);                              \
+    for (; i < total; i++)                                                    \
+      C::encode1(rawdata + i * C::size, src[i]);                              \
+                                                                              \
+    rawdata += total * C::size;                                               \
+    samples += n;                                                             \
+    size -= n;                                                                \
+  }                                                                           \
+}
+
+DEFINE_CONVERT_KERNELS(sse2, )
+DEFINE_CONVERT_KERNELS(ssse3, SIMD_TARGET_SSSE3)
+
+///////////////////////////////////////////////////////////////////////////////
+// Kernel tables
+// Formats are in the same order as in linear2pcm_formats[]
+
+#define CONVERT_ROW(kernel, nch) {                                            \
+  &kernel##_sse2 <pcm16_codec, nch>,    &kernel##_ssse3<pcm24_codec, nch>,    \
+  &kernel##_sse2 <pcm32_codec, nch>,    &kernel##_sse2 <pcm16_be_codec, nch>, \
+  &kernel##_ssse3<pcm24_be_codec, nch>, &kernel##_ssse3<pcm32_be_codec, nch>, \
+  &kernel##_sse2 <pcmfloat_codec, nch>, &kernel##_sse2 <pcmdouble_codec, nch> }
+
+static const int simd_convert_formats[] = { FORMAT_PCM16, FORMAT_PCM24, FORMAT_PCM32, FORMAT_PCM16_BE, FORMAT_PCM24_BE, FORMAT_PCM32_BE, FORMAT_PCMFLOAT, FORMAT_PCMDOUBLE };
+static const int simd_convert_caps[] = { SIMD_SSE2, SIMD_SSSE3, SIMD_SSE2, SIMD_SSE2, SIMD_SSSE3, SIMD_SSSE3, SIMD_SSE2, SIMD_SSE2 };
+
+static const convert_t pcm2linear_simd_tbl[NCHANNELS][8] = {
+  CONVERT_ROW(pcm2linear, 1), CONVERT_ROW(pcm2linear, 2), CONVERT_ROW(pcm2linear, 3),
+  CONVERT_ROW(pcm2linear, 4), CONVERT_ROW(pcm2linear, 5), CONVERT_ROW(pcm2linear, 6)
+};
+
+static const convert_t linear2pcm_simd_tbl[NCHANNELS][8] = {
+  CONVERT_ROW(linear2pcm, 1), CONVERT_ROW(linear2pcm, 2), CONVERT_ROW(linear2pcm, 3),
+  CONVERT_ROW(linear2pcm, 4), CONVERT_ROW(linear2pcm, 5), CONVERT_ROW(linear2pcm, 6)
+};
+
+static convert_t find_simd(const convert_t tbl[NCHANNELS][8], int pcm_format, int nch)
+{
+  for (size_t i = 0; i < array_size(simd_convert_formats); i++)
+    if (pcm_format == simd_convert_formats[i])
+      return simd_has(simd_convert_caps[i])? tbl[nch-1][i]: 0;
+  return 0;
+}
+
+static convert_t find_pcm2linear_simd(int pcm_format, int nch)
+{ return find_simd(pcm2linear_simd_tbl, pcm_format, nch); }
+
+static convert_t find_linear2pcm_simd(int pcm_format, int nch)
+{ return find_simd(linear2pcm_simd_tbl, pcm_format, nch); }
+
+#else
+
+static convert_t find_pcm2linear_simd(int, int) { return 0; }
+static convert_t find_linear2pcm_simd(int, int) { return 0; }
+
+#endif
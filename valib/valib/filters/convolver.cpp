@@ -7,6 +7,7 @@
 
 static const int min_fft_size = 16;
 static const int min_chunk_size = 1024;
+static const int max_block_size = 1024;
 
 inline unsigned int clp2(unsigned int x)
 {
@@ -23,7 +24,7 @@ inline unsigned int clp2(unsigned int x)
 
 Convolver::Convolver(const FIRGen *gen_):
   gen(gen_), fir(0),
-  buf_size(0), n(0), c(0),
+  buf_size(0), c(0),
   pos(0), pre_samples(0), post_samples(0),
   state(state_pass)
 {
@@ -44,45 +45,25 @@ Convolver::fir_changed() const
 void
 Convolver::convolve()
 {
-  int i;
-  int ch, nch = get_in_spk().nch();
-  sample_t *buf_ch, *delay_ch;
-
-  for (ch = 0; ch < nch; ch++)
-    for (int fft_pos = 0; fft_pos < buf_size; fft_pos += n)
-    {
-      buf_ch = buf[ch] + fft_pos;
-      delay_ch = buf[ch] + buf_size;
-
-      memcpy(fft_buf, buf_ch, n * sizeof(sample_t));
-      memset(fft_buf + n, 0, n * sizeof(sample_t));
-
-      fft.rdft(fft_buf);
-
-      fft_buf[0] = filter[0] * fft_buf[0];
-      fft_buf[1] = filter[1] * fft_buf[1]; 
-
-      for (i = 1; i < n; i++)
-      {
-        sample_t re,im;
-        re = filter[i*2  ] * fft_buf[i*2] - filter[i*2+1] * fft_buf[i*2+1];
-        im = filter[i*2+1] * fft_buf[i*2] + filter[i*2  ] * fft_buf[i*2+1];
-        fft_buf[i*2  ] = re;
-        fft_buf[i*2+1] = im;
-      }
-
-      fft.inv_rdft(fft_buf);
+  int nch = get_in_spk().nch();
+  int block_size = conv.get_block_size();
 
-      for (i = 0; i < n; i++)
-        buf_ch[i] = fft_buf[i] + delay_ch[i];
+  // All channels share the filter
+  int chs[NCHANNELS];
+  sample_t *blocks[NCHANNELS];
+  for (int ch = 0; ch < nch; ch++)
+    chs[ch] = ch;
 
-      memcpy(delay_ch, fft_buf + n, n * sizeof(sample_t));
-    }
+  for (int block_pos = 0; block_pos < buf_size; block_pos += block_size)
+  {
+    for (int ch = 0; ch < nch; ch++)
+      blocks[ch] = buf[ch] + block_pos;
+    conv.process(0, chs, nch, blocks);
+  }
 }
 
 bool Convolver::init(Speakers in_spk_, Speakers &out_spk_)
 {
-  int i;
   int nch = in_spk_.nch();
   out_spk_ = in_spk_;
 
@@ -104,34 +85,32 @@ bool Convolver::init(Speakers in_spk_, Speakers &out_spk_)
   }
 
   /////////////////////////////////////////////////////////
-  // Decide filter length
+  // Decide block size
+  // Long filters are split into partitions of max_block_size.
 
   if (fir->length <= 0 || fir->center < 0)
     return false;
 
-  n = clp2(fir->length);
+  int block_size = clp2(fir->length);
   c = fir->center;
 
-  if (n < min_fft_size / 2)
-    n = min_fft_size / 2;
+  if (block_size < min_fft_size / 2)
+    block_size = min_fft_size / 2;
+  if (block_size > max_block_size)
+    block_size = max_block_size;
 
-  buf_size = n;
+  buf_size = block_size;
   if (buf_size < min_chunk_size)
     buf_size = clp2(min_chunk_size);
 
   /////////////////////////////////////////////////////////
   // Allocate buffers
 
-  fft.set_length(n * 2);
-  filter.allocate(n * 2);
-  buf.allocate(nch, buf_size + n);
-  fft_buf.allocate(n * 2);
+  buf.allocate(nch, buf_size);
 
   // handle buffer allocation error
-  if (!filter.is_allocated() ||
-      !buf.is_allocated() ||
-      !fft_buf.is_allocated() ||
-      !fft.is_ok())
+  if (!buf.is_allocated() ||
+      !conv.init(1, nch, block_size, fir->length))
   {
     uninit();
     return false;
@@ -140,13 +119,7 @@ bool Convolver::init(Speakers in_spk_, Speakers &out_spk_)
   /////////////////////////////////////////////////////////
   // Build the filter
 
-  for (i = 0; i < fir->length; i++)
-    filter[i] = fir->data[i] / n;
-
-  for (i = i; i < 2 * n; i++)
-    filter[i] = 0;
-
-  fft.rdft(filter);
+  conv.set_filter(0, fir->data, fir->length, 0);
 
   state = state_filter;
 
@@ -155,7 +128,7 @@ bool Convolver::init(Speakers in_spk_, Speakers &out_spk_)
 
   pos = 0;
   pre_samples = c;
-  post_samples = fir->length - c;
+  post_samples = c;
   buf.zero();
 
   return true;
@@ -165,13 +138,13 @@ void
 Convolver::uninit()
 {
   buf_size = 0;
-  n = 0;
   c = 0;
   pos = 0;
   pre_samples = 0;
   post_samples = 0;
   state = state_pass;
 
+  conv.uninit();
   safe_delete(fir);
 }
 
@@ -182,8 +155,9 @@ Convolver::reset_state()
   {
     pos = 0;
     pre_samples = c;
-    post_samples = n - c;
+    post_samples = c;
     buf.zero();
+    conv.reset();
   }
 }
 
@@ -244,38 +218,39 @@ Convolver::process_samples(samples_t in, size_t in_size, samples_t &out, size_t
   pos = 0;
   convolve();
 
+  // Drop the delay of the filter (may be longer than the buffer)
+  size_t drop = MIN(size_t(pre_samples), size_t(buf_size));
   out = buf;
-  out_size = buf_size;
-  if (pre_samples)
-  {
-    out += pre_samples;
-    out_size -= pre_samples;
-    pre_samples = 0;
-  }
-
+  out += drop;
+  out_size = buf_size - drop;
+  pre_samples -= (int)drop;
   return true;
 }
 
 bool
 Convolver::flush(samples_t &out, size_t &out_size)
 {
-  if (!need_flushing())
-    return true;
+  // Output pos buffered samples and c samples of the tail. Tail may be
+  // longer than the buffer, so several blocks may be required, and a block
+  // may be dropped completely when the input is shorter than the delay.
 
-  for (int ch = 0; ch < get_in_spk().nch(); ch++)
-    memset(buf[ch] + pos, 0, (buf_size - pos) * sizeof(sample_t));
+  out_size = 0;
+  while (out_size == 0 && need_flushing())
+  {
+    for (int ch = 0; ch < get_in_spk().nch(); ch++)
+      memset(buf[ch] + pos, 0, (buf_size - pos) * sizeof(sample_t));
 
-  convolve();
-  out = buf;
-  out_size = pos + c;
-  post_samples = 0;
-  pos = 0;
+    convolve();
 
-  if (pre_samples)
-  {
-    out += pre_samples;
-    out_size -= pre_samples;
-    pre_samples = 0;
+    int n = MIN(buf_size, pos + post_samples);
+    post_samples -= n - pos;
+    pos = 0;
+
+    int drop = MIN(pre_samples, n);
+    out = buf;
+    out += drop;
+    out_size = n - drop;
+    pre_samples -= drop;
   }
   return true;
 }
@@ -283,5 +258,5 @@ Convolver::flush(samples_t &out, size_t &out_size)
 bool
 Convolver::need_flushing() const
 {
-  return state == state_filter && post_samples > 0;
+  return state == state_filter && pos + post_samples > pre_samples;
 }
@@ -6,12 +6,15 @@
 #include "../fir.h"
 #include "../sync.h"
 #include "../buffer.h"
-#include "../dsp/fft.h"
+#include "../dsp/part_conv.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // Convolver class
 // Use impulse response to implement FIR filtering.
+//
+// Uses uniformly partitioned convolution, so latency and the size of the
+// processing block do not depend on the length of the impulse response.
 ///////////////////////////////////////////////////////////////////////////////
 
 class Convolver : public LinearFilter
@@ -23,13 +26,11 @@ protected:
   SyncHelper sync_helper;
 
   int buf_size;
-  int n, c;
+  int c;
   int pos;
 
-  MM_FFT       fft;
-  Samples   filter;
+  PartConv  conv;
   SampleBuf buf;
-  Samples   fft_buf;
 
   int pre_samples;
   int post_samples;
@@ -7,6 +7,14 @@
 
 static const int min_fft_size = 16;
 static const int min_chunk_size = 1024;
+static const int max_block_size = 1024;
+
+static bool equal_fir(const FIRInstance *fir1, const FIRInstance *fir2)
+{
+  return fir1->length == fir2->length &&
+         fir1->center == fir2->center &&
+         memcmp(fir1->data, fir2->data, fir1->length * sizeof(fir1->data[0])) == 0;
+}
 
 inline unsigned int clp2(unsigned int x)
 {
@@ -22,8 +30,8 @@ inline unsigned int clp2(unsigned int x)
 
 
 ConvolverMch::ConvolverMch():
-  buf_size(0), n(0), c(0),
-  pos(0), pre_samples(0), post_samples(0)
+  ngroups(0), buf_size(0), c(0),
+  pos(0), delay_pos(0), pre_samples(0), post_samples(0)
 {
   for (int ch_name = 0; ch_name < NCHANNELS; ch_name++)
     ver[ch_name] = gen[ch_name].version();
@@ -118,51 +126,53 @@ ConvolverMch::process_trivial(samples_t samples, size_t size)
 }
 
 void
-ConvolverMch::process_convolve()
+ConvolverMch::process_delay()
 {
-  int ch, i;
-  int nch = get_in_spk().nch();
-  sample_t *buf_ch, *filter_ch, *delay_ch;
+  // Delay line swaps samples of the block with delayed ones
+  if (c == 0)
+    return;
 
-  for (ch = 0; ch < nch; ch++)
-    if (type[ch] == type_conv)
-      for (int fft_pos = 0; fft_pos < buf_size; fft_pos += n)
+  int ch, p;
+  for (ch = 0; ch < get_in_spk().nch(); ch++)
+    if (type[ch] != type_conv)
+    {
+      sample_t *s = buf[ch];
+      sample_t *d = delay[ch];
+      p = delay_pos;
+      for (int i = 0; i < buf_size; i++)
       {
-        buf_ch = buf[ch] + fft_pos;
-        delay_ch = buf[ch] + buf_size;
-        filter_ch = filter[ch];
-
-        memcpy(fft_buf, buf_ch, n * sizeof(sample_t));
-        memset(fft_buf + n, 0, n * sizeof(sample_t));
-
-        fft.rdft(fft_buf);
-
-        fft_buf[0] = filter_ch[0] * fft_buf[0];
-        fft_buf[1] = filter_ch[1] * fft_buf[1]; 
-
-        for (i = 1; i < n; i++)
-        {
-          sample_t re,im;
-          re = filter_ch[i*2  ] * fft_buf[i*2] - filter_ch[i*2+1] * fft_buf[i*2+1];
-          im = filter_ch[i*2+1] * fft_buf[i*2] + filter_ch[i*2  ] * fft_buf[i*2+1];
-          fft_buf[i*2  ] = re;
-          fft_buf[i*2+1] = im;
-        }
+        sample_t t = d[p];
+        d[p] = s[i];
+        s[i] = t;
+        if (++p >= c)
+          p = 0;
+      }
+    }
 
-        fft.inv_rdft(fft_buf);
+  delay_pos = (delay_pos + buf_size) % c;
+}
 
-        for (i = 0; i < n; i++)
-          buf_ch[i] = fft_buf[i] + delay_ch[i];
+void
+ConvolverMch::process_convolve()
+{
+  int block_size = conv.get_block_size();
+  sample_t *blocks[NCHANNELS];
 
-        memcpy(delay_ch, fft_buf + n, n * sizeof(sample_t));
-      }
+  for (int g = 0; g < ngroups; g++)
+    for (int block_pos = 0; block_pos < buf_size; block_pos += block_size)
+    {
+      for (int i = 0; i < group_size[g]; i++)
+        blocks[i] = buf[group_ch[g][i]] + block_pos;
+      conv.process(g, group_ch[g], group_size[g], blocks);
+    }
 }
 
 bool ConvolverMch::init(Speakers new_in_spk, Speakers &new_out_spk)
 {
-  int i, ch, ch_name;
+  int ch, ch_name;
   int nch = new_in_spk.nch();
 
+  uninit();
   trivial = true;
   int min_point = 0;
   int max_point = 0;
@@ -212,28 +222,50 @@ bool ConvolverMch::init(Speakers new_in_spk, Speakers &new_out_spk)
     return true;
 
   /////////////////////////////////////////////////////////
-  // Allocate buffers
+  // Group channels with identical responses
+
+  for (ch = 0; ch < nch; ch++)
+    if (type[ch] == type_conv)
+    {
+      int g = 0;
+      while (g < ngroups && !equal_fir(fir[group_ch[g][0]], fir[ch]))
+        g++;
+
+      if (g == ngroups)
+      {
+        group_size[g] = 0;
+        ngroups++;
+      }
+      group_ch[g][group_size[g]++] = ch;
+    }
 
-  n = clp2(max_point - min_point);
+  /////////////////////////////////////////////////////////
+  // Decide block size
+  // Long filters are split into partitions of max_block_size.
+
+  int length = max_point - min_point;
+  int block_size = clp2(length);
   c = -min_point;
 
-  if (n < min_fft_size / 2)
-    n = min_fft_size / 2;
+  if (block_size < min_fft_size / 2)
+    block_size = min_fft_size / 2;
+  if (block_size > max_block_size)
+    block_size = max_block_size;
 
-  buf_size = n;
+  buf_size = block_size;
   if (buf_size < min_chunk_size)
     buf_size = clp2(min_chunk_size);
 
-  fft.set_length(n * 2);
-  filter.allocate(nch, n * 2);
-  buf.allocate(nch, buf_size + n);
-  fft_buf.allocate(n * 2);
+  /////////////////////////////////////////////////////////
+  // Allocate buffers
+
+  buf.allocate(nch, buf_size);
+  delay.allocate(nch, MAX(c, 1));
 
   // handle buffer allocation error
-  if (!filter.is_allocated() ||
-      !buf.is_allocated() ||
-      !fft_buf.is_allocated() ||
-      !fft.is_ok())
+  if (!buf.is_allocated() ||
+      !delay.is_allocated() ||
+      !conv.init(ngroups, nch, block_size, length))
   {
     uninit();
     return false;
@@ -242,22 +274,21 @@ bool ConvolverMch::init(Speakers new_in_spk, Speakers &new_out_spk)
   /////////////////////////////////////////////////////////
   // Build filters
 
-  filter.zero();
-  for (ch = 0; ch < nch; ch++)
-    if (type[ch] == type_conv)
-    {
-      for (i = 0; i < fir[ch]->length; i++)
-        filter[ch][i + c - fir[ch]->center] = fir[ch]->data[i] / n;
-      fft.rdft(filter[ch]);
-    }
+  for (int g = 0; g < ngroups; g++)
+  {
+    const FIRInstance *f = fir[group_ch[g][0]];
+    conv.set_filter(g, f->data, f->length, c - f->center);
+  }
 
   /////////////////////////////////////////////////////////
   // Initial state
 
   pos = 0;
+  delay_pos = 0;
   pre_samples = c;
-  post_samples = n - c;
+  post_samples = c;
   buf.zero();
+  delay.zero();
   return true;
 }
 
@@ -265,12 +296,14 @@ void
 ConvolverMch::uninit()
 {
   buf_size = 0;
-  n = 0;
   c = 0;
   pos = 0;
+  delay_pos = 0;
+  ngroups = 0;
+  conv.uninit();
 
   trivial = true;
-  for (int ch = 0; ch < get_in_spk().nch(); ch++)
+  for (int ch = 0; ch < NCHANNELS; ch++)
   {
     safe_delete(fir[ch]);
     type[ch] = type_pass;
@@ -284,9 +317,12 @@ void
 ConvolverMch::reset_state()
 {
   pos = 0;
+  delay_pos = 0;
   pre_samples = c;
-  post_samples = n - c;
+  post_samples = c;
   buf.zero();
+  delay.zero();
+  conv.reset();
 }
 
 bool
@@ -317,23 +353,11 @@ ConvolverMch::process_samples(samples_t in, size_t in_size, samples_t &out, size
   /////////////////////////////////////////////////////////
   // Convolution
 
-  // Trivial cases:
-  // Copy delayed samples to the start of the buffer
-  if (pos == 0)
-    for (ch = 0; ch < nch; ch++)
-      if (type[ch] != type_conv)
-        memcpy(buf[ch], buf[ch] + buf_size, c * sizeof(sample_t));
-
-  // Accumulate the buffer
   if (pos < buf_size)
   {
     gone = MIN(in_size, size_t(buf_size - pos));
     for (ch = 0; ch < nch; ch++)
-      if (type[ch] == type_conv)
-        memcpy(buf[ch] + pos, in[ch], gone * sizeof(sample_t));
-      else
-        // Trivial cases are shifted
-        memcpy(buf[ch] + c + pos, in[ch], gone * sizeof(sample_t));
+      memcpy(buf[ch] + pos, in[ch], gone * sizeof(sample_t));
     pos += (int)gone;
 
     if (pos < buf_size)
@@ -342,49 +366,43 @@ ConvolverMch::process_samples(samples_t in, size_t in_size, samples_t &out, size
 
   pos = 0;
   process_trivial(buf, buf_size);
+  process_delay();
   process_convolve();
 
+  // Drop the delay of the filter (may be longer than the buffer)
+  size_t drop = MIN(size_t(pre_samples), size_t(buf_size));
   out = buf;
-  out_size = buf_size;
-  if (pre_samples)
-  {
-    out += pre_samples;
-    out_size -= pre_samples;
-    pre_samples = 0;
-  }
-
+  out += drop;
+  out_size = buf_size - drop;
+  pre_samples -= (int)drop;
   return true;
 }
 
 bool
 ConvolverMch::flush(samples_t &out, size_t &out_size)
 {
-  int ch, nch = get_in_spk().nch();
-  if (!need_flushing())
-    return true;
+  // Output pos buffered samples and c samples of the tail (see
+  // Convolver::flush())
 
-  if (pos == 0)
-    for (ch = 0; ch < nch; ch++)
-      if (type[ch] != type_conv)
-        memcpy(buf[ch], buf[ch] + buf_size, c * sizeof(sample_t));
-
-  for (ch = 0; ch < nch; ch++)
-    if (type[ch] == type_conv)
+  out_size = 0;
+  while (out_size == 0 && need_flushing())
+  {
+    for (int ch = 0; ch < get_in_spk().nch(); ch++)
       memset(buf[ch] + pos, 0, (buf_size - pos) * sizeof(sample_t));
 
-  process_trivial(buf, buf_size);
-  process_convolve();
+    process_trivial(buf, buf_size);
+    process_delay();
+    process_convolve();
 
-  out = buf;
-  out_size = pos + c;
-  post_samples = 0;
-  pos = 0;
+    int n = MIN(buf_size, pos + post_samples);
+    post_samples -= n - pos;
+    pos = 0;
 
-  if (pre_samples)
-  {
-    out += pre_samples;
-    out_size -= pre_samples;
-    pre_samples = 0;
+    int drop = MIN(pre_samples, n);
+    out = buf;
+    out += drop;
+    out_size = n - drop;
+    pre_samples -= drop;
   }
   return true;
 }
@@ -392,5 +410,5 @@ ConvolverMch::flush(samples_t &out, size_t &out_size)
 bool
 ConvolverMch::need_flushing() const
 {
-  return !trivial && post_samples > 0;
+  return !trivial && pos + post_samples > pre_samples;
 }
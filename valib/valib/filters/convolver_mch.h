@@ -6,12 +6,17 @@
 #include "../fir.h"
 #include "../sync.h"
 #include "../buffer.h"
-#include "../dsp/fft.h"
+#include "../dsp/part_conv.h"
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // Multichannel convolver class
 // Use impulse response to implement FIR filtering.
+//
+// Uses uniformly partitioned convolution (see Convolver). Channels with
+// trivial responses are delayed to stay aligned with convolved channels.
+// Channels with identical responses (for example, master-only equalizer)
+// share one filter spectrum and are convolved together.
 ///////////////////////////////////////////////////////////////////////////////
 
 class ConvolverMch : public LinearFilter
@@ -24,14 +29,18 @@ protected:
   const FIRInstance *fir[NCHANNELS];
   enum { type_pass, type_gain, type_zero, type_conv } type[NCHANNELS];
 
+  int ngroups;                       // number of distinct responses
+  int group_size[NCHANNELS];         // number of channels in the group
+  int group_ch[NCHANNELS][NCHANNELS]; // channels of the group
+
   int buf_size;
-  int n, c;
+  int c;
   int pos;
 
-  MM_FFT       fft;
-  SampleBuf filter;
+  PartConv  conv;
   SampleBuf buf;
-  Samples   fft_buf;
+  SampleBuf delay;
+  int delay_pos;
 
   int pre_samples;
   int post_samples;
@@ -40,6 +49,7 @@ protected:
   void uninit();
 
   void process_trivial(samples_t samples, size_t size);
+  void process_delay();
   void process_convolve();
 
 public:
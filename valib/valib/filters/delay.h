@@ -61,6 +61,8 @@ public:
 
   void get_delays(float delays[NCHANNELS]) const;
   void set_delays(const float delays[NCHANNELS]);
+
+  virtual bool is_inplace() const { return true; }
 };
 
 
@@ -22,6 +22,8 @@ public:
   double level;
   Dither(double level_ = 0.0): NullFilter(FORMAT_MASK_LINEAR), level(level_) {};
 
+  virtual bool is_inplace() const { return true; }
+
 protected:
   RNG rng;
 
@@ -0,0 +1,442 @@
+#include <math.h>
+#include <string.h>
+#include "dynamics.h"
+#include "../dsp/block_stat.h"
+#include "../simd_vec.h"
+
+static const size_t sub_size = 16;   // envelope follower step
+static const size_t max_block = 1024; // band split block
+
+///////////////////////////////////////////////////////////////////////////////
+// Crossover filters
+///////////////////////////////////////////////////////////////////////////////
+
+static bool passthrough(double sample_rate, double freq)
+{
+  return sample_rate < 10 || freq < 10 || freq >= sample_rate / 2;
+}
+
+void
+CrossoverLPF::update()
+{
+  if (passthrough(sample_rate, freq))
+  {
+    // setup as passthrough on incorrect parameters
+    a = 1.0; a1 = 0; a2 = 0; b1 = 0; b2 = 0;
+    return;
+  }
+
+  // Q = 1/sqrt(2): alfa = sin(omega) / (2 * Q)
+  double omega = 2.0 * M_PI * freq / sample_rate;
+  double c = cos(omega);
+  double alfa = sin(omega) / sqrt(2.0);
+
+  a  = gain * (1.0 - c) / 2.0 / (1.0 + alfa);
+  a1 = gain * (1.0 - c) / (1.0 + alfa);
+  a2 = gain * (1.0 - c) / 2.0 / (1.0 + alfa);
+  b1 = -(2.0 * c) / (1.0 + alfa);
+  b2 = (1.0 - alfa) / (1.0 + alfa);
+}
+
+void
+CrossoverHPF::update()
+{
+  if (passthrough(sample_rate, freq))
+  {
+    // zero high band when the crossover is out of range
+    a = 0; a1 = 0; a2 = 0; b1 = 0; b2 = 0;
+    return;
+  }
+
+  double omega = 2.0 * M_PI * freq / sample_rate;
+  double c = cos(omega);
+  double alfa = sin(omega) / sqrt(2.0);
+
+  a  = gain * (1.0 + c) / 2.0 / (1.0 + alfa);
+  a1 = gain * -(1.0 + c) / (1.0 + alfa);
+  a2 = gain * (1.0 + c) / 2.0 / (1.0 + alfa);
+  b1 = -(2.0 * c) / (1.0 + alfa);
+  b2 = (1.0 - alfa) / (1.0 + alfa);
+}
+
+void
+CrossoverAPF::update()
+{
+  if (passthrough(sample_rate, freq))
+  {
+    a = 1.0; a1 = 0; a2 = 0; b1 = 0; b2 = 0;
+    return;
+  }
+
+  double omega = 2.0 * M_PI * freq / sample_rate;
+  double c = cos(omega);
+  double alfa = sin(omega) / sqrt(2.0);
+
+  a  = gain * (1.0 - alfa) / (1.0 + alfa);
+  a1 = gain * -(2.0 * c) / (1.0 + alfa);
+  a2 = gain;
+  b1 = -(2.0 * c) / (1.0 + alfa);
+  b2 = (1.0 - alfa) / (1.0 + alfa);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Gain ramp kernels
+// y = x * (g + i * step), or y += x * (g + i * step) when add is true.
+
+typedef void (*gain_ramp_t)(sample_t *y, const sample_t *x, size_t n, sample_t g, sample_t step, bool add);
+
+static const sample_t lane[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+#define DEFINE_GAIN_RAMP(name, V, target)                                     \
+static target                                                                 \
+void name(sample_t *y, const sample_t *x, size_t n, sample_t g, sample_t step, bool add) \
+{                                                                             \
+  size_t i = 0;                                                               \
+  V::vec vg = V::add(V::set1(g), V::mul(V::set1(step), V::load(lane)));       \
+  V::vec vstep = V::set1(step * V::width);                                    \
+  if (add)                                                                    \
+    for (; i + V::width <= n; i += V::width)                                  \
+    {                                                                         \
+      V::store(y + i, V::add(V::load(y + i), V::mul(V::load(x + i), vg)));    \
+      vg = V::add(vg, vstep);                                                 \
+    }                                                                         \
+  else                                                                        \
+    for (; i + V::width <= n; i += V::width)                                  \
+    {                                                                         \
+      V::store(y + i, V::mul(V::load(x + i), vg));                            \
+      vg = V::add(vg, vstep);                                                 \
+    }                                                                         \
+                                                                              \
+  for (; i < n; i++)                                                          \
+    if (add)                                                                  \
+      y[i] += x[i] * (g + i * step);                                          \
+    else                                                                      \
+      y[i] = x[i] * (g + i * step);                                           \
+}
+
+DEFINE_GAIN_RAMP(gain_ramp_scalar, vec_scalar, )
+
+#ifdef VALIB_SIMD_X86
+DEFINE_GAIN_RAMP(gain_ramp_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_GAIN_RAMP(gain_ramp_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+#endif
+
+static gain_ramp_t find_gain_ramp()
+{
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return gain_ramp_avx;
+#endif
+  if (caps & SIMD_SSE2)
+    return gain_ramp_sse2;
+#endif
+  return gain_ramp_scalar;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Dynamics
+///////////////////////////////////////////////////////////////////////////////
+
+Dynamics::Dynamics()
+:NullFilter(FORMAT_MASK_LINEAR)
+{
+  enabled   = false;
+  multiband = false;
+  rms       = true;
+  freq[0]   = 250;   // Hz
+  freq[1]   = 4000;  // Hz
+  attack    = 10;    // ms
+  release   = 200;   // ms
+  sample_rate = 0;
+
+  for (int b = 0; b < nbands; b++)
+  {
+    band[b].threshold = -20; // dB
+    band[b].ratio     = 3;
+    band[b].gain      = 0;   // dB
+  }
+
+  for (int i = 0; i < nbands; i++)
+    band_buf[i].allocate(NCHANNELS, max_block);
+
+  update();
+  on_reset();
+}
+
+void
+Dynamics::update()
+{
+  for (int b = 0; b < nbands; b++)
+  {
+    threshold_lin[b] = db2value(band[b].threshold);
+    power[b]  = 1.0 / band[b].ratio - 1.0;
+    makeup[b] = db2value(band[b].gain);
+  }
+
+  if (sample_rate > 0)
+  {
+    attack_coef  = attack  > 0? exp(-(double)sub_size / (attack  * 1e-3 * sample_rate)): 0;
+    release_coef = release > 0? exp(-(double)sub_size / (release * 1e-3 * sample_rate)): 0;
+  }
+  else
+  {
+    attack_coef = 0;
+    release_coef = 0;
+  }
+
+  for (int ch = 0; ch < NCHANNELS; ch++)
+  {
+    for (int x = 0; x < 2; x++)
+      for (int i = 0; i < 2; i++)
+      {
+        lpf[ch][x][i].sample_rate = sample_rate;
+        lpf[ch][x][i].freq = freq[x];
+        lpf[ch][x][i].update();
+        hpf[ch][x][i].sample_rate = sample_rate;
+        hpf[ch][x][i].freq = freq[x];
+        hpf[ch][x][i].update();
+      }
+    apf[ch].sample_rate = sample_rate;
+    apf[ch].freq = freq[1];
+    apf[ch].update();
+  }
+}
+
+void
+Dynamics::set_enabled(bool _enabled)
+{
+  if (_enabled && !enabled)
+    on_reset();
+  enabled = _enabled;
+}
+
+void
+Dynamics::set_multiband(bool _multiband)
+{
+  if (_multiband != multiband)
+    on_reset();
+  multiband = _multiband;
+}
+
+void
+Dynamics::get_crossover(double &_low, double &_high) const
+{
+  _low = freq[0];
+  _high = freq[1];
+}
+
+void
+Dynamics::set_crossover(double _low, double _high)
+{
+  freq[0] = _low;
+  freq[1] = _high > _low? _high: _low;
+  update();
+}
+
+void
+Dynamics::get_band(int _band, DynamicsBand &_params) const
+{
+  if (_band >= 0 && _band < nbands)
+    _params = band[_band];
+}
+
+void
+Dynamics::set_band(int _band, const DynamicsBand &_params)
+{
+  if (_band < 0 || _band >= nbands)
+    return;
+
+  band[_band] = _params;
+  if (band[_band].ratio < 1.0)
+    band[_band].ratio = 1.0;
+  update();
+}
+
+void
+Dynamics::set_attack(double _attack)
+{
+  attack = _attack > 0? _attack: 0;
+  update();
+}
+
+void
+Dynamics::set_release(double _release)
+{
+  release = _release > 0? _release: 0;
+  update();
+}
+
+sample_t
+Dynamics::get_gain(int _band, int _ch) const
+{
+  if (_band < 0 || _band >= nbands || _ch < 0 || _ch >= NCHANNELS)
+    return 1.0;
+  return target[_band][_ch];
+}
+
+///////////////////////////////////////////////////////////
+// Processing
+
+void
+Dynamics::split(samples_t _samples, size_t n)
+{
+  // low  = LR4 low-pass (freq[0]) + allpass (freq[1])
+  // mid  = LR4 high-pass (freq[0]) + LR4 low-pass (freq[1])
+  // high = LR4 high-pass (freq[0]) + LR4 high-pass (freq[1])
+
+  for (int ch = 0; ch < spk.nch(); ch++)
+  {
+    sample_t *low = band_buf[0][ch];
+    sample_t *mid = band_buf[1][ch];
+    sample_t *high = band_buf[2][ch];
+
+    memcpy(low, _samples[ch], n * sizeof(sample_t));
+    memcpy(high, _samples[ch], n * sizeof(sample_t));
+    lpf[ch][0][0].process(low, n);
+    lpf[ch][0][1].process(low, n);
+    apf[ch].process(low, n);
+
+    hpf[ch][0][0].process(high, n);
+    hpf[ch][0][1].process(high, n);
+    memcpy(mid, high, n * sizeof(sample_t));
+    lpf[ch][1][0].process(mid, n);
+    lpf[ch][1][1].process(mid, n);
+    hpf[ch][1][0].process(high, n);
+    hpf[ch][1][1].process(high, n);
+  }
+}
+
+void
+Dynamics::follow(int nb)
+{
+  // End of the sub-block: update envelopes and find gains for the next one
+  for (int b = 0; b < nb; b++)
+    for (int ch = 0; ch < spk.nch(); ch++)
+    {
+      sample_t level = rms? sqrt(sub_sum2[b][ch] / sub_size): sub_peak[b][ch];
+      double coef = level > env[b][ch]? attack_coef: release_coef;
+      env[b][ch] = level + (env[b][ch] - level) * coef;
+
+      sample_t g = makeup[b];
+      if (env[b][ch] > threshold_lin[b])
+        g *= pow(env[b][ch] / threshold_lin[b], power[b]);
+
+      gain[b][ch] = target[b][ch];
+      target[b][ch] = g;
+      sub_peak[b][ch] = 0;
+      sub_sum2[b][ch] = 0;
+    }
+}
+
+void
+Dynamics::on_reset()
+{
+  for (int ch = 0; ch < NCHANNELS; ch++)
+  {
+    for (int x = 0; x < 2; x++)
+      for (int i = 0; i < 2; i++)
+      {
+        lpf[ch][x][i].reset();
+        hpf[ch][x][i].reset();
+      }
+    apf[ch].reset();
+  }
+
+  sub_pos = 0;
+  for (int b = 0; b < nbands; b++)
+    for (int ch = 0; ch < NCHANNELS; ch++)
+    {
+      sub_peak[b][ch] = 0;
+      sub_sum2[b][ch] = 0;
+      env[b][ch] = 0;
+      gain[b][ch] = makeup[b];
+      target[b][ch] = makeup[b];
+    }
+}
+
+bool
+Dynamics::on_set_input(Speakers _spk)
+{
+  sample_rate = _spk.sample_rate;
+  update();
+  on_reset();
+  return true;
+}
+
+bool
+Dynamics::on_process()
+{
+  if (!enabled)
+    return true;
+
+  int b, ch;
+  int nch = spk.nch();
+  int nb = multiband? nbands: 1;
+
+  block_stat_mch_t block_stat = find_block_stat_mch();
+  gain_ramp_t gain_ramp = find_gain_ramp();
+
+  sample_t peak[NCHANNELS];
+  sample_t sum2[NCHANNELS];
+  samples_t bands[nbands];
+
+  size_t pos = 0;
+  while (pos < size)
+  {
+    size_t n = MIN(size - pos, max_block);
+    samples_t out = samples;
+    out += pos;
+
+    if (multiband)
+    {
+      split(out, n);
+      for (b = 0; b < nbands; b++)
+        bands[b] = band_buf[b];
+    }
+    else
+      bands[0] = out;
+
+    size_t i = 0;
+    while (i < n)
+    {
+      size_t m = MIN(n - i, sub_size - sub_pos);
+
+      for (b = 0; b < nb; b++)
+      {
+        // level detection
+        samples_t x = bands[b];
+        x += i;
+        block_stat(x.samples, nch, m, peak, rms? sum2: 0);
+        for (ch = 0; ch < nch; ch++)
+        {
+          if (peak[ch] > sub_peak[b][ch]) sub_peak[b][ch] = peak[ch];
+          if (rms) sub_sum2[b][ch] += sum2[ch];
+        }
+
+        // gain ramp of the previous sub-block; bands are summed into output
+        for (ch = 0; ch < nch; ch++)
+        {
+          sample_t step = (target[b][ch] - gain[b][ch]) / sub_size;
+          sample_t g = gain[b][ch] + step * sub_pos;
+          gain_ramp(out[ch] + i, x[ch], m, g, step, b > 0);
+        }
+      }
+
+      sub_pos += m;
+      i += m;
+      if (sub_pos >= sub_size)
+      {
+        sub_pos = 0;
+        follow(nb);
+      }
+    }
+
+    pos += n;
+  }
+
+  return true;
+}
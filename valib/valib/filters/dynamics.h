@@ -0,0 +1,159 @@
+/*
+  Dynamic range compressor filter
+  Per-channel compression with optional 3-band processing.
+
+  Speakers: unchanged
+  Input formats: Linear
+  Output formats: Linear
+  Buffer: -
+  Inline: +
+  Delay: 0
+  Timing: unchanged
+  Parameters:
+    enabled      // compressor is enabled
+    multiband    // 3-band compression (wideband uses band 0 settings)
+    crossover    // crossover frequencies between bands (Hz)
+    band         // threshold (dB), ratio and makeup gain (dB) of a band
+    attack       // attack time (ms)
+    release      // release time (ms)
+    rms          // detect RMS level instead of peak level
+    gain         // current gain of a band and channel (read-only)
+
+  Each channel has its own gain, so loud effects at one channel do not
+  pump the dialog at the center channel, and (in multiband mode) loud
+  basses do not pump the voice band.
+
+  Bands are split with Linkwitz-Riley (4th order) crossovers, and the low
+  band is passed through the allpass of the high crossover, so the sum of
+  bands is an allpass filter (flat response when no compression is done).
+
+  Level is detected with block_stat() over sub-blocks of 16 samples for all
+  channels at once, and envelope followers run once per sub-block. Gain of
+  the previous sub-block is ramped linearly over the next one (SIMD), so
+  gain changes are smooth and the output does not depend on the chunk size.
+*/
+
+#ifndef VALIB_DYNAMICS_H
+#define VALIB_DYNAMICS_H
+
+#include "../buffer.h"
+#include "../filter.h"
+#include "bass_redir.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Crossover filters: 2nd order Butterworth (cascade of two makes 4th order
+// Linkwitz-Riley) and the allpass equal to the sum of LR4 low and high pass.
+///////////////////////////////////////////////////////////////////////////////
+
+class CrossoverLPF : public IIR
+{
+public:
+  void update();
+};
+
+class CrossoverHPF : public IIR
+{
+public:
+  void update();
+};
+
+class CrossoverAPF : public IIR
+{
+public:
+  void update();
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Dynamics filter class
+///////////////////////////////////////////////////////////////////////////////
+
+struct DynamicsBand
+{
+  sample_t threshold;   // compression threshold (dB)
+  sample_t ratio;       // compression ratio (>= 1)
+  sample_t gain;        // makeup gain (dB)
+};
+
+class Dynamics : public NullFilter
+{
+public:
+  enum { nbands = 3 };
+
+protected:
+  bool   enabled;
+  bool   multiband;
+  bool   rms;
+  double freq[nbands - 1];
+  double attack;
+  double release;
+  DynamicsBand band[nbands];
+  double sample_rate;
+
+  // filters for each channel
+  CrossoverLPF lpf[NCHANNELS][2][2];  // [ch][crossover][cascade]
+  CrossoverHPF hpf[NCHANNELS][2][2];
+  CrossoverAPF apf[NCHANNELS];        // high crossover allpass for low band
+  SampleBuf band_buf[nbands];
+
+  // per-band constants
+  sample_t threshold_lin[nbands];
+  sample_t power[nbands];             // 1/ratio - 1
+  sample_t makeup[nbands];
+  double   attack_coef;               // per sub-block
+  double   release_coef;
+
+  // envelope followers
+  size_t   sub_pos;                   // position in the current sub-block
+  sample_t sub_peak[nbands][NCHANNELS];
+  sample_t sub_sum2[nbands][NCHANNELS];
+  sample_t env[nbands][NCHANNELS];
+  sample_t gain[nbands][NCHANNELS];   // gain at the start of the sub-block
+  sample_t target[nbands][NCHANNELS]; // gain at the end of the sub-block
+
+  void update();
+  void split(samples_t samples, size_t n);
+  void follow(int nb);
+
+  /////////////////////////////////////////////////////////
+  // NullFilter overrides
+
+  virtual void on_reset();
+  virtual bool on_set_input(Speakers spk);
+  virtual bool on_process();
+
+public:
+  Dynamics();
+
+  /////////////////////////////////////////////////////////
+  // Dynamics interface
+
+  bool get_enabled() const { return enabled; }
+  void set_enabled(bool enabled);
+
+  bool get_multiband() const { return multiband; }
+  void set_multiband(bool multiband);
+
+  bool get_rms() const { return rms; }
+  void set_rms(bool _rms) { rms = _rms; }
+
+  void get_crossover(double &low, double &high) const;
+  void set_crossover(double low, double high);
+
+  void get_band(int band, DynamicsBand &params) const;
+  void set_band(int band, const DynamicsBand &params);
+
+  double get_attack() const { return attack; }
+  void   set_attack(double attack);
+
+  double get_release() const { return release; }
+  void   set_release(double release);
+
+  sample_t get_gain(int band, int ch) const;
+
+  /////////////////////////////////////////////////////////
+  // Filter interface
+
+  virtual bool is_inplace() const { return true; }
+};
+
+#endif
@@ -1,5 +1,6 @@
 #include <math.h>
 #include "levels.h"
+#include "../dsp/block_stat.h"
 
 ///////////////////////////////////////////////////////////
 // LevelsCache
@@ -186,6 +187,7 @@ bool
 Levels::on_process()
 {
   size_t n = size;
+  size_t pos = 0;
 
   if (sync)
     continuous_time = time;
@@ -193,46 +195,35 @@ Levels::on_process()
   /////////////////////////////////////////////////////////
   // Find peak-levels
 
-  sample_t max;
-  sample_t *sptr;
-  sample_t *send;
+  sample_t peak[NCHANNELS];
+  samples_t block_samples;
+  block_stat_mch_t block_stat = find_block_stat_mch();
 
   int nch = spk.nch();
   sample_t spk_level = 1.0 / spk.level;
   const short int *spk_order = spk.order();
 
+  // channels up to the first missing one
+  for (int ch = 0; ch < nch; ch++)
+    if (!samples[ch])
+    {
+      nch = ch;
+      break;
+    }
+
   while (n)
   {
     size_t block_size = MIN(n, nsamples - sample);
     n -= block_size;
     sample += block_size;
 
+    block_samples = samples;
+    block_samples += pos;
+    block_stat(block_samples.samples, nch, block_size, peak, 0);
+
     for (int ch = 0; ch < nch; ch++)
     {
-      max = 0;
-      sptr = samples[ch];
-      if (!sptr) break;
-      send = sptr + block_size - 7;
-      while (sptr < send)
-      {
-        if (fabs(sptr[0]) > max) max = fabs(sptr[0]);
-        if (fabs(sptr[1]) > max) max = fabs(sptr[1]);
-        if (fabs(sptr[2]) > max) max = fabs(sptr[2]);
-        if (fabs(sptr[3]) > max) max = fabs(sptr[3]);
-        if (fabs(sptr[4]) > max) max = fabs(sptr[4]);
-        if (fabs(sptr[5]) > max) max = fabs(sptr[5]);
-        if (fabs(sptr[6]) > max) max = fabs(sptr[6]);
-        if (fabs(sptr[7]) > max) max = fabs(sptr[7]);
-        sptr += 8;
-      }
-      send += 7;
-      while (sptr < send)
-      {
-        if (fabs(sptr[0]) > max) max = fabs(sptr[0]);
-        sptr++;
-      }
-
-      max *= spk_level;
+      sample_t max = peak[ch] * spk_level;
       if (max > levels[spk_order[ch]])
         levels[spk_order[ch]] = max;
     }
@@ -245,6 +236,7 @@ Levels::on_process()
     }
 
     continuous_time += vtime_t(block_size) / spk.sample_rate;
+    pos += block_size;
   }
 
   return true;
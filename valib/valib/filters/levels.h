@@ -126,6 +126,11 @@ public:
   inline void get_histogram(int ch, double *histogram, size_t count) const;
   inline sample_t get_max_level() const;
   inline sample_t get_max_level(int ch) const;
+
+  /////////////////////////////////////////////////////////
+  // Filter interface
+
+  virtual bool is_inplace() const { return true; }
 };
 
 ///////////////////////////////////////////////////////////
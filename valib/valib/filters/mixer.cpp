@@ -1,6 +1,7 @@
 #include <math.h>
 #include <string.h>
 #include "mixer.h"
+#include "mixer_simd.h"
 
 typedef void (Mixer::*io_mixfunc_t)(samples_t, samples_t, size_t); // input-output mixing
 typedef void (Mixer::*ip_mixfunc_t)(samples_t, size_t);            // in-place mixing
@@ -27,6 +28,7 @@ Mixer::Mixer(size_t _nsamples)
 :NullFilter(FORMAT_MASK_LINEAR)
 {
   nsamples = _nsamples;
+  inplace_nch = 0;
   out_spk = spk_unknown;
 
   // Options
@@ -63,11 +65,6 @@ Mixer::prepare_matrix()
   // Convert input matrix into internal form
   // to achieve maximum performance
 
-  // todo: throw out null columns
-  // todo: zero null output channels instead of matrixing 
-  // todo: do not touch pass-through channels
-  // todo: gain channel if possible instead of matrixing
-
   const short int *in_order = spk.order();
   const short int *out_order = out_spk.order();
   sample_t factor = 1.0;
@@ -84,6 +81,118 @@ Mixer::prepare_matrix()
         input_gains[in_order[ch1]] * 
         output_gains[out_order[ch2]] * 
         factor;
+
+  prepare_plan();
+}
+
+void
+Mixer::prepare_plan()
+{
+  // Build the list of operations from the reordered matrix
+
+  int nin = spk.nch();
+  int nout = out_spk.nch();
+  bool inplace = !is_buffered();
+  bool aliased[NCHANNELS] = { false, false, false, false, false, false };
+
+  mix_op_t ops[NCHANNELS];
+  int nops = 0;
+  int nmacs = 0;
+  int ntaps = 0;
+  int i, o, p;
+
+  plan_size = 0;
+  plan_dense = false;
+
+  for (o = 0; o < nout; o++)
+  {
+    mix_op_t &op = ops[nops];
+    op.out = o;
+    op.ntaps = 0;
+    op.k.zero();
+    for (i = 0; i < nin; i++)
+      if (m[i][o] != 0)
+      {
+        op.in[op.ntaps] = i;
+        op.k[op.ntaps][0] = m[i][o];
+        op.ntaps++;
+      }
+    ntaps += op.ntaps;
+
+    if (op.ntaps == 0)
+      op.type = MIXOP_ZERO;
+    else if (op.ntaps == 1 && op.k[0][0] == 1.0)
+    {
+      if (inplace && op.in[0] == o)
+        continue; // pass-through channel
+
+      // Output chunk may point to the input channel only once,
+      // otherwise in-place filters after us would process it twice.
+      if (!inplace && !aliased[op.in[0]])
+      {
+        aliased[op.in[0]] = true;
+        op.type = MIXOP_ALIAS;
+      }
+      else
+        op.type = MIXOP_COPY;
+    }
+    else
+    {
+      op.type = MIXOP_MAC;
+      nmacs++;
+    }
+    nops++;
+  }
+
+  // Dense matrix is processed faster in one pass
+  if (nout && nmacs == nout && ntaps == nin * nout)
+  {
+    plan_dense = true;
+    return;
+  }
+
+  if (!inplace)
+  {
+    for (p = 0; p < nops; p++)
+      plan[p] = ops[p];
+    plan_size = nops;
+    return;
+  }
+
+  // In-place mixing: the operation destroys the input channel it writes to,
+  // so it must go after all other operations that read this channel. When
+  // channels depend on each other cyclically (L' = L + R, R' = L - R), we
+  // cannot order operations and have to use full matrixing.
+
+  bool done[NCHANNELS] = { false, false, false, false, false, false };
+  while (plan_size < nops)
+  {
+    int next = -1;
+    for (p = 0; p < nops && next < 0; p++)
+    {
+      if (done[p]) continue;
+
+      bool ready = true;
+      for (int q = 0; q < nops && ready; q++)
+        if (q != p && !done[q])
+          for (int t = 0; t < ops[q].ntaps; t++)
+            if (ops[q].in[t] == ops[p].out)
+              ready = false;
+
+      if (ready)
+        next = p;
+    }
+
+    if (next < 0)
+    {
+      plan_size = 0;
+      plan_dense = true;
+      return;
+    }
+
+    done[next] = true;
+    plan[plan_size++] = ops[next];
+  }
 }
 
 bool
@@ -97,6 +206,8 @@ Mixer::set_output(Speakers _spk)
 
   if (is_buffered())
     buf.allocate(out_spk.nch(), nsamples);
+  else
+    buf.free();
 
   if (auto_matrix)
     calc_matrix();
@@ -115,6 +226,8 @@ Mixer::set_input(Speakers _spk)
   if (!NullFilter::set_input(_spk))
     return false;
 
+  // Input buffer is unknown until the graph negotiates it
+  inplace_nch = 0;
   out_spk.sample_rate = spk.sample_rate;
 
   if (is_buffered())
@@ -134,6 +247,31 @@ Mixer::get_output() const
   return out_spk;
 }
 
+bool
+Mixer::is_inplace() const
+{
+  return !is_buffered();
+}
+
+int
+Mixer::get_inplace_nch() const
+{
+  return out_spk.nch() > spk.nch()? out_spk.nch(): 0;
+}
+
+void
+Mixer::set_inplace_nch(int nch)
+{
+  inplace_nch = nch;
+  if (is_buffered())
+    buf.allocate(out_spk.nch(), nsamples);
+  else
+    buf.free();
+
+  // in-place and buffered plans differ
+  prepare_plan();
+}
+
 
 bool 
 Mixer::get_chunk(Chunk *_chunk)
@@ -142,8 +280,11 @@ Mixer::get_chunk(Chunk *_chunk)
   {
     // buffered mixing
     size_t n = MIN(nsamples, size);
-    io_mixfunc_t mixfunc = io_mix_tbl[spk.nch()-1][out_spk.nch()-1];
-    (this->*mixfunc)(samples, buf, n);
+    samples_t out = buf;
+    if (plan_dense)
+      mix_dense(samples, out, n);
+    else
+      mix_plan(samples, out, n);
     samples += n;
     size -= n;
 
@@ -151,7 +292,7 @@ Mixer::get_chunk(Chunk *_chunk)
     _chunk->set_linear
     (
       out_spk,
-      buf, n,
+      out, n,
       sync, time, 
       flushing && !size
     );
@@ -162,8 +303,10 @@ Mixer::get_chunk(Chunk *_chunk)
   else
   {
     // in-place mixing
-    ip_mixfunc_t mixfunc = ip_mix_tbl[spk.nch()-1][out_spk.nch()-1];
-    (this->*mixfunc)(samples, size);
+    if (plan_dense)
+      mix_dense(samples, samples, size);
+    else
+      mix_plan(samples, samples, size);
 
     // fill output chunk
     _chunk->set_linear
@@ -181,6 +324,69 @@ Mixer::get_chunk(Chunk *_chunk)
   return true;
 }
 
+void
+Mixer::mix_dense(samples_t input, samples_t output, size_t n)
+{
+  // Full matrixing; output may be the same as input (in-place mixing)
+  mix_simd_t simd_mix = find_mix_simd(spk.nch(), out_spk.nch());
+  if (simd_mix)
+    simd_mix(input, output, m, n);
+  else if (input[0] == output[0])
+  {
+    ip_mixfunc_t mixfunc = ip_mix_tbl[spk.nch()-1][out_spk.nch()-1];
+    (this->*mixfunc)(input, n);
+  }
+  else
+  {
+    io_mixfunc_t mixfunc = io_mix_tbl[spk.nch()-1][out_spk.nch()-1];
+    (this->*mixfunc)(input, output, n);
+  }
+}
+
+void
+Mixer::mix_plan(samples_t input, samples_t &output, size_t n)
+{
+  for (int p = 0; p < plan_size; p++)
+  {
+    const mix_op_t &op = plan[p];
+    switch (op.type)
+    {
+      case MIXOP_ZERO:
+        memset(output[op.out], 0, n * sizeof(sample_t));
+        break;
+
+      case MIXOP_COPY:
+        memcpy(output[op.out], input[op.in[0]], n * sizeof(sample_t));
+        break;
+
+      case MIXOP_ALIAS:
+        output[op.out] = input[op.in[0]];
+        break;
+
+      case MIXOP_MAC:
+      {
+        samples_t taps, dst;
+        for (int t = 0; t < op.ntaps; t++)
+          taps[t] = input[op.in[t]];
+        dst[0] = output[op.out];
+
+        mix_simd_t simd_mix = find_mix_simd(op.ntaps, 1);
+        if (simd_mix)
+          simd_mix(taps, dst, op.k, n);
+        else
+          for (size_t s = 0; s < n; s++)
+          {
+            sample_t sum = taps[0][s] * op.k[0][0];
+            for (int t = 1; t < op.ntaps; t++)
+              sum += taps[t][s] * op.k[t][0];
+            dst[0][s] = sum;
+          }
+        break;
+      }
+    }
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Matrix calculation
 ///////////////////////////////////////////////////////////////////////////////
@@ -10,6 +10,10 @@
   Speakers: can change mask
   Input formats:  Linear
   Buffering: yes/no
+    Mixer works in-place when the number of channels does not grow. When it
+    grows (upmix), mixer uses its own buffer, unless the filter graph finds
+    that the input buffer has room for all output channels (see buffer
+    negotiation at filter.h). In this case upmix is also done in-place.
   Timing: unchanged
   Parameters:
     output           - output speakers config
@@ -36,6 +40,32 @@
 
 //typedef sample_t matrix_t[NCHANNELS][NCHANNELS];
 
+///////////////////////////////////////////////////////////////////////////////
+// Mixing plan
+// Mixer compiles the reordered matrix into a list of operations, one per
+// output channel, so only non-zero matrix elements are processed:
+//   MIXOP_ZERO  - output channel has no inputs, fill it with zeros
+//   MIXOP_COPY  - output channel is an input channel with unit gain
+//   MIXOP_ALIAS - same as MIXOP_COPY, but output chunk just points to the
+//                 input channel (out-of-place mixing only)
+//   MIXOP_MAC   - weighted sum of non-zero inputs (scale for one input)
+// Pass-through channels (same channel with unit gain at in-place mixing)
+// have no operation at all.
+
+#define MIXOP_ZERO  0
+#define MIXOP_COPY  1
+#define MIXOP_ALIAS 2
+#define MIXOP_MAC   3
+
+struct mix_op_t
+{
+  int      type;                     // operation type
+  int      out;                      // output channel
+  int      ntaps;                    // number of inputs
+  int      in[NCHANNELS];            // input channels
+  matrix_t k;                        // input factors: k[tap][0]
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // Mixer class
 ///////////////////////////////////////////////////////////////////////////////
@@ -49,6 +79,7 @@ protected:
   // Buffer
   SampleBuf buf;                     // sample buffer
   size_t nsamples;                   // buffer size (in samples)
+  int inplace_nch;                   // channels in the input buffer (negotiated)
                                   
   // Options                      
   bool     auto_matrix;              // update matrix automatically
@@ -70,7 +101,15 @@ protected:
   matrix_t matrix;                   // mixing matrix
   matrix_t m;                        // reordered mixing matrix (internal)
 
+  // Mixing plan
+  mix_op_t plan[NCHANNELS];          // operations
+  int      plan_size;                // number of operations
+  bool     plan_dense;               // use full matrixing instead of the plan
+
   void prepare_matrix();
+  void prepare_plan();
+  void mix_dense(samples_t input, samples_t output, size_t nsamples);
+  void mix_plan(samples_t input, samples_t &output, size_t nsamples);
 
 public:
   Mixer(size_t nsamples);
@@ -82,6 +121,10 @@ public:
   virtual Speakers get_output() const;
   virtual bool get_chunk(Chunk *out);
 
+  virtual bool is_inplace() const;
+  virtual int  get_inplace_nch() const;
+  virtual void set_inplace_nch(int nch);
+
   /////////////////////////////////////////////////////////
   // Mixer interface
 
@@ -121,7 +164,8 @@ public:
   inline void     set_input_gains(const sample_t input_gains[NCHANNELS]);
   inline void     set_output_gains(const sample_t output_gains[NCHANNELS]);
 
-  // mixing functions
+  // scalar mixing functions (used when no SIMD kernel is available,
+  // see mixer_simd.h)
   void io_mix11(samples_t input, samples_t output, size_t nsamples);
   void io_mix12(samples_t input, samples_t output, size_t nsamples);
   void io_mix13(samples_t input, samples_t output, size_t nsamples);
@@ -206,7 +250,7 @@ public:
 inline bool
 Mixer::is_buffered() const
 {
-  return out_spk.nch() > spk.nch();
+  return out_spk.nch() > spk.nch() && out_spk.nch() > inplace_nch;
 }
 
 inline size_t
@@ -221,6 +265,8 @@ Mixer::set_buffer(size_t _nsamples)
   nsamples = _nsamples;
   if (is_buffered())
     buf.allocate(out_spk.nch(), _nsamples);
+  else
+    buf.free();
 }
 
 // Options get/set
@@ -0,0 +1,99 @@
+#include "mixer_simd.h"
+#include "../simd_vec.h"
+
+#ifdef VALIB_SIMD_X86
+
+///////////////////////////////////////////////////////////////////////////////
+// Mixing kernel
+//
+// Processes V::width samples of all channels per step. All input vectors of a
+// step are loaded before any output is stored, so input and output may point
+// to the same buffers (in-place mixing). The tail is processed with scalar
+// code that follows the same order of operations.
+//
+// The kernel body is defined with a macro because GCC requires the target
+// attribute on each instantiation that uses AVX intrinsics.
+
+#define DEFINE_MIX_KERNEL(name, V, target)                                    \
+template <int nin, int nout> static target                                    \
+void name(samples_t input, samples_t output, const matrix_t &m, size_t nsamples) \
+{                                                                             \
+  int i, o;                                                                   \
+  V::vec mv[nin][nout];                                                       \
+  for (i = 0; i < nin; i++)                                                   \
+    for (o = 0; o < nout; o++)                                                \
+      mv[i][o] = V::set1(m[i][o]);                                            \
+                                                                              \
+  size_t s = 0;                                                               \
+  for (; s + V::width <= nsamples; s += V::width)                             \
+  {                                                                           \
+    V::vec x[nin], y[nout];                                                   \
+    for (i = 0; i < nin; i++)                                                 \
+      x[i] = V::load(input[i] + s);                                           \
+    for (o = 0; o < nout; o++)                                                \
+    {                                                                         \
+      y[o] = V::mul(x[0], mv[0][o]);                                          \
+      for (i = 1; i < nin; i++)                                               \
+        y[o] = V::add(y[o], V::mul(x[i], mv[i][o]));                          \
+    }                                                                         \
+    for (o = 0; o < nout; o++)                                                \
+      V::store(output[o] + s, y[o]);                                          \
+  }                                                                           \
+                                                                              \
+  for (; s < nsamples; s++)                                                   \
+  {                                                                           \
+    sample_t x[nin], y[nout];                                                 \
+    for (i = 0; i < nin; i++)                                                 \
+      x[i] = input[i][s];                                                     \
+    for (o = 0; o < nout; o++)                                                \
+    {                                                                         \
+      y[o] = x[0] * m[0][o];                                                  \
+      for (i = 1; i < nin; i++)                                               \
+        y[o] += x[i] * m[i][o];                                               \
+    }                                                                         \
+    for (o = 0; o < nout; o++)                                                \
+      output[o][s] = y[o];                                                    \
+  }                                                                           \
+}
+
+DEFINE_MIX_KERNEL(mix_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_MIX_KERNEL(mix_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+
+#define MIX_ROW(kernel, nin) \
+  { &kernel<nin, 1>, &kernel<nin, 2>, &kernel<nin, 3>, &kernel<nin, 4>, &kernel<nin, 5>, &kernel<nin, 6> }
+
+static const mix_simd_t mix_sse2_tbl[NCHANNELS][NCHANNELS] = {
+  MIX_ROW(mix_sse2, 1), MIX_ROW(mix_sse2, 2), MIX_ROW(mix_sse2, 3),
+  MIX_ROW(mix_sse2, 4), MIX_ROW(mix_sse2, 5), MIX_ROW(mix_sse2, 6)
+};
+
+#ifdef VALIB_SIMD_AVX
+static const mix_simd_t mix_avx_tbl[NCHANNELS][NCHANNELS] = {
+  MIX_ROW(mix_avx, 1), MIX_ROW(mix_avx, 2), MIX_ROW(mix_avx, 3),
+  MIX_ROW(mix_avx, 4), MIX_ROW(mix_avx, 5), MIX_ROW(mix_avx, 6)
+};
+#endif
+
+#endif // VALIB_SIMD_X86
+
+///////////////////////////////////////////////////////////////////////////////
+
+mix_simd_t find_mix_simd(int nin, int nout)
+{
+  if (nin < 1 || nin > NCHANNELS || nout < 1 || nout > NCHANNELS)
+    return 0;
+
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return mix_avx_tbl[nin-1][nout-1];
+#endif
+  if (caps & SIMD_SSE2)
+    return mix_sse2_tbl[nin-1][nout-1];
+#endif
+
+  return 0;
+}
@@ -0,0 +1,31 @@
+/*
+  SIMD matrix mixing kernels for Mixer filter.
+
+  mix_simd_t(samples_t input, samples_t output, const matrix_t &m, size_t nsamples)
+    Mixing kernel definition
+    input   - input channels
+    output  - output channels (may be the same buffers as input for in-place
+              mixing)
+    m       - reordered mixing matrix m[input_ch][output_ch]
+    nsamples - number of samples to process
+
+  find_mix_simd(int nin, int nout)
+    Find the best SIMD kernel allowed by simd_caps().
+    Returns zero when no SIMD instruction set is available (or it is disabled
+    with simd_set_mask()), so the caller must use the scalar mixing functions.
+
+  Kernels do exactly the same operations in the same order as the scalar
+  Mixer::io_mixNM/ip_mixNM functions:
+    out[o] = in[0]*m[0][o] + in[1]*m[1][o] + ... (left to right, no FMA)
+  so the result is bit-identical to the scalar path.
+*/
+
+#ifndef VALIB_MIXER_SIMD_H
+#define VALIB_MIXER_SIMD_H
+
+#include "../spk.h"
+
+typedef void (*mix_simd_t)(samples_t, samples_t, const matrix_t &, size_t);
+mix_simd_t find_mix_simd(int nin, int nout);
+
+#endif
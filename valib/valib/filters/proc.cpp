@@ -12,6 +12,7 @@ AudioProcessor::AudioProcessor(const size_t _nsamples)
 {
   dithering = DITHER_AUTO;
   user_spk = spk_unknown;
+  dynamics_pre_mixer = false;
   rebuild_chain();
 }
 
@@ -137,13 +138,21 @@ AudioProcessor::rebuild_chain()
   FILTER_SAFE(chain.add_back(&in_cache, "Input cache"));
   if (out_spk.nch() < in_spk.nch())
   {
+    if (dynamics_pre_mixer)
+      FILTER_SAFE(chain.add_back(&dynamics, "Dynamics"));
     FILTER_SAFE(chain.add_back(&mixer,     "Mixer"));
+    if (!dynamics_pre_mixer)
+      FILTER_SAFE(chain.add_back(&dynamics, "Dynamics"));
     FILTER_SAFE(chain.add_back(&resample,  "SRC"));
   }
   else
   {
     FILTER_SAFE(chain.add_back(&resample,  "SRC"));
+    if (dynamics_pre_mixer)
+      FILTER_SAFE(chain.add_back(&dynamics, "Dynamics"));
     FILTER_SAFE(chain.add_back(&mixer,     "Mixer"));
+    if (!dynamics_pre_mixer)
+      FILTER_SAFE(chain.add_back(&dynamics, "Dynamics"));
   }
   FILTER_SAFE(chain.add_back(&bass_redir,"Bass redirection"));
   FILTER_SAFE(chain.add_back(&equalizer, "Equalizer"));
@@ -189,6 +198,7 @@ AudioProcessor::reset()
   mixer.reset();
   resample.reset();
   bass_redir.reset();
+  dynamics.reset();
   agc.reset();
   delay.reset();
   out_levels.reset();
@@ -283,6 +293,11 @@ AudioProcessor::get_state(vtime_t time)
   state->normalize = get_normalize();
   state->attack    = get_attack();
   state->release   = get_release();
+  // Limiter
+  state->limiter   = get_limiter();
+  state->true_peak = get_true_peak();
+  state->lookahead = get_lookahead();
+  state->limiter_level = get_limiter_level();
   // DRC
   state->drc       = get_drc();
   state->drc_power = get_drc_power();
@@ -331,6 +346,16 @@ AudioProcessor::get_state(vtime_t time)
   // Bass redirection
   state->bass_redir = get_bass_redir();
   state->bass_freq = get_bass_freq();
+  // Dynamics
+  state->dynamics = get_dynamics();
+  state->dynamics_pre_mixer = get_dynamics_pre_mixer();
+  state->dynamics_multiband = get_dynamics_multiband();
+  state->dynamics_rms = get_dynamics_rms();
+  get_dynamics_crossover(state->dynamics_crossover[0], state->dynamics_crossover[1]);
+  for (int band = 0; band < Dynamics::nbands; band++)
+    get_dynamics_band(band, state->dynamics_bands[band]);
+  state->dynamics_attack = get_dynamics_attack();
+  state->dynamics_release = get_dynamics_release();
   // Delays
   state->delay = get_delay();
   state->delay_units = get_delay_units();
@@ -356,6 +381,11 @@ AudioProcessor::set_state(const AudioProcessorState *state)
   set_normalize(state->normalize);
   set_attack(state->attack);
   set_release(state->release);
+  // Limiter
+  set_limiter(state->limiter);
+  set_true_peak(state->true_peak);
+  set_lookahead(state->lookahead);
+  set_limiter_level(state->limiter_level);
   // DRC
   set_drc(state->drc);
   set_drc_power(state->drc_power);
@@ -388,6 +418,16 @@ AudioProcessor::set_state(const AudioProcessorState *state)
   // Bass redirection
   set_bass_redir(state->bass_redir);
   set_bass_freq(state->bass_freq);
+  // Dynamics
+  set_dynamics(state->dynamics);
+  set_dynamics_pre_mixer(state->dynamics_pre_mixer);
+  set_dynamics_multiband(state->dynamics_multiband);
+  set_dynamics_rms(state->dynamics_rms);
+  set_dynamics_crossover(state->dynamics_crossover[0], state->dynamics_crossover[1]);
+  for (int band = 0; band < Dynamics::nbands; band++)
+    set_dynamics_band(band, state->dynamics_bands[band]);
+  set_dynamics_attack(state->dynamics_attack);
+  set_dynamics_release(state->dynamics_release);
   // Delays
   set_delay(state->delay);
   set_delay_units(state->delay_units);
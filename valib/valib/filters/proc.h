@@ -25,6 +25,12 @@
   attack              - attack speed (dB/s)
   release             - release speed (dB/s)
 
+  // Limiter (AGC mode, applied on reset)
+  limiter             - look-ahead limiter instead of block AGC
+  true_peak           - limit inter-sample peaks
+  lookahead           - limiter look-ahead (sec)
+  limiter_level       - limiter level
+
   // DRC
   drc                 - apply DRC control
   drc_power           - DRC power (gain in dB at -50dB level)
@@ -38,6 +44,19 @@
   bass_redir          - apply bass redirection
   bass_freq           - bass redirection frequency
 
+  // Dynamics (per-channel compressor, see dynamics.h)
+  dynamics            - apply compression
+  dynamics_pre_mixer  - compress input channels (before the mixer) instead
+                        of output channels; the chain is rebuilt, so the
+                        setter fails like set_user() when it cannot be built
+  dynamics_multiband  - 3-band compression
+  dynamics_rms        - RMS level detection
+  dynamics_crossover  - crossover frequencies (Hz)
+  dynamics_band       - band threshold, ratio and makeup gain
+  dynamics_attack     - attack time (ms)
+  dynamics_release    - release time (ms)
+  dynamics_gain       - current gain of a band and channel (read-only)
+
   // Matrix & options
   matrix              - mixing matrix
   auto_matrix         - update matrix automatically
@@ -81,6 +100,7 @@
 #include "mixer.h"
 #include "resample.h"
 #include "bass_redir.h"
+#include "dynamics.h"
 #include "agc.h"
 #include "delay.h"
 #include "dither.h"
@@ -112,6 +132,7 @@ protected:
   EqualizerMch equalizer;
   Dither       dither;
   BassRedir    bass_redir;
+  Dynamics     dynamics;
   AGC          agc;
   Delay        delay;
 
@@ -122,6 +143,8 @@ protected:
   FilterChain chain;
   bool rebuild_chain();
 
+  bool    dynamics_pre_mixer; // dynamics is placed before the mixer
+
 #ifdef _WIN64
   int dithering;
 #endif
@@ -183,6 +206,18 @@ public:
   inline void     set_attack(sample_t attack);
   inline void     set_release(sample_t release);
 
+  // Limiter
+
+  inline bool     get_limiter() const;
+  inline bool     get_true_peak() const;
+  inline vtime_t  get_lookahead() const;
+  inline sample_t get_limiter_level() const;
+
+  inline void     set_limiter(bool limiter);
+  inline void     set_true_peak(bool true_peak);
+  inline void     set_lookahead(vtime_t lookahead);
+  inline void     set_limiter_level(sample_t limiter_level);
+
   // DRC
 
   inline bool     get_drc() const;
@@ -257,6 +292,27 @@ public:
   inline void     set_bass_redir(bool bass_redir);
   inline void     set_bass_freq(int freq);
 
+  // Dynamics
+
+  inline bool     get_dynamics() const;
+  inline bool     get_dynamics_pre_mixer() const;
+  inline bool     get_dynamics_multiband() const;
+  inline bool     get_dynamics_rms() const;
+  inline void     get_dynamics_crossover(double &low, double &high) const;
+  inline void     get_dynamics_band(int band, DynamicsBand &params) const;
+  inline double   get_dynamics_attack() const;
+  inline double   get_dynamics_release() const;
+  inline sample_t get_dynamics_gain(int band, int ch) const; // r/o
+
+  inline void     set_dynamics(bool dynamics);
+  inline bool     set_dynamics_pre_mixer(bool pre_mixer);
+  inline void     set_dynamics_multiband(bool multiband);
+  inline void     set_dynamics_rms(bool rms);
+  inline void     set_dynamics_crossover(double low, double high);
+  inline void     set_dynamics_band(int band, const DynamicsBand &params);
+  inline void     set_dynamics_attack(double attack);
+  inline void     set_dynamics_release(double release);
+
   // Delays
 
   inline bool     get_delay() const;
@@ -297,6 +353,7 @@ public:
   inline sample_t get_max_level() const;
   inline sample_t get_max_level(int ch) const;
 
+
   // State
 
   AudioProcessorState *get_state(vtime_t time);
@@ -359,6 +416,32 @@ inline void AudioProcessor::set_attack(sample_t _attack)
 inline void AudioProcessor::set_release(sample_t _release)
 { agc.release = _release; }
 
+// Limiter
+
+inline bool AudioProcessor::get_limiter() const
+{ return agc.limiter; }
+
+inline bool AudioProcessor::get_true_peak() const
+{ return agc.true_peak; }
+
+inline vtime_t AudioProcessor::get_lookahead() const
+{ return agc.lookahead; }
+
+inline sample_t AudioProcessor::get_limiter_level() const
+{ return agc.limiter_level; }
+
+inline void AudioProcessor::set_limiter(bool _limiter)
+{ agc.limiter = _limiter; }
+
+inline void AudioProcessor::set_true_peak(bool _true_peak)
+{ agc.true_peak = _true_peak; }
+
+inline void AudioProcessor::set_lookahead(vtime_t _lookahead)
+{ agc.lookahead = _lookahead; }
+
+inline void AudioProcessor::set_limiter_level(sample_t _limiter_level)
+{ agc.limiter_level = _limiter_level; }
+
 // DRC
 
 inline bool AudioProcessor::get_drc() const
@@ -500,6 +583,71 @@ inline void AudioProcessor::set_bass_redir(bool _bass_redir)
 inline void AudioProcessor::set_bass_freq(int _bass_freq)
 { bass_redir.set_freq(_bass_freq); }
 
+// Dynamics
+
+inline bool AudioProcessor::get_dynamics() const
+{ return dynamics.get_enabled(); }
+
+inline bool AudioProcessor::get_dynamics_pre_mixer() const
+{ return dynamics_pre_mixer; }
+
+inline bool AudioProcessor::get_dynamics_multiband() const
+{ return dynamics.get_multiband(); }
+
+inline bool AudioProcessor::get_dynamics_rms() const
+{ return dynamics.get_rms(); }
+
+inline void AudioProcessor::get_dynamics_crossover(double &_low, double &_high) const
+{ dynamics.get_crossover(_low, _high); }
+
+inline void AudioProcessor::get_dynamics_band(int _band, DynamicsBand &_params) const
+{ dynamics.get_band(_band, _params); }
+
+inline double AudioProcessor::get_dynamics_attack() const
+{ return dynamics.get_attack(); }
+
+inline double AudioProcessor::get_dynamics_release() const
+{ return dynamics.get_release(); }
+
+inline sample_t AudioProcessor::get_dynamics_gain(int _band, int _ch) const
+{ return dynamics.get_gain(_band, _ch); }
+
+inline void AudioProcessor::set_dynamics(bool _dynamics)
+{ dynamics.set_enabled(_dynamics); }
+
+inline bool AudioProcessor::set_dynamics_pre_mixer(bool _pre_mixer)
+{
+  if (dynamics_pre_mixer != _pre_mixer)
+  {
+    dynamics_pre_mixer = _pre_mixer;
+    if (!rebuild_chain())
+    {
+      in_spk = spk_unknown;
+      out_spk = spk_unknown;
+      return false;
+    }
+  }
+  return true;
+}
+
+inline void AudioProcessor::set_dynamics_multiband(bool _multiband)
+{ dynamics.set_multiband(_multiband); }
+
+inline void AudioProcessor::set_dynamics_rms(bool _rms)
+{ dynamics.set_rms(_rms); }
+
+inline void AudioProcessor::set_dynamics_crossover(double _low, double _high)
+{ dynamics.set_crossover(_low, _high); }
+
+inline void AudioProcessor::set_dynamics_band(int _band, const DynamicsBand &_params)
+{ dynamics.set_band(_band, _params); }
+
+inline void AudioProcessor::set_dynamics_attack(double _attack)
+{ dynamics.set_attack(_attack); }
+
+inline void AudioProcessor::set_dynamics_release(double _release)
+{ dynamics.set_release(_release); }
+
 // Delays
 
 inline bool AudioProcessor::get_delay() const
@@ -3,6 +3,7 @@
 
 #include "../defs.h"
 #include "../fir/eq_fir.h"
+#include "dynamics.h"
 
 // Dithering mode constants
 
@@ -26,6 +27,12 @@ struct AudioProcessorState
   sample_t attack;
   sample_t release;
 
+  // Limiter
+  bool     limiter;
+  bool     true_peak;
+  vtime_t  lookahead;
+  sample_t limiter_level;
+
   // DRC
   bool     drc;
   sample_t drc_power;
@@ -68,6 +75,16 @@ struct AudioProcessorState
   bool     bass_redir;
   int      bass_freq;
 
+  // Dynamics
+  bool     dynamics;
+  bool     dynamics_pre_mixer;
+  bool     dynamics_multiband;
+  bool     dynamics_rms;
+  double   dynamics_crossover[2];
+  DynamicsBand dynamics_bands[Dynamics::nbands];
+  double   dynamics_attack;
+  double   dynamics_release;
+
   // Delay
   bool     delay;
   int      delay_units;
@@ -2,7 +2,7 @@
 #include <string.h>
 #include "resample.h"
 #include "../dsp/kaiser.h"
-#include "../dsp/fftsg.h"
+#include "../dsp/dot.h"
 
 static const double k_conv = 2;
 static const double k_fft = 20.1977305724455;
@@ -32,8 +32,7 @@ Resample::Resample():
   n1(0), n1x(0), n1y(0),
   c1(0), c1x(0), c1y(0),
   f1_raw(0), f1(0), order(0),
-  n2(0), n2b(0), c2(0), f2(0),
-  fft_ip(0), fft_w(0)
+  n2(0), n2b(0), c2(0), f2(0)
 {
   for (int i = 0; i < NCHANNELS; i++)
   {
@@ -55,8 +54,7 @@ Resample::Resample(int _sample_rate, double _a, double _q):
   n1(0), n1x(0), n1y(0),
   c1(0), c1x(0), c1y(0),
   f1_raw(0), f1(0), order(0),
-  n2(0), n2b(0), c2(0), f2(0),
-  fft_ip(0), fft_w(0)
+  n2(0), n2b(0), c2(0), f2(0)
 {
   for (int i = 0; i < NCHANNELS; i++)
   {
@@ -102,7 +100,7 @@ Resample::set(int _sample_rate, double _a, double _q)
   {
     out_spk.sample_rate = sample_rate;
     if (spk.sample_rate != sample_rate)
-      init_resample(spk.nch(), spk.sample_rate, sample_rate);
+      return init_resample(spk.nch(), spk.sample_rate, sample_rate) != 0;
   }
 
   return true;
@@ -140,7 +138,7 @@ Resample::set_input(Speakers _spk)
   {
     out_spk.sample_rate = sample_rate;
     if (spk.sample_rate != sample_rate)
-      init_resample(spk.nch(), spk.sample_rate, sample_rate);
+      return init_resample(spk.nch(), spk.sample_rate, sample_rate) != 0;
   }
   return true;
 }
@@ -314,11 +312,12 @@ Resample::init_resample(int _nch, int _fs, int _fd)
     f2[i] = (sample_t)(kaiser_window(i - c2, n2-1, alpha) * lpf(i - c2, lpf2) * l2 / n2);
 
   // convert the filter to frequency domain and init fft for future use
-  fft_ip    = new int[(int)(2 + sqrt(double(n2b)))];
-  fft_w     = new sample_t[n2b/2];
-  fft_ip[0] = 0;
-
-  rdft(n2b, 1, f2, fft_ip, fft_w);
+  if (!fft.set_length(n2b))
+  {
+    uninit_resample();
+    return false;
+  }
+  fft.rdft(f2);
 
   ///////////////////////////////////////////////////////
   // Allocate buffers
@@ -360,8 +359,6 @@ Resample::uninit_resample()
   safe_delete(f1_raw);
   safe_delete(order);
   safe_delete(f2);
-  safe_delete(fft_ip);
-  safe_delete(fft_w);
 
   safe_delete(buf1[0]);
   safe_delete(buf2[0]);
@@ -373,7 +370,6 @@ Resample::uninit_resample()
   c1 = 0; c1x = 0; c1y = 0;
   f1_raw = 0; f1 = 0; order = 0;
   n2 = 0; n2b = 0; c2 = 0; f2 = 0;
-  fft_ip = 0; fft_w = 0;
 
   out_samples.zero();
   for (int i = 0; i < NCHANNELS; i++)
@@ -399,39 +395,48 @@ Resample::do_stage1(sample_t *in[], sample_t *out[], int n_in, int n_out)
   stage1.start();
 #endif
 
-  for (int ch = 0; ch < nch; ch++)
+  // All channels are processed at each output position, so the filter
+  // bank row is loaded once for all channels and the whole bank is walked
+  // once per block instead of once per channel.
+
+  dot_mch_t dot = find_dot_mch();
+  const sample_t *x[NCHANNELS];
+  sample_t y[NCHANNELS];
+  int ch;
+
+  int i = pos_l;
+  int n = n_out;
+  pos_t ipos = -pos_m;
+  pos_t opos = -pos_l;
+
+  // Now ipos points to the 'imaginary' beginning of the block of M input
+  // samples and opos points to the beginning of the block of L output
+  // samples, so pos_m and pos_l are indexes at these blocks.
+  //
+  // But here a special case is possible. Consider L=3, M=5 and pos_m=4
+  // (4 input samples processed and 3 output samples generated). In this
+  // case pos_l=0 and order[pos_l]=0. So in[ch]-pos_m+order[pos_l] < in[ch].
+  // Thus we must skip last (unused) samples of the input block.
+
+  if (order[pos_l] < pos_m)
+     ipos += m1;
+
+  while (n--)
   {
-    int i = pos_l;
-    int n = n_out;
-    sample_t *iptr = in[ch] - pos_m;
-    sample_t *optr = out[ch] - pos_l;
-
-    // Now iptr points to the 'imaginary' beginning of the block of M input
-    // samples and optr points to the beginning of the block of L output
-    // samples, so pos_m and pos_l are indexes at these blocks.
-    //
-    // But here a special case is possible. Consider L=3, M=5 and pos_m=4
-    // (4 input samples processed and 3 output samples generated). In this
-    // case pos_l=0 and order[pos_l]=0. So in[ch]-pos_m+order[pos_l] < in[ch].
-    // Thus we must skip last (unused) samples of the input block.
-
-    if (order[pos_l] < pos_m)
-       iptr += m1;
-
-    while (n--)
-    {
-      double sum = 0;
-      for (int j = 0; j < n1x; j++)
-        sum += iptr[order[i] + j] * f1[i][j];
-      optr[i] = sum;
+    for (ch = 0; ch < nch; ch++)
+      x[ch] = in[ch] + ipos + order[i];
 
-      i++;
-      if (i >= l1)
-      {
-        i = 0;
-        iptr += m1;
-        optr += l1;
-      }
+    dot(x, nch, f1[i], n1x, y);
+
+    for (ch = 0; ch < nch; ch++)
+      out[ch][opos + i] = y[ch];
+
+    i++;
+    if (i >= l1)
+    {
+      i = 0;
+      ipos += m1;
+      opos += l1;
     }
   }
   pos_m = (pos_m + n_in) % m1;
@@ -453,7 +458,7 @@ Resample::do_stage2()
   {
     memset(buf2[ch] + n2, 0, n2 * sizeof(sample_t));
 
-    rdft(n2b, 1, buf2[ch], fft_ip, fft_w);
+    fft.rdft(buf2[ch]);
 
     buf2[ch][0] = f2[0] * buf2[ch][0];
     buf2[ch][1] = f2[1] * buf2[ch][1]; 
@@ -467,7 +472,7 @@ Resample::do_stage2()
       buf2[ch][i*2+1] = im;
     }
 
-    rdft(n2b, -1, buf2[ch], fft_ip, fft_w);
+    fft.inv_rdft(buf2[ch]);
   }
 
 #if RESAMPLE_PERF
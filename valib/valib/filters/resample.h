@@ -2,6 +2,7 @@
 #define VALIB_RESAMPLE_H
 
 #include "../filter.h"
+#include "../dsp/fft.h"
 #if RESAMPLE_PERF
 #include "../win32\cpu.h"
 #endif
@@ -37,8 +38,7 @@ protected:
   sample_t *f2;     // filter [n2b]
 
   // fft
-  int      *fft_ip;
-  sample_t *fft_w;
+  MM_FFT fft;
 
   // processing
   int pos_l, pos_m;            // stage1 convolution positions [0..l1), [0..m1)
@@ -81,6 +81,9 @@ StreamBuffer::StreamBuffer()
   new_stream = false;
 
   frames = 0;
+
+  zero_copy = false;
+  ext_frame = false;
 }
 
 StreamBuffer::StreamBuffer(const HeaderParser *_parser)
@@ -109,6 +112,9 @@ StreamBuffer::StreamBuffer(const HeaderParser *_parser)
 
   frames = 0;
 
+  zero_copy = false;
+  ext_frame = false;
+
   set_parser(_parser);
 }
 
@@ -171,6 +177,7 @@ StreamBuffer::reset()
 
   in_sync = false;
   new_stream = false;
+  ext_frame = false;
 }
 
 bool
@@ -411,13 +418,22 @@ StreamBuffer::load(uint8_t **data, uint8_t *end)
 
   if (is_frame_loaded())
   {
-    DROP(debris_size + frame_size);
+    if (!ext_frame)
+      DROP(debris_size + frame_size);
     debris_size = 0;
     frame_size = 0;
+    ext_frame = false;
   }
 
   new_stream = false;
 
+  /////////////////////////////////////////////////////////////////////////////
+  // Load next frame without copying if it is possible
+
+  if (zero_copy && sync_data == 0)
+    if (load_ext(data, end))
+      return true;
+
   /////////////////////////////////////////////////////////////////////////////
   // Load next frame
 
@@ -477,6 +493,58 @@ StreamBuffer::load(uint8_t **data, uint8_t *end)
   return sync(data, end);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Zero-copy version of the frame loading in load(). Same algorithm, but the
+// frame is searched directly at the input data. Returns false without data
+// consumed when the frame is not entirely in the input buffer (or not found
+// at all), so load() can continue with the copying version.
+
+bool
+StreamBuffer::load_ext(uint8_t **data, uint8_t *end)
+{
+  uint8_t *frame_pos = *data;
+  uint8_t *frame_max = *data;
+
+  if (hinfo.frame_size)
+    if (hinfo.frame_size < hinfo.scan_size)
+      frame_max += hinfo.scan_size - hinfo.frame_size;
+
+  while (frame_pos <= frame_max && frame_pos + header_size <= end)
+  {
+    HeaderInfo new_hinfo;
+    if (!parser->compare_headers(header_buf, frame_pos) || !parser->parse_header(frame_pos, &new_hinfo))
+    {
+      frame_pos++;
+      continue;
+    }
+
+    size_t load_size = new_hinfo.frame_size? new_hinfo.frame_size: frame_interval;
+    if (size_t(end - frame_pos) < load_size)
+      return false;
+
+    if (hinfo.frame_size)
+      frame_interval = hinfo.frame_size + frame_pos - *data;
+
+    memcpy(header_buf, frame_pos, header_size);
+    parser->parse_header(header_buf, &hinfo);
+
+    debris = *data;
+    debris_size = frame_pos - *data;
+
+    frame = frame_pos;
+    if (hinfo.frame_size)
+      frame_size = hinfo.frame_size;
+    else
+      frame_size = frame_interval;
+
+    *data = frame + frame_size;
+    ext_frame = true;
+    frames++;
+    return true;
+  }
+  return false;
+}
+
 bool 
 StreamBuffer::load_frame(uint8_t **data, uint8_t *end)
 {
@@ -492,9 +560,11 @@ StreamBuffer::load_frame(uint8_t **data, uint8_t *end)
 bool
 StreamBuffer::flush()
 {
-  DROP(debris_size + frame_size);
+  if (!ext_frame)
+    DROP(debris_size + frame_size);
   debris_size = 0;
   frame_size = 0;
+  ext_frame = false;
 
   in_sync = false;
   new_stream = false;
@@ -444,6 +444,20 @@ public:
 // recommended to demux SPDIF stream before working with the contained stream.
 // We can demux SPDIF stream correctly because SPDIF header contains real
 // frame size of the contained stream.
+//
+// Zero-copy mode
+// ==============
+//
+// Normally all data goes through the sync buffer: frames are copied into it
+// and moved to the start of the buffer when the previous frame is dropped.
+// In zero-copy mode (set_zero_copy()) a frame that lies entirely in the input
+// buffer is returned as a pointer into the input data. Only the frames that
+// straddle the end of the input buffer (and frames loaded at sync) are copied.
+// The result of loading is the same in both modes.
+//
+// In this mode the caller must keep the input data valid (and writable, for
+// in-place frame processing) until the next load() call. Frames and debris
+// may point into the input data.
 
 class StreamBuffer
 {
@@ -487,9 +501,13 @@ protected:
   bool new_stream;               // frame loaded belongs to a new stream
   int  frames;                   // number of frames loaded
 
+  bool zero_copy;                // load frames directly from the input data
+  bool ext_frame;                // frame loaded points to the input data
+
   inline bool load_buffer(uint8_t **data, uint8_t *end, size_t required_size);
   inline void drop_buffer(size_t size);
   bool sync(uint8_t **data, uint8_t *data_end);
+  bool load_ext(uint8_t **data, uint8_t *end);
 
 public:
   StreamBuffer();
@@ -503,6 +521,9 @@ public:
   const HeaderParser *get_parser() const { return parser; }
   void release_parser();
 
+  void set_zero_copy(bool _zero_copy) { zero_copy = _zero_copy; }
+  bool get_zero_copy() const          { return zero_copy;       }
+
   /////////////////////////////////////////////////////////
   // Processing
 
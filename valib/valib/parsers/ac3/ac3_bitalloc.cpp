@@ -1,8 +1,18 @@
 // Reference bit allocation
 // as it described in standard
+//
+// BitAlloc splits it into masking curve and bap parts and caches both
+// (see ac3_bitalloc.h). bap part has SSSE3 kernel.
 
+#include <string.h>
+#include "../../simd.h"
 #include "ac3_bitalloc.h"
 
+#ifdef VALIB_SIMD_X86
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#endif
+
 #define DELTA_BIT_REUSE    0
 #define DELTA_BIT_NEW      1
 #define DELTA_BIT_NONE     2
@@ -21,25 +31,25 @@ extern const uint8_t bndtab[51];
 extern const uint8_t bndsz[50];
 extern const uint8_t baptab[64];
 
-void bit_alloc(
-  int8_t *bap,    // [256]
-  int8_t *exp,    // [256]
+///////////////////////////////////////////////////////////////////////////////
+// Steps 1-5: PSD and masking curve (does not depend on SNR offset and floor)
+
+static void ba_mask(
+  int16_t *psd,   // [256] out
+  int *mask,      // [50] out
+  const int8_t *exp,
   int deltbae,
-  int8_t *deltba, // [50]
+  const int8_t *deltba,
   int start, int end, 
   int fscod, int halfratecod,
   int sdecay, int fdecay, 
   int sgain, int fgain, 
-  int dbknee, int floor, 
-  int fastleak, int slowleak, 
-  int snroffset)
-
+  int dbknee,
+  int fastleak, int slowleak)
 {
   int bin, lastbin, i, j, k, begin, bndstrt, bndend, lowcomp;
-  int psd[256];   // PSD
   int bndpsd[50]; // integrated PSD
   int excite[50]; // excitation
-  int mask[50];   // masking value
 
   // Step 1: Exponent mapping into PSD
 
@@ -142,8 +152,31 @@ void bit_alloc(
   if (deltbae == DELTA_BIT_NEW || deltbae == DELTA_BIT_REUSE)
     for (i = 0; i < 50; i++)
       mask[i] += deltba[i];
+}
 
-  // Step 6: Compute bit allocation
+///////////////////////////////////////////////////////////////////////////////
+// Step 6: bit allocation pointers
+
+static inline int snr_mask(int mask, int floor, int snroffset)
+{
+  mask -= snroffset;
+
+  mask -= floor;
+  if (mask < 0)
+    mask = 0;
+
+  mask &= 0x1fe0; // 0001 1111 1110 0000
+  mask += floor;
+  return mask;
+}
+
+static void ba_bap(
+  int8_t *bap,
+  const int16_t *psd, const int *mask,
+  int start, int end,
+  int floor, int snroffset)
+{
+  int i, j, k, lastbin;
 
   i = start;
   j = masktab[start];
@@ -151,18 +184,11 @@ void bit_alloc(
   do
   {
     lastbin = min(bndtab[j] + bndsz[j], end);
-    mask[j] -= snroffset;
-
-    mask[j] -= floor;
-    if (mask[j] < 0)
-      mask[j] = 0;
-
-    mask[j] &= 0x1fe0; // 0001 1111 1110 0000
-    mask[j] += floor;
+    int m = snr_mask(mask[j], floor, snroffset);
 
     for (k = i; k < lastbin; k++)
     {
-      int address = (psd[i] - mask[j]) >> 5;
+      int address = (psd[i] - m) >> 5;
       address = min(63, max(0, address));
       bap[i] = baptab[address];
       i++;
@@ -170,19 +196,190 @@ void bit_alloc(
     j++;
   }
   while (end > lastbin);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Reference bit allocation
+
+void bit_alloc(
+  int8_t *bap,    // [256]
+  int8_t *exp,    // [256]
+  int deltbae,
+  int8_t *deltba, // [50]
+  int start, int end, 
+  int fscod, int halfratecod,
+  int sdecay, int fdecay, 
+  int sgain, int fgain, 
+  int dbknee, int floor, 
+  int fastleak, int slowleak, 
+  int snroffset)
+{
+  int16_t psd[256];
+  int mask[50];
+  ba_mask(psd, mask, exp, deltbae, deltba, start, end, fscod, halfratecod,
+    sdecay, fdecay, sgain, fgain, dbknee, fastleak, slowleak);
+  ba_bap(bap, psd, mask, start, end, floor, snroffset);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// SSSE3 bap kernel
+// Mask of each band is spread over its bins, 16 bins are done at once:
+// address = (psd - mask) >> 5 is computed in 16 bits and saturated to
+// 0..255 with packus, then limited by 63. baptab[address] is looked up with
+// pshufb from 4 parts of the table (16 entries each).
+
+#ifdef VALIB_SIMD_X86
+static SIMD_TARGET_SSSE3 void ba_bap_ssse3(
+  int8_t *bap,
+  const int16_t *psd, const int *mask,
+  int start, int end,
+  int floor, int snroffset)
+{
+  int i, j, lastbin;
+  int16_t binmask[256 + 8];
+
+  // Bands of 8 bins and more are filled with vectors, the tail is
+  // overwritten by the next band.
+  i = start;
+  j = masktab[start];
+  do
+  {
+    lastbin = min(bndtab[j] + bndsz[j], end);
+    int16_t m = (int16_t)snr_mask(mask[j], floor, snroffset);
+    if (lastbin - i >= 8)
+    {
+      __m128i vm = _mm_set1_epi16(m);
+      for (; i < lastbin; i += 8)
+        _mm_storeu_si128((__m128i *)(binmask + i), vm);
+    }
+    else
+      while (i < lastbin)
+        binmask[i++] = m;
+    i = lastbin;
+    j++;
+  }
+  while (end > lastbin);
+
+  const __m128i tbl0 = _mm_loadu_si128((const __m128i *)(baptab + 0));
+  const __m128i tbl1 = _mm_loadu_si128((const __m128i *)(baptab + 16));
+  const __m128i tbl2 = _mm_loadu_si128((const __m128i *)(baptab + 32));
+  const __m128i tbl3 = _mm_loadu_si128((const __m128i *)(baptab + 48));
+  const __m128i max_address = _mm_set1_epi8(63);
+  const __m128i lo_mask = _mm_set1_epi8(15);
+  const __m128i hi_mask = _mm_set1_epi8(3);
+
+  for (i = start; i + 16 <= end; i += 16)
+  {
+    __m128i d0 = _mm_sub_epi16(
+      _mm_loadu_si128((const __m128i *)(psd + i)),
+      _mm_loadu_si128((const __m128i *)(binmask + i)));
+    __m128i d1 = _mm_sub_epi16(
+      _mm_loadu_si128((const __m128i *)(psd + i + 8)),
+      _mm_loadu_si128((const __m128i *)(binmask + i + 8)));
+    __m128i address = _mm_min_epu8(
+      _mm_packus_epi16(_mm_srai_epi16(d0, 5), _mm_srai_epi16(d1, 5)),
+      max_address);
+
+    __m128i lo = _mm_and_si128(address, lo_mask);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(address, 4), hi_mask);
+    __m128i r;
+    r =                   _mm_and_si128(_mm_shuffle_epi8(tbl0, lo), _mm_cmpeq_epi8(hi, _mm_setzero_si128()));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(tbl1, lo), _mm_cmpeq_epi8(hi, _mm_set1_epi8(1))));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(tbl2, lo), _mm_cmpeq_epi8(hi, _mm_set1_epi8(2))));
+    r = _mm_or_si128(r, _mm_and_si128(_mm_shuffle_epi8(tbl3, lo), _mm_cmpeq_epi8(hi, hi_mask)));
+    _mm_storeu_si128((__m128i *)(bap + i), r);
+  }
+
+  for (; i < end; i++)
+  {
+    int address = (psd[i] - binmask[i]) >> 5;
+    address = min(63, max(0, address));
+    bap[i] = baptab[address];
+  }
+}
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// BitAlloc
+
+void
+BitAlloc::reset()
+{
+  mask_ok = false;
+  bap_ok = false;
+}
 
+bool
+BitAlloc::compute(
+  int8_t *bap,
+  const int8_t *exp,
+  int deltbae,
+  const int8_t *deltba,
+  int start, int end, 
+  int fscod, int halfratecod,
+  int sdecay, int fdecay, 
+  int sgain, int fgain, 
+  int dbknee, int floor, 
+  int fastleak, int slowleak, 
+  int snroffset)
+{
+  bool delta = deltbae == DELTA_BIT_NEW || deltbae == DELTA_BIT_REUSE;
+  const int new_params[mask_params] = 
+  {
+    start, end, fscod, halfratecod, sdecay, fdecay, sgain, fgain, dbknee,
+    fastleak, slowleak, delta
+  };
+
+  // Masking curve
+  if (!mask_ok ||
+      memcmp(params, new_params, sizeof(params)) ||
+      memcmp(last_exp + start, exp + start, end - start) ||
+      (delta && memcmp(last_deltba, deltba, sizeof(last_deltba))))
+  {
+    memcpy(params, new_params, sizeof(params));
+    memcpy(last_exp + start, exp + start, end - start);
+    if (delta)
+      memcpy(last_deltba, deltba, sizeof(last_deltba));
+
+    ba_mask(psd, mask, exp, deltbae, deltba, start, end, fscod, halfratecod,
+      sdecay, fdecay, sgain, fgain, dbknee, fastleak, slowleak);
+    mask_ok = true;
+    bap_ok = false;
+  }
+
+  // Bit allocation pointers
+  if (bap_ok && last_floor == floor && last_snroffset == snroffset)
+    return false;
+
+  compute_bap(bap, floor, snroffset);
+  last_floor = floor;
+  last_snroffset = snroffset;
+  bap_ok = true;
+  return true;
+}
+
+void
+BitAlloc::compute_bap(int8_t *bap, int floor, int snroffset) const
+{
+  int start = params[0];
+  int end   = params[1];
+#ifdef VALIB_SIMD_X86
+  if (simd_caps() & SIMD_SSSE3)
+  {
+    ba_bap_ssse3(bap, psd, mask, start, end, floor, snroffset);
+    return;
+  }
+#endif
+  ba_bap(bap, psd, mask, start, end, floor, snroffset);
 }
 
 
 inline int logadd(int a, int b)
 {
+  // max(a, b) instead of a branch on sign of c: the branch is not predictable
   int c = a - b;
   int address = min((abs(c) >> 1), 255);
-  if (c >= 0)
-    return a + latab[address];
-  else
-    return b + latab[address];
-
+  return max(a, b) + latab[address];
 }
 
 inline int calc_lowcomp(int a, int b0, int b1, int bin)
@@ -1,5 +1,29 @@
 /*
   AC3 bit allocation
+
+  bit_alloc()
+    Reference bit allocation as it described in standard. Computes bap
+    for bins [start, end).
+
+  BitAlloc
+    The same bit allocation done incrementally. It is split into 2 parts:
+    * masking curve: PSD, PSD integration, excitation, masking curve and
+      delta bit allocation (steps 1-5 of the standard);
+    * bap: SNR offset, floor and bap table lookup (step 6).
+    Each part keeps its inputs and is recomputed only when they change
+    (exponents and delta bit allocation are compared with the copies of the
+    last ones). Exponent reuse and repeated bit allocation parameters are
+    common, so most calls do nothing.
+
+    compute() has the same parameters as bit_alloc(). bap must be the same
+    array every time: it is not touched when nothing has changed. Returns
+    true when bap was recomputed.
+
+    compute_bap() computes bap for another SNR offset with the current
+    masking curve (no caching), e.g. for an SNR offset search.
+
+    reset() drops cached state (must be called when bap array is
+    modified by someone else).
 */
 
 #ifndef VALIB_AC3_BITALLOC_H
@@ -20,6 +44,45 @@ void bit_alloc(
   int fastleak, int slowleak, 
   int snroffset);
 
+class BitAlloc
+{
+protected:
+  enum { mask_params = 12 };
+
+  // Masking curve and its inputs
+  bool    mask_ok;
+  int     params[mask_params]; // start, end, fscod, halfratecod, sdecay, fdecay,
+                               // sgain, fgain, dbknee, fastleak, slowleak, delta
+  int8_t  last_exp[256];
+  int8_t  last_deltba[50];
+  int16_t psd[256];
+  int     mask[50];
+
+  // Inputs of the last bap
+  bool    bap_ok;
+  int     last_floor;
+  int     last_snroffset;
+
+public:
+  BitAlloc() { reset(); }
+  void reset();
+
+  bool compute(
+    int8_t *bap,          // [256]
+    const int8_t *exp,    // [256]
+    int deltbae,
+    const int8_t *deltba, // [50]
+    int start, int end, 
+    int fscod, int halfratecod,
+    int sdecay, int fdecay, 
+    int sgain, int fgain, 
+    int dbknee, int floor, 
+    int fastleak, int slowleak, 
+    int snroffset);
+
+  void compute_bap(int8_t *bap, int floor, int snroffset) const;
+};
+
 class BAP_BitCount
 {
 protected:
@@ -3,7 +3,10 @@
 
 #include "../../defs.h"
 
-inline int16_t dither_gen()
+// Dither generator. LFSR state is kept by the caller, so each decoder
+// instance has its own sequence.
+
+inline int16_t dither_gen(uint16_t &lfsr_state)
 {
   static const uint16_t dither_lut[256] = {
       0x0000, 0xa011, 0xe033, 0x4022, 0x6077, 0xc066, 0x8044, 0x2055,
@@ -40,7 +43,6 @@ inline int16_t dither_gen()
       0x8bf4, 0x2be5, 0x6bc7, 0xcbd6, 0xeb83, 0x4b92, 0x0bb0, 0xaba1
   };
 
-  static uint16_t lfsr_state = 1;
   int16_t state;
 
   state = dither_lut[lfsr_state >> 8] ^ (lfsr_state << 8);
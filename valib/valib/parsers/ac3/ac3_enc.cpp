@@ -1,9 +1,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include "../../crc.h"
+#include "../../simd.h"
 #include "ac3_bitalloc.h"
 #include "ac3_enc.h"
 
+#ifdef VALIB_SIMD_X86
+#include <emmintrin.h>
+#endif
+
 
 
 #define EXP_REUSE 0
@@ -27,7 +32,6 @@
 
 #define min(a, b) ((a) < (b)? (a): (b))
 #define max(a, b) ((a) > (b)? (a): (b))
-inline int bits_left(int32_t v);
 inline unsigned int mul_poly(unsigned int a, unsigned int b, unsigned int poly);
 inline unsigned int pow_poly(unsigned int a, unsigned int n, unsigned int poly);
 
@@ -90,18 +94,172 @@ const uint16_t floor_tbl[8]  = { 0x02f0, 0x02b0, 0x0270, 0x0230, 0x01f0, 0x0170,
 const uint16_t fgain_tbl[8]  = { 0x0080, 0x0100, 0x0180, 0x0200, 0x0280, 0x0300, 0x0380, 0x0400 };
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Exponents and mantissas
+//
+// Exponent of a coefficient c is -1 - floor(log2(|c|)) limited to [0; 24]
+// (24 for zero). It is taken from the binary exponent of c converted to
+// float, so scalar and SIMD code give the same result.
+//
+// Mantissa is c * 2^exp in Q15 (rounded down and limited to 16 bits, as
+// sym_quant() and asym_quant() expect).
+
+typedef void (*compute_exp_t)(int8_t *exp, const sample_t *coef, int n);
+
+static void compute_exp_scalar(int8_t *exp, const sample_t *coef, int n)
+{
+  for (int s = 0; s < n; s++)
+  {
+    float f = float(coef[s]);
+    uint32_t i;
+    memcpy(&i, &f, sizeof(i));
+    int e = 126 - int((i >> 23) & 0xff);
+    exp[s] = int8_t(e < 0? 0: (e > 24? 24: e));
+  }
+}
+
+#ifdef VALIB_SIMD_X86
+static inline __m128i exp_epi32(const sample_t *p)
+{
+#ifdef FLOAT_SAMPLE
+  __m128 f = _mm_loadu_ps(p);
+#else
+  __m128 f = _mm_movelh_ps(_mm_cvtpd_ps(_mm_loadu_pd(p)), _mm_cvtpd_ps(_mm_loadu_pd(p + 2)));
+#endif
+  __m128i e = _mm_and_si128(_mm_srli_epi32(_mm_castps_si128(f), 23), _mm_set1_epi32(0xff));
+  return _mm_sub_epi32(_mm_set1_epi32(126), e);
+}
+
+// n must be a multiple of 8
+static void compute_exp_sse2(int8_t *exp, const sample_t *coef, int n)
+{
+  const __m128i exp_min = _mm_setzero_si128();
+  const __m128i exp_max = _mm_set1_epi16(24);
+  for (int s = 0; s < n; s += 8)
+  {
+    __m128i e = _mm_packs_epi32(exp_epi32(coef + s), exp_epi32(coef + s + 4));
+    e = _mm_min_epi16(_mm_max_epi16(e, exp_min), exp_max);
+    _mm_storel_epi64((__m128i *)(exp + s), _mm_packs_epi16(e, e));
+  }
+}
+#endif
+
+// Mantissa quantization by bap: stream of codes (0 - ungrouped, 1, 2, 3 -
+// groups of bap 1, 2 and 4), number of levels for symmetric quantization,
+// number of bits for asymmetric quantization and size of ungrouped code.
+static const int quant_class[16]  = { 0, 1, 2, 0, 3,  0, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0 };
+static const int quant_levels[16] = { 0, 3, 5, 7, 11, 15, 0, 0, 0, 0, 0,  0,  0,  0,  0,  0 };
+static const int quant_abits[16]  = { 0, 0, 0, 0, 0,  0, 5, 6, 7, 8, 9, 10, 11, 12, 14, 16 };
+static const int quant_bits[16]   = { 0, 0, 0, 3, 0,  4, 5, 6, 7, 8, 9, 10, 11, 12, 14, 16 };
+
+// Exponent strategy helpers: sum of absolute differences of 2 exponent
+// sets and minimum of 2 exponent sets (exponents are in [0; 24]).
+
+typedef int  (*exp_diff_t)(const int8_t *exp1, const int8_t *exp2, int n);
+typedef void (*exp_min_t)(int8_t *exp1, const int8_t *exp2, int n);
+
+static int exp_diff_scalar(const int8_t *exp1, const int8_t *exp2, int n)
+{
+  int diff = 0;
+  for (int s = 0; s < n; s++)
+    diff += abs(exp1[s] - exp2[s]);
+  return diff;
+}
+
+static void exp_min_scalar(int8_t *exp1, const int8_t *exp2, int n)
+{
+  for (int s = 0; s < n; s++)
+    if (exp1[s] > exp2[s])
+      exp1[s] = exp2[s];
+}
+
+#ifdef VALIB_SIMD_X86
+static int exp_diff_sse2(const int8_t *exp1, const int8_t *exp2, int n)
+{
+  int s;
+  __m128i sum = _mm_setzero_si128();
+  for (s = 0; s + 16 <= n; s += 16)
+    sum = _mm_add_epi64(sum, _mm_sad_epu8(
+      _mm_loadu_si128((const __m128i *)(exp1 + s)),
+      _mm_loadu_si128((const __m128i *)(exp2 + s))));
+
+  int diff = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+  for (; s < n; s++)
+    diff += abs(exp1[s] - exp2[s]);
+  return diff;
+}
+
+static void exp_min_sse2(int8_t *exp1, const int8_t *exp2, int n)
+{
+  int s;
+  for (s = 0; s + 16 <= n; s += 16)
+    _mm_storeu_si128((__m128i *)(exp1 + s), _mm_min_epu8(
+      _mm_loadu_si128((const __m128i *)(exp1 + s)),
+      _mm_loadu_si128((const __m128i *)(exp2 + s))));
+
+  for (; s < n; s++)
+    if (exp1[s] > exp2[s])
+      exp1[s] = exp2[s];
+}
+#endif
+
+static void compute_mant(int32_t *mant, const sample_t *coef, const int8_t *exp, int n)
+{
+  for (int s = 0; s < n; s++)
+  {
+    sample_t m = coef[s] * sample_t(1 << exp[s]) * 32768;
+    if (m < -32768) m = -32768;
+    if (m > 32767)  m = 32767;
+    mant[s] = int32_t(m + 32768) - 32768;
+  }
+}
+
+// Number of bits for mantissas of one block of one channel. Grouped
+// mantissas (bap 1, 2 and 4) are counted as if groups were not shared with
+// other channels, so it may be a bit more than the actual size.
+static int bap_bits(const int8_t *bap, int n)
+{
+  int cnt[16];
+  int s, bits;
+
+  memset(cnt, 0, sizeof(cnt));
+  for (s = 0; s < n; s++)
+    cnt[bap[s]]++;
+
+  bits  = 5 * ((cnt[1] + 2) / 3);  // 3-levels 3 values in 5 bits
+  bits += 7 * ((cnt[2] + 2) / 3);  // 5-levels 3 values in 7 bits
+  bits += 3 * cnt[3];
+  bits += 7 * ((cnt[4] + 1) / 2);  // 11-levels 2 values in 7 bits
+  bits += 4 * cnt[5];
+  for (s = 6; s < 14; s++)
+    bits += (s - 1) * cnt[s];
+  bits += 14 * cnt[14];
+  bits += 16 * cnt[15];
+  return bits;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
 AC3Enc::AC3Enc()
-:NullFilter(0), // use own query_input()
- mdct(7)
+:NullFilter(0) // use own query_input()
 {
   frames = 0;
   bitrate = 640000;
   frame_samples.allocate(AC3_NCHANNELS, AC3_FRAME_SAMPLES);
   frame_buf.allocate(AC3_MAX_FRAME_SIZE);
-  window.allocate(1, AC3_BLOCK_SAMPLES);
+  window.allocate(1, AC3_BLOCK_SAMPLES * 2);
+  coef.allocate(AC3_NCHANNELS, AC3_NBLOCKS * AC3_BLOCK_SAMPLES);
+  batch_enc = 0;
+  batch_nenc = 0;
   reset();
 }
 
+AC3Enc::~AC3Enc()
+{
+  if (batch_enc)
+    delete[] batch_enc;
+}
+
 int  
 AC3Enc::get_bitrate() const
 {
@@ -159,8 +317,9 @@ AC3Enc::reset()
   sample = 0;
 
   memset(delay, 0, sizeof(delay));
-  for (int ch = 0; ch < NCHANNELS; ch++)
-    delay_exp[ch] = 15; // indicate that we have 0 bits in delay array
+  for (int ch = 0; ch < AC3_NCHANNELS; ch++)
+    for (int b = 0; b < AC3_NBLOCKS; b++)
+      ba[ch][b].reset();
 
   // reset bit allocation
   sdcycod   = 2;
@@ -255,9 +414,12 @@ AC3Enc::set_input(Speakers _spk)
   nfchans = spk.lfe()? spk.nch() - 1: spk.nch();
 
   // scale window
-  sample_t factor = 32768.0 / spk.level;
+  sample_t factor = 1.0 / spk.level;
   for (int s = 0; s < AC3_BLOCK_SAMPLES; s++)
+  {
     window[0][s] = ac3_window[s] * factor;
+    window[0][AC3_BLOCK_SAMPLES * 2 - s - 1] = ac3_window[s] * factor;
+  }
 
   reset();
 
@@ -272,7 +434,7 @@ AC3Enc::get_chunk(Chunk *_chunk)
   if (fill_buffer())
   {
     // encode frame
-    if (!encode_frame())
+    if (!encode_frame(frame_samples, frame_buf))
       return false;
 
     // fill chunk
@@ -311,143 +473,245 @@ AC3Enc::get_output() const
 
 
 
-int 
-AC3Enc::encode_frame()
+///////////////////////////////////////////////////////////////////////////////
+// Batch encoding
+//
+// Frames depend on each other only with the delay buffer (the last block of
+// the previous frame, windowed) and the SNR offset search starts from the
+// offset of the previous frame (which does not change the result). So a run
+// of frames can be encoded with another encoder: it takes the delay from
+// the input frame before the run.
+
+struct AC3Enc::BatchJob
 {
-  // todo: support non-standart channel ordering given with spk
-  // todo: support for 24/32/float input sample formats
-  // todo: support coupling (basic encoder)
+  AC3Enc  *enc;
+  samples_t input;
+  size_t   nframes;
+  uint8_t *out;
+  size_t   done;     // number of frames encoded
+};
 
-  int ch, b, s; // channel, block, sample indexes
-  int endmant;
-  int nch = spk.nch();
+void
+AC3Enc::batch_proc(void *param, int job)
+{
+  BatchJob *j = (BatchJob *)param + job;
+  int frame_size = j->enc->get_frame_size();
+
+  samples_t input = j->input;
+  uint8_t *out = j->out;
+  for (j->done = 0; j->done < j->nframes; j->done++)
+  {
+    if (!j->enc->encode_frame(input, out))
+      break;
+    input += AC3_FRAME_SAMPLES;
+    out += frame_size;
+  }
+}
 
-  // frame-wide data
+void
+AC3Enc::set_delay(samples_t prev)
+{
+  const sample_t *wrise = window[0];
+  for (int ch = 0; ch < spk.nch(); ch++)
+  {
+    const sample_t *sptr = prev[ch] + AC3_FRAME_SAMPLES - AC3_BLOCK_SAMPLES;
+    for (int s = 0; s < AC3_BLOCK_SAMPLES; s++)
+      delay[ch][s] = sptr[s] * wrise[s];
+  }
+}
 
+size_t
+AC3Enc::encode_frames(samples_t input, size_t nframes, uint8_t *out)
+{
+  if (spk.format != FORMAT_LINEAR || sample || !is_empty())
+    return 0;
 
-  // channel-wide data
-  int exp_norm[AC3_NBLOCKS]; // normalization
+  int njobs = (int)MIN(nframes, (size_t)pool.get_threads());
+  if (njobs <= 1)
+  {
+    for (size_t i = 0; i < nframes; i++)
+    {
+      if (!encode_frame(input, out))
+        return i;
+      input += AC3_FRAME_SAMPLES;
+      out += frame_size;
+    }
+    return nframes;
+  }
 
-  // block-wide data
-  int16_t mdct_buf[AC3_BLOCK_SAMPLES * 2];
+  if (batch_nenc < njobs)
+  {
+    if (batch_enc)
+      delete[] batch_enc;
+    batch_nenc = 0;
+    batch_enc = new AC3Enc[njobs];
+    if (!batch_enc)
+      return 0;
+    batch_nenc = njobs;
+  }
 
-  for (ch = 0; ch < nch; ch++)
+  AutoBuf<BatchJob> jobs(njobs);
+  if (!jobs.is_allocated())
+    return 0;
+
+  size_t begin = 0;
+  for (int j = 0; j < njobs; j++)
   {
-    if (spk.lfe() && (ch == nfchans))
-      // lfe channel
-      endmant = 7;
-    else
+    BatchJob *job = jobs.data() + j;
+    AC3Enc *enc = batch_enc + j;
+    if (!enc->set_bitrate(bitrate) || !enc->set_input(spk))
+      return 0;
+
+    job->enc = enc;
+    job->input = input;
+    job->input += begin * AC3_FRAME_SAMPLES;
+    job->nframes = (nframes - begin) / (njobs - j);
+    job->out = out + begin * frame_size;
+    job->done = 0;
+
+    enc->csnroffst = csnroffst;
+    enc->fsnroffst = fsnroffst;
+    if (begin)
     {
-      // fbw channels
-      chbwcod[ch] = 50;
-      endmant = ((chbwcod[ch] + 12) * 3) + 37;
+      samples_t prev = input;
+      prev += (begin - 1) * AC3_FRAME_SAMPLES;
+      enc->set_delay(prev);
     }
-    nmant[ch] = endmant;
+    else
+      memcpy(enc->delay, delay, sizeof(delay));
 
-    /////////////////////////////////////////////////////////////////
-    // Compute exponents and mdct coeffitients
-    // for all blocks from input data
-    //
-    for (b = 0; b < AC3_NBLOCKS; b++)
+    begin += job->nframes;
+  }
+
+  pool.run(batch_proc, jobs.data(), njobs);
+
+  // Continue the stream after the last frame encoded
+  size_t done = 0;
+  for (int j = 0; j < njobs; j++)
+  {
+    done += jobs[j].done;
+    if (jobs[j].done)
     {
-      // todo: silence threshold at absolute level of 128
-      int exp_norm1 = 0;  // normalization for this block
-      int exp_norm2 = 0;  // normalization for next block delay
-
-      memcpy(mdct_buf, delay[ch], sizeof(delay[ch]));
-
-      ///////////////////////////////////////////////////////////////
-      // Form input for MDCT
-      //
-
-      sample_t v;
-      sample_t *sptr = frame_samples[ch];
-      sptr += b * AC3_BLOCK_SAMPLES;
-
-      // * copy samples from input buffer to mdct and delay 
-      // * apply ac3 window to both mdct and delay halves
-      // * compute the normalization for mdct (using 
-      //   delay normalization computed at previous block) 
-      //   and delay
-      // optimize: unroll cycle
-      for (s = 0; s < AC3_BLOCK_SAMPLES; s++)
-      {
-        v = *sptr++;
-        mdct_buf[s + 256] = int32_t(v * window[0][AC3_BLOCK_SAMPLES - s - 1]);
-        delay[ch][s] = int32_t(v * window[0][s]);
-        exp_norm1 |= abs(mdct_buf[s + 256]);
-        exp_norm2 |= abs(delay[ch][s]);
-      }
+      csnroffst = jobs[j].enc->csnroffst;
+      fsnroffst = jobs[j].enc->fsnroffst;
+    }
+    if (jobs[j].done < jobs[j].nframes)
+      break;
+  }
 
-      // compute normalization
-      exp_norm1 = 15 - bits_left(exp_norm1);
-      exp_norm2 = 15 - bits_left(exp_norm2);
-
-      exp_norm1     = min(exp_norm1, delay_exp[ch]);
-
-      exp_norm[b]   = exp_norm1;
-      delay_exp[ch] = exp_norm2;
-
-      // normalize
-      for (s = 0; s < AC3_BLOCK_SAMPLES * 2; s++)
-        mdct_buf[s] <<= exp_norm1;
-
-      // finished with input
-      // now we have normalized mdct_buf[] buffer
-      // and noramlization exponent 'exp'
-      ///////////////////////////////////////////////////////////////
-      
-      ///////////////////////////////////////////////////////////////
-      // MDCT and exponents computation
-      // todo: mdct 256/512 switch 
-
-      mdct.mdct512(mant[ch][b], mdct_buf);
-      
-      // compute exponents
-      // normalize mdct coeffitients
-      // we take into account the normalization
-      for (s = 0; s < AC3_BLOCK_SAMPLES; s++)
-      {
-        exp_norm2 = 15 - bits_left(abs(mant[ch][b][s]));
-        if (exp_norm2 == 15)
-          exp[ch][b][s] = 24;
-        else 
-        {
-          if (exp_norm1 + exp_norm2 > 24)
-          {
-            exp[ch][b][s] = 24;
-            mant[ch][b][s] >>= exp_norm1 + exp_norm2 - 24;  
-          }
-          else
-            exp[ch][b][s] = exp_norm1 + exp_norm2;
-        }
-      }
+  if (done)
+  {
+    samples_t prev = input;
+    prev += (done - 1) * AC3_FRAME_SAMPLES;
+    set_delay(prev);
+  }
+  frames += (int)done;
+  return done;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Frame encoding
+
+void
+AC3Enc::analyze_proc(void *param, int ch)
+{
+  ((AC3Enc *)param)->analyze(ch);
+}
 
-      // finished with MDCT and exponents
-      ///////////////////////////////////////////////////////////////
-    } // for (b = 0; b < AC3_NBLOCKS; b++)
+void
+AC3Enc::analyze(int ch)
+{
+  // Analysis of one channel of the frame: mdct coeffitients, exponents,
+  // mantissas and masking curves. Only data of the channel is changed.
 
+  int b, s; // block, sample indexes
+  int endmant;
 
-    compute_expstr(expstr[ch], exp[ch], endmant);
-    restrict_exp(expcod[ch], ngrps[ch], exp[ch], expstr[ch], endmant);
+  // block-wide data
+  sample_t mdct_buf[AC3_BLOCK_SAMPLES * 2];
+  const sample_t *wrise = window[0];
+  const sample_t *wfall = window[0] + AC3_BLOCK_SAMPLES;
+
+  compute_exp_t compute_exp = compute_exp_scalar;
+#ifdef VALIB_SIMD_X86
+  if (simd_caps() & SIMD_SSE2)
+    compute_exp = compute_exp_sse2;
+#endif
 
-    // normalize mdct coefs
-    int b1;
-    for (b = 0; b < AC3_NBLOCKS; b++)
+  if (spk.lfe() && (ch == nfchans))
+    // lfe channel
+    endmant = 7;
+  else
+  {
+    // fbw channels
+    chbwcod[ch] = 50;
+    endmant = ((chbwcod[ch] + 12) * 3) + 37;
+  }
+  nmant[ch] = endmant;
+
+  /////////////////////////////////////////////////////////////////
+  // Compute mdct coeffitients and exponents
+  // for all blocks from input data
+  //
+  for (b = 0; b < AC3_NBLOCKS; b++)
+  {
+    sample_t *sptr = frame_input[ch] + b * AC3_BLOCK_SAMPLES;
+    sample_t *cptr = coef[ch] + b * AC3_BLOCK_SAMPLES;
+
+    // mdct input is the delay (windowed previous block) and the
+    // current block windowed with the falling half of the window;
+    // the current block with the rising half is the next delay
+    memcpy(mdct_buf, delay[ch], sizeof(delay[ch]));
+    for (s = 0; s < AC3_BLOCK_SAMPLES; s++)
     {
-      if (expstr[ch][b] != EXP_REUSE)  b1 = b;
-      for (s = 0; s < endmant; s++)
-        // note: it is possible that exp[ch][b1][s] < exp_norm[b]
-        //       exponent may be decreased because of differential 
-        //       restricttions
-        if (exp[ch][b1][s] - exp_norm[b] >= 0)
-          mant[ch][b][s] <<= exp[ch][b1][s] - exp_norm[b];
-        else
-          mant[ch][b][s] >>= exp_norm[b] - exp[ch][b1][s];
+      mdct_buf[s + AC3_BLOCK_SAMPLES] = sptr[s] * wfall[s];
+      delay[ch][s] = sptr[s] * wrise[s];
     }
 
-  } // for (ch = 0; ch < nch; ch++)
+    // todo: mdct 256/512 switch 
+    mdct.mdct512(cptr, mdct_buf);
+    compute_exp(exp[ch][b], cptr, AC3_BLOCK_SAMPLES);
+  }
+
+  compute_expstr(expstr[ch], exp[ch], endmant);
+  restrict_exp(expcod[ch], ngrps[ch], exp[ch], expstr[ch], endmant);
+
+  // normalize mdct coefs with exponents as decoder will see them
+  // note: exponents may be decreased because of differential 
+  //       restrictions and reuse
+  for (b = 0; b < AC3_NBLOCKS; b++)
+    compute_mant(mant[ch][b], coef[ch] + b * AC3_BLOCK_SAMPLES, exp[ch][b], endmant);
+
+  // Masking curves. bap computed here is not used: bap is computed
+  // for each SNR offset tried by count_bits().
+  for (b = 0; b < AC3_NBLOCKS; b++)
+    if (expstr[ch][b] != EXP_REUSE)
+      ba[ch][b].compute(
+        bap[ch][b], exp[ch][b], 
+        DELTA_BIT_NONE, 0, 
+        0, nmant[ch], 
+        fscod, halfratecod, 
+        sdecay_tbl[sdcycod], fdecay_tbl[fdcycod], 
+        sgain_tbl[sgaincod], fgain_tbl[fgaincod], 
+        dbknee_tbl[dbpbcod], floor_tbl[floorcod], 
+        0, 0, 
+        0);
+}
+
+int 
+AC3Enc::encode_frame(samples_t input, uint8_t *frame)
+{
+  // todo: support non-standart channel ordering given with spk
+  // todo: support for 24/32/float input sample formats
+  // todo: support coupling (basic encoder)
+
+  int ch, b, s; // channel, block, sample indexes
+  int nch = spk.nch();
 
+  // Channels are independent until bit allocation, so the analysis
+  // may be done by several threads (see set_threads()).
+  frame_input = input;
+  pool.run(analyze_proc, this, nch);
 
   // now we have computed exponents at exp[ch][b][s]
   // and mantissas at mant[ch][b][s]
@@ -506,129 +770,23 @@ AC3Enc::encode_frame()
   ///////////////////////////////////////////////////////////////////
   // Bit allocation
 
-  int sdecay    = sdecay_tbl[sdcycod];
-  int fdecay    = fdecay_tbl[fdcycod];
-  int sgain     = sgain_tbl[sgaincod];
-  int dbknee    = dbknee_tbl[dbpbcod];
-  int floor     = floor_tbl[floorcod];
-  int fgain     = fgain_tbl[fgaincod];
+  // Masking curves are computed by analyze()
 
-  const int snroffset_max = (((63 - 15) << 4) + 15) << 2;
-  const int snroffset_min = (((0 - 15) << 4) + 0) << 2;
+  // Search starts from the offset of the previous frame
   int snroffset = (((csnroffst - 15) << 4) + fsnroffst) << 2;
-  int ba_bits;
-  int ba_block;
-  int high, low; // bisection bounds
-
-  BAP_BitCount block_bits;
-  ba_bits = 0;
-  ba_block = 0;
-
-  for (ch = 0; ch < nch; ch++)
-    for (b = 0; b < AC3_NBLOCKS; b++)
-      if (expstr[ch][b] != EXP_REUSE)
-      {
-        bit_alloc(
-          bap[ch][b], exp[ch][b], 
-          DELTA_BIT_NONE, 0, 
-          0, nmant[ch], 
-          fscod, halfratecod, 
-          sdecay, fdecay, 
-          sgain, fgain, 
-          dbknee, floor, 
-          0, 0, 
-          snroffset);
-        block_bits.reset();
-        block_bits.add_bap(bap[ch][b], 0, nmant[ch]);
-        ba_bits += block_bits.bits;
-        ba_block = b;
-      }
-      else
-      {
-        memcpy(bap[ch][b], bap[ch][ba_block], sizeof(bap[0][0][0]) * nmant[ch]);
-        ba_bits += block_bits.bits;
-      }
-
-  // bisection init
-  if (ba_bits > bits_left)
-  {
-    high = snroffset;
-    low = snroffset_min;
-  }
-  else
-  {
-    high = snroffset_max;
-    low = snroffset;
-  }
-
-  // bisection steps
-  while (high - low > 4)
-  {
-    snroffset = ((high + low) >> 1) & ~3;
-
-    ba_bits = 0;
-    for (ch = 0; ch < nch; ch++)
-      for (b = 0; b < AC3_NBLOCKS; b++)
-        if (expstr[ch][b] != EXP_REUSE)
-        {
-          bit_alloc(
-            bap[ch][b], exp[ch][b], 
-            DELTA_BIT_NONE, 0, 
-            0, nmant[ch], 
-            fscod, halfratecod, 
-            sdecay, fdecay, 
-            sgain, fgain, 
-            dbknee, floor, 
-            0, 0, 
-            snroffset);
-          block_bits.reset();
-          block_bits.add_bap(bap[ch][b], 0, nmant[ch]);
-          ba_bits += block_bits.bits;
-          ba_block = b;
-        }
-        else
-        {
-          memcpy(bap[ch][b], bap[ch][ba_block], sizeof(bap[0][0][0]) * nmant[ch]);
-          ba_bits += block_bits.bits;
-        }
-
-    if (ba_bits > bits_left)
-      high = snroffset;
-    else
-      low = snroffset;
-  }
+  snroffset = find_snroffset(snroffset, bits_left);
+  if (count_bits(snroffset) > bits_left)
+    // some error happen!!!
+    return 0;
 
-  // do bit allocation
-  snroffset = low & ~3; // clear 2 last bits
-  ba_bits = 0;
+  // bap for reused exponents
+  int ba_block = 0;
   for (ch = 0; ch < nch; ch++)
     for (b = 0; b < AC3_NBLOCKS; b++)
       if (expstr[ch][b] != EXP_REUSE)
-      {
-        bit_alloc(
-          bap[ch][b], exp[ch][b], 
-          DELTA_BIT_NONE, 0, 
-          0, nmant[ch], 
-          fscod, halfratecod, 
-          sdecay, fdecay, 
-          sgain, fgain, 
-          dbknee, floor, 
-          0, 0, 
-          snroffset);
-        block_bits.reset();
-        block_bits.add_bap(bap[ch][b], 0, nmant[ch]);
-        ba_bits += block_bits.bits;
         ba_block = b;
-      }
       else
-      {
         memcpy(bap[ch][b], bap[ch][ba_block], sizeof(bap[0][0][0]) * nmant[ch]);
-        ba_bits += block_bits.bits;
-      }
-
-  if (ba_bits > bits_left)
-    // some error happen!!!
-    return 0;
 
   //  snroffset = (((csnroffst - 15) << 4) + fsnroffst) << 2;
   csnroffst = (snroffset >> 6) + 15;
@@ -644,8 +802,8 @@ AC3Enc::encode_frame()
   ///////////////////////////////////////////////////////////////////
   // Output everything
 
-  memset(frame_buf, 0, frame_size);
-  bs.set(frame_buf, 0, frame_size * 8);
+  memset(frame, 0, frame_size);
+  bs.set(frame, 0, frame_size * 8);
 
   ///////////////////////////////////////////////////////////////////
   // BSI
@@ -685,6 +843,10 @@ AC3Enc::encode_frame()
   ///////////////////////////////////////////////////////////////////
   // Audio blocks
 
+  // mantissa codes and sizes of code streams (see below)
+  uint16_t qcode[4][AC3_NCHANNELS * AC3_BLOCK_SAMPLES + 2];
+  uint8_t  qsize[4][AC3_NCHANNELS * AC3_BLOCK_SAMPLES + 2];
+
   for (b = 0; b < AC3_NBLOCKS; b++)
   {
     for (ch = 0; ch < nfchans; ch++)
@@ -772,145 +934,88 @@ AC3Enc::encode_frame()
     bs.put_bool(false);                // 'skiple'
 
     // mantissas
+    // Mantissas are quantized to codes of 4 streams: ungrouped mantissas
+    // and 3 group streams (bap 1, 2 and 4), grouped across channels in
+    // the order of transmission. A group is written at the place of its
+    // first mantissa, other mantissas of the group have zero code and size
+    // (incomplete groups are padded with zeros). This is done without
+    // branches on bap, which is unpredictable.
+
+    int k, i, n[4] = { 0, 0, 0, 0 };
+    for (ch = 0; ch < nch; ch++)
+      for (s = 0; s < nmant[ch]; s++)
+      {
+        int q = bap[ch][b][s];
+        int m = mant[ch][b][s];
+        int abits = quant_abits[q];
+        int v = (((m + 32768) * quant_levels[q]) >> 16)  // sym_quant()
+              + ((m >> (16 - abits)) & ((1 << abits) - 1)); // asym_quant()
+
+        k = quant_class[q];
+        qcode[k][n[k]] = v;
+        qsize[k][n[k]] = quant_bits[q];
+        n[k]++;
+      }
 
-#ifdef _DEBUG
-  int bits0 = 0;
-  int bits1 = 0;
-  int bits2 = 0;
-  int bits4 = 0;
-#define COUNT_BITS(id, n) { bits##id += n; }
-#else 
-#define COUNT_BITS(id, n)
-#endif
+    for (k = 1; k < 4; k++)
+      qcode[k][n[k]] = qcode[k][n[k] + 1] = 0;
 
-    int qs1 = 0; int qch1 = 0;
-    int qs2 = 0; int qch2 = 0;
-    int qs4 = 0; int qch4 = 0;
-    int v;
+    // 5 bits 3 groups 3 q-levels
+    for (i = 0; i < n[1]; i += 3)
+    {
+      qcode[1][i] = 9 * qcode[1][i] + 3 * qcode[1][i + 1] + qcode[1][i + 2];
+      qcode[1][i + 1] = qcode[1][i + 2] = 0;
+      qsize[1][i] = 5;
+    }
+    // 7 bits 3 groups 5 q-levels
+    for (i = 0; i < n[2]; i += 3)
+    {
+      qcode[2][i] = 25 * qcode[2][i] + 5 * qcode[2][i + 1] + qcode[2][i + 2];
+      qcode[2][i + 1] = qcode[2][i + 2] = 0;
+      qsize[2][i] = 7;
+    }
+    // 7 bits 2 groups 11 q-levels
+    for (i = 0; i < n[3]; i += 2)
+    {
+      qcode[3][i] = 11 * qcode[3][i] + qcode[3][i + 1];
+      qcode[3][i + 1] = 0;
+      qsize[3][i] = 7;
+    }
 
+    // output codes in the order of mantissas
+    uint64_t acc = 0;
+    int acc_bits = 0;
+    n[0] = n[1] = n[2] = n[3] = 0;
     for (ch = 0; ch < nch; ch++)
       for (s = 0; s < nmant[ch]; s++)
-        #define GROUP_NEXT(q, value, levels, mul)                        \
-          while (qch##q < nch)                                           \
-          {                                                              \
-            while (qs##q < nmant[qch##q] && bap[qch##q][b][qs##q] != q) qs##q++;   \
-            if (qs##q < nmant[qch##q]) break;                            \
-            qs##q = 0;                                                   \
-            qch##q++;                                                    \
-          }                                                              \
-          if (qs##q < nmant[qch##q] && qch##q < nch)                     \
-          {                                                              \
-            value += mul * sym_quant(mant[qch##q][b][qs##q], levels);    \
-            qs##q++;                                                     \
-          }
-
-        switch (bap[ch][b][s])
+      {
+        k = quant_class[bap[ch][b][s]];
+        i = n[k]++;
+        acc = (acc << qsize[k][i]) | qcode[k][i];
+        acc_bits += qsize[k][i];
+        if (acc_bits >= 32)
         {
-          case 0: break;
-
-          case 1: 
-            // 5 bits 3 groups 3 q-levels
-            if ((qch1 > ch) || (qch1 == ch && qs1 > s)) break;
-
-            v = 9 * sym_quant(mant[ch][b][s], 3);
-
-            // seek for next value to group
-            // we start seeking from current position
-            qch1 = ch;
-            qs1 = s + 1;
-            while (qch1 < nch)
-            {
-              while (qs1 < nmant[qch1] && bap[qch1][b][qs1] != 1) qs1++;
-              if (qs1 < nmant[qch1]) break; // found
-              qs1 = 0;
-              qch1++;
-            }
-
-            // group value if found
-            if (qs1 < nmant[qch1] && qch1 < nch)
-            {
-              v += 3 * sym_quant(mant[qch1][b][qs1], 3);
-              qs1++;
-            }
-
-            // seek for next value to group
-            GROUP_NEXT(1, v, 3, 1)
-
-            bs.put(5, v);
-            COUNT_BITS(1, 5);
-            break;
-
-          case 2: 
-            // 7 bits 3 groups 5 q-levels
-            if ((qch2 > ch) || (qch2 == ch && qs2 > s)) break;
-            // note: ch >= qch2 && s >= qs2;
-
-            v = 25 * sym_quant(mant[ch][b][s], 5);
-
-            qch2 = ch;
-            qs2 = s + 1;
-            GROUP_NEXT(2, v, 5, 5);
-            GROUP_NEXT(2, v, 5, 1);
-
-            bs.put(7, v);
-            COUNT_BITS(2, 7);
-            break;
-
-          case 3:
-            bs.put(3, sym_quant(mant[ch][b][s], 7));
-            COUNT_BITS(0, 3);
-            break;
-
-          case 4: 
-            // 7 bits 2 groups 11 q-levels
-            if ((qch4 > ch) || (qch4 == ch && qs4 > s)) break;
-
-            v = 11 * sym_quant(mant[ch][b][s], 11);
-            qch4 = ch;
-            qs4 = s + 1;
-            GROUP_NEXT(4, v, 11, 1);
-
-            bs.put(7, v);
-            COUNT_BITS(4, 7);
-            break;
-
-          case 5:
-            bs.put(4, sym_quant(mant[ch][b][s], 15));
-            COUNT_BITS(0, 4);
-            break;
-
-          case 14:
-            bs.put(14, asym_quant(mant[ch][b][s], 14));
-            COUNT_BITS(0, 14);
-            break;
-
-          case 15:
-            bs.put(16, asym_quant(mant[ch][b][s], 16));
-            COUNT_BITS(0, 16);
-            break;
-
-          default:
-            bs.put(bap[ch][b][s] - 1, asym_quant(mant[ch][b][s], bap[ch][b][s] - 1));
-            COUNT_BITS(0, bap[ch][b][s] - 1);
-            break;      
-        } // switch (bap[s])
-      // for (s = 0; s < nmant[ch]; s++)    
-    // for (ch = 0; ch < nch; ch++)
+          acc_bits -= 32;
+          bs.put(32, uint32_t(acc >> acc_bits));
+        }
+      }
+    if (acc_bits)
+      bs.put(acc_bits, uint32_t(acc) & ((1u << acc_bits) - 1));
 
   } // for (b = 0; b < AC3_NBLOCKS; b++)
   bs.flush();
 
   // calc CRC
   int frame_size1 = ((frame_size >> 1) + (frame_size >> 3)) & ~1; // should be even
-  int crc = calc_crc(0, frame_buf + 4,  frame_size1 - 4);
+  int crc = calc_crc(0, frame + 4,  frame_size1 - 4);
   int crc_inv = pow_poly((CRC16_POLY >> 1), (frame_size1 * 8) - 16, CRC16_POLY);
   crc = mul_poly(crc_inv, crc, CRC16_POLY);
-  frame_buf[2] = crc >> 8;
-  frame_buf[3] = crc & 0xff;
+  frame[2] = crc >> 8;
+  frame[3] = crc & 0xff;
 
-  crc = calc_crc(0, frame_buf + frame_size1, frame_size - frame_size1 - 2);
-  frame_buf[frame_size - 2] = crc >> 8;
-  frame_buf[frame_size - 1] = crc & 0xff;
+  crc = calc_crc(0, frame + frame_size1, frame_size - frame_size1 - 2);
+  frame[frame_size - 2] = crc >> 8;
+  frame[frame_size - 1] = crc & 0xff;
 
 
   frames++;
@@ -918,22 +1023,108 @@ AC3Enc::encode_frame()
 }
 
 
+int
+AC3Enc::count_bits(int snroffset)
+{
+  // Computes bap for new exponents and returns the number of mantissa bits
+  // for the whole frame (reused exponents give the same number of bits).
+  int floor = floor_tbl[floorcod];
+  int bits = 0;
+  int ba_block = 0;
+
+  for (int ch = 0; ch < spk.nch(); ch++)
+    for (int b = 0; b < AC3_NBLOCKS; b++)
+    {
+      if (expstr[ch][b] != EXP_REUSE)
+      {
+        ba[ch][b].compute_bap(bap[ch][b], floor, snroffset);
+        ba_bits[ch][b] = bap_bits(bap[ch][b], nmant[ch]);
+        ba_block = b;
+      }
+      bits += ba_bits[ch][ba_block];
+    }
+
+  return bits;
+}
+
+int
+AC3Enc::find_snroffset(int snroffset, int bits_left)
+{
+  // Finds the maximum SNR offset that fits into bits_left (number of bits
+  // grows with the offset). Offsets are multiples of 4. Successive frames
+  // need close offsets, so we start with a small step from the given
+  // offset and double it until the answer is bracketed, then bisect.
+  // Returns snroffset_min when nothing fits.
+
+  const int snroffset_max = (((63 - 15) << 4) + 15) << 2;
+  const int snroffset_min = (((0 - 15) << 4) + 0) << 2;
+  int high, low; // low fits, high does not fit
+  int step = 16;
+
+  snroffset = max(snroffset_min, min(snroffset_max, snroffset));
+  if (count_bits(snroffset) <= bits_left)
+  {
+    low = snroffset;
+    high = snroffset_max + 4;
+    while (low < snroffset_max)
+    {
+      snroffset = min(low + step, snroffset_max);
+      if (count_bits(snroffset) > bits_left)
+      {
+        high = snroffset;
+        break;
+      }
+      low = snroffset;
+      step <<= 1;
+    }
+  }
+  else
+  {
+    high = snroffset;
+    low = snroffset_min;
+    while (high > snroffset_min)
+    {
+      snroffset = max(high - step, snroffset_min);
+      if (count_bits(snroffset) <= bits_left)
+      {
+        low = snroffset;
+        break;
+      }
+      high = snroffset;
+      step <<= 1;
+    }
+  }
+
+  // bisection steps
+  while (high - low > 4)
+  {
+    snroffset = ((high + low) >> 1) & ~3;
+    if (count_bits(snroffset) > bits_left)
+      high = snroffset;
+    else
+      low = snroffset;
+  }
+
+  return low;
+}
+
 inline void 
 AC3Enc::compute_expstr(int expstr[AC3_NBLOCKS], int8_t exp[AC3_NBLOCKS][AC3_BLOCK_SAMPLES], int endmant) const
 {
-  int b, b1, s;
-  int exp_diff;
+  int b, b1;
+
+  exp_diff_t exp_diff = exp_diff_scalar;
+#ifdef VALIB_SIMD_X86
+  if (simd_caps() & SIMD_SSE2)
+    exp_diff = exp_diff_sse2;
+#endif
 
   // compute variation of exponents over time and reuse 
   // old exponents if variation is too small
   expstr[0] = EXP_D15;
   for (b = 1; b < AC3_NBLOCKS; b++) 
   {
-    exp_diff = 0;
-    for (s = 0; s < endmant; s++)
-      exp_diff += abs(exp[b][s] - exp[b-1][s]);
-
-    if (exp_diff > EXP_DIFF_THRESHOLD)
+    if (exp_diff(exp[b], exp[b-1], endmant) > EXP_DIFF_THRESHOLD)
       expstr[b] = EXP_D15;
     else
       expstr[b] = EXP_REUSE;
@@ -972,16 +1163,20 @@ AC3Enc::compute_expstr(int expstr[AC3_NBLOCKS], int8_t exp[AC3_NBLOCKS][AC3_BLOC
 inline void 
 AC3Enc::restrict_exp(int8_t expcod[AC3_NBLOCKS][AC3_BLOCK_SAMPLES], int ngrps[AC3_NBLOCKS], int8_t exp[AC3_NBLOCKS][AC3_BLOCK_SAMPLES], int expstr[AC3_NBLOCKS], int endmant) const
 {
-  int s, b, b1;
+  int b, b1;
+
+  exp_min_t exp_min = exp_min_scalar;
+#ifdef VALIB_SIMD_X86
+  if (simd_caps() & SIMD_SSE2)
+    exp_min = exp_min_sse2;
+#endif
 
   b = 0;
   while (b < AC3_NBLOCKS) 
   {
     // Find minimum of reused exponents
     for (b1 = b + 1; b1 < AC3_NBLOCKS && expstr[b1] == EXP_REUSE; b1++)
-      for (s = 0; s < endmant; s++)
-        if (exp[b][s] > exp[b1][s])
-          exp[b][s] = exp[b1][s];
+      exp_min(exp[b], exp[b1], endmant);
 
     // compute encoded exponents
     // and update exponents as decoder will see them
@@ -1135,37 +1330,6 @@ AC3Enc::encode_exp(int8_t expcod[AC3_BLOCK_SAMPLES], int8_t exp[AC3_BLOCK_SAMPLE
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 
-#ifdef _M_IX86
-inline int bits_left(int32_t v)
-{
-  __asm {
-    mov ecx, v
-    shl ecx, 1
-    or  ecx, 1
-    bsr eax, ecx
-    mov v, eax
-  }
-  return v;
-}
-#else
-inline int bits_left(int32_t v)
-{
-  int n = 0;
-  if (v & 0xffff0000) { v >>= 16; n += 16; }
-  if (v & 0xff00)     { v >>= 8;  n += 8;  }
-  if (v & 0xf0)       { v >>= 4;  n += 4;  }
-  if (v & 0xc)        { v >>= 2;  n += 2;  }
-
-  if (v & 0x2)        { n += 2; }
-  else
-  if (v & 0x1)        { n++;  }
-  return n;
-}
-#endif
-
-
-
-
 inline unsigned int mul_poly(unsigned int a, unsigned int b, unsigned int poly)
 {
   unsigned int c;
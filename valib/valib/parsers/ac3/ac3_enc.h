@@ -4,8 +4,10 @@
 #include "../../filter.h"
 #include "../../bitstream.h"
 #include "../../buffer.h"
+#include "../../thread_pool.h"
 #include "ac3_defs.h"
 #include "ac3_mdct.h"
+#include "ac3_bitalloc.h"
 
 inline int sym_quant(int m, int levels);
 inline int asym_quant(int m, int bits);
@@ -17,7 +19,8 @@ public:
   size_t    sample;
   SampleBuf frame_samples;
   Rawdata   frame_buf;
-  SampleBuf window;
+  SampleBuf window;        // rising half and falling half
+  SampleBuf coef;          // mdct coeffitients [ch][blk * AC3_BLOCK_SAMPLES]
 
   // decoder mode
   int sample_rate;
@@ -28,6 +31,13 @@ public:
   MDCT mdct;
   WriteBS bs;
 
+  // threads
+  struct BatchJob;
+  ThreadPool pool;
+  samples_t  frame_input;              // input of the frame being encoded
+  AC3Enc    *batch_enc;                // encoders for batch jobs
+  int        batch_nenc;
+
   // stream-level data
   int  acmod;
   bool dolby;
@@ -49,10 +59,9 @@ public:
   int csnroffst;                       // 'csnroffst' - coarse SNR offset
   int fsnroffst;                       // 'fsnroffst' - fine SNR offset
 
-  int16_t  delay[AC3_NCHANNELS][AC3_BLOCK_SAMPLES]; // delay buffer (not normalized)
-  int      delay_exp[AC3_NCHANNELS];                // delay buffer normalization
-                                           
-  int32_t  mant[AC3_NCHANNELS][AC3_NBLOCKS][AC3_BLOCK_SAMPLES];    // mdct coeffitients
+  sample_t delay[AC3_NCHANNELS][AC3_BLOCK_SAMPLES]; // delay buffer (windowed)
+
+  int32_t  mant[AC3_NCHANNELS][AC3_NBLOCKS][AC3_BLOCK_SAMPLES];    // normalized mantissas
   int8_t   exp[AC3_NCHANNELS][AC3_NBLOCKS][AC3_BLOCK_SAMPLES];     // exponents
   int8_t   expcod[AC3_NCHANNELS][AC3_NBLOCKS][AC3_BLOCK_SAMPLES];  // encoded exponents
   int8_t   bap[AC3_NCHANNELS][AC3_NBLOCKS][AC3_BLOCK_SAMPLES];     // bit allocation pointers
@@ -62,19 +71,60 @@ public:
   int      expstr[AC3_NCHANNELS][AC3_NBLOCKS];            // 'expstr'/'lfeexpstr' - exponent strategy
   int      ngrps[AC3_NCHANNELS][AC3_NBLOCKS];             // number of exponent groups
 
+  BitAlloc ba[AC3_NCHANNELS][AC3_NBLOCKS];                // masking curves for SNR offset search
+  int      ba_bits[AC3_NCHANNELS][AC3_NBLOCKS];           // mantissa bits at the last offset tried
+
   inline void output_mant(WriteBS &pb, int8_t bap[AC3_BLOCK_SAMPLES], int32_t mant[AC3_BLOCK_SAMPLES], int8_t exp[AC3_BLOCK_SAMPLES], int start, int end) const;
   inline void compute_expstr(int expstr[AC3_NBLOCKS], int8_t exp[AC3_NBLOCKS][AC3_BLOCK_SAMPLES], int endmant) const;
   inline void restrict_exp(int8_t expcod[AC3_NBLOCKS][AC3_BLOCK_SAMPLES], int ngrps[AC3_NBLOCKS], int8_t exp[AC3_NBLOCKS][AC3_BLOCK_SAMPLES], int expstr[AC3_NBLOCKS], int endmant) const;
   inline int  encode_exp(int8_t expcod[AC3_BLOCK_SAMPLES], int8_t exp[AC3_BLOCK_SAMPLES], int expstr, int endmant) const;
+  int  count_bits(int snroffset);
+  int  find_snroffset(int snroffset, int bits_left);
+
+  void analyze(int ch);
+  static void analyze_proc(void *param, int ch);
+  static void batch_proc(void *param, int job);
+  void set_delay(samples_t prev);
 
   bool fill_buffer();
-  int  encode_frame();
+  int  encode_frame(samples_t input, uint8_t *frame);
 
 public:
   AC3Enc();
+  ~AC3Enc();
 
   int  get_bitrate() const;
   bool set_bitrate(int bitrate);
+  int  get_frame_size() const { return frame_size; }
+
+  /////////////////////////////////////////////////////////
+  // Threads
+  //
+  // set_threads(int threads)
+  //   Number of threads to use, zero means the number of processors.
+  //   Default is one thread. Channels of a frame are analyzed (mdct,
+  //   exponents and masking curves) by several threads, bit allocation
+  //   and output is done by the caller's thread. Output does not depend
+  //   on the number of threads.
+
+  bool set_threads(int threads) { return pool.set_threads(threads); }
+  int  get_threads() const { return pool.get_threads(); }
+
+  /////////////////////////////////////////////////////////
+  // Batch encoding (offline use)
+  //
+  // encode_frames(samples_t input, size_t nframes, uint8_t *out)
+  //   Encode nframes of input (AC3_FRAME_SAMPLES samples per frame) in the
+  //   format set by set_input(). Frames are written one after another to
+  //   the output buffer of nframes * get_frame_size() bytes. Frames are
+  //   split between threads, each thread encodes a run of frames with its
+  //   own encoder, so several frames are encoded at once. The result is
+  //   identical to encoding of the same frames with the filter interface,
+  //   and the encoder continues the stream after the last frame. The filter
+  //   must be empty (no partial frame buffered). Returns the number of
+  //   frames encoded.
+
+  size_t encode_frames(samples_t input, size_t nframes, uint8_t *out);
 
   /////////////////////////////////////////////////////////
   // Filter interface
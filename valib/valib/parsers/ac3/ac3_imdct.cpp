@@ -1,3 +1,5 @@
+#include <math.h>
+#include "../../simd_vec.h"
 #include "ac3_imdct.h"
 
 const sample_t imdct_window[] = 
@@ -36,225 +38,259 @@ const sample_t imdct_window[] =
   1.00000, 1.00000, 1.00000, 1.00000, 1.00000, 1.00000, 1.00000, 1.00000
 };
 
-const uint8_t fftorder[] = 
-{
-    0, 128,  64, 192,  32, 160, 224,  96,  16, 144,  80, 208, 240, 112,  48, 176,
-    8, 136,  72, 200,  40, 168, 232, 104, 248, 120,  56, 184,  24, 152, 216,  88,
-    4, 132,  68, 196,  36, 164, 228, 100,  20, 148,  84, 212, 244, 116,  52, 180,
-  252, 124,  60, 188,  28, 156, 220,  92,  12, 140,  76, 204, 236, 108,  44, 172,
-    2, 130,  66, 194,  34, 162, 226,  98,  18, 146,  82, 210, 242, 114,  50, 178,
-   10, 138,  74, 202,  42, 170, 234, 106, 250, 122,  58, 186,  26, 154, 218,  90,
-  254, 126,  62, 190,  30, 158, 222,  94,  14, 142,  78, 206, 238, 110,  46, 174,
-    6, 134,  70, 198,  38, 166, 230, 102, 246, 118,  54, 182,  22, 150, 214,  86
-};
+///////////////////////////////////////////////////////////////////////////////
+// SIMD kernels
+//
+// The long block is an IFFT of 128 complex values:
+//   z[k] = conj(pre1[k]) * (x[2k] + i*x[255-2k])
+// Short blocks are 2 IFFTs of 64 values (even and odd coefficients):
+//   z1[k] = conj(pre2[k]) * (x[4k]   + i*x[254-4k])
+//   z2[k] = conj(pre2[k]) * (x[4k+1] + i*x[255-4k])
+// liba52 does an IFFT of the permuted input, which is the same as the
+// forward FFT of z in natural order, so y = FFT(z). Post-twiddle is:
+//   a = conj(post[n]) * y[n], b = i * post[n] * conj(y[N-1-n])
+// Output of pass n goes to both ends of the block, so values from the end
+// are loaded and stored in reverse order.
 
+// Long block pre-twiddle: data -> (re, im), natural order
+#define DEFINE_IMDCT_PRE(pre512, V, target)                                   \
+static target void pre512(const sample_t *data, const sample_t *tr, const sample_t *ti, sample_t *re, sample_t *im) \
+{                                                                             \
+  V::vec x0, x1, y0, y1;                                                      \
+  for (int k = 0; k < 128; k += V::width)                                     \
+  {                                                                           \
+    V::vec t_r = V::load(tr + k);                                             \
+    V::vec t_i = V::load(ti + k);                                             \
+    V::load2(data + 2 * k, x0, x1);                                           \
+    V::load2(data + 256 - 2 * (k + V::width), y0, y1);                        \
+    y1 = V::reverse(y1);                                                      \
+    V::store(re + k, V::add(V::mul(t_i, y1), V::mul(t_r, x0)));               \
+    V::store(im + k, V::sub(V::mul(t_r, y1), V::mul(t_i, x0)));               \
+  }                                                                           \
+}
 
-IMDCT::IMDCT()
-{
-  int i, k;
+// Post-twiddle, windowing and overlap-add
+#define DEFINE_IMDCT_POST(post512, post256, V, target)                        \
+static target void post512(sample_t *data, sample_t *delay, const sample_t *re, const sample_t *im, const sample_t *tr, const sample_t *ti, const sample_t *window) \
+{                                                                             \
+  for (int n = 0; n < 64; n += V::width)                                      \
+  {                                                                           \
+    int j = 128 - n - V::width; /* y[127-n] */                                \
+    int h = 256 - 2 * (n + V::width); /* data[254-2n], data[255-2n] */        \
+    V::vec t_r = V::load(tr + n);                                             \
+    V::vec t_i = V::load(ti + n);                                             \
+    V::vec y_r = V::load(re + n);                                             \
+    V::vec y_i = V::load(im + n);                                             \
+    V::vec z_r = V::reverse(V::load(re + j));                                 \
+    V::vec z_i = V::reverse(V::load(im + j));                                 \
+                                                                              \
+    V::vec a_r = V::add(V::mul(t_r, y_r), V::mul(t_i, y_i));                  \
+    V::vec a_i = V::sub(V::mul(t_i, y_r), V::mul(t_r, y_i));                  \
+    V::vec b_r = V::add(V::mul(t_i, z_r), V::mul(t_r, z_i));                  \
+    V::vec b_i = V::sub(V::mul(t_r, z_r), V::mul(t_i, z_i));                  \
+                                                                              \
+    V::vec d0, d1, w0, w1, w254, w255;                                        \
+    V::load2(delay + 2 * n, d0, d1);                                          \
+    V::load2(window + 2 * n, w0, w1);                                         \
+    V::load2(window + h, w254, w255);                                         \
+    w254 = V::reverse(w254);                                                  \
+    w255 = V::reverse(w255);                                                  \
+                                                                              \
+    V::store2(data + 2 * n,                                                   \
+      V::sub(V::mul(d0, w255), V::mul(a_r, w0)),                              \
+      V::add(V::mul(d1, w254), V::mul(b_r, w1)));                             \
+    V::store2(data + h,                                                       \
+      V::reverse(V::sub(V::mul(d1, w1), V::mul(b_r, w254))),                  \
+      V::reverse(V::add(V::mul(d0, w0), V::mul(a_r, w255))));                 \
+    V::store2(delay + 2 * n, a_i, b_i);                                       \
+  }                                                                           \
+}                                                                             \
+                                                                              \
+static target void post256(sample_t *data, sample_t *delay, const sample_t *re, const sample_t *im, const sample_t *tr, const sample_t *ti, const sample_t *window) \
+{                                                                             \
+  for (int n = 0; n < 32; n += V::width)                                      \
+  {                                                                           \
+    int j = 64 - n - V::width;        /* y[63-n] */                           \
+    int h1 = 256 - 2 * (n + V::width); /* [254-2n], [255-2n] */               \
+    int h2 = 128 - 2 * (n + V::width); /* [126-2n], [127-2n] */               \
+    V::vec t_r = V::load(tr + n);                                             \
+    V::vec t_i = V::load(ti + n);                                             \
+    V::vec y_r, y_i, z_r, z_i;                                                \
+                                                                              \
+    y_r = V::load(re + n);                                                    \
+    y_i = V::load(im + n);                                                    \
+    z_r = V::reverse(V::load(re + j));                                        \
+    z_i = V::reverse(V::load(im + j));                                        \
+    V::vec a_r = V::add(V::mul(t_r, y_r), V::mul(t_i, y_i));                  \
+    V::vec a_i = V::sub(V::mul(t_i, y_r), V::mul(t_r, y_i));                  \
+    V::vec b_r = V::add(V::mul(t_i, z_r), V::mul(t_r, z_i));                  \
+    V::vec b_i = V::sub(V::mul(t_r, z_r), V::mul(t_i, z_i));                  \
+                                                                              \
+    y_r = V::load(re + 64 + n);                                               \
+    y_i = V::load(im + 64 + n);                                               \
+    z_r = V::reverse(V::load(re + 64 + j));                                   \
+    z_i = V::reverse(V::load(im + 64 + j));                                   \
+    V::vec c_r = V::add(V::mul(t_r, y_r), V::mul(t_i, y_i));                  \
+    V::vec c_i = V::sub(V::mul(t_i, y_r), V::mul(t_r, y_i));                  \
+    V::vec d_r = V::add(V::mul(t_i, z_r), V::mul(t_r, z_i));                  \
+    V::vec d_i = V::sub(V::mul(t_r, z_r), V::mul(t_i, z_i));                  \
+                                                                              \
+    V::vec d0, d1, d126, d127, w0, w1, w254, w255, w128, w129, w126, w127;    \
+    V::load2(delay + 2 * n, d0, d1);                                          \
+    V::load2(delay + h2, d126, d127);                                         \
+    d126 = V::reverse(d126);                                                  \
+    d127 = V::reverse(d127);                                                  \
+    V::load2(window + 2 * n, w0, w1);                                         \
+    V::load2(window + 128 + 2 * n, w128, w129);                               \
+    V::load2(window + h1, w254, w255);                                        \
+    w254 = V::reverse(w254);                                                  \
+    w255 = V::reverse(w255);                                                  \
+    V::load2(window + h2, w126, w127);                                        \
+    w126 = V::reverse(w126);                                                  \
+    w127 = V::reverse(w127);                                                  \
+                                                                              \
+    V::store2(data + 2 * n,                                                   \
+      V::sub(V::mul(d0, w255), V::mul(a_r, w0)),                              \
+      V::sub(V::mul(d1, w254), V::mul(b_i, w1)));                             \
+    V::store2(data + h1,                                                      \
+      V::reverse(V::add(V::mul(d1, w1), V::mul(b_i, w254))),                  \
+      V::reverse(V::add(V::mul(d0, w0), V::mul(a_r, w255))));                 \
+    V::store2(data + 128 + 2 * n,                                             \
+      V::add(V::mul(d127, w127), V::mul(a_i, w128)),                          \
+      V::add(V::mul(d126, w126), V::mul(b_r, w129)));                         \
+    V::store2(data + h2,                                                      \
+      V::reverse(V::sub(V::mul(d126, w129), V::mul(b_r, w126))),              \
+      V::reverse(V::sub(V::mul(d127, w128), V::mul(a_i, w127))));             \
+    V::store2(delay + 2 * n, c_i, d_r);                                       \
+    V::store2(delay + h2, V::reverse(d_i), V::reverse(c_r));                  \
+  }                                                                           \
+}
 
-  buf64_1 = buf128;
-  buf64_2 = buf128 + 64;
+typedef void (*imdct_pre_t)(const sample_t *data, const sample_t *tr, const sample_t *ti, sample_t *re, sample_t *im);
+typedef void (*imdct_post_t)(sample_t *data, sample_t *delay, const sample_t *re, const sample_t *im, const sample_t *tr, const sample_t *ti, const sample_t *window);
 
-  for (i = 0; i < 3; i++)
-    roots16[i] = cos ((M_PI / 8) * (i + 1));
+DEFINE_IMDCT_PRE(imdct_pre512_scalar, vec_scalar, )
+DEFINE_IMDCT_POST(imdct_post512_scalar, imdct_post256_scalar, vec_scalar, )
 
-  for (i = 0; i < 7; i++)
-    roots32[i] = cos ((M_PI / 16) * (i + 1));
+#ifdef VALIB_SIMD_X86
+DEFINE_IMDCT_PRE(imdct_pre512_sse2, vec_sse2, )
+DEFINE_IMDCT_POST(imdct_post512_sse2, imdct_post256_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_IMDCT_PRE(imdct_pre512_avx,  vec_avx,  SIMD_TARGET_AVX)
+DEFINE_IMDCT_POST(imdct_post512_avx,  imdct_post256_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+#endif
 
-  for (i = 0; i < 15; i++)
-    roots64[i] = cos ((M_PI / 32) * (i + 1));
+///////////////////////////////////////////////////////////////////////////////
+// IMDCT
 
-  for (i = 0; i < 31; i++)
-    roots128[i] = cos ((M_PI / 64) * (i + 1));
+IMDCT::IMDCT()
+{
+  int i;
 
-  for (i = 0; i < 64; i++) 
-  {
-    k = fftorder[i] / 2 + 64;
-    pre1[i].real = cos ((M_PI / 256) * (k - 0.25));
-    pre1[i].imag = sin ((M_PI / 256) * (k - 0.25));
-  }
+  fft128.set_length(128);
+  fft64.set_length(64);
 
-  for (i = 64; i < 128; i++) 
+  // Odd values are negated (sign of the second half of liba52's permuted
+  // input order)
+  for (i = 0; i < 128; i++)
   {
-    k = fftorder[i] / 2 + 64;
-    pre1[i].real = -cos ((M_PI / 256) * (k - 0.25));
-    pre1[i].imag = -sin ((M_PI / 256) * (k - 0.25));
+    double sign = (i & 1)? -1: 1;
+    pre1_r[i] = sample_t(sign * cos((M_PI / 256) * (i + 64 - 0.25)));
+    pre1_i[i] = sample_t(sign * sin((M_PI / 256) * (i + 64 - 0.25)));
   }
 
-  // Post-IFFT coefs are pre-scaled by 2
-  // (moved here from overlap/add step)
   for (i = 0; i < 64; i++) 
   {
-    post1[i].real = 2 * cos ((M_PI / 256) * (i + 0.5));
-    post1[i].imag = 2 * sin ((M_PI / 256) * (i + 0.5));
+    post1_r[i] = sample_t(2 * cos((M_PI / 256) * (i + 0.5)));
+    post1_i[i] = sample_t(2 * sin((M_PI / 256) * (i + 0.5)));
   }
 
   for (i = 0; i < 64; i++) 
   {
-    k = fftorder[i] / 4;
-    pre2[i].real = cos ((M_PI / 128) * (k - 0.25));
-    pre2[i].imag = sin ((M_PI / 128) * (k - 0.25));
+    pre2_r[i] = sample_t(cos((M_PI / 128) * (i - 0.25)));
+    pre2_i[i] = sample_t(sin((M_PI / 128) * (i - 0.25)));
   }
 
-  // Post-IFFT coefs are pre-scaled by 2
-  // (moved here from overlap/add step)
   for (i = 0; i < 32; i++) 
   {
-    post2[i].real = 2 * cos ((M_PI / 128) * (i + 0.5));
-    post2[i].imag = 2 * sin ((M_PI / 128) * (i + 0.5));
+    post2_r[i] = sample_t(2 * cos((M_PI / 128) * (i + 0.5)));
+    post2_i[i] = sample_t(2 * sin((M_PI / 128) * (i + 0.5)));
   }
-
-}
-
-void 
-IMDCT::ifft16(complex_t * buf)
-{
-  ifft8 (buf);
-  ifft4 (buf + 8);
-  ifft4 (buf + 12);
-  ifft_pass (buf, roots16 - 4, 4);
-}
-
-void 
-IMDCT::ifft32(complex_t *buf)
-{
-  ifft16 (buf);
-  ifft8 (buf + 16);
-  ifft8 (buf + 24);
-  ifft_pass (buf, roots32 - 8, 8);
-}
-
-void 
-IMDCT::ifft64(complex_t *buf)
-{
-  ifft32 (buf);
-  ifft16 (buf + 32);
-  ifft16 (buf + 48);
-  ifft_pass (buf, roots64 - 16, 16);
-}
-
-void 
-IMDCT::ifft128(complex_t *buf)
-{
-  ifft32 (buf);
-  ifft16 (buf + 32);
-  ifft16 (buf + 48);
-  ifft_pass (buf, roots64 - 16, 16);
-  
-  ifft32 (buf + 64);
-  ifft32 (buf + 96);
-  ifft_pass (buf, roots128 - 32, 32);
 }
 
 void 
 IMDCT::imdct_512(sample_t *data, sample_t *delay)
 {
-  int i, k;
-  sample_t t_r, t_i, a_r, a_i, b_r, b_i, w_1, w_2;
-  const sample_t *window = imdct_window;
-
-  for (i = 0; i < 128; i++) 
+  int i;
+  imdct_pre_t pre = imdct_pre512_scalar;
+  imdct_post_t post = imdct_post512_scalar;
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+  {
+    pre = imdct_pre512_avx;
+    post = imdct_post512_avx;
+  }
+  else
+#endif
+  if (caps & SIMD_SSE2)
   {
-    k = fftorder[i];
-    t_r = pre1[i].real;
-    t_i = pre1[i].imag;
-    
-    buf128[i].real = t_i * data[255-k] + t_r * data[k];
-    buf128[i].imag = t_r * data[255-k] - t_i * data[k];
+    pre = imdct_pre512_sse2;
+    post = imdct_post512_sse2;
   }
+#endif
 
-  ifft128 (buf128);
-  
-  // Post IFFT complex multiply plus IFFT complex conjugate
-  // Window and convert to real valued signal
-  for (i = 0; i < 64; i++) 
+  pre(data, pre1_r, pre1_i, buf_r, buf_i);
+
+  const unsigned *rev = fft128.rev();
+  for (i = 0; i < 128; i++)
   {
-    // y[n] = z[n] * (xcos1[n] + j * xsin1[n]);
-    t_r = post1[i].real;
-    t_i = post1[i].imag;
-    
-    a_r = t_r * buf128[i].real     + t_i * buf128[i].imag;
-    a_i = t_i * buf128[i].real     - t_r * buf128[i].imag;
-    b_r = t_i * buf128[127-i].real + t_r * buf128[127-i].imag;
-    b_i = t_r * buf128[127-i].real - t_i * buf128[127-i].imag;
-    
-    w_1 = window[2*i];
-    w_2 = window[255-2*i];
-    data[2*i]     = delay[2*i] * w_2 - a_r * w_1;
-    data[255-2*i] = delay[2*i] * w_1 + a_r * w_2;
-    delay[2*i] = a_i;
-    
-    w_1 = window[2*i+1];
-    w_2 = window[254-2*i];
-    data[2*i+1]   = delay[2*i+1] * w_2 + b_r * w_1;
-    data[254-2*i] = delay[2*i+1] * w_1 - b_r * w_2;
-    delay[2*i+1] = b_i;
+    fft_r[i] = buf_r[rev[i]];
+    fft_i[i] = buf_i[rev[i]];
   }
+  fft128.fft(fft_r, fft_i);
+
+  post(data, delay, fft_r, fft_i, post1_r, post1_i, imdct_window);
 }
 
 void 
 IMDCT::imdct_256(sample_t *data, sample_t *delay)
 {
   int i, k;
-  sample_t t_r, t_i, a_r, a_i, b_r, b_i, c_r, c_i, d_r, d_i, w_1, w_2;
-  const sample_t * window = imdct_window;
-  
-  // Pre IFFT complex multiply plus IFFT complex conjugate
-  for (i = 0; i < 64; i++) {
-    k = fftorder[i];
-    t_r = pre2[i].real;
-    t_i = pre2[i].imag;
-    
-    buf64_1[i].real = t_i * data[254-k] + t_r * data[k];
-    buf64_1[i].imag = t_r * data[254-k] - t_i * data[k];
-    
-    buf64_2[i].real = t_i * data[255-k] + t_r * data[k+1];
-    buf64_2[i].imag = t_r * data[255-k] - t_i * data[k+1];
-  }
-  
-  ifft64 (buf64_1);
-  ifft64 (buf64_2);
-  
-  // Post IFFT complex multiply
-  // Window and convert to real valued signal
-  for (i = 0; i < 32; i++) {
-    // y1[n] = z1[n] * (xcos2[n] + j * xs in2[n]) ;
-    t_r = post2[i].real;
-    t_i = post2[i].imag;
-    
-    a_r = t_r * buf64_1[i].real    + t_i * buf64_1[i].imag;
-    a_i = t_i * buf64_1[i].real    - t_r * buf64_1[i].imag;
-    b_r = t_i * buf64_1[63-i].real + t_r * buf64_1[63-i].imag;
-    b_i = t_r * buf64_1[63-i].real - t_i * buf64_1[63-i].imag;
-    
-    c_r = t_r * buf64_2[i].real    + t_i * buf64_2[i].imag;
-    c_i = t_i * buf64_2[i].real    - t_r * buf64_2[i].imag;
-    d_r = t_i * buf64_2[63-i].real + t_r * buf64_2[63-i].imag;
-    d_i = t_r * buf64_2[63-i].real - t_i * buf64_2[63-i].imag;
-    
-    w_1 = window[2*i];
-    w_2 = window[255-2*i];
-    data[2*i]     = delay[2*i] * w_2 - a_r * w_1;
-    data[255-2*i] = delay[2*i] * w_1 + a_r * w_2;
-    delay[2*i] = c_i;
-    
-    w_1 = window[128+2*i];
-    w_2 = window[127-2*i];
-    data[128+2*i] = delay[127-2*i] * w_2 + a_i * w_1;
-    data[127-2*i] = delay[127-2*i] * w_1 - a_i * w_2 ;
-    delay[127-2*i] = c_r;
-    
-    w_1 = window[2*i+1];
-    w_2 = window[254-2*i];
-    data[2*i+1]   = delay[2*i+1] * w_2 - b_i * w_1;
-    data[254-2*i] = delay[2*i+1] * w_1 + b_i * w_2;
-    delay[2*i+1] = d_r;
-    
-    w_1 = window[129+2*i];
-    w_2 = window[126-2*i];
-    data[129+2*i] = delay[126-2*i] * w_2 + b_r * w_1;
-    data[126-2*i] = delay[126-2*i] * w_1 - b_r * w_2;
-    delay[126-2*i] = d_i;
+  sample_t t_r, t_i;
+  imdct_post_t post = imdct_post256_scalar;
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    post = imdct_post256_avx;
+  else
+#endif
+  if (caps & SIMD_SSE2)
+    post = imdct_post256_sse2;
+#endif
+
+  // Pre-twiddle with reordering for FFT
+  // (short blocks are rare, so it is not vectorized)
+  const unsigned *rev = fft64.rev();
+  for (i = 0; i < 64; i++)
+  {
+    k = rev[i];
+    t_r = pre2_r[k];
+    t_i = pre2_i[k];
+    k *= 4;
+
+    fft_r[i] = t_i * data[254-k] + t_r * data[k];
+    fft_i[i] = t_r * data[254-k] - t_i * data[k];
+
+    fft_r[64+i] = t_i * data[255-k] + t_r * data[k+1];
+    fft_i[64+i] = t_r * data[255-k] - t_i * data[k+1];
   }
+
+  fft64.fft(fft_r, fft_i);
+  fft64.fft(fft_r + 64, fft_i + 64);
+
+  post(data, delay, fft_r, fft_i, post2_r, post2_i, imdct_window);
 }
@@ -1,181 +1,152 @@
 #include <math.h>
-#include "ac3_defs.h"
+#include "../../simd_vec.h"
 #include "ac3_mdct.h"
 
-#define N (AC3_BLOCK_SAMPLES * 2)
-#define MDCT_NBITS 9
+///////////////////////////////////////////////////////////////////////////////
+// SIMD kernels
+//
+// The block of N = 512 samples is folded into 128 complex values
+// (N/4-point complex MDCT):
+//   x[k] = (-d[384+2k] - d[383-2k]) + i*(d[127-2k] - d[128+2k])  (k < 64)
+//   x[k] = ( d[2k-128] - d[383-2k]) - i*(d[2k+128] + d[639-2k])  (k >= 64)
+// Then z = pre[k] * x[k], y = FFT(z), and post-twiddle r[n] = post[n] * y[n]
+// gives both odd and even coefficients:
+//   coef[2n] = Im(r[n]), coef[255-2n] = Re(r[n])
+// Values from the end of a block are loaded and stored in reverse order.
 
+#define MDCT_CMUL(V, r_r, r_i, a_r, a_i, b_r, b_i)                            \
+  r_r = V::sub(V::mul(a_r, b_r), V::mul(a_i, b_i));                           \
+  r_i = V::add(V::mul(a_r, b_i), V::mul(a_i, b_r));
 
-inline int16_t fix15(double a)
-{
-  int v;
-  v = (int)(a * (double)(1 << 15));
-  if (v < -32767)
-    v = -32767;
-  else if (v > 32767) 
-    v = 32767;
-  return v;
+// Folding and pre-twiddle: data -> (re, im), natural order
+#define DEFINE_MDCT_PRE(pre512, V, target)                                    \
+static target void pre512(const sample_t *data, const sample_t *tr, const sample_t *ti, sample_t *re, sample_t *im) \
+{                                                                             \
+  V::vec a, b, c, d, x_r, x_i, t_r, t_i, z_r, z_i, unused;                    \
+  int k;                                                                      \
+  for (k = 0; k < 64; k += V::width)                                          \
+  {                                                                           \
+    V::load2(data + 384 + 2 * k, a, unused);                                  \
+    V::load2(data + 384 - 2 * (k + V::width), unused, b);                     \
+    V::load2(data + 128 + 2 * k, c, unused);                                  \
+    V::load2(data + 128 - 2 * (k + V::width), unused, d);                     \
+    x_r = V::sub(V::zero(), V::add(a, V::reverse(b)));                        \
+    x_i = V::sub(V::reverse(d), c);                                           \
+    t_r = V::load(tr + k);                                                    \
+    t_i = V::load(ti + k);                                                    \
+    MDCT_CMUL(V, z_r, z_i, x_r, x_i, t_r, t_i);                               \
+    V::store(re + k, z_r);                                                    \
+    V::store(im + k, z_i);                                                    \
+  }                                                                           \
+  for (k = 64; k < 128; k += V::width)                                        \
+  {                                                                           \
+    V::load2(data + 2 * k - 128, a, unused);                                  \
+    V::load2(data + 384 - 2 * (k + V::width), unused, b);                     \
+    V::load2(data + 2 * k + 128, c, unused);                                  \
+    V::load2(data + 640 - 2 * (k + V::width), unused, d);                     \
+    x_r = V::sub(a, V::reverse(b));                                           \
+    x_i = V::sub(V::zero(), V::add(c, V::reverse(d)));                        \
+    t_r = V::load(tr + k);                                                    \
+    t_i = V::load(ti + k);                                                    \
+    MDCT_CMUL(V, z_r, z_i, x_r, x_i, t_r, t_i);                               \
+    V::store(re + k, z_r);                                                    \
+    V::store(im + k, z_i);                                                    \
+  }                                                                           \
 }
 
-
-MDCT::MDCT(int ln)
-{
-  int i, j, m, n;
-  float alpha;
-  
-  n = 1 << ln;
-  
-  for(i=0;i<(n/2);i++) 
-  {
-    alpha = 2 * (float)M_PI * (float)i / (float)n;
-    costab[i] = fix15(cos(alpha));
-    sintab[i] = fix15(sin(alpha));
-  }
-  
-  for(i = 0; i < n; i++) 
-  {
-    m = 0;
-    for(j = 0; j < ln; j++) 
-      m |= ((i >> j) & 1) << (ln-j-1);
-
-    fft_rev[i] = m;
-  }
-
-  //
-  for(i = 0; i < N/4; i++) 
-  {
-    alpha = 2 * (float)M_PI * (i + 1.0f / 8.0f) / (float)N;
-    xcos1[i] = fix15(-cos(alpha));
-    xsin1[i] = fix15(-sin(alpha));
-  }
+// Post-twiddle and output reordering
+#define DEFINE_MDCT_POST(post512, V, target)                                  \
+static target void post512(sample_t *coef, const sample_t *re, const sample_t *im, const sample_t *tr, const sample_t *ti) \
+{                                                                             \
+  V::vec y_r, y_i, t_r, t_i, a_r, a_i, b_r, b_i;                              \
+  for (int n = 0; n < 64; n += V::width)                                      \
+  {                                                                           \
+    int j = 128 - n - V::width; /* r[127-n] */                                \
+    int h = 256 - 2 * (n + V::width); /* coef[254-2n], coef[255-2n] */        \
+    y_r = V::load(re + n);                                                    \
+    y_i = V::load(im + n);                                                    \
+    t_r = V::load(tr + n);                                                    \
+    t_i = V::load(ti + n);                                                    \
+    MDCT_CMUL(V, a_r, a_i, y_r, y_i, t_r, t_i);                               \
+    y_r = V::load(re + j);                                                    \
+    y_i = V::load(im + j);                                                    \
+    t_r = V::load(tr + j);                                                    \
+    t_i = V::load(ti + j);                                                    \
+    MDCT_CMUL(V, b_r, b_i, y_r, y_i, t_r, t_i);                               \
+    V::store2(coef + 2 * n, a_i, V::reverse(b_r));                            \
+    V::store2(coef + h, b_i, V::reverse(a_r));                                \
+  }                                                                           \
 }
-  
 
-/* butter fly op */
-#define BF(pre, pim, qre, qim, pre1, pim1, qre1, qim1) \
-{\
-  int ax, ay, bx, by;\
-  bx=pre1;\
-  by=pim1;\
-  ax=qre1;\
-  ay=qim1;\
-  pre = (bx + ax) >> 1;\
-  pim = (by + ay) >> 1;\
-  qre = (bx - ax) >> 1;\
-  qim = (by - ay) >> 1;\
-}
+typedef void (*mdct_pre_t)(const sample_t *data, const sample_t *tr, const sample_t *ti, sample_t *re, sample_t *im);
+typedef void (*mdct_post_t)(sample_t *coef, const sample_t *re, const sample_t *im, const sample_t *tr, const sample_t *ti);
 
-#define MUL16(a,b) ((a) * (b))
+DEFINE_MDCT_PRE(mdct_pre512_scalar, vec_scalar, )
+DEFINE_MDCT_POST(mdct_post512_scalar, vec_scalar, )
 
-#define CMUL(pre, pim, are, aim, bre, bim) \
-{\
-   pre = (MUL16(are, bre) - MUL16(aim, bim)) >> 15;\
-   pim = (MUL16(are, bim) + MUL16(bre, aim)) >> 15;\
-}
+#ifdef VALIB_SIMD_X86
+DEFINE_MDCT_PRE(mdct_pre512_sse2, vec_sse2, )
+DEFINE_MDCT_POST(mdct_post512_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_MDCT_PRE(mdct_pre512_avx,  vec_avx,  SIMD_TARGET_AVX)
+DEFINE_MDCT_POST(mdct_post512_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+#endif
 
+///////////////////////////////////////////////////////////////////////////////
+// MDCT
 
-/* do a 2^n point complex fft on 2^ln points. */
-void MDCT::fft(IComplex *z, int ln)
+MDCT::MDCT()
 {
-  int j, l, np, np2;
-  int nblocks, nloops;
-  IComplex *p,*q;
-  int tmp_re, tmp_im;
-  
-  np = 1 << ln;
-  
-  /* reverse */
-  for(j=0;j<np;j++) {
-    int k;
-    IComplex tmp;
-    k = fft_rev[j];
-    if (k < j) {
-      tmp = z[k];
-      z[k] = z[j];
-      z[j] = tmp;
-    }
+  fft128.set_length(128);
+
+  // pre  = exp(-i*a) / 256
+  // post = -i * exp(-i*a)
+  // a = 2*pi/N * (k + 1/8)
+  for (int k = 0; k < 128; k++)
+  {
+    double a = (2 * M_PI / 512) * (k + 0.125);
+    pre_r[k]  = sample_t(cos(a) / 256);
+    pre_i[k]  = sample_t(-sin(a) / 256);
+    post_r[k] = sample_t(-sin(a));
+    post_i[k] = sample_t(-cos(a));
   }
-  
-  /* pass 0 */
-  
-  p=&z[0];
-  j=(np >> 1);
-  do {
-    BF(p[0].re, p[0].im, p[1].re, p[1].im, 
-      p[0].re, p[0].im, p[1].re, p[1].im);
-    p+=2;
-  } while (--j != 0);
-  
-  /* pass 1 */
-  
-  p=&z[0];
-  j=np >> 2;
-  do {
-    BF(p[0].re, p[0].im, p[2].re, p[2].im, 
-      p[0].re, p[0].im, p[2].re, p[2].im);
-    BF(p[1].re, p[1].im, p[3].re, p[3].im, 
-      p[1].re, p[1].im, p[3].im, -p[3].re);
-    p+=4;
-  } while (--j != 0);
-  
-  /* pass 2 .. ln-1 */
-  
-  nblocks = np >> 3;
-  nloops = 1 << 2;
-  np2 = np >> 1;
-  do {
-    p = z;
-    q = z + nloops;
-    for (j = 0; j < nblocks; ++j) {
-      
-      BF(p->re, p->im, q->re, q->im,
-        p->re, p->im, q->re, q->im);
-      
-      p++;
-      q++;
-      for(l = nblocks; l < np2; l += nblocks) {
-        CMUL(tmp_re, tmp_im, costab[l], -sintab[l], q->re, q->im);
-        BF(p->re, p->im, q->re, q->im,
-          p->re, p->im, tmp_re, tmp_im);
-        p++;
-        q++;
-      }
-      p += nloops;
-      q += nloops;
-    }
-    nblocks = nblocks >> 1;
-    nloops = nloops << 1;
-  } while (nblocks != 0);
 }
 
-/* do a 512 point mdct */
-void MDCT::mdct512(int32_t *out, int16_t *in)
+void
+MDCT::mdct512(sample_t *coef, const sample_t *data) const
 {
-  int i, re, im, re1, im1;
-  int16_t rot[N]; 
-  IComplex x[N/4];
-  
-  /* shift to simplify computations */
-  for(i=0;i<N/4;i++)
-    rot[i] = -in[i + 3*N/4];
-  for(i=N/4;i<N;i++)
-    rot[i] = in[i - N/4];
-  
-  /* pre rotation */
-  for(i=0;i<N/4;i++) {
-    re = ((int)rot[2*i] - (int)rot[N-1-2*i]) >> 1;
-    im = -((int)rot[N/2+2*i] - (int)rot[N/2-1-2*i]) >> 1;
-    CMUL(x[i].re, x[i].im, re, im, -xcos1[i], xsin1[i]);
+  int i;
+  sample_t buf_r[128], buf_i[128];
+  sample_t fft_r[128], fft_i[128];
+  mdct_pre_t pre = mdct_pre512_scalar;
+  mdct_post_t post = mdct_post512_scalar;
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+  {
+    pre = mdct_pre512_avx;
+    post = mdct_post512_avx;
   }
-  
-  fft(x, MDCT_NBITS - 2);
-  
-  /* post rotation */
-  for(i=0;i<N/4;i++) {
-    re = x[i].re;
-    im = x[i].im;
-    CMUL(re1, im1, re, im, xsin1[i], xcos1[i]);
-    out[2*i] = im1;
-    out[N/2-1-2*i] = re1;
+  else
+#endif
+  if (caps & SIMD_SSE2)
+  {
+    pre = mdct_pre512_sse2;
+    post = mdct_post512_sse2;
   }
+#endif
+
+  pre(data, pre_r, pre_i, buf_r, buf_i);
+
+  const unsigned *rev = fft128.rev();
+  for (i = 0; i < 128; i++)
+  {
+    fft_r[i] = buf_r[rev[i]];
+    fft_i[i] = buf_i[rev[i]];
+  }
+  fft128.fft(fft_r, fft_i);
+
+  post(coef, fft_r, fft_i, post_r, post_i);
 }
@@ -1,28 +1,41 @@
+/*
+  AC3 MDCT
+
+  mdct512() - forward transform of a long block
+
+  data[512] is a windowed input block, coef[256] receives coefficients:
+    coef[k] = -2/N * sum(data[n] * cos(2*pi/(4*N) * (2n+1) * (2k+1) + pi/4 * (2k+1)))
+  where N = 512. For input in [-1; 1] coefficients are in the range used
+  by the AC3 encoder (exponent 0 for [0.5; 1)).
+
+  The transform is done with N/4-point complex FFT on split arrays (SplitFFT)
+  like IMDCT. Input folding with pre-twiddle and post-twiddle with output
+  reordering are SIMD kernels chosen by simd_caps() at each call.
+
+  mdct512() does not change the object, so one MDCT may be used by several
+  threads at once.
+*/
+
 #ifndef VALIB_AC3_MDCT_H
 #define VALIB_AC3_MDCT_H
 
 #include "../../defs.h"
+#include "../../dsp/fft.h"
 
 class MDCT
 {
 protected:
-  int16_t costab[64];
-  int16_t sintab[64];
-  int16_t fft_rev[512];
-  int16_t xcos1[128];
-  int16_t xsin1[128];
-
-  struct IComplex 
-  {
-    short re,im;
-  };
+  SplitFFT fft128;
 
-  void fft(IComplex *z, int ln);
+  // Twiddle factors, natural order
+  // Pre-FFT coefs include the scale of the transform
+  sample_t pre_r[128],  pre_i[128];
+  sample_t post_r[128], post_i[128];
 
 public:
-  MDCT(int ln);
+  MDCT();
 
-  void mdct512(int32_t *out, int16_t *in);
+  void mdct512(sample_t *coef, const sample_t *data) const;
 };
 
 #endif
@@ -1,3 +1,4 @@
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include "../../crc.h"
@@ -23,6 +24,9 @@
 #define DELTA_BIT_NONE     2
 #define DELTA_BIT_RESERVED 3
 
+// Max number of exponent groups: (253 - 1) / 3
+static const int max_expgrps = 84;
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -37,9 +41,10 @@ protected:
   sample_t q3[2];
   sample_t q5[2];
   sample_t q11;
+  uint16_t &dither_state;
 
 public:
-  Quantizer(): q3_cnt(0), q5_cnt(0), q11_cnt(0) {};
+  Quantizer(uint16_t &_dither_state): q3_cnt(0), q5_cnt(0), q11_cnt(0), dither_state(_dither_state) {};
 
   void get_coeff(ReadBS &bs, sample_t *s, int8_t *bap, int8_t *exp, int n, bool dither);
 };
@@ -56,6 +61,7 @@ AC3Parser::AC3Parser()
   do_crc = true;
   do_dither = true;
   do_imdct = true;
+  dither_state = 1;
 
   // allocate buffers
   samples.allocate(AC3_NCHANNELS, AC3_FRAME_SAMPLES);
@@ -90,6 +96,12 @@ AC3Parser::reset()
   block = 0;
   samples.zero();
   delay.zero();
+
+  // bap arrays were cleared
+  for (int ch = 0; ch < 5; ch++)
+    ba[ch].reset();
+  cplba.reset();
+  lfeba.reset();
 }
 
 bool
@@ -746,7 +758,7 @@ AC3Parser::parse_block()
     {
       if (bitalloc & (1 << ch))
       {
-        bit_alloc(
+        ba[ch].compute(
           bap[ch], exps[ch],
           deltbae[ch], deltba[ch],
           0, endmant[ch], 
@@ -757,13 +769,15 @@ AC3Parser::parse_block()
           0, 0, 
           snroffset[ch]);
 
+        // count mantissa bits even when bap is cached: the frame size
+        // check below needs all of them
         counter.add_bap(bap[ch], 0, endmant[ch]);
       }
 
       if (cplinu && !got_cplchan && (bitalloc & (1 << 6)))
       {
         got_cplchan = true;
-        bit_alloc(
+        cplba.compute(
           cplbap, cplexps, 
           cpldeltbae, cpldeltba,
           cplstrtmant, cplendmant, 
@@ -780,7 +794,7 @@ AC3Parser::parse_block()
 
     if (lfeon && bitalloc & (1 << 5))
     {
-      bit_alloc(
+      lfeba.compute(
         lfebap, lfeexps,
         DELTA_BIT_NONE, 0,
         0, 7, 
@@ -804,6 +818,13 @@ AC3Parser::parse_block()
 bool
 AC3Parser::parse_exponents(int8_t *exps, int8_t absexp, int expstr, int nexpgrps)
 {
+  // Exponent groups are 7 bit each, read them at once
+  uint32_t expgrps[max_expgrps];
+  if (nexpgrps > max_expgrps)
+    return false;
+  bs.get_n(7, expgrps, nexpgrps);
+
+  const uint32_t *grp = expgrps;
   int expgrp;
 
   switch (expstr)
@@ -811,7 +832,7 @@ AC3Parser::parse_exponents(int8_t *exps, int8_t absexp, int expstr, int nexpgrps
   case EXP_D15:
     while (nexpgrps--)
     {
-      expgrp = bs.get(7);
+      expgrp = *grp++;
 
       absexp += exp1_tbl[expgrp];
       if (absexp > 24) return false;
@@ -830,7 +851,7 @@ AC3Parser::parse_exponents(int8_t *exps, int8_t absexp, int expstr, int nexpgrps
   case EXP_D25:
     while (nexpgrps--)
     {
-      expgrp = bs.get(7);
+      expgrp = *grp++;
 
       absexp += exp1_tbl[expgrp];
       if (absexp > 24) return false;
@@ -852,7 +873,7 @@ AC3Parser::parse_exponents(int8_t *exps, int8_t absexp, int expstr, int nexpgrps
   case EXP_D45:
     while (nexpgrps--)
     {
-      expgrp = bs.get(7);
+      expgrp = *grp++;
       if (expgrp >= 125) 
         return false;
 
@@ -917,7 +938,7 @@ void
 AC3Parser::parse_coeff(samples_t samples)
 {
   int ch, bnd, s;
-  Quantizer q;
+  Quantizer q(dither_state);
 
   int nfchans = nfchans_tbl[acmod];
   bool got_cplchan = false;
@@ -954,7 +975,7 @@ AC3Parser::parse_coeff(samples_t samples)
     if (chincpl[ch] && dithflag[ch])
       for (s = cplstrtmant; s < cplendmant; s++)
         if (!cplbap[s])
-          samples[ch][s] = dither_gen() * scale_factor[cplexps[s]];
+          samples[ch][s] = dither_gen(dither_state) * scale_factor[cplexps[s]];
 
   // Apply coupling coordinates
   for (ch = 0; ch < nfchans; ch++)
@@ -1019,7 +1040,7 @@ Quantizer::get_coeff(ReadBS &bs, sample_t *s, int8_t *bap, int8_t *exp, int n, b
     {
       case 0:
         if (dither)
-          *s++ = dither_gen() * scale_factor[*exp++];
+          *s++ = dither_gen(dither_state) * scale_factor[*exp++];
         else
         {
           *s++ = 0;
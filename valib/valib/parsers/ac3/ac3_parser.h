@@ -6,6 +6,7 @@
 #include "../../bitstream.h"
 #include "ac3_defs.h"
 #include "ac3_imdct.h"
+#include "ac3_bitalloc.h"
 
 // todo: decode_block() for per-block decode
 
@@ -178,6 +179,11 @@ public:
   IMDCT     imdct;      // IMDCT
   ReadBS    bs;         // Bitstream reader
 
+  BitAlloc  ba[5];      // bit allocation state of fbw channels
+  BitAlloc  cplba;      // bit allocation state of coupling channel
+  BitAlloc  lfeba;      // bit allocation state of lfe channel
+  uint16_t  dither_state; // dither generator state
+
   int block;
 
   bool start_parse(uint8_t *frame, size_t size);
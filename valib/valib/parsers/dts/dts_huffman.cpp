@@ -0,0 +1,120 @@
+#include <string.h>
+#include "dts_huffman.h"
+
+// Primary table index bits
+static const unsigned max_lut_bits = 9;
+
+DTSHuffman::~DTSHuffman()
+{
+  delete[] lut;
+  delete[] sub;
+}
+
+void
+DTSHuffman::init(const huff_entry_t *huff)
+{
+  int i;
+  unsigned j;
+
+  delete[] lut;
+  delete[] sub;
+  sub = 0;
+
+  /////////////////////////////////////////////////////////
+  // Primary table size
+
+  unsigned max_len = 0;
+  for (i = 0; huff[i].length; i++)
+    max_len = MAX(max_len, unsigned(huff[i].length));
+
+  bits = MIN(max_len, max_lut_bits);
+  const unsigned lut_size = 1 << bits;
+
+  lut = new entry_t[lut_size];
+  memset(lut, 0, lut_size * sizeof(entry_t));
+
+  /////////////////////////////////////////////////////////
+  // Short codes fill the range of primary entries they
+  // are the prefix of. For long codes find the subtable
+  // size for each prefix (stored at 'len' temporarily).
+
+  for (i = 0; huff[i].length; i++)
+  {
+    unsigned len = huff[i].length;
+    if (len <= bits)
+    {
+      unsigned first = huff[i].code << (bits - len);
+      for (j = 0; j < (1u << (bits - len)); j++)
+      {
+        entry_t &e = lut[first + j];
+        e.value = huff[i].value;
+        e.count = 1;
+        e.len = len;
+        e.len2 = len;
+      }
+    }
+    else
+    {
+      entry_t &e = lut[huff[i].code >> (len - bits)];
+      e.len = MAX(e.len, uint8_t(len - bits));
+    }
+  }
+
+  /////////////////////////////////////////////////////////
+  // Subtables
+
+  unsigned sub_size = 0;
+  for (j = 0; j < lut_size; j++)
+    if (lut[j].count == 0)
+    {
+      lut[j].value = sub_size;
+      sub_size += 1 << lut[j].len;
+    }
+
+  if (sub_size)
+  {
+    sub = new entry_t[sub_size];
+    memset(sub, 0, sub_size * sizeof(entry_t));
+  }
+
+  for (i = 0; huff[i].length; i++)
+  {
+    unsigned len = huff[i].length;
+    if (len > bits)
+    {
+      const entry_t &e = lut[huff[i].code >> (len - bits)];
+      unsigned sub_len = len - bits;
+      unsigned sub_code = huff[i].code & ((1 << sub_len) - 1);
+      unsigned first = e.value + (sub_code << (e.len - sub_len));
+      for (j = 0; j < (1u << (e.len - sub_len)); j++)
+      {
+        entry_t &s = sub[first + j];
+        s.value = huff[i].value;
+        s.count = 1;
+        s.len = sub_len;
+        s.len2 = sub_len;
+      }
+    }
+  }
+
+  /////////////////////////////////////////////////////////
+  // Pairs: if the bits left after the first symbol
+  // determine the second symbol, store it too.
+  // Single-symbol entries are filled above, so we
+  // can look up the second symbol in the same table.
+
+  for (j = 0; j < lut_size; j++)
+  {
+    entry_t &e = lut[j];
+    if (e.count != 1 || e.len >= bits)
+      continue;
+
+    const entry_t &e2 = lut[(j << e.len) & (lut_size - 1)];
+    if (e2.count >= 1 && e.len + e2.len <= bits)
+    {
+      e.value2 = int8_t(e2.value);
+      e.len2 = e.len + e2.len;
+      e.count = 2;
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/*
+  DTS Huffman lookup-table decoder
+
+  Decodes codes from huff_entry_t tables without walking the table bit by
+  bit. The table is built once from huff_entry_t list (DTS codes are
+  complete prefix codes up to 16 bits):
+
+  * Primary table is indexed by the next 'bits' bits of the stream
+    (up to 9). Each entry holds the first symbol and its length. If the
+    second symbol also fits into the index bits, the entry holds it too,
+    so get_n() decodes 2 symbols per lookup.
+  * Longer codes escape to a subtable indexed by the bits that follow.
+
+  get()   - decode one symbol
+  get_n() - decode a group of symbols coded with the same table
+*/
+
+#ifndef VALIB_DTS_HUFFMAN_H
+#define VALIB_DTS_HUFFMAN_H
+
+#include "../../bitstream.h"
+#include "dts_defs.h"
+
+class DTSHuffman
+{
+protected:
+  struct entry_t
+  {
+    int16_t value;   // first symbol (subtable offset for long codes)
+    int8_t  value2;  // second symbol
+    uint8_t count;   // number of symbols (0 for long codes)
+    uint8_t len;     // length of the first symbol (subtable index bits for long codes)
+    uint8_t len2;    // total length of both symbols
+  };
+
+  unsigned bits;
+  entry_t *lut;
+  entry_t *sub;
+
+  inline int decode(ReadBS &bs, const entry_t *e) const;
+
+private:
+  DTSHuffman(const DTSHuffman &);
+  DTSHuffman &operator =(const DTSHuffman &);
+
+public:
+  DTSHuffman(): bits(0), lut(0), sub(0) {}
+  DTSHuffman(const huff_entry_t *huff): bits(0), lut(0), sub(0) { init(huff); }
+  ~DTSHuffman();
+
+  void init(const huff_entry_t *huff);
+
+  inline int  get(ReadBS &bs) const;
+  inline void get_n(ReadBS &bs, int *values, int n) const;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+
+inline int
+DTSHuffman::decode(ReadBS &bs, const entry_t *e) const
+{
+  if (e->count == 0)
+  {
+    bs.skip(bits);
+    e = sub + e->value + bs.peek(e->len);
+  }
+  bs.skip(e->len);
+  return e->value;
+}
+
+inline int
+DTSHuffman::get(ReadBS &bs) const
+{
+  return decode(bs, lut + bs.peek(bits));
+}
+
+inline void
+DTSHuffman::get_n(ReadBS &bs, int *values, int n) const
+{
+  while (n > 1)
+  {
+    const entry_t *e = lut + bs.peek(bits);
+    if (e->count == 2)
+    {
+      bs.skip(e->len2);
+      values[0] = e->value;
+      values[1] = e->value2;
+      values += 2;
+      n -= 2;
+    }
+    else
+    {
+      *values++ = decode(bs, e);
+      n--;
+    }
+  }
+
+  if (n)
+    *values = get(bs);
+}
+
+#endif
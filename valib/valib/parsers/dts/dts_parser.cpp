@@ -2,12 +2,12 @@
 #include <stdio.h>
 #include "dts_parser.h"
 #include "dts_header.h"
+#include "dts_huffman.h"
 
 #include "dts_tables.h"
 #include "dts_tables_huffman.h"
 #include "dts_tables_quantization.h"
 #include "dts_tables_adpcm.h"
-#include "dts_tables_fir.h"
 #include "dts_tables_vq.h"
 
 #define DTS_MODE_MONO           0
@@ -21,6 +21,33 @@
 #define DTS_MODE_2F2R           8
 #define DTS_MODE_3F2R           9
 
+///////////////////////////////////////////////////////////////////////////////
+// Huffman lookup-table decoders
+// Built at startup from the tables above.
+
+static struct DTSHuffmanTables
+{
+  DTSHuffman bitalloc_12[5];
+  DTSHuffman scales_129[5];
+  DTSHuffman tmode[4];
+  DTSHuffman bitalloc_select[11][7];
+
+  DTSHuffmanTables()
+  {
+    int i, j;
+    for (i = 0; i < 5; i++)
+    {
+      bitalloc_12[i].init(::bitalloc_12[i]);
+      scales_129[i].init(::scales_129[i]);
+    }
+    for (i = 0; i < 4; i++)
+      tmode[i].init(::tmode[i]);
+    for (i = 0; i < 11; i++)
+      for (j = 0; j < 7 && ::bitalloc_select[i][j]; j++)
+        bitalloc_select[i][j].init(::bitalloc_select[i][j]);
+  }
+} huff_tables;
+
 static const int dts_order[NCHANNELS] = { CH_C, CH_L, CH_R, CH_SL, CH_SR, CH_LFE };
 
 static const int amode2mask_tbl[] = 
@@ -87,31 +114,10 @@ decode_blockcode(int code, int levels, int *values)
 
 DTSParser::DTSParser()
 {
-  init_cosmod();
   samples.allocate(DTS_NCHANNELS, DTS_MAX_SAMPLES);
   reset();
 }
 
-void 
-DTSParser::init_cosmod()
-{
-  int i, j, k;
-  
-  for (j=0,k=0;k<16;k++)
-    for (i=0;i<16;i++)
-      cos_mod[j++] = cos((2*i+1)*(2*k+1)*M_PI/64);
-    
-  for (k=0;k<16;k++)
-    for (i=0;i<16;i++)
-      cos_mod[j++] = cos((i)*(2*k+1)*M_PI/32);
-      
-  for (k=0;k<16;k++)
-    cos_mod[j++] = 0.25/(2*cos((2*k+1)*M_PI/128));
-  
-  for (k=0;k<16;k++)
-    cos_mod[j++] = -0.25/(2.0*sin((2*k+1)*M_PI/128));
-}
-
 ///////////////////////////////////////////////////////////////////////////////
 // FrameParser overrides
 
@@ -138,8 +144,7 @@ DTSParser::reset()
   bit_rate        = 0;
 
   memset(subband_samples_hist, 0, sizeof(subband_samples_hist));
-  memset(subband_fir_hist, 0, sizeof(subband_fir_hist));
-  memset(subband_fir_noidea, 0, sizeof(subband_fir_noidea));
+  synth.reset();
   memset(lfe_data, 0, sizeof(lfe_data));
 }
 
@@ -472,7 +477,7 @@ DTSParser::parse_subframe_header()
       else if (bitalloc_huffman[ch] == 5)
         bitalloc[ch][k] = bs.get(4);
       else
-        bitalloc[ch][k] = InverseQ(bitalloc_12[bitalloc_huffman[ch]]);
+        bitalloc[ch][k] = huff_tables.bitalloc_12[bitalloc_huffman[ch]].get(bs);
       
       if (bitalloc[ch][k] > 26)
       {
@@ -490,7 +495,7 @@ DTSParser::parse_subframe_header()
     {
       transition_mode[ch][k] = 0;
       if (subsubframes > 1 && k < vq_start_subband[ch] && bitalloc[ch][k] > 0)
-        transition_mode[ch][k] = InverseQ(tmode[transient_huffman[ch]]);
+        transition_mode[ch][k] = huff_tables.tmode[transient_huffman[ch]].get(bs);
     }
   }
   
@@ -520,7 +525,7 @@ DTSParser::parse_subframe_header()
       {
         if (scalefactor_huffman[ch] < 5)
           // huffman encoded
-          scale_sum += InverseQ(scales_129[scalefactor_huffman[ch]]);
+          scale_sum += huff_tables.scales_129[scalefactor_huffman[ch]].get(bs);
         else if (scalefactor_huffman[ch] == 5)
           scale_sum = bs.get(6);
         else if (scalefactor_huffman[ch] == 6)
@@ -534,7 +539,7 @@ DTSParser::parse_subframe_header()
         // Get second scale factor
         if (scalefactor_huffman[ch] < 5)
           // huffman encoded
-          scale_sum += InverseQ(scales_129[scalefactor_huffman[ch]]);
+          scale_sum += huff_tables.scales_129[scalefactor_huffman[ch]].get(bs);
         else if (scalefactor_huffman[ch] == 5)
           scale_sum = bs.get(6);
         else if (scalefactor_huffman[ch] == 6)
@@ -570,7 +575,7 @@ DTSParser::parse_subframe_header()
       {
         if (joint_huff[ch] < 5)
           // huffman encoded
-          scale = InverseQ(scales_129[joint_huff[ch]]);
+          scale = huff_tables.scales_129[joint_huff[ch]].get(bs);
         else if (joint_huff[ch] == 5)
           scale = bs.get(6);
         else if (joint_huff[ch] == 6)
@@ -710,21 +715,21 @@ DTSParser::parse_subsubframe()
           break;
         
         case 1: // Huffman code
-          for (m=0; m<8; m++)
-            subband_samples[ch][l][m] = InverseQ(bitalloc_select[abits][sel]);
+          {
+            int q_index[8];
+            huff_tables.bitalloc_select[abits][sel].get_n(bs, q_index, 8);
+            for (m=0; m<8; m++)
+              subband_samples[ch][l][m] = q_index[m];
+          }
           break;
         
         case 2: // No further encoding
-          for (m=0; m<8; m++)
           {
-            // Extract (signed) quantization index
-            int q_index = bs.get(abits - 3);
-            if (q_index & (1 << (abits - 4)))
-            {
-              q_index = (1 << (abits - 3)) - q_index;
-              q_index = -q_index;
-            }
-            subband_samples[ch][l][m] = q_index;
+            // Extract (signed) quantization indexes
+            int32_t q_index[8];
+            bs.get_signed_n(abits - 3, q_index, 8);
+            for (m=0; m<8; m++)
+              subband_samples[ch][l][m] = q_index[m];
           }
           break;
         
@@ -894,19 +899,21 @@ DTSParser::parse_subsubframe()
   int base = (current_subframe * subsubframes + current_subsubframe) * 32 * 8;
 
   // 32 subbands QMF
+  sample_t *out[DTS_PRIM_CHANNELS_MAX];
   for (ch = 0; ch < prim_channels; ch++)
-    qmf_32_subbands(ch,
-      subband_samples[ch],
-      samples[reorder[amode][ch]] + base,
-//      pcmr2level_tbl[source_pcm_res]);
-      32768.0);
+    out[ch] = samples[reorder[amode][ch]] + base;
+
+  synth.qmf(prim_channels, subband_samples, subband_activity,
+    multirate_inter != 0, out,
+//    pcmr2level_tbl[source_pcm_res]);
+    32768.0);
 
   // Generate LFE samples for this subsubframe FIXME!!!
   if (lfe)
   {
     int lfe_samples = 2 * lfe * subsubframes;
    
-    lfe_interpolation_fir (lfe, 2 * lfe,
+    DTSSynth::lfe(lfe, 2 * lfe,
       lfe_data + lfe_samples + 2 * lfe * subsubframe,
       samples[prim_channels] + base,
       8388608.0);
@@ -954,220 +961,3 @@ DTSParser::parse_subframe_footer()
 
   return true;
 }
-
-
-int 
-DTSParser::InverseQ(const huff_entry_t *huff)
-{
-  int value = 0;
-  int length = 0, j;
-  
-  while (1)
-  {
-    length++;
-    value <<= 1;
-    value |= bs.get(1);
-    
-    for (j = 0; huff[j].length != 0 && huff[j].length < length; j++ );
-    
-    if (huff[j].length == 0) 
-      break;
-    
-    for (; huff[j].length == length; j++)
-      if (huff[j].code == value)
-        return huff[j].value;
-  }
-  
-  return 0;
-}
-
-
-void 
-DTSParser::qmf_32_subbands (int ch, double samples_in[32][8], sample_t *samples_out,
-                            double scale)
-{           
-  const double *prCoeff;
-  int i, j, k;
-  double raXin[32];
-
-  double *subband_fir  = subband_fir_hist[ch];
-  double *subband_fir2 = subband_fir_noidea[ch];
-
-  int nChIndex = 0, NumSubband = 32, nStart = 0, nEnd = 8, nSubIndex;
-
-  // Select filter
-  if (!multirate_inter) 
-    // Non-perfect reconstruction
-    prCoeff = fir_32bands_nonperfect;
-  else 
-    // Perfect reconstruction
-    prCoeff = fir_32bands_perfect;
-
-  // Reconstructed channel sample index
-  scale = 1.0 / scale;
-  for (nSubIndex = nStart; nSubIndex < nEnd; nSubIndex++)
-  {
-    // Load in one sample from each subband
-    for (i = 0; i < subband_activity[ch]; i++)
-      raXin[i] = samples_in[i][nSubIndex];
-
-    // Clear inactive subbands
-    for (i = subband_activity[ch]; i < NumSubband; i++)
-      raXin[i] = 0.0;
-
-    sample_t a, b;
-    for (j = 0, k = 0; k < 16; k++, j += 16)
-    {
-      a  = (raXin[0]  + raXin[1])  * cos_mod[j+0];
-      a += (raXin[2]  + raXin[3])  * cos_mod[j+1];
-      a += (raXin[4]  + raXin[5])  * cos_mod[j+2];
-      a += (raXin[6]  + raXin[7])  * cos_mod[j+3];
-      a += (raXin[8]  + raXin[9])  * cos_mod[j+4];
-      a += (raXin[10] + raXin[11]) * cos_mod[j+5];
-      a += (raXin[12] + raXin[13]) * cos_mod[j+6];
-      a += (raXin[14] + raXin[15]) * cos_mod[j+7];
-      a += (raXin[16] + raXin[17]) * cos_mod[j+8];
-      a += (raXin[18] + raXin[19]) * cos_mod[j+9];
-      a += (raXin[20] + raXin[21]) * cos_mod[j+10];
-      a += (raXin[22] + raXin[23]) * cos_mod[j+11];
-      a += (raXin[24] + raXin[25]) * cos_mod[j+12];
-      a += (raXin[26] + raXin[27]) * cos_mod[j+13];
-      a += (raXin[28] + raXin[29]) * cos_mod[j+14];
-      a += (raXin[30] + raXin[31]) * cos_mod[j+15];
-
-      b  = (raXin[0])              * cos_mod[256 + j+0];
-      b += (raXin[2]  + raXin[1])  * cos_mod[256 + j+1];
-      b += (raXin[4]  + raXin[3])  * cos_mod[256 + j+2];
-      b += (raXin[6]  + raXin[5])  * cos_mod[256 + j+3];
-      b += (raXin[8]  + raXin[7])  * cos_mod[256 + j+4];
-      b += (raXin[10] + raXin[9])  * cos_mod[256 + j+5];
-      b += (raXin[12] + raXin[11]) * cos_mod[256 + j+6];
-      b += (raXin[14] + raXin[13]) * cos_mod[256 + j+7];
-      b += (raXin[16] + raXin[15]) * cos_mod[256 + j+8];
-      b += (raXin[18] + raXin[17]) * cos_mod[256 + j+9];
-      b += (raXin[20] + raXin[19]) * cos_mod[256 + j+10];
-      b += (raXin[22] + raXin[21]) * cos_mod[256 + j+11];
-      b += (raXin[24] + raXin[23]) * cos_mod[256 + j+12];
-      b += (raXin[26] + raXin[25]) * cos_mod[256 + j+13];
-      b += (raXin[28] + raXin[27]) * cos_mod[256 + j+14];
-      b += (raXin[30] + raXin[29]) * cos_mod[256 + j+15];
-
-      subband_fir[k]      = cos_mod[k + 512] * (a+b);
-      subband_fir[32-k-1] = cos_mod[k + 528] * (a-b);
-    }
-
-    // Multiply by filter coefficients
-    for (k = 31, i = 0; i < 32; i++, k--)
-    {
-      a = subband_fir2[i];
-      b = subband_fir2[32+i];
-
-      a += prCoeff[i] * (subband_fir[i] - subband_fir[k]);
-      b += prCoeff[32+i]*(-subband_fir[i] - subband_fir[k]);
-      a += prCoeff[i+64] * (subband_fir[i+64] - subband_fir[k+64]);
-      b += prCoeff[32+i+64]*(-subband_fir[i+64] - subband_fir[k+64]);
-      a += prCoeff[i+128] * (subband_fir[i+128] - subband_fir[k+128]);
-      b += prCoeff[32+i+128]*(-subband_fir[i+128] - subband_fir[k+128]);
-      a += prCoeff[i+192] * (subband_fir[i+192] - subband_fir[k+192]);
-      b += prCoeff[32+i+192]*(-subband_fir[i+192] - subband_fir[k+192]);
-      a += prCoeff[i+256] * (subband_fir[i+256] - subband_fir[k+256]);
-      b += prCoeff[32+i+256]*(-subband_fir[i+256] - subband_fir[k+256]);
-      a += prCoeff[i+320] * (subband_fir[i+320] - subband_fir[k+320]);
-      b += prCoeff[32+i+320]*(-subband_fir[i+320] - subband_fir[k+320]);
-      a += prCoeff[i+384] * (subband_fir[i+384] - subband_fir[k+384]);
-      b += prCoeff[32+i+384]*(-subband_fir[i+384] - subband_fir[k+384]);
-      a += prCoeff[i+448] * (subband_fir[i+448] - subband_fir[k+448]);
-      b += prCoeff[32+i+448]*(-subband_fir[i+448] - subband_fir[k+448]);
-
-      subband_fir2[i] = a;
-      subband_fir2[32+i] = b;
-    }
-
-    // Create 32 PCM output samples
-    for (i = 0; i < 32; i++)
-      samples_out[nChIndex++] = subband_fir2[i] * scale;
-
-    // Update working arrays
-    for (i = 512-16; i >= 32; i -= 16)
-    {
-      subband_fir[i+0]  = subband_fir[i-32+0];
-      subband_fir[i+1]  = subband_fir[i-32+1];
-      subband_fir[i+2]  = subband_fir[i-32+2];
-      subband_fir[i+3]  = subband_fir[i-32+3];
-      subband_fir[i+4]  = subband_fir[i-32+4];
-      subband_fir[i+5]  = subband_fir[i-32+5];
-      subband_fir[i+6]  = subband_fir[i-32+6];
-      subband_fir[i+7]  = subband_fir[i-32+7];
-      subband_fir[i+8]  = subband_fir[i-32+8];
-      subband_fir[i+9]  = subband_fir[i-32+9];
-      subband_fir[i+10] = subband_fir[i-32+10];
-      subband_fir[i+11] = subband_fir[i-32+11];
-      subband_fir[i+12] = subband_fir[i-32+12];
-      subband_fir[i+13] = subband_fir[i-32+13];
-      subband_fir[i+14] = subband_fir[i-32+14];
-      subband_fir[i+15] = subband_fir[i-32+15];
-    }
-
-    for (i = 0; i < NumSubband; i++)
-      subband_fir2[i] = subband_fir2[i+32];
-
-    for (i = 0; i < NumSubband; i++)
-      subband_fir2[i+32] = 0.0;
-
-  } // for (nSubIndex=nStart; nSubIndex<nEnd; nSubIndex++)
-}
-
-void 
-DTSParser::lfe_interpolation_fir(int nDecimationSelect, int nNumDeciSample,
-                                 double *samples_in, sample_t *samples_out,
-                                 double scale)
-{
-  // samples_in: An array holding decimated samples.
-  //   Samples in current subframe starts from samples_in[0],
-  //   while samples_in[-1], samples_in[-2], ..., stores samples
-  //   from last subframe as history.
-  //
-  // samples_out: An array holding interpolated samples
-  //
-
-  int nDeciFactor, k, J;
-  const double *prCoeff;
-
-  int NumFIRCoef = 512; // Number of FIR coefficients
-  int nInterpIndex = 0; // Index to the interpolated samples
-  int nDeciIndex;
-
-  // Select decimation filter
-  if (nDecimationSelect == 1)
-  {
-    // 128 decimation
-    nDeciFactor = 128;      
-    prCoeff = lfe_fir_128;
-  } 
-  else 
-  {
-    // 64 decimation
-    nDeciFactor = 64;
-    prCoeff = lfe_fir_64;
-  }
-
-  // Interpolation
-  for (nDeciIndex = 0; nDeciIndex < nNumDeciSample; nDeciIndex++)
-  {
-    // One decimated sample generates nDeciFactor interpolated ones
-    for (k = 0; k < nDeciFactor; k++)
-    {
-      double rTmp = 0.0;
-      for (J = 0; J < NumFIRCoef/nDeciFactor; J++)
-        rTmp += samples_in[nDeciIndex-J] * prCoeff[k+J*nDeciFactor];
-      // Save interpolated samples
-      samples_out[nInterpIndex++] = rTmp / scale;
-    }
-  }
-}
-
-
-
-
-
-
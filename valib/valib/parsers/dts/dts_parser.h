@@ -9,6 +9,7 @@
 #include "../../parser.h"
 #include "../../bitstream.h"
 #include "dts_defs.h"
+#include "dts_synth.h"
 
 class DTSInfo
 {
@@ -76,8 +77,6 @@ public:
 
   // Subband samples history (for ADPCM)
   double subband_samples_hist[DTS_PRIM_CHANNELS_MAX][DTS_SUBBANDS][4];
-  double subband_fir_hist[DTS_PRIM_CHANNELS_MAX][512];
-  double subband_fir_noidea[DTS_PRIM_CHANNELS_MAX][64];
 };
 
 class DTSParser : public FrameParser, public DTSInfo
@@ -118,27 +117,14 @@ protected:
   int current_subframe;
   int current_subsubframe;
 
-  // pre-calculated cosine modulation coefs for the QMF
-  double cos_mod[544];
-  void init_cosmod();
+  // synthesis filterbank
+  DTSSynth synth;
 
   // parse functions
   bool parse_frame_header();
   bool parse_subframe_header();
   bool parse_subsubframe();
   bool parse_subframe_footer();
-
-  // utility functions
-  int  InverseQ(const huff_entry_t *huff);
-  void qmf_32_subbands(int ch, 
-         double samples_in[32][8], 
-         sample_t *samples_out,
-         double scale);
-  void lfe_interpolation_fir(int nDecimationSelect, 
-         int nNumDeciSample,
-         double *samples_in, 
-         sample_t *samples_out,
-         double scale);
 };
 
 #endif
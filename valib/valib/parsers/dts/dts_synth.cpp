@@ -0,0 +1,258 @@
+#include <math.h>
+#include <string.h>
+#include "../../simd_vec.h"
+#include "dts_synth.h"
+#include "dts_tables_fir.h"
+
+static const int L = DTSSynth::lanes;
+
+///////////////////////////////////////////////////////////////////////////////
+// Tables in sample_t precision
+
+static struct DTSSynthTables
+{
+  sample_t fir[2][512];               // non-perfect, perfect reconstruction
+  sample_t lfe_64[512];
+  sample_t lfe_128[512];
+
+  // DCT-IV: 0.25 * y[k] = sum(x[n] * cos(pi/32 * (n + 1/2) * (k + 1/2)))
+  sample_t pre_re[16], pre_im[16];    // 0.25 * exp(-i*pi*(n + 1/4)/32)
+  sample_t post_re[16], post_im[16];  // exp(-i*pi*k/32)
+  sample_t tw_re[8], tw_im[8];        // FFT twiddles: exp(-2i*pi*k/16)
+  int bitrev[16];
+
+  DTSSynthTables()
+  {
+    int i;
+    for (i = 0; i < 512; i++)
+    {
+      fir[0][i] = sample_t(fir_32bands_nonperfect[i]);
+      fir[1][i] = sample_t(fir_32bands_perfect[i]);
+      lfe_64[i] = sample_t(lfe_fir_64[i]);
+      lfe_128[i] = sample_t(lfe_fir_128[i]);
+    }
+
+    for (i = 0; i < 16; i++)
+    {
+      pre_re[i]  = sample_t(0.25 * cos(-M_PI * (i + 0.25) / 32));
+      pre_im[i]  = sample_t(0.25 * sin(-M_PI * (i + 0.25) / 32));
+      post_re[i] = sample_t(cos(-M_PI * i / 32));
+      post_im[i] = sample_t(sin(-M_PI * i / 32));
+      bitrev[i]  = ((i & 1) << 3) | ((i & 2) << 1) | ((i & 4) >> 1) | ((i & 8) >> 3);
+    }
+
+    for (i = 0; i < 8; i++)
+    {
+      tw_re[i] = sample_t(cos(-2 * M_PI * i / 16));
+      tw_im[i] = sample_t(sin(-2 * M_PI * i / 16));
+    }
+  }
+} synth_tables;
+
+///////////////////////////////////////////////////////////////////////////////
+// QMF kernel
+// Processes 8 samples for lanes [0, nlanes) in groups of V::width.
+//
+// x    - input [8][32][L]
+// ring - history [16][32][L], pos - current block
+// prev - second half of the previous filter output [32][L]
+// fir  - prototype filter [512]
+// y    - output [8][32][L]
+
+typedef void (*qmf_kernel_t)(const sample_t *x, sample_t *ring, int pos, sample_t *prev, const sample_t *fir, sample_t *y, sample_t scale, int nlanes);
+
+#define DEFINE_QMF_KERNEL(name, V, target)                                    \
+static target void name(const sample_t *x, sample_t *ring, int pos, sample_t *prev, const sample_t *fir, sample_t *y, sample_t scale, int nlanes) \
+{                                                                             \
+  int i, j, k, h, s, l;                                                       \
+  V::vec re[16], im[16];                                                      \
+  V::vec vscale = V::set1(scale);                                             \
+                                                                              \
+  for (l = 0; l < nlanes; l += V::width)                                      \
+  {                                                                           \
+    int p = pos;                                                              \
+    for (s = 0; s < 8; s++)                                                   \
+    {                                                                         \
+      /* DCT-IV: pre-twiddle, store in bit-reversed order */                  \
+      const sample_t *xs = x + s * 32 * L + l;                                \
+      for (i = 0; i < 16; i++)                                                \
+      {                                                                       \
+        V::vec xr = V::load(xs + 2 * i * L);                                  \
+        V::vec xi = V::load(xs + (31 - 2 * i) * L);                           \
+        V::vec cr = V::set1(synth_tables.pre_re[i]);                          \
+        V::vec ci = V::set1(synth_tables.pre_im[i]);                          \
+        re[synth_tables.bitrev[i]] = V::sub(V::mul(xr, cr), V::mul(xi, ci));  \
+        im[synth_tables.bitrev[i]] = V::add(V::mul(xr, ci), V::mul(xi, cr));  \
+      }                                                                       \
+                                                                              \
+      /* 16-point complex FFT */                                              \
+      for (h = 1; h < 16; h *= 2)                                             \
+        for (j = 0; j < h; j++)                                               \
+        {                                                                     \
+          V::vec wr = V::set1(synth_tables.tw_re[j * 8 / h]);                 \
+          V::vec wi = V::set1(synth_tables.tw_im[j * 8 / h]);                 \
+          for (k = j; k < 16; k += 2 * h)                                     \
+          {                                                                   \
+            V::vec ar = V::sub(V::mul(re[k + h], wr), V::mul(im[k + h], wi)); \
+            V::vec ai = V::add(V::mul(re[k + h], wi), V::mul(im[k + h], wr)); \
+            re[k + h] = V::sub(re[k], ar);                                    \
+            im[k + h] = V::sub(im[k], ai);                                    \
+            re[k] = V::add(re[k], ar);                                        \
+            im[k] = V::add(im[k], ai);                                        \
+          }                                                                   \
+        }                                                                     \
+                                                                              \
+      /* Post-twiddle into the current block */                               \
+      sample_t *f = ring + p * 32 * L + l;                                    \
+      for (i = 0; i < 16; i++)                                                \
+      {                                                                       \
+        V::vec cr = V::set1(synth_tables.post_re[i]);                         \
+        V::vec ci = V::set1(synth_tables.post_im[i]);                         \
+        V::store(f + 2 * i * L, V::sub(V::mul(re[i], cr), V::mul(im[i], ci))); \
+        V::store(f + (31 - 2 * i) * L,                                        \
+          V::sub(V::zero(), V::add(V::mul(re[i], ci), V::mul(im[i], cr))));   \
+      }                                                                       \
+                                                                              \
+      /* Polyphase filter: blocks of even age */                              \
+      for (i = 0, k = 31; i < 32; i++, k--)                                   \
+      {                                                                       \
+        V::vec a = V::load(prev + i * L + l);                                 \
+        V::vec b = V::zero();                                                 \
+        for (j = 0; j < 8; j++)                                               \
+        {                                                                     \
+          const sample_t *blk = ring + ((p + 2 * j) & 15) * 32 * L + l;       \
+          V::vec fi = V::load(blk + i * L);                                   \
+          V::vec fk = V::load(blk + k * L);                                   \
+          a = V::add(a, V::mul(V::set1(fir[i + 64 * j]), V::sub(fi, fk)));    \
+          b = V::sub(b, V::mul(V::set1(fir[i + 64 * j + 32]), V::add(fi, fk))); \
+        }                                                                     \
+        V::store(y + (s * 32 + i) * L + l, V::mul(a, vscale));                \
+        V::store(prev + i * L + l, b);                                        \
+      }                                                                       \
+      p = (p + 15) & 15;                                                      \
+    }                                                                         \
+  }                                                                           \
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// LFE kernel
+// One decimated sample gives 'deci' output samples, each of them is a
+// convolution of 512/deci last decimated samples with a filter phase.
+
+typedef void (*lfe_kernel_t)(int deci, int nsamples, const double *in, const sample_t *fir, sample_t *out, sample_t scale);
+
+#define DEFINE_LFE_KERNEL(name, V, target)                                    \
+static target void name(int deci, int nsamples, const double *in, const sample_t *fir, sample_t *out, sample_t scale) \
+{                                                                             \
+  int taps = 512 / deci;                                                      \
+  V::vec vscale = V::set1(scale);                                             \
+  for (int n = 0; n < nsamples; n++)                                          \
+    for (int k = 0; k < deci; k += V::width)                                  \
+    {                                                                         \
+      V::vec acc = V::zero();                                                 \
+      for (int j = 0; j < taps; j++)                                          \
+        acc = V::add(acc, V::mul(V::set1(sample_t(in[n - j])), V::load(fir + k + j * deci))); \
+      V::store(out, V::mul(acc, vscale));                                     \
+      out += V::width;                                                        \
+    }                                                                         \
+}
+
+DEFINE_QMF_KERNEL(qmf_scalar, vec_scalar, )
+DEFINE_LFE_KERNEL(lfe_scalar, vec_scalar, )
+
+#ifdef VALIB_SIMD_X86
+DEFINE_QMF_KERNEL(qmf_sse2, vec_sse2, )
+DEFINE_LFE_KERNEL(lfe_sse2, vec_sse2, )
+#ifdef VALIB_SIMD_AVX
+DEFINE_QMF_KERNEL(qmf_avx,  vec_avx,  SIMD_TARGET_AVX)
+DEFINE_LFE_KERNEL(lfe_avx,  vec_avx,  SIMD_TARGET_AVX)
+#endif
+#endif
+
+static qmf_kernel_t find_qmf_kernel()
+{
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return qmf_avx;
+#endif
+  if (caps & SIMD_SSE2)
+    return qmf_sse2;
+#endif
+  return qmf_scalar;
+}
+
+static lfe_kernel_t find_lfe_kernel()
+{
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return lfe_avx;
+#endif
+  if (caps & SIMD_SSE2)
+    return lfe_sse2;
+#endif
+  return lfe_scalar;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// DTSSynth
+
+DTSSynth::DTSSynth()
+{
+  nlanes = 0;
+  reset();
+}
+
+void
+DTSSynth::reset()
+{
+  pos = 0;
+  memset(ring, 0, sizeof(ring));
+  memset(prev, 0, sizeof(prev));
+}
+
+void
+DTSSynth::qmf(int nch, double samples_in[][DTS_SUBBANDS][8], const int *activity,
+  bool perfect, sample_t *const *samples_out, double scale)
+{
+  int ch, i, s;
+
+  if (nch != nlanes)
+  {
+    reset();
+    nlanes = nch;
+  }
+
+  memset(x, 0, sizeof(x));
+  for (ch = 0; ch < nch; ch++)
+    for (i = 0; i < activity[ch]; i++)
+      for (s = 0; s < 8; s++)
+        x[s][i][ch] = sample_t(samples_in[ch][i][s]);
+
+  qmf_kernel_t kernel = find_qmf_kernel();
+  kernel(&x[0][0][0], &ring[0][0][0], pos, &prev[0][0], synth_tables.fir[perfect? 1: 0],
+    &y[0][0][0], sample_t(1.0 / scale), nch);
+  pos = (pos + 8) & 15;
+
+  for (ch = 0; ch < nch; ch++)
+  {
+    sample_t *out = samples_out[ch];
+    for (s = 0; s < 8; s++)
+      for (i = 0; i < 32; i++)
+        *out++ = y[s][i][ch];
+  }
+}
+
+void
+DTSSynth::lfe(int decimation, int nsamples, const double *samples_in,
+  sample_t *samples_out, double scale)
+{
+  lfe_kernel_t kernel = find_lfe_kernel();
+  if (decimation == 1)
+    kernel(128, nsamples, samples_in, synth_tables.lfe_128, samples_out, sample_t(1.0 / scale));
+  else
+    kernel(64, nsamples, samples_in, synth_tables.lfe_64, samples_out, sample_t(1.0 / scale));
+}
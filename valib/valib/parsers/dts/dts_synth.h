@@ -0,0 +1,63 @@
+/*
+  DTS synthesis filterbank
+
+  * qmf() - 32-band QMF synthesis of one subsubframe (8 samples of each
+    subband) for all primary channels at once. Channels are processed in
+    parallel: the state of each channel lives in its own lane of the
+    interleaved buffers, so a SIMD vector holds the same value of
+    several channels.
+
+    Cosine modulation is a 32-point DCT-IV computed with a 16-point complex
+    FFT. History of the polyphase filter is a ring of 16 blocks of 32
+    values, so no history shift is required.
+
+  * lfe() - LFE interpolation. Vectorized over output samples.
+
+  Filter state is reset when the number of channels changes.
+
+  Kernels are selected according to simd_caps() at each call. All kernels
+  do the same operations in the same order for each lane, so SIMD and scalar
+  results are identical.
+*/
+
+#ifndef VALIB_DTS_SYNTH_H
+#define VALIB_DTS_SYNTH_H
+
+#include "../../defs.h"
+#include "dts_defs.h"
+
+class DTSSynth
+{
+public:
+  // Interleaved buffers lanes (a multiple of any SIMD vector width)
+  enum { lanes = 8 };
+
+  DTSSynth();
+  void reset();
+
+  // samples_in - subband samples [ch][subband][sample]
+  // activity   - number of active subbands for each channel [nch]
+  // perfect    - use perfect reconstruction filter
+  // samples_out - output pointers for each channel [nch], 256 samples each
+  // Output samples are divided by scale.
+  void qmf(int nch, double samples_in[][DTS_SUBBANDS][8], const int *activity,
+    bool perfect, sample_t *const *samples_out, double scale);
+
+  // decimation  - 1 for 128x interpolation, 64x otherwise
+  // nsamples    - number of decimated samples
+  // samples_in  - decimated samples; samples_in[-1], samples_in[-2], ...
+  //               are the samples of the previous subframe
+  // samples_out - interpolated samples [nsamples * decimation factor]
+  static void lfe(int decimation, int nsamples, const double *samples_in,
+    sample_t *samples_out, double scale);
+
+protected:
+  int nlanes;                     // number of channels processed
+  int pos;                        // current block of the ring
+  sample_t ring[16][32][lanes];   // cosine modulation output history
+  sample_t prev[32][lanes];       // second half of the previous filter output
+  sample_t x[8][32][lanes];       // input samples, interleaved
+  sample_t y[8][32][lanes];       // output samples, interleaved
+};
+
+#endif
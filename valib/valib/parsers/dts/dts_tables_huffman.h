@@ -276,13 +276,13 @@ const huff_entry_t bitalloc_a_4[] =
 
 const huff_entry_t bitalloc_b_4[] =
 {
-  { 2,     2,  0}, { 3,     6,  1}, { 3,     7,  2}, { 1,     0,  3}, 
+  { 1,     0,  3}, { 2,     2,  0}, { 3,     6,  1}, { 3,     7,  2}, 
   { 0,     0,  0}
 };
 
 const huff_entry_t bitalloc_c_4[] =
 {
-  { 3,     6,  0}, { 3,     7,  1}, { 1,     0,  2}, { 2,     2,  3}, 
+  { 1,     0,  2}, { 2,     2,  3}, { 3,     6,  0}, { 3,     7,  1}, 
   { 0,     0,  0}
 };
 
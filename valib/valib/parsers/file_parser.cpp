@@ -6,6 +6,7 @@
 
 #define FLOAT_THRESHOLD 1e-20
 static const size_t max_buf_size = 65536;
+static const size_t default_map_window = 16 * 1024 * 1024;
 
 int compact_size(AutoFile::fsize_t size)
 {
@@ -35,22 +36,26 @@ FileParser::FileParser()
 {
   filename = 0;
 
-  buf = new uint8_t[max_buf_size];
+  own_buf = new uint8_t[max_buf_size];
+  buf = own_buf;
   buf_size = buf? max_buf_size: 0;
   buf_data = 0;
   buf_pos = 0;
+  map_pos = 0;
 
   stat_size = 0;
   avg_frame_interval = 0;
   avg_bitrate = 0;
 
   max_scan = 0;
+  use_mmap = false;
+  map_window = default_map_window;
 }
 
 FileParser::~FileParser()
 {
   close();
-  safe_delete(buf);
+  safe_delete(own_buf);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -70,6 +75,11 @@ FileParser::open(const char *_filename, const HeaderParser *_parser, size_t _max
   if (!f.open(_filename))
     return false;
 
+  if (use_mmap)
+    map.open(_filename);
+  stream.set_zero_copy(map.is_open());
+  map_pos = 0;
+
   max_scan = _max_scan;
   filename = _strdup(_filename);
 
@@ -82,6 +92,10 @@ FileParser::close()
 {
   stream.release_parser();
   f.close();
+  map.close();
+  buf = own_buf;
+  buf_data = 0;
+  buf_pos = 0;
 
   safe_delete(filename);
 
@@ -97,9 +111,9 @@ FileParser::probe()
 {
   if (!f) return false;
 
-  fsize_t old_pos = f.pos();
+  fsize_t old_pos = get_pos();
   bool result = load_frame();
-  f.seek(old_pos);
+  seek(old_pos);
   return result;
 }
 
@@ -108,13 +122,13 @@ FileParser::stats(unsigned max_measurments, vtime_t precision)
 {
   if (!f) return false;
 
-  fsize_t old_pos = f.pos();
+  fsize_t old_pos = get_pos();
 
   // If we cannot load a frame we will not gather any stats.
   // (If file format is unknown measurments may take much of time)
   if (!load_frame())
   {
-    f.seek(old_pos);
+    seek(old_pos);
     return false;
   }
 
@@ -129,7 +143,7 @@ FileParser::stats(unsigned max_measurments, vtime_t precision)
   for (unsigned i = 0; i < max_measurments; i++)
   {
     fsize_t file_pos = fsize_t((double)rand() * f.size() / RAND_MAX);
-    f.seek(file_pos);
+    seek(file_pos);
 
     if (!load_frame())
       continue;
@@ -218,6 +232,8 @@ FileParser::units_factor(units_t units) const
 FileParser::fsize_t
 FileParser::get_pos() const
 {
+  if (map.is_open())
+    return map_pos + buf_pos;
   return f.is_open()? fsize_t(f.pos() - buf_data + buf_pos): 0;
 }
 
@@ -242,6 +258,13 @@ FileParser::get_size(units_t units) const
 int
 FileParser::seek(fsize_t pos)
 {
+  if (map.is_open())
+  {
+    reset();
+    map_pos = pos;
+    return pos >= 0 && pos <= map.size()? 0: -1;
+  }
+
   int result = f.seek(pos);
   reset();
   return result;
@@ -262,11 +285,64 @@ FileParser::seek(double pos, units_t units)
 void
 FileParser::reset()
 {
+  // Buffered data is dropped, continue after it
+  map_pos += buf_data;
   buf_data = 0;
   buf_pos = 0;
   stream.reset();
 }
 
+bool
+FileParser::eof() const
+{
+  bool file_eof = map.is_open()? map_pos + fsize_t(buf_data) >= map.size(): f.eof();
+  return file_eof && (buf_pos >= buf_data) && !stream.is_frame_loaded();
+}
+
+// Map the view of the file that contains the position given.
+// View position is aligned to the map granularity. Returns false at the end
+// of the file. If the view cannot be mapped, switches to buffered reading.
+
+bool
+FileParser::map_view(fsize_t pos)
+{
+  buf_data = 0;
+  buf_pos = 0;
+  if (pos >= map.size())
+  {
+    map_pos = map.size();
+    return false;
+  }
+
+  size_t granularity = map.granularity();
+  fsize_t view_pos = pos - pos % granularity;
+  size_t window = MAX(map_window, max_buf_size);
+  window = (window + granularity - 1) / granularity * granularity;
+  size_t view_size = (size_t)MIN(fsize_t(window), map.size() - view_pos);
+
+  map_pos = view_pos;
+  buf = map.map(view_pos, view_size);
+  if (!buf)
+    return unmap_file(pos);
+
+  buf_data = view_size;
+  buf_pos = size_t(pos - view_pos);
+  return true;
+}
+
+// Close the mapping and continue with buffered reading at the position given
+
+bool
+FileParser::unmap_file(fsize_t pos)
+{
+  map.close();
+  stream.set_zero_copy(false);
+  buf = own_buf;
+  buf_data = 0;
+  buf_pos = 0;
+  return f.seek(pos) == 0;
+}
+
 bool
 FileParser::load_frame()
 {
@@ -300,6 +376,14 @@ FileParser::load_frame()
     ///////////////////////////////////////////////////////
     // Fill the buffer
 
+    if (map.is_open())
+    {
+      if (!buf_data || buf_pos >= buf_data)
+        if (!map_view(map_pos + buf_pos))
+          return false;
+      continue;
+    }
+
     if (!buf_data || buf_pos >= buf_data)
     {
       /* Move the data
@@ -1,5 +1,18 @@
 /*
   File parser class
+
+  Memory-mapped mode
+  ==================
+  When use_mmap is set before open() the file is memory-mapped with a window
+  of map_window bytes instead of reading it into the buffer. StreamBuffer
+  works in zero-copy mode, so frames are returned as pointers into the
+  mapping, and only frames that straddle the window boundary are copied.
+  Frame data is copy-on-write and may be processed in-place as usual.
+
+  If the file cannot be mapped (empty file, for example) the usual buffered
+  reading is used. If a view cannot be mapped later (I/O or address space
+  error) the parser switches to buffered reading from the same position.
+  is_mapped() tells what mode is actually used.
 */
 
 #ifndef VALIB_FILE_PARSER_H
@@ -18,12 +31,18 @@ protected:
   StreamBuffer stream;
 
   AutoFile f;
+  MapFile map;
   char *filename;
 
-  uint8_t *buf;
+  uint8_t *own_buf;         // read buffer
+  uint8_t *buf;             // current data: read buffer or mapped view
   size_t buf_size;
   size_t buf_data;
   size_t buf_pos;
+  AutoFile::fsize_t map_pos; // file position of the mapped view
+
+  bool map_view(AutoFile::fsize_t pos);
+  bool unmap_file(AutoFile::fsize_t pos);
 
   size_t stat_size;         // number of measurments done by stat() call
   float avg_frame_interval; // average frame interval
@@ -32,6 +51,9 @@ protected:
 public:
   typedef AutoFile::fsize_t fsize_t;
   size_t max_scan;
+  bool   use_mmap;          // use memory-mapped mode
+  size_t map_window;        // size of the mapped view
+
   enum units_t { bytes, relative, frames, time };
   inline double units_factor(units_t units) const;
 
@@ -49,7 +71,8 @@ public:
   bool stats(unsigned max_measurments = 100, vtime_t precision = 0.5);
 
   bool is_open() const { return f != 0; }
-  bool eof() const { return f.eof() && (buf_pos >= buf_data) && !stream.is_frame_loaded(); }
+  bool is_mapped() const { return map.is_open(); }
+  bool eof() const;
 
   const char *get_filename() const { return filename; }
   const HeaderParser *get_parser() const { return stream.get_parser(); }
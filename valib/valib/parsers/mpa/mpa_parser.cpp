@@ -14,8 +14,9 @@
 MPAParser::MPAParser()
 {
   samples.allocate(2, MPA_NSAMPLES);
-  synth[0] = new SynthBufferFPU();
-  synth[1] = new SynthBufferFPU();
+  synth[0] = 0;
+  synth[1] = 0;
+  synth_caps = 0;
 
   // always useful
   reset();
@@ -42,8 +43,22 @@ MPAParser::reset()
 {
   spk = spk_unknown;
   samples.zero();
-  if (synth[0]) synth[0]->reset();
-  if (synth[1]) synth[1]->reset();
+
+  // Choose synthesis filter implementation again only when the SIMD
+  // mask has changed
+  int caps = simd_caps();
+  if (synth[0] && synth[1] && caps == synth_caps)
+  {
+    synth[0]->reset();
+    synth[1]->reset();
+    return;
+  }
+
+  safe_delete(synth[0]);
+  safe_delete(synth[1]);
+  synth[0] = create_synth_buffer();
+  synth[1] = create_synth_buffer();
+  synth_caps = caps;
 }
 
 bool
@@ -416,10 +431,13 @@ MPAParser::II_decode_fraction(
       {
         if (ba > 0)
         {                                        
+          uint32_t code[3];
+          bs.get_n(ba, code, 3);
+
           d  = d_tbl[ba]; // ba > 0 => ba = quant
-          s0 = (uint16_t) bs.get(ba);
-          s1 = (uint16_t) bs.get(ba);
-          s2 = (uint16_t) bs.get(ba);
+          s0 = (uint16_t) code[0];
+          s1 = (uint16_t) code[1];
+          s2 = (uint16_t) code[2];
 
           ba = 16 - ba;  // number of bits we should shift
         }
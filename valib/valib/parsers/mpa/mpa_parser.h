@@ -87,6 +87,7 @@ private:
   ReadBS    bs;         // bitstream reader
 
   SynthBuffer *synth[MPA_NCH]; // synthesis buffers
+  int synth_caps;       // simd_caps() the synthesis buffers were created for
   int II_table;         // Layer II allocation table number 
 
   /////////////////////////////////////////////////////////
@@ -1,4 +1,5 @@
 #include <string.h>
+#include "../../simd_vec.h"
 #include "mpa_defs.h"
 #include "mpa_synth.h"
 #include "mpa_synth_filter.h"
@@ -316,3 +317,190 @@ SynthBufferFPU::synth(sample_t samples[32])
         window[j + 480] * dt[15][j];
   }
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SIMD synthesis filters
+//
+// DCT-32 above is 5 butterfly stages followed by a fixed output
+// permutation. Stage of size n splits each block of n values into sums and
+// scaled differences of the mirrored halves:
+//   out[i]       = in[i] + in[n-1-i]
+//   out[n/2 + i] = cos[i] * (in[i] - in[n-1-i])   (i < n/2)
+// Sums of the first stage (p) and differences (q) go through the same
+// 16-point transform, so all stages work on the whole 32-value array.
+// Stages with n/2 >= vector width are vectorized, the rest is scalar.
+// Operations are the same as in SynthBufferFPU, so results are bit-exact.
+
+static const sample_t dct_cos[31] =
+{
+  cos1_64, cos3_64, cos5_64, cos7_64, cos9_64, cos11_64, cos13_64, cos15_64,
+  cos17_64, cos19_64, cos21_64, cos23_64, cos25_64, cos27_64, cos29_64, cos31_64,
+  cos1_32, cos3_32, cos5_32, cos7_32, cos9_32, cos11_32, cos13_32, cos15_32,
+  cos1_16, cos3_16, cos5_16, cos7_16,
+  cos1_8, cos3_8,
+  cos1_4
+};
+
+// Output permutation of DCT-32 (the same as at SynthBufferFPU::synth())
+// p - transform of sums, q - transform of differences, buf - output [64]
+// (a macro to be inlined into kernels compiled for different targets)
+#define DCT32_OUTPUT(p, q, buf)                                               \
+{                                                                             \
+  int m;                                                                      \
+  sample_t tmp;                                                               \
+                                                                              \
+  tmp     = p[6] + p[7];                                                      \
+  buf[36] = -(p[5] + tmp);                                                    \
+  buf[44] = -(p[4] + tmp);                                                    \
+  tmp     = p[11] + p[15];                                                    \
+  buf[10] = tmp;                                                              \
+  buf[6]  = p[13] + tmp;                                                      \
+  tmp     = p[14] + p[15];                                                    \
+  buf[46] = -(p[8]  + p[12] + tmp);                                           \
+  buf[34] = -(p[9]  + p[13] + tmp);                                           \
+  tmp    += p[10] + p[11];                                                    \
+  buf[38] = -(p[13] + tmp);                                                   \
+  buf[42] = -(p[12] + tmp);                                                   \
+  buf[2]  = p[9] + p[13] + p[15];                                             \
+  buf[4]  = p[5] + p[7];                                                      \
+  buf[48] = -p[0];                                                            \
+  buf[0]  = p[1];                                                             \
+  buf[8]  = p[3];                                                             \
+  buf[12] = p[7];                                                             \
+  buf[14] = p[15];                                                            \
+  buf[40] = -(p[2]  + p[3]);                                                  \
+                                                                              \
+  tmp     = q[13] + q[15];                                                    \
+  buf[1]  = q[1] + q[9] + tmp;                                                \
+  buf[5]  = q[5] + q[7] + q[11] + tmp;                                        \
+  tmp    += q[9];                                                             \
+  buf[33] = -(q[1] + q[14] + tmp);                                            \
+  tmp    += q[5] + q[7];                                                      \
+  buf[3]  = tmp;                                                              \
+  buf[35] = -(q[6] + q[14] + tmp);                                            \
+  tmp     = q[10] + q[11] + q[12] + q[13] + q[14] + q[15];                    \
+  buf[39] = -(q[2] + q[3] + tmp - q[12]);                                     \
+  buf[43] = -(q[4] + q[6] + q[7] + tmp - q[13]);                              \
+  buf[37] = -(q[5] + q[6] + q[7] + tmp - q[12]);                              \
+  buf[41] = -(q[2] + q[3] + tmp - q[13]);                                     \
+  tmp     = q[8] + q[12] + q[14] + q[15];                                     \
+  buf[47] = -(q[0] + tmp);                                                    \
+  buf[45] = -(q[4] + q[6] + q[7] + tmp);                                      \
+  tmp     = q[11] + q[15];                                                    \
+  buf[11] = q[7]  + tmp;                                                      \
+  tmp    += q[3];                                                             \
+  buf[9]  = tmp;                                                              \
+  buf[7]  = q[13] + tmp;                                                      \
+  buf[13] = q[7] + q[15];                                                     \
+  buf[15] = q[15];                                                            \
+                                                                              \
+  buf[16] = 0.0;                                                              \
+  for (m = 0; m < 16; m++)                                                    \
+  {                                                                           \
+    buf[32-m] = -buf[m];                                                      \
+    buf[63-m] = buf[33+m];                                                    \
+  }                                                                           \
+}
+
+// Butterfly stage of size n, c - cosines of the stage
+#define SYNTH_STAGE(V, in, out, n, c)                                         \
+  for (blk = 0; blk < 32; blk += n)                                           \
+  {                                                                           \
+    i = 0;                                                                    \
+    if (n / 2 >= V::width)                                                    \
+      for (; i < n / 2; i += V::width)                                        \
+      {                                                                       \
+        V::vec v0 = V::load(in + blk + i);                                    \
+        V::vec v1 = V::reverse(V::load(in + blk + n - V::width - i));         \
+        V::store(out + blk + i, V::add(v0, v1));                              \
+        V::store(out + blk + n / 2 + i, V::mul(V::load(c + i), V::sub(v0, v1))); \
+      }                                                                       \
+    for (; i < n / 2; i++)                                                    \
+    {                                                                         \
+      out[blk + i] = in[blk + i] + in[blk + n - 1 - i];                       \
+      out[blk + n / 2 + i] = c[i] * (in[blk + i] - in[blk + n - 1 - i]);      \
+    }                                                                         \
+  }
+
+#define DEFINE_SYNTH_KERNEL(name, V, target)                                  \
+static target void name(sample_t *synth_buf, int synth_offset, sample_t samples[32]) \
+{                                                                             \
+  int i, j, k, blk;                                                           \
+  sample_t x[32], y[32];                                                      \
+                                                                              \
+  /* DCT-32 butterflies */                                                    \
+  SYNTH_STAGE(V, samples, x, 32, dct_cos);                                    \
+  SYNTH_STAGE(V, x, y, 16, (dct_cos + 16));                                   \
+  SYNTH_STAGE(V, y, x, 8,  (dct_cos + 24));                                   \
+  SYNTH_STAGE(V, x, y, 4,  (dct_cos + 28));                                   \
+  SYNTH_STAGE(V, y, x, 2,  (dct_cos + 30));                                   \
+  DCT32_OUTPUT(x, (x + 16), (synth_buf + synth_offset));                      \
+                                                                              \
+  /* Windowing */                                                             \
+  const sample_t *dt[16];                                                     \
+  for (k = 0; k < 16; k++)                                                    \
+    dt[k] = synth_buf + (((k << 5) + (((k+1) >> 1) << 6) + synth_offset) & 0x3ff); \
+                                                                              \
+  /* 4 independent sums to hide addition latency */                           \
+  for (j = 0; j < 32; j += 4 * V::width)                                      \
+  {                                                                           \
+    const sample_t *w = window + j;                                           \
+    const sample_t *d = dt[0] + j;                                            \
+    V::vec acc0 = V::mul(V::load(w),                V::load(d));              \
+    V::vec acc1 = V::mul(V::load(w + V::width),     V::load(d + V::width));   \
+    V::vec acc2 = V::mul(V::load(w + 2 * V::width), V::load(d + 2 * V::width)); \
+    V::vec acc3 = V::mul(V::load(w + 3 * V::width), V::load(d + 3 * V::width)); \
+    for (k = 1; k < 16; k++)                                                  \
+    {                                                                         \
+      d = dt[k] + j;                                                          \
+      w += 32;                                                                \
+      acc0 = V::add(acc0, V::mul(V::load(w),                V::load(d)));     \
+      acc1 = V::add(acc1, V::mul(V::load(w + V::width),     V::load(d + V::width))); \
+      acc2 = V::add(acc2, V::mul(V::load(w + 2 * V::width), V::load(d + 2 * V::width))); \
+      acc3 = V::add(acc3, V::mul(V::load(w + 3 * V::width), V::load(d + 3 * V::width))); \
+    }                                                                         \
+    V::store(samples + j,                acc0);                               \
+    V::store(samples + j + V::width,     acc1);                               \
+    V::store(samples + j + 2 * V::width, acc2);                               \
+    V::store(samples + j + 3 * V::width, acc3);                               \
+  }                                                                           \
+}
+
+#ifdef VALIB_SIMD_X86
+
+DEFINE_SYNTH_KERNEL(synth_sse2, vec_sse2, )
+
+void
+SynthBufferSSE2::synth(sample_t samples[32])
+{
+  synth_offset = (synth_offset - 64) & 0x3ff;
+  synth_sse2(synth_buf, synth_offset, samples);
+}
+
+#ifdef VALIB_SIMD_AVX
+DEFINE_SYNTH_KERNEL(synth_avx,  vec_avx,  SIMD_TARGET_AVX)
+
+void
+SynthBufferAVX::synth(sample_t samples[32])
+{
+  synth_offset = (synth_offset - 64) & 0x3ff;
+  synth_avx(synth_buf, synth_offset, samples);
+}
+#endif
+
+#endif
+
+SynthBuffer *create_synth_buffer()
+{
+#ifdef VALIB_SIMD_X86
+  int caps = simd_caps();
+#ifdef VALIB_SIMD_AVX
+  if (caps & SIMD_AVX)
+    return new SynthBufferAVX();
+#endif
+  if (caps & SIMD_SSE2)
+    return new SynthBufferSSE2();
+#endif
+  return new SynthBufferFPU();
+}
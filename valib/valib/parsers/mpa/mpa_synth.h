@@ -3,20 +3,30 @@
 
   Implements synthesis filter for 
   MPEG1 Audio LayerI and LayerII
+
+  SynthBufferFPU - reference implementation
+  SynthBufferSSE2, SynthBufferAVX - the same filter with DCT-32 butterflies
+    and windowing done with SIMD. Results are bit-exact with SynthBufferFPU
+    (each output value is computed with the same operations in the same
+    order).
+
+  create_synth_buffer() creates the best implementation allowed by
+  simd_caps(). The choice is made once for the object, so the parser
+  creates new buffers at reset() when the SIMD mask has changed.
 */
 
 #ifndef VALIB_MPA_SYNTH_H
 #define VALIB_MPA_SYNTH_H
 
 #include "../../defs.h"
+#include "../../simd.h"
 
 class SynthBuffer;
 class SynthBufferFPU;     
-//class SynthBufferMMX;     
-//class SynthBufferSSE;
-//class SynthBufferSSE2;
-//class SynthBuffer3DNow;
-//class SynthBuffer3DNow2;
+class SynthBufferSSE2;
+class SynthBufferAVX;
+
+SynthBuffer *create_synth_buffer();
 
 
 ///////////////////////////////////////////////////////////
@@ -25,6 +35,7 @@ class SynthBufferFPU;
 class SynthBuffer
 {
 public:
+  virtual ~SynthBuffer() {}
   virtual void synth(sample_t samples[32]) = 0;
   virtual void reset() = 0;
 };
@@ -46,4 +57,26 @@ public:
   virtual void reset();
 };
 
+///////////////////////////////////////////////////////////
+// SIMD synthesis filters
+// Share the buffer layout with FPU version.
+
+#ifdef VALIB_SIMD_X86
+
+class SynthBufferSSE2: public SynthBufferFPU
+{
+public:
+  virtual void synth(sample_t samples[32]);
+};
+
+#ifdef VALIB_SIMD_AVX
+class SynthBufferAVX: public SynthBufferFPU
+{
+public:
+  virtual void synth(sample_t samples[32]);
+};
+#endif
+
+#endif
+
 #endif
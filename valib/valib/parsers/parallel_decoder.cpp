@@ -0,0 +1,440 @@
+#include <string.h>
+#include "parallel_decoder.h"
+#include "multi_frame.h"
+#include "mpa/mpa_parser.h"
+#include "ac3/ac3_parser.h"
+#include "dts/dts_parser.h"
+#include "../simd.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Internal structures
+
+struct ParallelDecoder::Frame
+{
+  int      number;      // frame number at the file
+  size_t   pos;         // frame position at the batch buffer
+  size_t   size;        // frame size
+  bool     new_stream;  // frame starts a new stream
+
+  // Decoding result, filled by the worker
+  bool     ok;          // frame was decoded successfully
+  Speakers spk;         // output format
+  size_t   nsamples;    // number of samples per channel
+  size_t   out_pos;     // position at the output buffer of the job
+};
+
+struct ParallelDecoder::Job
+{
+  Worker  *worker;
+  Batch   *batch;
+
+  size_t   first;       // first frame to decode (preroll starts here)
+  size_t   begin;       // first frame to output
+  size_t   end;         // frame after the last frame of the job
+
+  Samples  out;         // decoded samples
+  size_t   out_size;    // number of decoded samples at the buffer
+  int      errors;      // number of frames failed to decode
+  bool     dither;      // do AC3 dithering
+
+  Job(): worker(0), batch(0), first(0), begin(0), end(0), out_size(0), errors(0), dither(true)
+  {}
+
+  void decode();
+  static void job_proc(void *param, int job);
+};
+
+struct ParallelDecoder::Batch
+{
+  Rawdata data;         // frames data
+  size_t  data_size;    // amount of data at the buffer
+
+  AutoBuf<Frame> frames;
+  size_t  nframes;      // number of frames at the batch
+  size_t  ntail;        // number of frames copied from the previous batch
+
+  Job    *jobs;
+
+  Batch(int njobs): data_size(0), nframes(0), ntail(0)
+  {
+    jobs = new Job[njobs];
+  }
+
+  ~Batch()
+  {
+    delete[] jobs;
+  }
+
+  void clear()
+  {
+    data_size = 0;
+    nframes = 0;
+    ntail = 0;
+  }
+
+  bool add_frame(int number, const uint8_t *frame, size_t size, bool new_stream)
+  {
+    if (data.size() < data_size + size)
+      if (!data.reallocate((data_size + size) * 2))
+        return false;
+
+    if (frames.size() < nframes + 1)
+      if (!frames.reallocate((nframes + 1) * 2))
+        return false;
+
+    memcpy(data.data() + data_size, frame, size);
+    Frame *f = frames.data() + nframes;
+    f->number = number;
+    f->pos = data_size;
+    f->size = size;
+    f->new_stream = new_stream;
+    f->ok = false;
+    f->spk = spk_unknown;
+    f->nsamples = 0;
+    f->out_pos = 0;
+
+    data_size += size;
+    nframes++;
+    return true;
+  }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Worker: set of parsers used by one thread
+
+class ParallelDecoder::Worker
+{
+protected:
+  MPAParser  mpa;
+  AC3Parser  ac3;
+  DTSParser  dts;
+  MultiFrame parser;
+
+  // Parsers work in-place and preroll frames are shared between jobs,
+  // so we decode a private copy of a frame.
+  Rawdata frame;
+
+  // Number of the frame that follows the last frame decoded. If a job
+  // continues the previous one we do not need preroll.
+  int next_frame;
+
+public:
+  Worker(): next_frame(-1)
+  {
+    FrameParser *parsers[] = { &ac3, &dts, &mpa };
+    parser.set_parsers(parsers, array_size(parsers));
+  }
+
+  void reset() { next_frame = -1; }
+  void decode(Job *job);
+};
+
+void
+ParallelDecoder::Worker::decode(Job *job)
+{
+  Batch *b = job->batch;
+  ac3.do_dither = job->dither;
+
+  size_t first = job->first;
+  bool cont = b->frames[job->begin].number == next_frame;
+  if (cont)
+    first = job->begin;
+  else
+    parser.reset();
+
+  job->out_size = 0;
+  job->errors = 0;
+  next_frame = -1;
+
+  for (size_t i = first; i < job->end; i++)
+  {
+    Frame *f = b->frames.data() + i;
+    if (f->new_stream && (i > first || cont))
+      parser.reset();
+
+    if (frame.size() < f->size)
+      if (!frame.allocate(f->size))
+        return;
+
+    memcpy(frame.data(), b->data.data() + f->pos, f->size);
+    bool ok = parser.parse_frame(frame.data(), f->size);
+    if (i < job->begin)
+      continue; // preroll frame
+
+    if (!ok)
+    {
+      job->errors++;
+      continue;
+    }
+
+    Speakers spk = parser.get_spk();
+    samples_t samples = parser.get_samples();
+    size_t nsamples = parser.get_nsamples();
+    size_t size = spk.nch() * nsamples;
+
+    if (job->out.size() < job->out_size + size)
+      if (!job->out.reallocate((job->out_size + size) * 2))
+        return;
+
+    sample_t *out = job->out.data() + job->out_size;
+    for (int ch = 0; ch < spk.nch(); ch++)
+      memcpy(out + ch * nsamples, samples[ch], nsamples * sizeof(sample_t));
+
+    f->ok = true;
+    f->spk = spk;
+    f->nsamples = nsamples;
+    f->out_pos = job->out_size;
+    job->out_size += size;
+  }
+
+  next_frame = b->frames[job->end - 1].number + 1;
+}
+
+void
+ParallelDecoder::Job::decode()
+{
+  worker->decode(this);
+}
+
+void
+ParallelDecoder::Job::job_proc(void *param, int job)
+{
+  Job *j = ((Batch *)param)->jobs + job;
+  if (j->begin < j->end)
+    j->decode();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// ParallelDecoder
+
+ParallelDecoder::ParallelDecoder(int threads):
+job_frames(16), preroll(2), dither(true),
+nthreads(0), workers(0), frames(0), errors(0)
+{
+  batch[0] = 0;
+  batch[1] = 0;
+
+  // Detect SIMD before threads start
+  simd_caps();
+  set_threads(threads);
+}
+
+ParallelDecoder::~ParallelDecoder()
+{
+  release();
+}
+
+int
+ParallelDecoder::get_cpus()
+{
+  return ThreadPool::get_cpus();
+}
+
+bool
+ParallelDecoder::set_threads(int threads)
+{
+  if (threads < 0)
+    return false;
+
+  if (threads == 0)
+    threads = get_cpus();
+
+  if (threads == nthreads)
+    return true;
+
+  release();
+  // The scanner's thread takes no jobs, so the pool has one more thread.
+  // Without threads the pool decodes jobs at the scanner's thread.
+  pool.set_threads(threads + 1);
+  workers = new Worker[threads];
+  batch[0] = new Batch(threads);
+  batch[1] = new Batch(threads);
+  if (!workers || !batch[0] || !batch[1])
+  {
+    release();
+    return false;
+  }
+
+  nthreads = threads;
+  return true;
+}
+
+void
+ParallelDecoder::release()
+{
+  safe_delete(batch[0]);
+  safe_delete(batch[1]);
+  if (workers)
+  {
+    delete[] workers;
+    workers = 0;
+  }
+  nthreads = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Decoding
+
+bool
+ParallelDecoder::decode(FileParser *file, Sink *sink)
+{
+  if (!nthreads || !file || !sink)
+    return false;
+
+  frames = 0;
+  errors = 0;
+  out_spk = spk_unknown;
+  new_stream = false;
+  for (int i = 0; i < nthreads; i++)
+    workers[i].reset();
+
+  Batch *cur = batch[0];
+  Batch *next = batch[1];
+
+  if (!scan(file, cur, 0))
+    return false;
+  start(cur);
+
+  while (cur->nframes > cur->ntail)
+  {
+    // Scan the next batch while workers decode the current one
+    bool scanned = scan(file, next, cur);
+    join();
+    if (!scanned)
+      return false;
+
+    // Send the current batch while workers decode the next one
+    start(next);
+    if (!send(cur, sink))
+    {
+      join();
+      return false;
+    }
+
+    Batch *temp = cur;
+    cur = next;
+    next = temp;
+  }
+
+  join();
+  return send_eos(sink);
+}
+
+bool
+ParallelDecoder::scan(FileParser *file, Batch *next, const Batch *prev)
+{
+  next->clear();
+
+  // Preroll frames for the first job
+  if (prev)
+  {
+    size_t n = MIN(preroll, prev->nframes);
+    for (size_t i = prev->nframes - n; i < prev->nframes; i++)
+    {
+      const Frame *f = prev->frames.data() + i;
+      if (!next->add_frame(f->number, prev->data.data() + f->pos, f->size, f->new_stream))
+        return false;
+    }
+    next->ntail = n;
+  }
+
+  size_t max_frames = next->ntail + nthreads * job_frames;
+  while (next->nframes < max_frames && file->load_frame())
+  {
+    if (!next->add_frame(frames, file->get_frame(), file->get_frame_size(), file->is_new_stream()))
+      return false;
+    frames++;
+  }
+  return true;
+}
+
+void
+ParallelDecoder::start(Batch *b)
+{
+  size_t njob_frames = MAX(job_frames, 1);
+
+  for (int j = 0; j < nthreads; j++)
+  {
+    Job *job = b->jobs + j;
+    job->worker = workers + j;
+    job->batch = b;
+    job->begin = MIN(b->ntail + j * njob_frames, b->nframes);
+    job->end = MIN(job->begin + njob_frames, b->nframes);
+    job->out_size = 0;
+    job->errors = 0;
+    job->dither = dither;
+    job->first = job->begin;
+
+    if (job->begin >= job->end)
+      continue;
+
+    // Preroll does not cross the new stream boundary
+    job->first = job->begin - MIN(preroll, job->begin);
+    for (size_t i = job->begin; i > job->first; i--)
+      if (b->frames[i].new_stream)
+      {
+        job->first = i;
+        break;
+      }
+  }
+
+  // Jobs are decoded in this thread if the pool cannot start threads
+  pool.run_async(Job::job_proc, b, nthreads);
+}
+
+void
+ParallelDecoder::join()
+{
+  pool.wait();
+}
+
+bool
+ParallelDecoder::send(Batch *b, Sink *sink)
+{
+  samples_t samples;
+  Chunk chunk;
+
+  for (int j = 0; j < nthreads; j++)
+  {
+    Job *job = b->jobs + j;
+    errors += job->errors;
+
+    for (size_t i = job->begin; i < job->end; i++)
+    {
+      Frame *f = b->frames.data() + i;
+      new_stream |= f->new_stream;
+      if (!f->ok)
+        continue;
+
+      // Inter-stream flushing
+      if (new_stream || f->spk != out_spk)
+      {
+        if (!send_eos(sink))
+          return false;
+        out_spk = f->spk;
+        new_stream = false;
+      }
+
+      samples.zero();
+      for (int ch = 0; ch < f->spk.nch(); ch++)
+        samples[ch] = job->out.data() + f->out_pos + ch * f->nsamples;
+
+      chunk.set_linear(f->spk, samples, f->nsamples);
+      if (!sink->process(&chunk))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool
+ParallelDecoder::send_eos(Sink *sink)
+{
+  if (out_spk == spk_unknown)
+    return true;
+
+  Chunk chunk;
+  chunk.set_empty(out_spk);
+  chunk.set_eos(true);
+  return sink->process(&chunk);
+}
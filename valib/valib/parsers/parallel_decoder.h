@@ -0,0 +1,99 @@
+/*
+  Frame-parallel file decoder
+
+  Decodes a compressed file (AC3, DTS, MPA) with several threads at once.
+  Intended for offline transcoding, when the whole file is decoded as fast
+  as possible.
+
+  The caller's thread works as a scanner: it loads frames with FileParser
+  and copies a batch of frames into a buffer. The batch is split into jobs
+  of consecutive frames, and each job is decoded at a ThreadPool thread with
+  its own set of parsers. While workers decode a batch the scanner loads
+  the next one and sends decoded samples of the previous batch to the sink
+  in the original order.
+
+  Stitching
+  =========
+  Frames depend on each other only with a small decoder state: IMDCT delay
+  (AC3), synthesis buffer (MPA), QMF history (DTS). To build this state a
+  worker decodes 'preroll' frames before the first frame of a job and drops
+  the output. Preroll never crosses a new stream boundary, and the parser
+  is reset at each new stream, so the result does not depend on the way
+  the file is split into jobs. A worker skips preroll when its job directly
+  follows the previous one (always the case for one thread).
+
+  With the default preroll of 2 frames AC3 and MPA output is identical to
+  sequential decoding with one thread. AC3 dithering is the exception
+  (random noise depends on the history), turn it off with 'dither' if an
+  exact result is required. DTS ADPCM prediction may carry the state
+  further, so DTS output may differ slightly at job boundaries.
+
+  Output
+  ======
+  Chunks are sent to the sink like ParserFilter does: PCM frames, and an
+  empty end-of-stream chunk at each new stream, format change and at the
+  end of the file. Chunks have no timestamps.
+
+  set_threads(int threads)
+    Set the number of worker threads. Zero means the number of processors.
+    Returns false if threads cannot be set.
+
+  decode(FileParser *file, Sink *sink)
+    Decode the file from the current position to the end. Returns false if
+    the sink fails or if the memory cannot be allocated.
+*/
+
+#ifndef VALIB_PARALLEL_DECODER_H
+#define VALIB_PARALLEL_DECODER_H
+
+#include "../buffer.h"
+#include "../filter.h"
+#include "../thread_pool.h"
+#include "file_parser.h"
+
+class ParallelDecoder
+{
+public:
+  size_t job_frames;  // number of frames in one job
+  size_t preroll;     // number of frames to decode before the job
+  bool   dither;      // do AC3 dithering
+
+  ParallelDecoder(int threads = 0);
+  ~ParallelDecoder();
+
+  bool set_threads(int threads);
+  int  get_threads() const { return nthreads; }
+  static int get_cpus();
+
+  int  get_frames() const { return frames; }
+  int  get_errors() const { return errors; }
+
+  bool decode(FileParser *file, Sink *sink);
+
+protected:
+  struct Frame;
+  struct Batch;
+  struct Job;
+  class  Worker;
+
+  int nthreads;
+  ThreadPool pool;
+  Worker *workers;
+  Batch  *batch[2];
+
+  int frames;
+  int errors;
+
+  Speakers out_spk;
+  bool new_stream;
+
+  bool scan(FileParser *file, Batch *next, const Batch *prev);
+  void start(Batch *b);
+  void join();
+  bool send(Batch *b, Sink *sink);
+  bool send_eos(Sink *sink);
+
+  void release();
+};
+
+#endif
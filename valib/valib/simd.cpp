@@ -0,0 +1,109 @@
+#include "simd.h"
+
+#if defined(VALIB_SIMD_X86) && defined(_MSC_VER)
+#  include <intrin.h>
+#elif defined(VALIB_SIMD_X86) && defined(__GNUC__)
+#  include <cpuid.h>
+#endif
+
+static int simd_detected = -1;
+static int simd_mask = SIMD_ALL;
+
+///////////////////////////////////////////////////////////////////////////////
+// CPUID wrappers
+
+#if defined(VALIB_SIMD_X86) && defined(_MSC_VER)
+
+static void cpuid(int leaf, uint32_t regs[4])
+{
+  int r[4];
+  __cpuidex(r, leaf, 0);
+  regs[0] = r[0]; regs[1] = r[1]; regs[2] = r[2]; regs[3] = r[3];
+}
+
+static uint64_t xgetbv0()
+{
+#if _MSC_FULL_VER >= 160040219 // VS2010 SP1
+  return _xgetbv(0);
+#else
+  return 0; // no way to check OS support for AVX state
+#endif
+}
+
+#elif defined(VALIB_SIMD_X86) && defined(__GNUC__)
+
+static void cpuid(int leaf, uint32_t regs[4])
+{
+  unsigned a, b, c, d;
+  __cpuid_count(leaf, 0, a, b, c, d);
+  regs[0] = a; regs[1] = b; regs[2] = c; regs[3] = d;
+}
+
+static uint64_t xgetbv0()
+{
+  uint32_t lo, hi;
+  __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a" (lo), "=d" (hi) : "c" (0));
+  return ((uint64_t)hi << 32) | lo;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+int simd_detect()
+{
+  if (simd_detected >= 0)
+    return simd_detected;
+
+  int caps = SIMD_NONE;
+
+#if defined(VALIB_SIMD_X86)
+  uint32_t r[4];
+  cpuid(0, r);
+  uint32_t max_leaf = r[0];
+
+  if (max_leaf >= 1)
+  {
+    cpuid(1, r);
+    if (r[3] & (1 << 26)) caps |= SIMD_SSE2;
+    if (r[2] & (1 <<  9)) caps |= SIMD_SSSE3;
+    if (r[2] & (1 << 19)) caps |= SIMD_SSE41;
+    if (r[2] & (1 <<  1)) caps |= SIMD_PCLMUL;
+
+    // AVX requires OS support for saving YMM state (OSXSAVE + XCR0 bits 1,2)
+    bool os_avx = false;
+    if ((r[2] & (1 << 27)) && (r[2] & (1 << 28)))
+      os_avx = (xgetbv0() & 6) == 6;
+
+    if (os_avx)
+    {
+      caps |= SIMD_AVX;
+      if (r[2] & (1 << 12)) caps |= SIMD_FMA;
+
+      if (max_leaf >= 7)
+      {
+        cpuid(7, r);
+        if (r[1] & (1 << 5)) caps |= SIMD_AVX2;
+      }
+    }
+  }
+#endif
+
+  simd_detected = caps;
+  return caps;
+}
+
+int simd_caps()
+{
+  return simd_detect() & simd_mask;
+}
+
+int simd_get_mask()
+{
+  return simd_mask;
+}
+
+void simd_set_mask(int mask)
+{
+  simd_mask = mask;
+}
@@ -0,0 +1,79 @@
+/*
+  SIMD support
+  CPU feature detection and runtime kernel selection
+
+  simd_detect() - instruction sets supported by both the CPU and the OS
+  simd_caps()   - instruction sets that kernels are allowed to use
+                  (detected set restricted by the mask)
+  simd_set_mask(mask) - restrict instruction sets used by kernels. Set mask
+                  to SIMD_NONE to force scalar code paths (used by tests to
+                  compare SIMD kernels with the reference implementation).
+                  Use SIMD_ALL to allow everything detected.
+
+  Kernels must check simd_caps() each time they select an implementation,
+  not cache the result permanently, so the mask can be changed at runtime.
+
+  VALIB_SIMD_X86 is defined when we compile for x86/x64 and may use
+  SSE intrinsics. VALIB_SIMD_AVX/VALIB_SIMD_AVX2 are defined when the
+  compiler also knows AVX/AVX2 intrinsics (VS2010 SP1/VS2012, GCC 4.9,
+  clang); older compilers build SSE kernels only. AVX code must be placed
+  into functions marked with SIMD_TARGET_AVX/SIMD_TARGET_AVX2 (required by
+  GCC to generate VEX code in a translation unit compiled without -mavx).
+*/
+
+#ifndef VALIB_SIMD_H
+#define VALIB_SIMD_H
+
+#include "defs.h"
+
+#define SIMD_NONE    0
+#define SIMD_SSE2    (1 << 0)
+#define SIMD_SSSE3   (1 << 1)
+#define SIMD_SSE41   (1 << 2)
+#define SIMD_AVX     (1 << 3)
+#define SIMD_AVX2    (1 << 4)
+#define SIMD_FMA     (1 << 5)
+#define SIMD_PCLMUL  (1 << 6)
+#define SIMD_ALL     (-1)
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#  define VALIB_SIMD_X86
+#endif
+
+#if defined(VALIB_SIMD_X86)
+#  if defined(_MSC_VER)
+#    if _MSC_FULL_VER >= 160040219 // VS2010 SP1
+#      define VALIB_SIMD_AVX
+#    endif
+#    if _MSC_VER >= 1700 // VS2012
+#      define VALIB_SIMD_AVX2
+#    endif
+#  elif defined(__clang__) || (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#    define VALIB_SIMD_AVX
+#    define VALIB_SIMD_AVX2
+#  endif
+#endif
+
+#if defined(__GNUC__)
+#  define SIMD_TARGET_SSSE3  __attribute__((target("ssse3")))
+#  define SIMD_TARGET_SSE41  __attribute__((target("sse4.1")))
+#  define SIMD_TARGET_AVX    __attribute__((target("avx")))
+#  define SIMD_TARGET_AVX2   __attribute__((target("avx2")))
+#  define SIMD_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#  define SIMD_TARGET_SSSE3
+#  define SIMD_TARGET_SSE41
+#  define SIMD_TARGET_AVX
+#  define SIMD_TARGET_AVX2
+#  define SIMD_TARGET_PCLMUL
+#endif
+
+int  simd_detect();
+int  simd_caps();
+int  simd_get_mask();
+void simd_set_mask(int mask);
+
+inline bool simd_has(int caps)
+{ return (simd_caps() & caps) == caps; }
+
+#endif
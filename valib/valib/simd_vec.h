@@ -0,0 +1,237 @@
+/*
+  SIMD vector traits for sample_t (internal header for SIMD kernels)
+
+  vec_scalar - one sample (to build reference kernels from the same code)
+  vec_sse2   - SSE2 vector (2 doubles or 4 floats)
+  vec_avx    - AVX vector (4 doubles or 8 floats)
+
+  Each traits struct exposes vector type, width (in samples) and basic
+  operations: load, store, broadcast (set1), zero, mul, add, sub, hsum (sum
+  of all elements, pairwise).
+
+  Reductions of levels:
+    abs(v)                 - absolute value
+    max(a, b)              - maximum; b when a is NaN (max(abs(x), acc) skips
+                             NaN samples like 'if (fabs(x) > acc)' does)
+    hmax(v)                - maximum of all elements
+
+  Shuffles for complex data:
+    reverse(v)             - reverse the order of elements
+    load2(p, re, im)       - load 2*width interleaved values (re, im, re...)
+    store2(p, re, im)      - store 2*width values interleaved
+
+  Functions of vec_avx are marked with SIMD_TARGET_AVX, so functions that use
+  them must be marked the same way. vec_sse2 is defined only when
+  VALIB_SIMD_X86 is defined, vec_avx only when VALIB_SIMD_AVX is defined.
+  vec_scalar is always available.
+*/
+
+#ifndef VALIB_SIMD_VEC_H
+#define VALIB_SIMD_VEC_H
+
+#include <math.h>
+#include "simd.h"
+
+struct vec_scalar
+{
+  typedef sample_t vec;
+  enum { width = 1 };
+  static inline vec load(const sample_t *p)      { return *p;    }
+  static inline void store(sample_t *p, vec v)   { *p = v;       }
+  static inline vec set1(sample_t s)             { return s;     }
+  static inline vec zero()                       { return 0;     }
+  static inline vec mul(vec a, vec b)            { return a * b; }
+  static inline vec add(vec a, vec b)            { return a + b; }
+  static inline vec sub(vec a, vec b)            { return a - b; }
+  static inline sample_t hsum(vec v)             { return v;     }
+  static inline vec abs(vec v)                   { return fabs(v);       }
+  static inline vec max(vec a, vec b)            { return a > b? a: b;   }
+  static inline sample_t hmax(vec v)             { return v;     }
+
+  static inline vec reverse(vec v)               { return v;     }
+  static inline void load2(const sample_t *p, vec &re, vec &im)
+  { re = p[0]; im = p[1]; }
+  static inline void store2(sample_t *p, vec re, vec im)
+  { p[0] = re; p[1] = im; }
+};
+
+#ifdef VALIB_SIMD_X86
+
+#include <emmintrin.h>
+#ifdef VALIB_SIMD_AVX
+#include <immintrin.h>
+#endif
+
+#ifndef FLOAT_SAMPLE
+
+struct vec_sse2
+{
+  typedef __m128d vec;
+  enum { width = 2 };
+  static inline vec load(const sample_t *p)      { return _mm_loadu_pd(p);    }
+  static inline void store(sample_t *p, vec v)   { _mm_storeu_pd(p, v);       }
+  static inline vec set1(sample_t s)             { return _mm_set1_pd(s);     }
+  static inline vec zero()                       { return _mm_setzero_pd();   }
+  static inline vec mul(vec a, vec b)            { return _mm_mul_pd(a, b);   }
+  static inline vec add(vec a, vec b)            { return _mm_add_pd(a, b);   }
+  static inline vec sub(vec a, vec b)            { return _mm_sub_pd(a, b);   }
+  static inline sample_t hsum(vec v)
+  { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+  static inline vec abs(vec v)                   { return _mm_andnot_pd(_mm_set1_pd(-0.0), v); }
+  static inline vec max(vec a, vec b)            { return _mm_max_pd(a, b);   }
+  static inline sample_t hmax(vec v)
+  { return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v))); }
+
+  static inline vec reverse(vec v)               { return _mm_shuffle_pd(v, v, 1); }
+  static inline void load2(const sample_t *p, vec &re, vec &im)
+  {
+    vec x = _mm_loadu_pd(p), y = _mm_loadu_pd(p + 2);
+    re = _mm_unpacklo_pd(x, y);
+    im = _mm_unpackhi_pd(x, y);
+  }
+  static inline void store2(sample_t *p, vec re, vec im)
+  {
+    _mm_storeu_pd(p,     _mm_unpacklo_pd(re, im));
+    _mm_storeu_pd(p + 2, _mm_unpackhi_pd(re, im));
+  }
+};
+
+#ifdef VALIB_SIMD_AVX
+
+struct vec_avx
+{
+  typedef __m256d vec;
+  enum { width = 4 };
+  static inline SIMD_TARGET_AVX vec load(const sample_t *p)    { return _mm256_loadu_pd(p);  }
+  static inline SIMD_TARGET_AVX void store(sample_t *p, vec v) { _mm256_storeu_pd(p, v);     }
+  static inline SIMD_TARGET_AVX vec set1(sample_t s)           { return _mm256_set1_pd(s);   }
+  static inline SIMD_TARGET_AVX vec zero()                     { return _mm256_setzero_pd(); }
+  static inline SIMD_TARGET_AVX vec mul(vec a, vec b)          { return _mm256_mul_pd(a, b); }
+  static inline SIMD_TARGET_AVX vec add(vec a, vec b)          { return _mm256_add_pd(a, b); }
+  static inline SIMD_TARGET_AVX vec sub(vec a, vec b)          { return _mm256_sub_pd(a, b); }
+  static inline SIMD_TARGET_AVX sample_t hsum(vec v)
+  {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+  }
+  static inline SIMD_TARGET_AVX vec abs(vec v)   { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), v); }
+  static inline SIMD_TARGET_AVX vec max(vec a, vec b)          { return _mm256_max_pd(a, b); }
+  static inline SIMD_TARGET_AVX sample_t hmax(vec v)
+  {
+    __m128d m = _mm_max_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+    return _mm_cvtsd_f64(_mm_max_sd(m, _mm_unpackhi_pd(m, m)));
+  }
+
+  static inline SIMD_TARGET_AVX vec reverse(vec v)
+  { return _mm256_permute_pd(_mm256_permute2f128_pd(v, v, 1), 5); }
+  static inline SIMD_TARGET_AVX void load2(const sample_t *p, vec &re, vec &im)
+  {
+    vec x = _mm256_loadu_pd(p), y = _mm256_loadu_pd(p + 4);
+    vec t0 = _mm256_permute2f128_pd(x, y, 0x20);
+    vec t1 = _mm256_permute2f128_pd(x, y, 0x31);
+    re = _mm256_unpacklo_pd(t0, t1);
+    im = _mm256_unpackhi_pd(t0, t1);
+  }
+  static inline SIMD_TARGET_AVX void store2(sample_t *p, vec re, vec im)
+  {
+    vec lo = _mm256_unpacklo_pd(re, im), hi = _mm256_unpackhi_pd(re, im);
+    _mm256_storeu_pd(p,     _mm256_permute2f128_pd(lo, hi, 0x20));
+    _mm256_storeu_pd(p + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+  }
+};
+
+#endif
+
+#else
+
+struct vec_sse2
+{
+  typedef __m128 vec;
+  enum { width = 4 };
+  static inline vec load(const sample_t *p)      { return _mm_loadu_ps(p);    }
+  static inline void store(sample_t *p, vec v)   { _mm_storeu_ps(p, v);       }
+  static inline vec set1(sample_t s)             { return _mm_set1_ps(s);     }
+  static inline vec zero()                       { return _mm_setzero_ps();   }
+  static inline vec mul(vec a, vec b)            { return _mm_mul_ps(a, b);   }
+  static inline vec add(vec a, vec b)            { return _mm_add_ps(a, b);   }
+  static inline vec sub(vec a, vec b)            { return _mm_sub_ps(a, b);   }
+  static inline sample_t hsum(vec v)
+  {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+  }
+  static inline vec abs(vec v)                   { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v); }
+  static inline vec max(vec a, vec b)            { return _mm_max_ps(a, b);   }
+  static inline sample_t hmax(vec v)
+  {
+    __m128 m = _mm_max_ps(v, _mm_movehl_ps(v, v));
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+  }
+
+  static inline vec reverse(vec v)               { return _mm_shuffle_ps(v, v, 0x1b); }
+  static inline void load2(const sample_t *p, vec &re, vec &im)
+  {
+    vec x = _mm_loadu_ps(p), y = _mm_loadu_ps(p + 4);
+    re = _mm_shuffle_ps(x, y, 0x88);
+    im = _mm_shuffle_ps(x, y, 0xdd);
+  }
+  static inline void store2(sample_t *p, vec re, vec im)
+  {
+    _mm_storeu_ps(p,     _mm_unpacklo_ps(re, im));
+    _mm_storeu_ps(p + 4, _mm_unpackhi_ps(re, im));
+  }
+};
+
+#ifdef VALIB_SIMD_AVX
+
+struct vec_avx
+{
+  typedef __m256 vec;
+  enum { width = 8 };
+  static inline SIMD_TARGET_AVX vec load(const sample_t *p)    { return _mm256_loadu_ps(p);  }
+  static inline SIMD_TARGET_AVX void store(sample_t *p, vec v) { _mm256_storeu_ps(p, v);     }
+  static inline SIMD_TARGET_AVX vec set1(sample_t s)           { return _mm256_set1_ps(s);   }
+  static inline SIMD_TARGET_AVX vec zero()                     { return _mm256_setzero_ps(); }
+  static inline SIMD_TARGET_AVX vec mul(vec a, vec b)          { return _mm256_mul_ps(a, b); }
+  static inline SIMD_TARGET_AVX vec add(vec a, vec b)          { return _mm256_add_ps(a, b); }
+  static inline SIMD_TARGET_AVX vec sub(vec a, vec b)          { return _mm256_sub_ps(a, b); }
+  static inline SIMD_TARGET_AVX sample_t hsum(vec v)
+  {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+  }
+  static inline SIMD_TARGET_AVX vec abs(vec v)   { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v); }
+  static inline SIMD_TARGET_AVX vec max(vec a, vec b)          { return _mm256_max_ps(a, b); }
+  static inline SIMD_TARGET_AVX sample_t hmax(vec v)
+  {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+  }
+
+  static inline SIMD_TARGET_AVX vec reverse(vec v)
+  { return _mm256_permute_ps(_mm256_permute2f128_ps(v, v, 1), 0x1b); }
+  static inline SIMD_TARGET_AVX void load2(const sample_t *p, vec &re, vec &im)
+  {
+    vec x = _mm256_loadu_ps(p), y = _mm256_loadu_ps(p + 8);
+    vec t0 = _mm256_permute2f128_ps(x, y, 0x20);
+    vec t1 = _mm256_permute2f128_ps(x, y, 0x31);
+    re = _mm256_shuffle_ps(t0, t1, 0x88);
+    im = _mm256_shuffle_ps(t0, t1, 0xdd);
+  }
+  static inline SIMD_TARGET_AVX void store2(sample_t *p, vec re, vec im)
+  {
+    vec lo = _mm256_unpacklo_ps(re, im), hi = _mm256_unpackhi_ps(re, im);
+    _mm256_storeu_ps(p,     _mm256_permute2f128_ps(lo, hi, 0x20));
+    _mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+  }
+};
+
+#endif
+
+#endif
+
+#endif // VALIB_SIMD_X86
+
+#endif
@@ -1,5 +1,16 @@
 #include <memory.h>
 #include "syncscan.h"
+#include "simd.h"
+
+#ifdef VALIB_SIMD_X86
+#include <emmintrin.h>
+#endif
+#ifdef VALIB_SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+// Checking more keys is slower than the scalar scan
+static const int max_keys = 12;
 
 ///////////////////////////////////////////////////////////////////////////////
 // Syncronization table for MPA/AC3/DTS
@@ -17,6 +28,7 @@ SyncScan::SyncScan(uint32_t _syncword, uint32_t _syncmask)
   synctable = new synctbl_t[1024];
   memset(synctable, 0, sizeof(synctbl_t) * 1024);
   count = 0;
+  nkeys = 0;
 
   if (_syncword)
     set(1, _syncword, _syncmask);
@@ -30,7 +42,7 @@ SyncScan::~SyncScan()
 bool
 SyncScan::set(int _index, uint32_t _syncword, uint32_t _syncmask)
 {
-  if (_index < 0 || _index > sizeof(synctbl_t) * 8)
+  if (_index < 0 || _index >= int(sizeof(synctbl_t) * 8))
     return false;
 
   synctbl_t table_mask = (1 << _index);
@@ -75,13 +87,14 @@ SyncScan::set(int _index, uint32_t _syncword, uint32_t _syncmask)
     else
       synctable[i + 768] &= ~table_mask;
 
+  update_keys();
   return true;
 }
 
 bool
 SyncScan::allow(int _index, uint32_t _syncword, uint32_t _syncmask)
 {
-  if (_index < 0 || _index > sizeof(synctbl_t) * 8)
+  if (_index < 0 || _index >= int(sizeof(synctbl_t) * 8))
     return false;
 
   synctbl_t table_mask = (1 << _index);
@@ -122,13 +135,14 @@ SyncScan::allow(int _index, uint32_t _syncword, uint32_t _syncmask)
       if ((sync_byte & mask_byte) == (i & mask_byte))
         synctable[i + 768] |= table_mask;
 
+  update_keys();
   return true;
 }
 
 bool
 SyncScan::deny(int _index, uint32_t _syncword, uint32_t _syncmask)
 {
-  if (_index < 0 || _index > sizeof(synctbl_t) * 8)
+  if (_index < 0 || _index >= int(sizeof(synctbl_t) * 8))
     return false;
 
   synctbl_t table_mask = (1 << _index);
@@ -169,6 +183,7 @@ SyncScan::deny(int _index, uint32_t _syncword, uint32_t _syncmask)
       if ((sync_byte & mask_byte) == (i & mask_byte))
         synctable[i + 768] &= ~table_mask;
 
+  update_keys();
   return true;
 }
 
@@ -188,13 +203,14 @@ SyncScan::set_list(const uint32_t *_list, unsigned _size)
 bool
 SyncScan::clear(int _index)
 {
-  if (_index < 0 || _index > sizeof(synctbl_t) * 8)
+  if (_index < 0 || _index >= int(sizeof(synctbl_t) * 8))
     return false;
 
   synctbl_t table_mask = ~(1 << _index);
   for (int i = 0; i < 1024; i++)
     synctable[i] &= table_mask;
 
+  update_keys();
   return true;
 }
 
@@ -202,6 +218,7 @@ void
 SyncScan::clear_all()
 {
   memset(synctable, 0, sizeof(synctbl_t) * 1024);
+  nkeys = 0;
 }
 
 void
@@ -254,6 +271,138 @@ SyncScan::set_standard(uint32_t _syncmask)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Vectorized scan
+
+void
+SyncScan::update_keys()
+{
+  nkeys = 0;
+  for (int index = 0; index < int(sizeof(synctbl_t) * 8); index++)
+  {
+    synctbl_t table_mask = synctbl_t(1) << index;
+
+    // Bits equal for all allowed values are set in both 'and' and 'or'
+    // or cleared in both.
+    int and1 = 0xff, or1 = 0, n1 = 0;
+    int and2 = 0xff, or2 = 0, n2 = 0;
+    for (int i = 0; i < 256; i++)
+    {
+      if (synctable[i] & table_mask)
+      { and1 &= i; or1 |= i; n1++; }
+      if (synctable[i + 256] & table_mask)
+      { and2 &= i; or2 |= i; n2++; }
+    }
+
+    // syncpoint is not used or never matches
+    if (n1 == 0 || n2 == 0)
+      continue;
+
+    SyncKey key;
+    key.mask1 = uint8_t(~(and1 ^ or1));
+    key.mask2 = uint8_t(~(and2 ^ or2));
+    key.value1 = uint8_t(and1);
+    key.value2 = uint8_t(and2);
+
+    // any pair of bytes may start the syncpoint
+    if (key.mask1 == 0 && key.mask2 == 0)
+    {
+      nkeys = 0;
+      return;
+    }
+
+    int k = 0;
+    while (k < nkeys && memcmp(&keys[k], &key, sizeof(key)))
+      k++;
+    if (k == nkeys)
+      keys[nkeys++] = key;
+  }
+
+  if (nkeys > max_keys)
+    nkeys = 0;
+}
+
+#ifdef VALIB_SIMD_X86
+
+// Checks positions [0, pos) where all 4 bytes of the syncpoint are at
+// the buffer. Returns true and the position of the first syncpoint found,
+// or false and the position where to continue scalar scanning.
+
+#define DEFINE_FIND_SYNC(name, target, vec_t, width, loadu, set1, and_, or_, cmpeq, movemask, zero) \
+static target bool name(const SyncKey *keys, int nkeys, const uint32_t *st,           \
+  const uint8_t *buf, size_t size, size_t &pos)                                      \
+{                                                                                     \
+  vec_t value1[max_keys], mask1[max_keys];                                            \
+  vec_t value2[max_keys], mask2[max_keys];                                            \
+  int k;                                                                              \
+  for (k = 0; k < nkeys; k++)                                                         \
+  {                                                                                   \
+    value1[k] = set1(char(keys[k].value1)); mask1[k] = set1(char(keys[k].mask1));     \
+    value2[k] = set1(char(keys[k].value2)); mask2[k] = set1(char(keys[k].mask2));     \
+  }                                                                                   \
+                                                                                      \
+  size_t i = 0;                                                                       \
+  while (i + width + 3 <= size)                                                       \
+  {                                                                                   \
+    vec_t b1 = loadu(buf + i);                                                        \
+    vec_t b2 = loadu(buf + i + 1);                                                    \
+    vec_t hit = zero();                                                               \
+    for (k = 0; k < nkeys; k++)                                                       \
+      hit = or_(hit, and_(                                                            \
+        cmpeq(and_(b1, mask1[k]), value1[k]),                                         \
+        cmpeq(and_(b2, mask2[k]), value2[k])));                                       \
+                                                                                      \
+    uint32_t candidates = (uint32_t)movemask(hit);                                    \
+    for (int j = 0; candidates; j++, candidates >>= 1)                                \
+      if (candidates & 1)                                                             \
+      {                                                                               \
+        const uint8_t *p = buf + i + j;                                               \
+        if (st[p[0]] & st[p[1] + 256] & st[p[2] + 512] & st[p[3] + 768])             \
+        {                                                                             \
+          pos = i + j;                                                                \
+          return true;                                                                \
+        }                                                                             \
+      }                                                                               \
+    i += width;                                                                       \
+  }                                                                                   \
+                                                                                      \
+  pos = i;                                                                            \
+  return false;                                                                       \
+}
+
+#define LOADU_SSE2(p) _mm_loadu_si128((const __m128i *)(p))
+
+DEFINE_FIND_SYNC(find_sync_sse2, , __m128i, 16, LOADU_SSE2, _mm_set1_epi8,
+  _mm_and_si128, _mm_or_si128, _mm_cmpeq_epi8, _mm_movemask_epi8, _mm_setzero_si128)
+
+#ifdef VALIB_SIMD_AVX2
+#define LOADU_AVX2(p) _mm256_loadu_si256((const __m256i *)(p))
+
+DEFINE_FIND_SYNC(find_sync_avx2, SIMD_TARGET_AVX2, __m256i, 32, LOADU_AVX2, _mm256_set1_epi8,
+  _mm256_and_si256, _mm256_or_si256, _mm256_cmpeq_epi8, _mm256_movemask_epi8, _mm256_setzero_si256)
+#endif
+
+#endif
+
+bool
+SyncScan::find_sync(const uint8_t *buf, size_t size, size_t &pos) const
+{
+  pos = 0;
+  if (nkeys == 0)
+    return false;
+
+#ifdef VALIB_SIMD_X86
+#ifdef VALIB_SIMD_AVX2
+  if (simd_has(SIMD_AVX2))
+    return find_sync_avx2(keys, nkeys, synctable, buf, size, pos);
+#endif
+  if (simd_has(SIMD_SSE2))
+    return find_sync_sse2(keys, nkeys, synctable, buf, size, pos);
+#endif
+
+  return false;
+}
+
 void 
 SyncScan::reset()
 {
@@ -345,6 +494,37 @@ SyncScan::scan(uint8_t *buf, size_t size)
 
   count = 4;
 
+  ///////////////////////////////////////////////////////
+  // Vectorized scan
+  // Syncpoints that start before the buffer are checked
+  // byte by byte.
+
+  if (nkeys)
+  {
+    while (pos < end && pos < buf + 3)
+    {
+      sync = (sync << 8) | *pos++;
+      if (is_sync(sync))
+      {
+        syncword = swab_u32(sync);
+        return pos - buf;
+      }
+    }
+
+    size_t i;
+    if (find_sync(buf, size, i))
+    {
+      syncword = *(uint32_t *)(buf + i);
+      return i + 4;
+    }
+
+    if (i)
+    {
+      pos = buf + i + 3;
+      sync = swab_u32(*(uint32_t *)(buf + i - 1));
+    }
+  }
+
   ///////////////////////////////////////////////////////
   // Process unaligned start
 
@@ -467,6 +647,37 @@ SyncScan::scan(uint8_t *syncbuf, uint8_t *buf, size_t size) const
     st4(sync & 0xff)            \
   )
 
+  ///////////////////////////////////////////////////////
+  // Vectorized scan
+  // Syncpoints that start before the buffer are checked
+  // byte by byte.
+
+  if (nkeys)
+  {
+    while (pos < end && pos < buf + 3)
+    {
+      sync = (sync << 8) | *pos++;
+      if (is_sync(sync))
+      {
+        *(uint32_t *)syncbuf = swab_u32(sync);
+        return pos - buf;
+      }
+    }
+
+    size_t i;
+    if (find_sync(buf, size, i))
+    {
+      *(uint32_t *)syncbuf = *(uint32_t *)(buf + i);
+      return i + 4;
+    }
+
+    if (i)
+    {
+      pos = buf + i + 3;
+      sync = swab_u32(*(uint32_t *)(buf + i - 1));
+    }
+  }
+
   ///////////////////////////////////////////////////////
   // Process unaligned start
 
@@ -399,6 +399,29 @@
   Standard syncpoints are defined with most complex error checking possible, 
   so it is preferrable to use functionality provided by this module rather than
   define own syncpoints.
+
+  -----------------------------------------------------------------------------
+  VECTORIZED SCAN
+  -----------------------------------------------------------------------------
+
+  Table lookups cannot be vectorized without gather instructions, so SIMD 
+  scanner uses a prefilter built from the synctable. For each syncpoint we
+  find bits that are the same for all allowed values of the 1st byte and for
+  all allowed values of the 2nd byte. So we have a key (value and mask) for
+  each of 2 bytes:
+
+    ((b1 & mask1) == value1) && ((b2 & mask2) == value2)
+
+  This condition is true for all syncpoints (but may be true for other byte
+  pairs too). SSE2/AVX2 code checks keys of all syncpoints at 16/32 positions
+  at once and verifies candidates found with the table. Probability of a
+  candidate at random data is low (1/4096 for MPA and 1/65536 for others), so
+  the scanner processes data at memory speed.
+
+  Keys are rebuilt on each table change. When a syncpoint allows any first 2
+  bytes (empty key) or when there are too many keys, the prefilter is not
+  effective and the scanner uses scalar code only. Result of the scan does
+  not depend on the code used.
 */
 
 #ifndef VALIB_SYNCSCAN_H
@@ -445,6 +468,15 @@
 #define SYNCMASK_SPDIF    0x10000
 #define SYNCMASK_PS       0x20000
 
+///////////////////////////////////////////////////////////
+// Prefilter key for the vectorized scan
+
+struct SyncKey
+{
+  uint8_t value1, mask1;
+  uint8_t value2, mask2;
+};
+
 ///////////////////////////////////////////////////////////
 // SyncScan class
 
@@ -454,6 +486,13 @@ protected:
   typedef uint32_t synctbl_t;
   synctbl_t *synctable;
 
+  // Prefilter for the vectorized scan
+  SyncKey keys[sizeof(synctbl_t) * 8];
+  int nkeys; // zero when the prefilter is not used
+
+  void update_keys();
+  bool find_sync(const uint8_t *buf, size_t size, size_t &pos) const;
+
 public:
   union
   {
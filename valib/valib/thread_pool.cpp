@@ -0,0 +1,357 @@
+#include <string.h>
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#  include <windows.h>
+#else
+#  include <pthread.h>
+#  include <unistd.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Synchronization
+//
+// Each run wakes up nthreads-1 workers. 'busy' counts wake-ups that are not
+// finished yet, so a fast thread may take 2 wake-ups of a run (and find no
+// jobs with the second one), but the run ends only when all of them are done.
+
+#ifdef _WIN32
+
+struct ThreadPool::Sync
+{
+  CRITICAL_SECTION lock;
+  HANDLE  start;        // semaphore: number of wake-ups
+  HANDLE  done;         // auto-reset event: all wake-ups are done
+  HANDLE *threads;
+  int     nthreads;     // number of started threads
+  LONG    busy;
+  volatile bool quit;
+  ThreadPool *pool;
+
+  Sync(ThreadPool *_pool): threads(0), nthreads(0), busy(0), quit(false), pool(_pool)
+  {
+    InitializeCriticalSection(&lock);
+    start = CreateSemaphore(0, 0, 0x7fffffff, 0);
+    done = CreateEvent(0, FALSE, FALSE, 0);
+  }
+
+  ~Sync()
+  {
+    stop();
+    CloseHandle(start);
+    CloseHandle(done);
+    DeleteCriticalSection(&lock);
+  }
+
+  static DWORD WINAPI thread_proc(LPVOID param)
+  {
+    Sync *s = (Sync *)param;
+    for (;;)
+    {
+      WaitForSingleObject(s->start, INFINITE);
+      if (s->quit)
+        return 0;
+      s->pool->work();
+      if (InterlockedDecrement(&s->busy) == 0)
+        SetEvent(s->done);
+    }
+  }
+
+  bool start_threads(int n)
+  {
+    if (!start || !done)
+      return false;
+
+    threads = new HANDLE[n];
+    if (!threads)
+      return false;
+
+    quit = false;
+    for (nthreads = 0; nthreads < n; nthreads++)
+    {
+      threads[nthreads] = CreateThread(0, 0, thread_proc, this, 0, 0);
+      if (!threads[nthreads])
+      {
+        stop();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void stop()
+  {
+    if (!threads)
+      return;
+
+    quit = true;
+    ReleaseSemaphore(start, nthreads, 0);
+    for (int i = 0; i < nthreads; i++)
+    {
+      WaitForSingleObject(threads[i], INFINITE);
+      CloseHandle(threads[i]);
+    }
+    delete[] threads;
+    threads = 0;
+    nthreads = 0;
+  }
+
+  void wake()
+  {
+    busy = nthreads;
+    ReleaseSemaphore(start, nthreads, 0);
+  }
+
+  void wait()
+  {
+    WaitForSingleObject(done, INFINITE);
+  }
+
+  void enter() { EnterCriticalSection(&lock); }
+  void leave() { LeaveCriticalSection(&lock); }
+};
+
+int
+ThreadPool::get_cpus()
+{
+  SYSTEM_INFO sysinfo;
+  memset(&sysinfo, 0, sizeof(sysinfo));
+  GetSystemInfo(&sysinfo);
+  int ncpus = sysinfo.dwNumberOfProcessors;
+  return ncpus > 0? ncpus: 1;
+}
+
+#else
+
+struct ThreadPool::Sync
+{
+  pthread_mutex_t lock;
+  pthread_cond_t  start;  // wake-up or quit
+  pthread_cond_t  done;   // all wake-ups are done
+  pthread_t *threads;
+  int  nthreads;          // number of started threads
+  int  wakeups;           // wake-ups not taken yet
+  int  busy;
+  bool quit;
+  ThreadPool *pool;
+
+  Sync(ThreadPool *_pool): threads(0), nthreads(0), wakeups(0), busy(0), quit(false), pool(_pool)
+  {
+    pthread_mutex_init(&lock, 0);
+    pthread_cond_init(&start, 0);
+    pthread_cond_init(&done, 0);
+  }
+
+  ~Sync()
+  {
+    stop();
+    pthread_cond_destroy(&done);
+    pthread_cond_destroy(&start);
+    pthread_mutex_destroy(&lock);
+  }
+
+  static void *thread_proc(void *param)
+  {
+    Sync *s = (Sync *)param;
+    pthread_mutex_lock(&s->lock);
+    for (;;)
+    {
+      while (!s->wakeups && !s->quit)
+        pthread_cond_wait(&s->start, &s->lock);
+      if (s->quit)
+        break;
+
+      s->wakeups--;
+      pthread_mutex_unlock(&s->lock);
+      s->pool->work();
+      pthread_mutex_lock(&s->lock);
+
+      if (--s->busy == 0)
+        pthread_cond_signal(&s->done);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return 0;
+  }
+
+  bool start_threads(int n)
+  {
+    threads = new pthread_t[n];
+    if (!threads)
+      return false;
+
+    quit = false;
+    for (nthreads = 0; nthreads < n; nthreads++)
+      if (pthread_create(threads + nthreads, 0, thread_proc, this) != 0)
+      {
+        stop();
+        return false;
+      }
+    return true;
+  }
+
+  void stop()
+  {
+    if (!threads)
+      return;
+
+    pthread_mutex_lock(&lock);
+    quit = true;
+    pthread_cond_broadcast(&start);
+    pthread_mutex_unlock(&lock);
+
+    for (int i = 0; i < nthreads; i++)
+      pthread_join(threads[i], 0);
+    delete[] threads;
+    threads = 0;
+    nthreads = 0;
+  }
+
+  void wake()
+  {
+    pthread_mutex_lock(&lock);
+    wakeups = busy = nthreads;
+    pthread_cond_broadcast(&start);
+    pthread_mutex_unlock(&lock);
+  }
+
+  void wait()
+  {
+    pthread_mutex_lock(&lock);
+    while (busy)
+      pthread_cond_wait(&done, &lock);
+    pthread_mutex_unlock(&lock);
+  }
+
+  void enter() { pthread_mutex_lock(&lock); }
+  void leave() { pthread_mutex_unlock(&lock); }
+};
+
+int
+ThreadPool::get_cpus()
+{
+  int ncpus = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return ncpus > 0? ncpus: 1;
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// ThreadPool
+
+ThreadPool::ThreadPool(int threads):
+sync(0), nthreads(1), proc(0), param(0), njobs(0), next_job(0), running(false)
+{
+  set_threads(threads);
+}
+
+ThreadPool::~ThreadPool()
+{
+  stop();
+}
+
+bool
+ThreadPool::set_threads(int threads)
+{
+  if (threads < 0)
+    return false;
+
+  if (threads == 0)
+    threads = get_cpus();
+
+  if (threads == nthreads)
+    return true;
+
+  stop();
+  if (threads == 1)
+    return true;
+
+  if (!start(threads))
+  {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+bool
+ThreadPool::start(int threads)
+{
+  sync = new Sync(this);
+  if (!sync || !sync->start_threads(threads - 1))
+    return false;
+
+  nthreads = threads;
+  return true;
+}
+
+void
+ThreadPool::stop()
+{
+  wait();
+  safe_delete(sync);
+  nthreads = 1;
+}
+
+void
+ThreadPool::run(job_proc _proc, void *_param, int _njobs)
+{
+  wait();
+  if (nthreads <= 1 || _njobs <= 1)
+  {
+    for (int job = 0; job < _njobs; job++)
+      _proc(_param, job);
+    return;
+  }
+
+  proc = _proc;
+  param = _param;
+  njobs = _njobs;
+  next_job = 0;
+  sync->wake();
+  work();
+  sync->wait();
+}
+
+void
+ThreadPool::run_async(job_proc _proc, void *_param, int _njobs)
+{
+  wait();
+  if (nthreads <= 1)
+  {
+    for (int job = 0; job < _njobs; job++)
+      _proc(_param, job);
+    return;
+  }
+
+  proc = _proc;
+  param = _param;
+  njobs = _njobs;
+  next_job = 0;
+  running = true;
+  sync->wake();
+}
+
+void
+ThreadPool::wait()
+{
+  if (running)
+  {
+    sync->wait();
+    running = false;
+  }
+}
+
+void
+ThreadPool::work()
+{
+  for (;;)
+  {
+    sync->enter();
+    int job = next_job < njobs? next_job++: -1;
+    sync->leave();
+
+    if (job < 0)
+      break;
+    proc(param, job);
+  }
+}
@@ -0,0 +1,76 @@
+/*
+  Thread pool
+
+  Runs a number of jobs at several threads and waits for them to finish.
+  Threads are started once and sleep between runs, so a run is cheap
+  enough to split a single frame of audio between threads.
+
+  The caller's thread takes jobs too, so a pool of N threads starts N-1
+  worker threads. Jobs are taken in order of their numbers.
+
+  set_threads(int threads)
+    Set the number of threads including the caller's thread. Zero means
+    the number of processors, one means that jobs run at the caller's
+    thread. Returns false if threads cannot be started (the pool runs jobs
+    at the caller's thread in this case).
+
+  run(job_proc proc, void *param, int njobs)
+    Call proc(param, job) for job = 0..njobs-1 and wait for all of them.
+    Must not be called from a job or from several threads at once.
+
+  run_async(job_proc proc, void *param, int njobs)
+    Start jobs at worker threads and return immediately, so the caller's
+    thread may do something else meanwhile. The caller's thread takes no
+    jobs, so a pool of N threads runs N-1 jobs at once. Without worker
+    threads the jobs are done before the call returns.
+
+  wait()
+    Wait for jobs started with run_async(). Does nothing when no jobs are
+    running. Must be called before the next run.
+*/
+
+#ifndef VALIB_THREAD_POOL_H
+#define VALIB_THREAD_POOL_H
+
+#include "defs.h"
+
+class ThreadPool
+{
+public:
+  typedef void (*job_proc)(void *param, int job);
+
+  ThreadPool(int threads = 1);
+  ~ThreadPool();
+
+  bool set_threads(int threads);
+  int  get_threads() const { return nthreads; }
+  static int get_cpus();
+
+  void run(job_proc proc, void *param, int njobs);
+  void run_async(job_proc proc, void *param, int njobs);
+  void wait();
+
+protected:
+  struct Sync;        // platform-specific synchronization
+  Sync *sync;
+  int nthreads;
+
+  // current run
+  job_proc proc;
+  void *param;
+  int njobs;
+  int next_job;
+  bool running;       // run_async() is not waited for yet
+
+  bool start(int threads);
+  void stop();
+  void work();
+
+  friend struct Sync;
+
+private:
+  ThreadPool(const ThreadPool &);
+  ThreadPool &operator =(const ThreadPool &);
+};
+
+#endif